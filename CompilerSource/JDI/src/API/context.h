@@ -93,6 +93,9 @@ namespace jdi
     
     /// This is a map of structures which conflict with other declarations, which is allowed by the rules of C.
     map<string, definition*> c_structs;
+    
+    /// The files #included by the last stream given to \c parse_C_stream, by the path they were opened with.
+    set<string> included_files;
     /** Function to insert into c_structs by the rules of definition_scope::declare.
         @param name  The name of the definition to declare.
         @param def   Pointer to the definition being declared, if one is presently available.
@@ -177,6 +180,27 @@ namespace jdi
     **/
     int parse_C_stream(llreader& cfile, const char* fname = NULL, error_handler *errhandl = NULL);
     
+    /** Write everything parsed into this context to a string, to be restored by \c read_cache.
+        Built-in types and macros are written by name only, so the cache is only good for a
+        context built over the same built-ins. Function bodies are not kept, and of default
+        arguments and dependent types, only that they exist is kept.
+        @param out  The string to which the cache will be appended.
+    **/
+    void write_cache(string &out);
+    /** Restore the definitions and macros written by \c write_cache into this context, which
+        should be freshly constructed.
+        @param data  The cache, as given by \c write_cache.
+        @param size  The length of the cache, in bytes.
+        @return Returns whether the cache was read; if not, this context is left as it was.
+    **/
+    bool read_cache(const char* data, size_t size);
+    /** Name the build of JDI which writes and reads caches. A cache written by one build may not
+        mean the same to another, so anything which keeps caches between runs should key them
+        on this, as well as on what was parsed.
+        @return Returns the cache format version and the time JDI was built.
+    **/
+    static string cache_stamp();
+    
     /** Parse an input stream for definitions using the default C++ lexer.
         @param lang_lexer The lexer which will be polled for tokens. This lexer will already know its token source.
                           If this parameter is NULL, the previous lexer will be used. Or else a huge error will be thrown.
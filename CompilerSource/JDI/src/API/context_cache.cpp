@@ -0,0 +1,659 @@
+/**
+ * @file  context_cache.cpp
+ * @brief Source implementing the writing and reading of context caches.
+ *
+ * A cache lists every definition reachable from the global scope, then gives each
+ * one's contents, referring to other definitions by their place in that list. It is
+ * meant to be read back by the same build of JDI, on the same machine, so numbers
+ * are written as they lie in memory.
+ *
+ * @section License
+ *
+ * Copyright (C) 2026 ENIGMA Development Team
+ * This file is part of JustDefineIt.
+ *
+ * JustDefineIt is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3 of the License, or (at your option) any later version.
+ *
+ * JustDefineIt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * JustDefineIt. If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <string>
+#include <cstring>
+#include <cstdio>
+using namespace std;
+
+#include "context.h"
+#include <System/macros.h>
+#include <System/builtins.h>
+
+using namespace jdi;
+using namespace jdip;
+
+namespace {
+  const char cache_magic[4] = { 'J', 'D', 'I', 'C' };
+  const unsigned cache_version = 1;
+
+  /// The concrete type of a cached definition.
+  enum cache_kind {
+    CK_DEFINITION, CK_TYPED, CK_VALUED, CK_FUNCTION, CK_ENUM,
+    CK_SCOPE, CK_CLASS, CK_UNION, CK_ATOMIC, CK_TEMPSCOPE, CK_HYPOTHETICAL,
+    CK_TEMPLATE
+  };
+  /// How a reference to a definition is written.
+  enum cache_ref { CR_NULL, CR_ABSTRACT, CR_BUILTIN_GLOBAL, CR_PRIMITIVE, CR_DEFINITION };
+
+  cache_kind kind_of(definition *d) {
+    if (dynamic_cast<definition_template*>(d))     return CK_TEMPLATE;
+    if (dynamic_cast<definition_hypothetical*>(d)) return CK_HYPOTHETICAL;
+    if (dynamic_cast<definition_class*>(d))        return CK_CLASS;
+    if (dynamic_cast<definition_union*>(d))        return CK_UNION;
+    if (dynamic_cast<definition_atomic*>(d))       return CK_ATOMIC;
+    if (dynamic_cast<definition_tempscope*>(d))    return CK_TEMPSCOPE;
+    if (dynamic_cast<definition_scope*>(d))        return CK_SCOPE;
+    if (dynamic_cast<definition_function*>(d))     return CK_FUNCTION;
+    if (dynamic_cast<definition_valued*>(d))       return CK_VALUED;
+    if (dynamic_cast<definition_enum*>(d))         return CK_ENUM;
+    if (dynamic_cast<definition_typed*>(d))        return CK_TYPED;
+    return CK_DEFINITION;
+  }
+  inline bool is_scope(cache_kind k) { return k >= CK_SCOPE and k <= CK_HYPOTHETICAL; }
+
+  //===========================================================================================
+  //=====: Writing :===========================================================================
+  //===========================================================================================
+
+  struct cache_writer {
+    string &out;
+    map<definition*, unsigned> ids; ///< The place of each definition in the list.
+    vector<definition*> defs; ///< Every definition to be written, the global scope first.
+    vector<cache_kind> kinds; ///< The type of each definition to be written.
+    vector<definition_scope*> owners; ///< The scope in which each definition was found.
+    map<definition*, string> primitives; ///< Built-in primitives, which are written by name.
+
+    void u8(unsigned char x) { out += char(x); }
+    void u32(unsigned x) { out.append((const char*)&x, sizeof x); }
+    void u64(unsigned long long x) { out.append((const char*)&x, sizeof x); }
+    void dbl(double x) { out.append((const char*)&x, sizeof x); }
+    void str(const string &s) { u32(s.length()); out += s; }
+
+    /** Lists a definition, and later everything it owns. Only definitions which something
+        owns are followed, as a definition may still point to scopes which were torn down
+        when the parser left them. **/
+    void add(definition *d, definition_scope *owner) {
+      if (!d or ids.find(d) != ids.end() or primitives.find(d) != primitives.end())
+        return;
+      ids[d] = defs.size();
+      defs.push_back(d);
+      kinds.push_back(kind_of(d));
+      owners.push_back(owner);
+    }
+    void collect(definition_scope *global) {
+      for (prim_iter it = builtin_primitives.begin(); it != builtin_primitives.end(); ++it)
+        primitives[it->second] = it->first;
+      add(global, NULL);
+      for (size_t i = 0; i < defs.size(); ++i) {
+        definition *d = defs[i];
+        definition_scope *owner = is_scope(kinds[i])? (definition_scope*)d : owners[i];
+        switch (kinds[i]) {
+          case CK_SCOPE: case CK_CLASS: case CK_UNION: case CK_ATOMIC: case CK_HYPOTHETICAL:
+              for (definition_scope::defiter it = ((definition_scope*)d)->members.begin(); it != ((definition_scope*)d)->members.end(); ++it)
+                add(it->second, owner);
+            break;
+          case CK_TEMPSCOPE:
+              for (definition_scope::defiter it = ((definition_scope*)d)->members.begin(); it != ((definition_scope*)d)->members.end(); ++it)
+                add(it->second, owner);
+              add(((definition_tempscope*)d)->source, owner);
+            break;
+          case CK_FUNCTION: {
+              definition_function *f = (definition_function*)d;
+              for (definition_function::overload_iter it = f->overloads.begin(); it != f->overloads.end(); ++it)
+                add(it->second, owner);
+              for (size_t j = 0; j < f->template_overloads.size(); ++j)
+                add(f->template_overloads[j], owner);
+            } break;
+          case CK_TEMPLATE: {
+              definition_template *t = (definition_template*)d;
+              add(t->def, owner);
+              for (size_t j = 0; j < t->params.size(); ++j)
+                add(t->params[j], owner);
+              for (definition_template::speciter it = t->specializations.begin(); it != t->specializations.end(); ++it)
+                add(it->second, owner);
+              for (definition_template::institer it = t->instantiations.begin(); it != t->instantiations.end(); ++it)
+                add(it->second, owner);
+              for (definition_template::depiter it = t->dependents.begin(); it != t->dependents.end(); ++it)
+                add(*it, owner);
+            } break;
+          case CK_DEFINITION: case CK_TYPED: case CK_VALUED: case CK_ENUM:
+            break;
+        }
+      }
+    }
+
+    bool known(definition *d) {
+      return !d or d == &arg_key::abstract or d == builtin->get_global() or ids.find(d) != ids.end() or primitives.find(d) != primitives.end();
+    }
+    /// Write a reference to a definition; definitions not listed are written as NULL.
+    void ref(definition *d) {
+      map<definition*, unsigned>::iterator id;
+      map<definition*, string>::iterator prim;
+      if (!d) u8(CR_NULL);
+      else if (d == &arg_key::abstract) u8(CR_ABSTRACT);
+      else if (d == builtin->get_global()) u8(CR_BUILTIN_GLOBAL);
+      else if ((id = ids.find(d)) != ids.end()) u8(CR_DEFINITION), u32(id->second);
+      else if ((prim = primitives.find(d)) != primitives.end()) u8(CR_PRIMITIVE), str(prim->second);
+      else u8(CR_NULL);
+    }
+
+    void refs(const ref_stack &rs);
+    void fulltype(const full_type &ft) { ref(ft.def); refs(ft.refs); u32(ft.flags); }
+    void val(const value &v) {
+      u8(v.type);
+      if (v.type == VT_DOUBLE) dbl(v.val.d);
+      else if (v.type == VT_INTEGER) u64(v.val.i);
+      else if (v.type == VT_STRING) str(v.val.s);
+    }
+    void key(const arg_key &ck) {
+      arg_key &k = const_cast<arg_key&>(ck);
+      u32(k.end() - k.begin());
+      for (arg_key::node *n = k.begin(); n != k.end(); ++n) {
+        u8(n->type);
+        if (n->type == arg_key::AKT_FULLTYPE) fulltype(n->ft());
+        else if (n->type == arg_key::AKT_VALUE) val(n->val());
+      }
+    }
+    void defs_in(const definition_scope::defmap &m) {
+      u32(m.size());
+      for (definition_scope::defiter_c it = m.begin(); it != m.end(); ++it)
+        str(it->first), ref(it->second);
+    }
+
+    void body(size_t i);
+    cache_writer(string &o): out(o) {}
+  };
+
+  void cache_writer::refs(const ref_stack &rs) {
+    str(rs.name);
+    u32(rs.size());
+    for (ref_stack::iterator it = rs.begin(); it; ++it) { // Top to bottom
+      u8(it->type);
+      if (it->type == ref_stack::RT_ARRAYBOUND)
+        u64(((ref_stack::node_array*)*it)->bound);
+      else if (it->type == ref_stack::RT_FUNCTION) {
+        const ref_stack::parameter_ct &ps = ((ref_stack::node_func*)*it)->params;
+        u32(ps.size());
+        for (size_t j = 0; j < ps.size(); ++j)
+          fulltype(ps[j]), u8(ps[j].variadic), u8(ps[j].default_value != NULL);
+      }
+    }
+  }
+
+  void cache_writer::body(size_t i) {
+    definition *d = defs[i];
+    ref(known(d->parent)? d->parent : owners[i]); // A scope the parser has since left is replaced by the one owning d
+    switch (kinds[i]) {
+      case CK_TYPED: case CK_VALUED: case CK_FUNCTION: case CK_ENUM: {
+          definition_typed *t = (definition_typed*)d;
+          ref(t->type);
+          refs(t->referencers);
+          u32(t->modifiers);
+          if (kinds[i] == CK_VALUED)
+            val(((definition_valued*)d)->value_of);
+          else if (kinds[i] == CK_FUNCTION) {
+            definition_function *f = (definition_function*)d;
+            u32(f->overloads.size());
+            for (definition_function::overload_iter it = f->overloads.begin(); it != f->overloads.end(); ++it)
+              key(it->first), ref(it->second);
+            u32(f->template_overloads.size());
+            for (size_t j = 0; j < f->template_overloads.size(); ++j)
+              ref(f->template_overloads[j]);
+          }
+          else if (kinds[i] == CK_ENUM)
+            defs_in(((definition_enum*)d)->constants);
+        } break;
+      case CK_SCOPE: case CK_CLASS: case CK_UNION: case CK_ATOMIC: case CK_TEMPSCOPE: case CK_HYPOTHETICAL: {
+          definition_scope *s = (definition_scope*)d;
+          defs_in(s->members);
+          defs_in(s->using_general);
+          unsigned c = 0;
+          for (definition_scope::using_node *n = s->get_using_front(); n; n = n->next)
+            ++c;
+          u32(c);
+          for (definition_scope::using_node *n = s->get_using_front(); n; n = n->next)
+            ref(n->use);
+          if (kinds[i] == CK_CLASS or kinds[i] == CK_HYPOTHETICAL) {
+            definition_class *c = (definition_class*)d;
+            u32(c->ancestors.size());
+            for (size_t j = 0; j < c->ancestors.size(); ++j)
+              u32(c->ancestors[j].protection), ref(c->ancestors[j].def);
+          }
+          if (kinds[i] == CK_HYPOTHETICAL)
+            u8(((definition_hypothetical*)d)->def != NULL);
+          else if (kinds[i] == CK_ATOMIC)
+            u64(((definition_atomic*)d)->sz);
+          else if (kinds[i] == CK_TEMPSCOPE)
+            ref(((definition_tempscope*)d)->source), u8(((definition_tempscope*)d)->referenced);
+        } break;
+      case CK_TEMPLATE: {
+          definition_template *t = (definition_template*)d;
+          ref(t->def);
+          u32(t->params.size());
+          for (size_t j = 0; j < t->params.size(); ++j)
+            ref(t->params[j]);
+          u32(t->specializations.size());
+          for (definition_template::speciter it = t->specializations.begin(); it != t->specializations.end(); ++it)
+            key(it->first), ref(it->second);
+          u32(t->instantiations.size());
+          for (definition_template::institer it = t->instantiations.begin(); it != t->instantiations.end(); ++it)
+            key(it->first), ref(it->second);
+          u32(t->dependents.size());
+          for (definition_template::depiter it = t->dependents.begin(); it != t->dependents.end(); ++it)
+            ref(*it);
+        } break;
+      case CK_DEFINITION:
+        break;
+    }
+  }
+
+  //===========================================================================================
+  //=====: Reading :===========================================================================
+  //===========================================================================================
+
+  struct cache_reader {
+    const char *pos, *end;
+    bool ok; ///< False once anything read was out of bounds or nonsensical.
+    vector<definition*> defs;
+
+    bool take(void *dest, size_t n) {
+      if (!ok or size_t(end - pos) < n)
+        return ok = false;
+      memcpy(dest, pos, n); pos += n;
+      return true;
+    }
+    unsigned char u8() { unsigned char x = 0; take(&x, sizeof x); return x; }
+    unsigned u32() { unsigned x = 0; take(&x, sizeof x); return x; }
+    unsigned long long u64() { unsigned long long x = 0; take(&x, sizeof x); return x; }
+    double dbl() { double x = 0; take(&x, sizeof x); return x; }
+    string str() {
+      const unsigned n = u32();
+      if (!ok or size_t(end - pos) < n)
+        return (ok = false, string());
+      string res(pos, n); pos += n;
+      return res;
+    }
+    /// Read a count of things which each take at least one byte.
+    unsigned count() {
+      const unsigned n = u32();
+      if (size_t(end - pos) < n) ok = false;
+      return ok? n : 0;
+    }
+
+    definition *ref() {
+      switch (u8()) {
+        case CR_NULL: return NULL;
+        case CR_ABSTRACT: return &arg_key::abstract;
+        case CR_BUILTIN_GLOBAL: return builtin->get_global();
+        case CR_PRIMITIVE: {
+            prim_iter it = builtin_primitives.find(str());
+            if (it != builtin_primitives.end()) return it->second;
+          } break;
+        case CR_DEFINITION: {
+            const unsigned id = u32();
+            if (id < defs.size()) return defs[id];
+          } break;
+      }
+      ok = false;
+      return NULL;
+    }
+
+    void refs(ref_stack &rs);
+    void fulltype(full_type &ft) {
+      ft.def = ref();
+      refs(ft.refs);
+      ft.flags = u32();
+    }
+    void val(value &v) {
+      switch (u8()) {
+        case VT_NONE: v = value(); break;
+        case VT_DOUBLE: v = value(dbl()); break;
+        case VT_INTEGER: v = value(long(u64())); break;
+        case VT_STRING: v = value(str()); break;
+        default: ok = false;
+      }
+    }
+    arg_key key() {
+      const unsigned n = count();
+      arg_key k(n);
+      for (unsigned i = 0; i < n; ++i) {
+        const unsigned char type = u8();
+        if (type == arg_key::AKT_FULLTYPE) {
+          full_type ft; fulltype(ft);
+          k.swap_final_type(i, ft);
+        }
+        else if (type == arg_key::AKT_VALUE) {
+          value v; val(v);
+          k.put_value(i, v);
+        }
+      }
+      return k;
+    }
+    void defs_in(definition_scope::defmap &m) {
+      for (unsigned n = count(); n; --n) {
+        string name = str();
+        if (definition *d = ref())
+          m[name] = d;
+      }
+    }
+
+    void body(definition *d, cache_kind k, definition_scope *into);
+  };
+
+  void cache_reader::refs(ref_stack &rs) {
+    rs.name = str();
+    for (unsigned n = count(); n and ok; --n) { // Top to bottom
+      ref_stack node;
+      const unsigned char type = u8();
+      if (type == ref_stack::RT_ARRAYBOUND)
+        node.push_array(u64());
+      else if (type == ref_stack::RT_FUNCTION) {
+        ref_stack::parameter_ct ps;
+        for (unsigned pc = count(); pc and ok; --pc) {
+          ref_stack::parameter p;
+          fulltype(p);
+          p.variadic = u8();
+          if (u8()) p.default_value = new AST(); // Only whether there was a default is kept
+          ps.throw_on(p);
+        }
+        node.push_func(ps);
+      }
+      else if (type == ref_stack::RT_POINTERTO or type == ref_stack::RT_REFERENCE)
+        node.push(ref_stack::ref_type(type));
+      else ok = false;
+      rs.prepend_c(node);
+    }
+  }
+
+  /// Read the contents of d; the members of a scope go into \p into, which is usually d itself.
+  void cache_reader::body(definition *d, cache_kind k, definition_scope *into) {
+    d->parent = (definition_scope*)ref();
+    switch (k) {
+      case CK_TYPED: case CK_VALUED: case CK_FUNCTION: case CK_ENUM: {
+          definition_typed *t = (definition_typed*)d;
+          t->type = ref();
+          refs(t->referencers);
+          t->modifiers = u32();
+          if (k == CK_VALUED)
+            val(((definition_valued*)d)->value_of);
+          else if (k == CK_FUNCTION) {
+            definition_function *f = (definition_function*)d;
+            for (unsigned n = count(); n and ok; --n) {
+              arg_key k = key();
+              definition *o = ref();
+              if (o and kind_of(o) == CK_FUNCTION)
+                f->overloads[k] = (definition_function*)o;
+              else ok = false;
+            }
+            for (unsigned n = count(); n and ok; --n) {
+              definition *o = ref();
+              if (o and kind_of(o) == CK_TEMPLATE)
+                f->template_overloads.push_back((definition_template*)o);
+              else ok = false;
+            }
+          }
+          else if (k == CK_ENUM)
+            defs_in(((definition_enum*)d)->constants);
+        } break;
+      case CK_SCOPE: case CK_CLASS: case CK_UNION: case CK_ATOMIC: case CK_TEMPSCOPE: case CK_HYPOTHETICAL: {
+          defs_in(into->members);
+          defs_in(into->using_general);
+          for (unsigned n = count(); n and ok; --n) {
+            definition *u = ref();
+            if (u and is_scope(kind_of(u)))
+              into->use_namespace((definition_scope*)u);
+          }
+          if (k == CK_CLASS or k == CK_HYPOTHETICAL) {
+            definition_class *c = (definition_class*)d;
+            for (unsigned n = count(); n and ok; --n) {
+              const unsigned protection = u32();
+              definition *a = ref();
+              if (a and kind_of(a) == CK_CLASS)
+                c->ancestors.push_back(definition_class::ancestor(protection, (definition_class*)a));
+            }
+          }
+          if (k == CK_HYPOTHETICAL) {
+            if (u8()) ((definition_hypothetical*)d)->def = new AST(); // Only that there was an expression is kept
+          }
+          else if (k == CK_ATOMIC)
+            ((definition_atomic*)d)->sz = u64();
+          else if (k == CK_TEMPSCOPE) {
+            ((definition_tempscope*)d)->source = ref();
+            ((definition_tempscope*)d)->referenced = u8();
+          }
+        } break;
+      case CK_TEMPLATE: {
+          definition_template *t = (definition_template*)d;
+          t->def = ref();
+          for (unsigned n = count(); n and ok; --n)
+            t->params.push_back(ref());
+          for (unsigned n = count(); n and ok; --n) {
+            arg_key k = key();
+            definition *s = ref();
+            if (s and kind_of(s) == CK_TEMPLATE)
+              t->specializations[k] = (definition_template*)s;
+            else ok = false;
+          }
+          for (unsigned n = count(); n and ok; --n) {
+            arg_key k = key();
+            t->instantiations[k] = ref();
+          }
+          for (unsigned n = count(); n and ok; --n) {
+            definition *h = ref();
+            if (h and kind_of(h) == CK_HYPOTHETICAL)
+              t->dependents.push_back((definition_hypothetical*)h);
+            else ok = false;
+          }
+        } break;
+      case CK_DEFINITION:
+        break;
+    }
+  }
+
+  definition *allocate(cache_kind k, string name, unsigned flags) {
+    definition *res;
+    switch (k) {
+      case CK_DEFINITION: res = new definition(name, NULL, flags); break;
+      case CK_TYPED: res = new definition_typed(name, NULL, NULL, 0, flags); break;
+      case CK_VALUED: { value v; res = new definition_valued(name, NULL, NULL, 0, flags, v); } break;
+      case CK_FUNCTION: {
+          ref_stack rf; ref_stack::parameter_ct ps;
+          rf.push_func(ps); // The constructor lists itself as an overload; the real ones are read later
+          definition_function *f = new definition_function(name, NULL, NULL, rf, 0, flags);
+          f->overloads.clear();
+          ref_stack().swap(f->referencers);
+          res = f;
+        } break;
+      case CK_ENUM: res = new definition_enum(name, NULL, flags); break;
+      case CK_SCOPE: res = new definition_scope(name, NULL, flags); break;
+      case CK_CLASS: res = new definition_class(name, NULL, flags); break;
+      case CK_UNION: res = new definition_union(name, NULL, flags); break;
+      case CK_ATOMIC: res = new definition_atomic(name, NULL, flags, 0); break;
+      case CK_TEMPSCOPE: res = new definition_tempscope(name, NULL, flags, NULL); break;
+      case CK_HYPOTHETICAL: res = new definition_hypothetical(name, NULL, flags, NULL); break;
+      case CK_TEMPLATE: res = new definition_template(name, NULL, flags); break;
+      default: return NULL;
+    }
+    res->flags = flags; // Constructors add flags of their own
+    return res;
+  }
+}
+
+string context::cache_stamp()
+{
+  char version[16];
+  sprintf(version, "%u", cache_version);
+  return string("JDI cache ") + version + "; built " __DATE__ " " __TIME__;
+}
+
+void context::write_cache(string &out)
+{
+  cache_writer w(out);
+  out.append(cache_magic, sizeof cache_magic);
+  w.u32(cache_version);
+
+  w.collect(global);
+  w.u32(w.defs.size());
+  for (size_t i = 0; i < w.defs.size(); ++i)
+    w.u8(w.kinds[i]), w.u32(w.defs[i]->flags), w.str(w.defs[i]->name);
+  for (size_t i = 0; i < w.defs.size(); ++i)
+    w.body(i);
+
+  w.u32(c_structs.size());
+  for (map<string, definition*>::iterator it = c_structs.begin(); it != c_structs.end(); ++it)
+    w.str(it->first), w.ref(it->second);
+  w.u32(variadics.size());
+  for (set<definition*>::iterator it = variadics.begin(); it != variadics.end(); ++it)
+    w.ref(*it);
+
+  // Macros are written only where they differ from the built-ins this context started from
+  vector<const macro_type*> own;
+  for (macro_iter_c it = macros.begin(); it != macros.end(); ++it) {
+    macro_iter_c bit = builtin->macros.find(it->first);
+    if (bit == builtin->macros.end() or bit->second != it->second)
+      own.push_back(it->second);
+  }
+  w.u32(own.size());
+  for (size_t i = 0; i < own.size(); ++i) {
+    w.str(own[i]->name);
+    w.u32(own[i]->argc);
+    if (own[i]->argc < 0)
+      w.str(((const macro_scalar*)own[i])->value);
+    else {
+      const macro_function *mf = (const macro_function*)own[i];
+      w.u32(mf->args.size());
+      for (size_t j = 0; j < mf->args.size(); ++j)
+        w.str(mf->args[j]);
+      w.u32(mf->value.size());
+      for (size_t j = 0; j < mf->value.size(); ++j) {
+        w.u8(mf->value[j].is_arg);
+        if (mf->value[j].is_arg) w.u64(mf->value[j].metric);
+        else w.str(string(mf->value[j].data, mf->value[j].metric));
+      }
+    }
+  }
+  vector<string> undefined;
+  for (macro_iter_c it = builtin->macros.begin(); it != builtin->macros.end(); ++it)
+    if (macros.find(it->first) == macros.end())
+      undefined.push_back(it->first);
+  w.u32(undefined.size());
+  for (size_t i = 0; i < undefined.size(); ++i)
+    w.str(undefined[i]);
+}
+
+/** @section Implementation
+  Every definition is allocated before any is read, so that references can be resolved as
+  they are met. Nothing is attached to this context until the whole cache has been read;
+  should it prove bad partway, whatever was allocated is abandoned rather than freed, since
+  it may point into itself in ways which no destructor expects.
+**/
+bool context::read_cache(const char* data, size_t size)
+{
+  cache_reader r;
+  r.pos = data, r.end = data + size, r.ok = true;
+  char magic[sizeof cache_magic];
+  if (!r.take(magic, sizeof magic) or memcmp(magic, cache_magic, sizeof magic) or r.u32() != cache_version)
+    return false;
+
+  const unsigned defc = r.count();
+  vector<cache_kind> kinds(defc);
+  definition_scope staging; // Holds what goes in the global scope until we are done
+  for (unsigned i = 0; i < defc and r.ok; ++i) {
+    kinds[i] = cache_kind(r.u8());
+    const unsigned flags = r.u32();
+    const string name = r.str();
+    if (!i) {
+      r.ok = r.ok and kinds[i] == CK_SCOPE;
+      r.defs.push_back(global);
+    }
+    else if (definition *d = r.ok? allocate(kinds[i], name, flags) : NULL)
+      r.defs.push_back(d);
+    else r.ok = false;
+  }
+  for (unsigned i = 0; i < defc and r.ok; ++i)
+    r.body(r.defs[i], kinds[i], i? (definition_scope*)r.defs[i] : &staging);
+  global->parent = NULL;
+
+  map<string, definition*> structs;
+  for (unsigned n = r.count(); n and r.ok; --n) {
+    string name = r.str();
+    if (definition *d = r.ref())
+      structs[name] = d;
+  }
+  set<definition*> vars;
+  for (unsigned n = r.count(); n and r.ok; --n)
+    if (definition *d = r.ref())
+      vars.insert(d);
+
+  vector<macro_type*> own;
+  for (unsigned n = r.count(); n and r.ok; --n) {
+    const string name = r.str();
+    const int argc = r.u32();
+    if (argc < 0) {
+      own.push_back(new macro_scalar(name, r.str()));
+      continue;
+    }
+    vector<string> args;
+    for (unsigned ac = r.count(); ac and r.ok; --ac)
+      args.push_back(r.str());
+    macro_function *mf = new macro_function(name, args, "", size_t(argc) > args.size());
+    own.push_back(mf);
+    for (unsigned vc = r.count(); vc and r.ok; --vc) {
+      if (r.u8()) {
+        mf->value.push_back(macro_function::mv_chunk(size_t(r.u64())));
+        continue;
+      }
+      const string chunk = r.str();
+      char *buf = new char[chunk.length()];
+      memcpy(buf, chunk.data(), chunk.length());
+      mf->value.push_back(macro_function::mv_chunk(buf, chunk.length()));
+    }
+  }
+  vector<string> undefined;
+  for (unsigned n = r.count(); n and r.ok; --n)
+    undefined.push_back(r.str());
+
+  if (!r.ok or r.pos != r.end) {
+    for (size_t i = 0; i < own.size(); ++i)
+      macro_type::free(own[i]);
+    staging.members.clear();
+    return false;
+  }
+
+  global->members.insert(staging.members.begin(), staging.members.end());
+  global->using_general.insert(staging.using_general.begin(), staging.using_general.end());
+  for (definition_scope::using_node *n = staging.get_using_front(); n; n = n->next)
+    global->use_namespace(n->use);
+  staging.members.clear();
+  c_structs.insert(structs.begin(), structs.end());
+  variadics.insert(vars.begin(), vars.end());
+  for (size_t i = 0; i < own.size(); ++i) {
+    pair<macro_iter, bool> ins = macros.insert(pair<string, const macro_type*>(own[i]->name, own[i]));
+    if (!ins.second) {
+      macro_type::free(ins.first->second);
+      ins.first->second = own[i];
+    }
+  }
+  for (size_t i = 0; i < undefined.size(); ++i) {
+    macro_iter it = macros.find(undefined[i]);
+    if (it != macros.end()) {
+      macro_type::free(it->second);
+      macros.erase(it);
+    }
+  }
+  return true;
+}
@@ -38,7 +38,12 @@ using namespace jdip;
   new instance of the C++ lexer that ships with JDI, \c lex_cpp.
 **/
 int jdi::context::parse_C_stream(llreader &cfile, const char* fname, error_handler *errhandl) {
-  return parse_stream(fname? new lexer_cpp(cfile, macros, fname) : new lexer_cpp(cfile, macros), errhandl); // Invoke our common method with it
+  if (parse_open) // Let parse_stream report this
+    return parse_stream(new lexer_cpp(cfile, macros), errhandl);
+  lexer_cpp *lcpp = fname? new lexer_cpp(cfile, macros, fname) : new lexer_cpp(cfile, macros);
+  int res = parse_stream(lcpp, errhandl); // Invoke our common method with it
+  included_files.swap(lcpp->visited_files);
+  return res;
 }
 
 /** @section Implementation
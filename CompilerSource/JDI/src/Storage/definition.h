@@ -342,6 +342,8 @@ namespace jdi {
     void unuse_namespace(using_node *ns);
     /** Add a namespace to the using list. This can technically be used on any scope. **/
     void use_general(string name, definition* def);
+    /** Return the first node of our using list, or NULL if we use no scopes. **/
+    using_node *get_using_front() const { return using_front; }
     
     /** Free all contents of this scope. No copy is made. **/
     void clear();
@@ -40,6 +40,7 @@ using namespace jdi;
 using namespace jdip;
 
 void test_expression_evaluator();
+bool test_cache_round_trip();
 
 static void putcap(string cap) {
   cout << endl << endl << endl << endl;
@@ -73,6 +74,9 @@ int main() {
   
   test_expression_evaluator();
   
+  putcap("Test context cache");
+  const bool cache_ok = test_cache_round_trip();
+  
   #if 0
     builtin->add_search_directory("c:\\mingw/lib/gcc/mingw32/4.6.1/include/c++");
     builtin->add_search_directory("c:\\mingw/lib/gcc/mingw32/4.6.1/include/c++/mingw32");
@@ -144,7 +148,7 @@ int main() {
     cout << "Failed to open file for parsing!" << endl;
   
   clean_up();
-  return 0;
+  return cache_ok ? 0 : 1;
 }
 
 #ifdef __linux__d
@@ -0,0 +1,284 @@
+/* Copyright (C) 2026 ENIGMA Development Team
+ * This file is part of JustDefineIt.
+ *
+ * JustDefineIt is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3 of the License, or (at your option) any later version.
+ *
+ * JustDefineIt is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * JustDefineIt. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Round trip of the context cache: parse some declarations, write the cache, read it back into a
+   fresh context, and check that the definition trees and the macros came back the same. The
+   trees are compared as text in which each definition a tree refers to is named by its place
+   in that tree, so two trees describe alike exactly when they are alike, wherever they live
+   in memory. Definitions in maps keyed by pointer are sorted by their description, as their
+   order differs between the two contexts.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+#include <API/jdi.h>
+#include <General/llreader.h>
+#include <System/macros.h>
+
+using namespace jdi;
+using namespace jdip;
+
+static const char cache_test_code[] =
+  "#define SCALAR 42\n"
+  "#define FUNCTIONAL(a, b) ((a) * (b) + SCALAR)\n"
+  "#define VARIADIC(fmt, ...) printf(fmt, __VA_ARGS__)\n"
+  "typedef unsigned long size_type;\n"
+  "namespace outer {\n"
+  "  enum color { red, green = 5, blue };\n"
+  "  const int limit = 16 * 4;\n"
+  "  struct base { int x; virtual ~base(); protected: double y; };\n"
+  "  class derived2: public base {\n"
+  "    static const unsigned table_size = 8;\n"
+  "    char table[table_size];\n"
+  "   public:\n"
+  "    derived2();\n"
+  "    int method(int a, const char *b = 0) const;\n"
+  "    int method(double a);\n"
+  "    int (*callback)(void *data, size_type n);\n"
+  "    union { int i; float f; } u;\n"
+  "  };\n"
+  "  namespace inner { int f(); int f(int); long f(long, ...); using namespace outer; }\n"
+  "}\n"
+  "template<typename T, int N = 3> struct fixed { T items[N]; T &at(int i); static const int count = N; };\n"
+  "template<typename T> struct fixed<T*, 4> { T *first; };\n"
+  "template<> struct fixed<char, 2> { char pair[2]; };\n"
+  "template<typename T> T maximum(T a, T b);\n"
+  "template<typename T> struct holder { typedef typename T::value_type value_type; value_type held; };\n"
+  "fixed<int> three_ints;\n"
+  "fixed<int, 8> eight_ints;\n"
+  "holder< fixed<int> > held_fixed;\n"
+  "extern outer::derived2 *instances[SCALAR];\n"
+  "using outer::color;\n";
+
+namespace {
+  struct describer {
+    definition_scope *global;
+    map<definition*, string> names; ///< The path to each definition the tree owns.
+    map<definition*, definition*> owners; ///< The scope in which each definition was found.
+
+    /// Name each definition the tree owns by the way down to it from the global scope.
+    void name_all(definition *d, const string &path, definition *owner) {
+      if (!d or names.find(d) != names.end()) return;
+      for (prim_iter it = builtin_primitives.begin(); it != builtin_primitives.end(); ++it)
+        if (it->second == d) return;
+      names[d] = path, owners[d] = owner;
+      if (dynamic_cast<definition_scope*>(d) and !dynamic_cast<definition_template*>(d))
+        owner = d;
+      vector<pair<string, definition*> > owned;
+      owned_by(d, owned);
+      for (size_t i = 0; i < owned.size(); ++i)
+        name_all(owned[i].second, path + "/" + owned[i].first, owner);
+    }
+    /// Everything a definition owns, labeled; labels of things kept in maps keyed by pointer are
+    /// their descriptions, so that they come out the same in either context.
+    void owned_by(definition *d, vector<pair<string, definition*> > &owned) {
+      char buf[32];
+      if (definition_template *t = dynamic_cast<definition_template*>(d)) {
+        owned.push_back(make_pair("def", t->def));
+        for (size_t i = 0; i < t->params.size(); ++i)
+          sprintf(buf, "param%u", unsigned(i)), owned.push_back(make_pair(string(buf), t->params[i]));
+        for (definition_template::speciter it = t->specializations.begin(); it != t->specializations.end(); ++it)
+          owned.push_back(make_pair("spec<" + label(it->first) + ">", (definition*)it->second));
+        for (definition_template::institer it = t->instantiations.begin(); it != t->instantiations.end(); ++it)
+          owned.push_back(make_pair("inst<" + label(it->first) + ">", it->second));
+        unsigned dep = 0;
+        for (definition_template::depiter it = t->dependents.begin(); it != t->dependents.end(); ++it)
+          sprintf(buf, "dep%u", dep++), owned.push_back(make_pair(string(buf), *it));
+      }
+      else if (definition_function *f = dynamic_cast<definition_function*>(d)) {
+        for (definition_function::overload_iter it = f->overloads.begin(); it != f->overloads.end(); ++it)
+          if (it->second != f)
+            owned.push_back(make_pair("overload<" + label(it->first) + ">", (definition*)it->second));
+        for (size_t i = 0; i < f->template_overloads.size(); ++i)
+          sprintf(buf, "tover%u", unsigned(i)), owned.push_back(make_pair(string(buf), (definition*)f->template_overloads[i]));
+      }
+      else if (definition_scope *s = dynamic_cast<definition_scope*>(d)) {
+        for (definition_scope::defiter it = s->members.begin(); it != s->members.end(); ++it)
+          owned.push_back(make_pair(it->first, it->second));
+        if (definition_tempscope *ts = dynamic_cast<definition_tempscope*>(d))
+          owned.push_back(make_pair("source", ts->source));
+      }
+      sort(owned.begin(), owned.end());
+    }
+    /// A description of template arguments or of a function's parameters which refers to
+    /// nothing by pointer; definitions are given by their qualified names.
+    static string label(const arg_key &ck) {
+      arg_key &k = const_cast<arg_key&>(ck);
+      string res;
+      char buf[32];
+      for (arg_key::node *n = k.begin(); n != k.end(); ++n) {
+        if (n != k.begin()) res += ", ";
+        if (n->type == arg_key::AKT_FULLTYPE) {
+          sprintf(buf, " %08X", n->ft().flags);
+          res += qualified(n->ft().def) + " " + n->ft().refs.toString() + buf;
+        }
+        else if (n->type == arg_key::AKT_VALUE)
+          res += const_cast<value&>(n->val()).toString();
+      }
+      return res;
+    }
+    static string qualified(definition *d) {
+      if (!d) return "<null>";
+      if (d == &arg_key::abstract) return "<abstract>";
+      string res = d->name;
+      for (definition *p = d->parent; p; p = p->parent)
+        res = p->name + "::" + res;
+      return res;
+    }
+
+    /// How a definition refers to another.
+    string ref(definition *d) {
+      if (!d) return "<null>";
+      if (d == &arg_key::abstract) return "<abstract>";
+      if (d == builtin->get_global()) return "<builtin global>";
+      for (prim_iter it = builtin_primitives.begin(); it != builtin_primitives.end(); ++it)
+        if (it->second == d) return "<primitive " + it->first + ">";
+      map<definition*, string>::iterator n = names.find(d);
+      return n == names.end()? "<unowned " + d->name + ">" : n->second;
+    }
+    /// Referencers as the cache keeps them: of default arguments, only that they exist.
+    string refs(const ref_stack &rs) {
+      string res = rs.name;
+      char buf[32];
+      for (ref_stack::iterator it = rs.begin(); it; ++it) {
+        sprintf(buf, " %d", int(it->type));
+        res += buf;
+        if (it->type == ref_stack::RT_ARRAYBOUND)
+          sprintf(buf, "[%lu]", (unsigned long)((ref_stack::node_array*)*it)->bound), res += buf;
+        else if (it->type == ref_stack::RT_FUNCTION) {
+          const ref_stack::parameter_ct &ps = ((ref_stack::node_func*)*it)->params;
+          for (size_t i = 0; i < ps.size(); ++i)
+            res += " (" + ref(ps[i].def) + " " + refs(ps[i].refs) + (ps[i].variadic? " ..." : "") + (ps[i].default_value? " =" : "") + ")";
+        }
+      }
+      return res;
+    }
+
+    /// Every field the cache keeps of one definition.
+    string describe(definition *d) {
+      char buf[64];
+      sprintf(buf, "%08X ", d->flags);
+      // A scope the parser has since left is cached as the one owning d
+      const bool parent_known = !d->parent or d->parent == builtin->get_global() or names.find(d->parent) != names.end();
+      string res = names[d] + ": " + buf + "`" + d->name + "' in " + ref(parent_known? d->parent : owners[d]);
+      if (definition_typed *t = dynamic_cast<definition_typed*>(d)) {
+        sprintf(buf, " %08X", t->modifiers);
+        res += " type " + ref(t->type) + " " + refs(t->referencers) + buf;
+      }
+      if (definition_valued *v = dynamic_cast<definition_valued*>(d))
+        res += " = " + v->value_of.toString();
+      if (definition_enum *e = dynamic_cast<definition_enum*>(d))
+        for (definition_scope::defiter it = e->constants.begin(); it != e->constants.end(); ++it)
+          res += " " + it->first + "=" + ref(it->second);
+      if (definition_function *f = dynamic_cast<definition_function*>(d)) {
+        sprintf(buf, " %u overloads", unsigned(f->overloads.size()));
+        res += buf;
+      }
+      if (definition_scope *s = dynamic_cast<definition_scope*>(d)) {
+        for (definition_scope::defiter it = s->using_general.begin(); it != s->using_general.end(); ++it)
+          res += " using " + it->first + "=" + ref(it->second);
+        for (definition_scope::using_node *n = s->get_using_front(); n; n = n->next)
+          res += " using namespace " + ref(n->use);
+      }
+      if (definition_class *c = dynamic_cast<definition_class*>(d)) {
+        for (size_t i = 0; i < c->ancestors.size(); ++i)
+          sprintf(buf, " ancestor %u ", c->ancestors[i].protection), res += buf + ref(c->ancestors[i].def);
+      }
+      if (definition_atomic *a = dynamic_cast<definition_atomic*>(d))
+        sprintf(buf, " size %lu", (unsigned long)a->sz), res += buf;
+      if (definition_tempscope *ts = dynamic_cast<definition_tempscope*>(d))
+        res += " source " + ref(ts->source);
+      return res;
+    }
+
+    string describe_all() {
+      vector<string> lines;
+      for (map<definition*, string>::iterator it = names.begin(); it != names.end(); ++it)
+        lines.push_back(describe(it->first));
+      sort(lines.begin(), lines.end());
+      string res;
+      for (size_t i = 0; i < lines.size(); ++i)
+        res += lines[i] + "\n";
+      return res;
+    }
+
+    describer(context &ct): global(ct.get_global()) { name_all(global, "", NULL); }
+  };
+
+  string describe_macros(context &ct) {
+    string res;
+    const macro_map &m = ct.get_macros();
+    for (macro_iter_c it = m.begin(); it != m.end(); ++it)
+      res += it->first + ": " + it->second->toString() + "\n";
+    return res;
+  }
+
+  /// Print the first line in which two descriptions differ.
+  void report_difference(const string &what, const string &a, const string &b) {
+    size_t line = 0;
+    while (line < a.length() and line < b.length() and a[line] == b[line]) ++line;
+    line = a.rfind('\n', line) + 1;
+    cout << "Cache round trip changed the " << what << ":" << endl
+         << "  parsed: " << a.substr(line, a.find('\n', line) - line) << endl
+         << "  cached: " << b.substr(line, b.find('\n', line) - line) << endl;
+  }
+}
+
+/// Returns whether the cache gave back what was parsed.
+bool test_cache_round_trip() {
+  context parsed;
+  llreader code(string(cache_test_code), true);
+  if (parsed.parse_C_stream(code, "cache_test.cc")) {
+    cout << "Cache round trip: the test code failed to parse" << endl;
+    return false;
+  }
+
+  string cache;
+  parsed.write_cache(cache);
+  context cached;
+  if (!cached.read_cache(cache.data(), cache.length())) {
+    cout << "Cache round trip: the cache written was not read back" << endl;
+    return false;
+  }
+
+  bool ok = true;
+  const string parsed_tree = describer(parsed).describe_all(), cached_tree = describer(cached).describe_all();
+  if (parsed_tree != cached_tree)
+    report_difference("definitions", parsed_tree, cached_tree), ok = false;
+  else if (parsed_tree.find("spec<") == string::npos)
+    cout << "Cache round trip: the test code made no template specializations" << endl, ok = false;
+
+  const string parsed_macros = describe_macros(parsed), cached_macros = describe_macros(cached);
+  if (parsed_macros != cached_macros)
+    report_difference("macros", parsed_macros, cached_macros), ok = false;
+
+  // A cache cut short anywhere must be refused, leaving the context as it was.
+  for (size_t n = 0; n < cache.length(); n += 1 + n / 16) {
+    context partial;
+    if (partial.read_cache(cache.data(), n)) {
+      cout << "Cache round trip: a cache cut to " << n << " of " << cache.length() << " bytes was accepted" << endl;
+      ok = false;
+      break;
+    }
+  }
+
+  cout << "Cache round trip: " << (ok? "passed" : "FAILED") << " (" << cache.length() << " bytes)" << endl;
+  return ok;
+}
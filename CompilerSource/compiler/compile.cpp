@@ -60,6 +60,9 @@ using namespace std;
 #include "gcc_interface/gcc_backend.h"
 
 #include "general/bettersystem.h"
+#include "general/estring.h"
+#include "general/parallel.h"
+#include "reshandlers/rescache.h"
 #include "event_reader/event_parser.h"
 
 #include "languages/lang_CPP.h"
@@ -108,7 +111,7 @@ inline string fc(const char* fn)
 string toUpper(string x) { string res = x; for (size_t i = 0; i < res.length(); i++) res[i] = res[i] >= 'a' and res[i] <= 'z' ? res[i] + 'A' - 'a' : res[i]; return res; }
 void clear_ide_editables()
 {
-  ofstream wto;
+  ofstream_if_changed wto;
   string f2comp = fc((makedir + "API_Switchboard.h").c_str());
   string f2write = license;
     string inc = "/include.h\"\n";
@@ -152,13 +155,72 @@ void clear_ide_editables()
     wto << "#define PRIMDEPTH2 6\n";
     wto << "#define AUTOLOCALS 0\n";
     wto << "#define MODE3DVARS 0\n";
-    wto << "void ABORT_ON_ALL_ERRORS() { }\n";
+    wto << "#ifdef SHELLMAIN_DEFINITIONS\n";
+    wto << "void ABORT_ON_ALL_ERRORS() {  }\n";
+    wto << "#endif\n";
     wto << '\n';
   wto.close();
 }
 
 #include "System/builtins.h"
 
+// A key over everything the module writers put into the resource block, and over the build
+// of the compiler, whose Makefile rebuilds this file whenever a writer changes.
+static string resource_block_key(const EnigmaStruct *es)
+{
+  rescache::hasher hash;
+  const char *const built = __DATE__ " " __TIME__;
+  hash.add(built, strlen(built));
+
+  hash.add(es->spriteCount);
+  for (int i = 0; i < es->spriteCount; i++) {
+    const Sprite &spr = es->sprites[i];
+    hash.add(spr.id).add(spr.originX).add(spr.originY).add(spr.shape);
+    hash.add(spr.bbTop).add(spr.bbBottom).add(spr.bbLeft).add(spr.bbRight);
+    hash.add(spr.subImageCount);
+    for (int ii = 0; ii < spr.subImageCount; ii++) {
+      const Image &img = spr.subImages[ii].image;
+      hash.add(img.width).add(img.height).add(img.dataSize).add(img.data, img.dataSize);
+    }
+  }
+
+  hash.add(es->soundCount);
+  for (int i = 0; i < es->soundCount; i++)
+    hash.add(es->sounds[i].id).add(es->sounds[i].size).add(es->sounds[i].data, es->sounds[i].size);
+
+  hash.add(es->backgroundCount);
+  for (int i = 0; i < es->backgroundCount; i++) {
+    const Background &bkg = es->backgrounds[i];
+    hash.add(bkg.id).add(bkg.transparent).add(bkg.smoothEdges).add(bkg.preload).add(bkg.useAsTileset);
+    hash.add(bkg.tileWidth).add(bkg.tileHeight).add(bkg.hOffset).add(bkg.vOffset).add(bkg.hSep).add(bkg.vSep);
+    const Image &img = bkg.backgroundImage;
+    hash.add(img.width).add(img.height).add(img.dataSize).add(img.data, img.dataSize);
+  }
+
+  hash.add(es->fontCount);
+  for (int i = 0; i < es->fontCount; i++) {
+    const Font &font = es->fonts[i];
+    hash.add(font.id).add(font.glyphRangeCount);
+    for (int ii = 0; ii < font.glyphRangeCount; ii++) {
+      const GlyphRange &glyphRange = font.glyphRanges[ii];
+      hash.add(glyphRange.rangeMin).add(glyphRange.rangeMax);
+      for (int ig = 0; ig < glyphRange.rangeMax - glyphRange.rangeMin + 1; ig++) {
+        const Glyph &glyph = glyphRange.glyphs[ig];
+        hash.add(&glyph.advance, sizeof glyph.advance).add(&glyph.baseline, sizeof glyph.baseline).add(&glyph.origin, sizeof glyph.origin);
+        hash.add(glyph.width).add(glyph.height).add(glyph.data, size_t(glyph.width) * glyph.height);
+      }
+    }
+  }
+
+  hash.add(es->pathCount);
+  for (int i = 0; i < es->pathCount; i++) {
+    const Path &pth = es->paths[i];
+    hash.add(pth.id).add(pth.smooth).add(pth.closed).add(pth.precision).add(pth.pointCount);
+    hash.add(pth.points, sizeof(PathPoint) * pth.pointCount);
+  }
+  return hash.key("block");
+}
+
 // modes: 0=run, 1=debug, 2=design, 3=compile
 enum { emode_run, emode_debug, emode_design, emode_compile, emode_rebuild };
 
@@ -314,7 +376,7 @@ int lang_CPP::compile(EnigmaStruct *es, const char* exe_filename, int mode)
 
   //Export resources to each file.
 
-  ofstream wto;
+  ofstream_if_changed wto;
   idpr("Outputting Resources in Various Places...",10);
 
   // FIRST FILE
@@ -358,7 +420,9 @@ int lang_CPP::compile(EnigmaStruct *es, const char* exe_filename, int mode)
     wto << "#define PRIMDEPTH2 6\n";
     wto << "#define AUTOLOCALS 0\n";
     wto << "#define MODE3DVARS 0\n";
+    wto << "#ifdef SHELLMAIN_DEFINITIONS\n";
     wto << "void ABORT_ON_ALL_ERRORS() { " << (false?"game_end();":"") << " }\n";
+    wto << "#endif\n";
     wto << '\n';
   wto.close();
 
@@ -397,7 +461,7 @@ int lang_CPP::compile(EnigmaStruct *es, const char* exe_filename, int mode)
     wto << license;
 
 
-stringstream ss;
+stringstream ss, defs; // Names go in every game source; the definitions only in SHELLmain.cpp
 
     max = 0;
     wto << "namespace enigma_user {\nenum //object names\n{\n";
@@ -405,10 +469,11 @@ stringstream ss;
       if (i->first >= max) max = i->first + 1;
       wto << "  " << i->second->name << " = " << i->first << ",\n";
       ss << "    case " << i->first << ": return \"" << i->second->name << "\"; break;\n";
-    } wto << "};\n}\nnamespace enigma { size_t object_idmax = " << max << "; }\n\n";
+    } wto << "};\n}\n\n";
+    defs << "namespace enigma { size_t object_idmax = " << max << "; }\n\n";
 
-    wto << "namespace enigma_user {\nstring object_get_name(int i) {\n switch (i) {\n";
-     wto << ss.str() << " default: return \"<undefined>\";}};}\n\n";
+    defs << "namespace enigma_user {\nstring object_get_name(int i) {\n switch (i) {\n";
+     defs << ss.str() << " default: return \"<undefined>\";}};}\n\n";
      ss.str( "" );
 
     max = 0;
@@ -417,10 +482,11 @@ stringstream ss;
       if (es->sprites[i].id >= max) max = es->sprites[i].id + 1;
       wto << "  " << es->sprites[i].name << " = " << es->sprites[i].id << ",\n";
       ss << "    case " << es->sprites[i].id << ": return \"" << es->sprites[i].name << "\"; break;\n";
-    } wto << "};}\nnamespace enigma { size_t sprite_idmax = " << max << "; }\n\n";
+    } wto << "};}\n\n";
+    defs << "namespace enigma { size_t sprite_idmax = " << max << "; }\n\n";
 
-     wto << "namespace enigma_user {\nstring sprite_get_name(int i) {\n switch (i) {\n";
-     wto << ss.str() << " default: return \"<undefined>\";}};}\n\n";
+     defs << "namespace enigma_user {\nstring sprite_get_name(int i) {\n switch (i) {\n";
+     defs << ss.str() << " default: return \"<undefined>\";}};}\n\n";
      ss.str( "" );
 
     max = 0;
@@ -429,10 +495,11 @@ stringstream ss;
       if (es->backgrounds[i].id >= max) max = es->backgrounds[i].id + 1;
       wto << "  " << es->backgrounds[i].name << " = " << es->backgrounds[i].id << ",\n";
       ss << "    case " << es->backgrounds[i].id << ": return \"" << es->backgrounds[i].name << "\"; break;\n";
-    } wto << "};}\nnamespace enigma { size_t background_idmax = " << max << "; }\n\n";
+    } wto << "};}\n\n";
+    defs << "namespace enigma { size_t background_idmax = " << max << "; }\n\n";
 
-     wto << "namespace enigma_user {\nstring background_get_name(int i) {\n switch (i) {\n";
-     wto << ss.str() << " default: return \"<undefined>\";}};}\n\n";
+     defs << "namespace enigma_user {\nstring background_get_name(int i) {\n switch (i) {\n";
+     defs << ss.str() << " default: return \"<undefined>\";}};}\n\n";
      ss.str( "" );
 
     max = 0;
@@ -441,10 +508,11 @@ stringstream ss;
       if (es->fonts[i].id >= max) max = es->fonts[i].id + 1;
       wto << "  " << es->fonts[i].name << " = " << es->fonts[i].id << ",\n";
       ss << "    case " << es->fonts[i].id << ": return \"" << es->fonts[i].name << "\"; break;\n";
-    } wto << "};}\nnamespace enigma { size_t font_idmax = " << max << "; }\n\n";
+    } wto << "};}\n\n";
+    defs << "namespace enigma { size_t font_idmax = " << max << "; }\n\n";
 
-     wto << "namespace enigma_user {\nstring font_get_name(int i) {\n switch (i) {\n";
-     wto << ss.str() << " default: return \"<undefined>\";}};}\n\n";
+     defs << "namespace enigma_user {\nstring font_get_name(int i) {\n switch (i) {\n";
+     defs << ss.str() << " default: return \"<undefined>\";}};}\n\n";
      ss.str( "" );
 
     max = 0;
@@ -453,10 +521,11 @@ stringstream ss;
 	    if (es->timelines[i].id >= max) max = es->timelines[i].id + 1;
         wto << "  " << es->timelines[i].name << " = " << es->timelines[i].id << ",\n";
         ss << "    case " << es->timelines[i].id << ": return \"" << es->timelines[i].name << "\"; break;\n";
-	} wto << "};}\nnamespace enigma { size_t timeline_idmax = " << max << "; }\n\n";
+	} wto << "};}\n\n";
+    defs << "namespace enigma { size_t timeline_idmax = " << max << "; }\n\n";
 
-wto << "namespace enigma_user {\nstring timeline_get_name(int i) {\n switch (i) {\n";
-     wto << ss.str() << " default: return \"<undefined>\";}};}\n\n";
+defs << "namespace enigma_user {\nstring timeline_get_name(int i) {\n switch (i) {\n";
+     defs << ss.str() << " default: return \"<undefined>\";}};}\n\n";
      ss.str( "" );
 
     max = 0;
@@ -465,10 +534,11 @@ wto << "namespace enigma_user {\nstring timeline_get_name(int i) {\n switch (i)
 	    if (es->paths[i].id >= max) max = es->paths[i].id + 1;
         wto << "  " << es->paths[i].name << " = " << es->paths[i].id << ",\n";
         ss << "    case " << es->paths[i].id << ": return \"" << es->paths[i].name << "\"; break;\n";
-	} wto << "};}\nnamespace enigma { size_t path_idmax = " << max << "; }\n\n";
+	} wto << "};}\n\n";
+    defs << "namespace enigma { size_t path_idmax = " << max << "; }\n\n";
 
-wto << "namespace enigma_user {\nstring path_get_name(int i) {\n switch (i) {\n";
-     wto << ss.str() << " default: return \"<undefined>\";}};}\n\n";
+defs << "namespace enigma_user {\nstring path_get_name(int i) {\n switch (i) {\n";
+     defs << ss.str() << " default: return \"<undefined>\";}};}\n\n";
      ss.str( "" );
 
     max = 0;
@@ -477,10 +547,11 @@ wto << "namespace enigma_user {\nstring path_get_name(int i) {\n switch (i) {\n"
       if (es->sounds[i].id >= max) max = es->sounds[i].id + 1;
       wto << "  " << es->sounds[i].name << " = " << es->sounds[i].id << ",\n";
       ss << "    case " << es->sounds[i].id << ": return \"" << es->sounds[i].name << "\"; break;\n";
-    } wto << "};}\nnamespace enigma { size_t sound_idmax = " <<max << "; }\n\n";
+    } wto << "};}\n\n";
+    defs << "namespace enigma { size_t sound_idmax = " << max << "; }\n\n";
 
-wto << "namespace enigma_user {\nstring sound_get_name(int i) {\n switch (i) {\n";
-     wto << ss.str() << " default: return \"<undefined>\";}};}\n\n";
+defs << "namespace enigma_user {\nstring sound_get_name(int i) {\n switch (i) {\n";
+     defs << ss.str() << " default: return \"<undefined>\";}};}\n\n";
      ss.str( "" );
 
     max = 0;
@@ -489,10 +560,11 @@ wto << "namespace enigma_user {\nstring sound_get_name(int i) {\n switch (i) {\n
       if (es->scripts[i].id >= max) max = es->scripts[i].id + 1;
       wto << "  " << es->scripts[i].name << " = " << es->scripts[i].id << ",\n";
       ss << "    case " << es->scripts[i].id << ": return \"" << es->scripts[i].name << "\"; break;\n";
-    } wto << "};}\nnamespace enigma { size_t script_idmax = " <<max << "; }\n\n";
+    } wto << "};}\n\n";
+    defs << "namespace enigma { size_t script_idmax = " << max << "; }\n\n";
 
-wto << "namespace enigma_user {\nstring script_get_name(int i) {\n switch (i) {\n";
-     wto << ss.str() << " default: return \"<undefined>\";}};}\n\n";
+defs << "namespace enigma_user {\nstring script_get_name(int i) {\n switch (i) {\n";
+     defs << ss.str() << " default: return \"<undefined>\";}};}\n\n";
      ss.str( "" );
 
     max = 0;
@@ -501,10 +573,11 @@ wto << "namespace enigma_user {\nstring script_get_name(int i) {\n switch (i) {\
       if (es->shaders[i].id >= max) max = es->shaders[i].id + 1;
       wto << "  " << es->shaders[i].name << " = " << es->shaders[i].id << ",\n";
       ss << "    case " << es->shaders[i].id << ": return \"" << es->shaders[i].name << "\"; break;\n";
-    } wto << "};}\nnamespace enigma { size_t shader_idmax = " <<max << "; }\n\n";
+    } wto << "};}\n\n";
+    defs << "namespace enigma { size_t shader_idmax = " << max << "; }\n\n";
 
-wto << "namespace enigma_user {\nstring shader_get_name(int i) {\n switch (i) {\n";
-     wto << ss.str() << " default: return \"<undefined>\";}};}\n\n";
+defs << "namespace enigma_user {\nstring shader_get_name(int i) {\n switch (i) {\n";
+     defs << ss.str() << " default: return \"<undefined>\";}};}\n\n";
      ss.str( "" );
 	 
     max = 0;
@@ -513,7 +586,10 @@ wto << "namespace enigma_user {\nstring shader_get_name(int i) {\n switch (i) {\
       if (es->rooms[i].id >= max) max = es->rooms[i].id + 1;
       wto << "  " << es->rooms[i].name << " = " << es->rooms[i].id << ",\n";
     }
-    wto << "};}\nnamespace enigma { size_t room_idmax = " <<max << "; }\n\n";
+    wto << "};}\n\n";
+    defs << "namespace enigma { size_t room_idmax = " << max << "; }\n\n";
+
+    wto << "#ifdef SHELLMAIN_DEFINITIONS\n" << defs.str() << "#endif\n";
   wto.close();
 
   idpr("Performing Secondary Parsing and Writing Globals",25);
@@ -591,6 +667,8 @@ wto << "namespace enigma_user {\nstring shader_get_name(int i) {\n switch (i) {\
 
   string make = "Game ";
 
+  // The game's objects and scripts are separate sources now, so build them side by side
+  make += "-j" + tostring(parallel_thread_count()) + " ";
   make += "WORKDIR=\"" + makedir + "\" ";
   make += mode == emode_debug? "GMODE=Debug ": mode == emode_design? "GMODE=Design ": mode == emode_compile?"GMODE=Compile ": "GMODE=Run ";
   make += "GRAPHICS=" + extensions::targetAPI.graphicsSys + " ";
@@ -668,62 +746,77 @@ wto << "namespace enigma_user {\nstring shader_get_name(int i) {\n switch (i) {\
 
   FILE *gameModule;
   int resourceblock_start = 0;
+  string resname, block_key; // A separate resource file is left alone if its inputs are unchanged
+  if (extensions::targetOS.resfile != "$exe")
+  {
+    resname = extensions::targetOS.resfile;
+    for (size_t p = resname.find("$exe"); p != string::npos; p = resname.find("$game"))
+      resname.replace(p,4,gameFname);
+    block_key = resource_block_key(es);
+  }
   cout << "`" << extensions::targetOS.resfile << "` == '$exe': " << (extensions::targetOS.resfile == "$exe"?"true":"FALSE") << endl;
-  if (extensions::targetOS.resfile == "$exe")
+  if (!resname.empty() and rescache::file_matches(resname, block_key))
+    edbg << "Resources unchanged; leaving `" << resname << "' as it was." << flushl;
+  else
   {
-    gameModule = fopen(gameFname.c_str(),"ab");
-    if (!gameModule) {
-      user << "Failed to append resources to the game. Did compile actually succeed?" << flushl;
-      idpr("Failed to add resources.",-1); return 12;
-    }
+    if (extensions::targetOS.resfile == "$exe")
+    {
+      gameModule = fopen(gameFname.c_str(),"ab");
+      if (!gameModule) {
+        user << "Failed to append resources to the game. Did compile actually succeed?" << flushl;
+        idpr("Failed to add resources.",-1); return 12;
+      }
 
-    fseek(gameModule,0,SEEK_END); //necessary on Windows for no reason.
-    resourceblock_start = ftell(gameModule);
+      fseek(gameModule,0,SEEK_END); //necessary on Windows for no reason.
+      resourceblock_start = ftell(gameModule);
 
-    if (resourceblock_start < 128) {
-      user << "Compiled game is clearly not a working module; cannot continue" << flushl;
-      idpr("Failed to add resources.",-1); return 13;
+      if (resourceblock_start < 128) {
+        user << "Compiled game is clearly not a working module; cannot continue" << flushl;
+        idpr("Failed to add resources.",-1); return 13;
+      }
     }
-  }
-  else
-  {
-    string resname = extensions::targetOS.resfile;
-    for (size_t p = resname.find("$exe"); p != string::npos; p = resname.find("$game"))
-      resname.replace(p,4,gameFname);
-    gameModule = fopen(resname.c_str(),"wb");
-    if (!gameModule) {
-      user << "Failed to write resources to compiler-specified file, `" << resname << "`. Write permissions to valid path?" << flushl;
-      idpr("Failed to write resources.",-1); return 12;
+    else
+    {
+      rescache::note_file(resname, ""); // Until it is whole again
+      gameModule = fopen(resname.c_str(),"wb");
+      if (!gameModule) {
+        user << "Failed to write resources to compiler-specified file, `" << resname << "`. Write permissions to valid path?" << flushl;
+        idpr("Failed to write resources.",-1); return 12;
+      }
     }
-  }
 
-  // Start by setting off our location with a DWord of NULLs
-  fwrite("\0\0\0",1,4,gameModule);
+    // Start by setting off our location with a DWord of NULLs
+    fwrite("\0\0\0",1,4,gameModule);
 
-  idpr("Adding Sprites",90);
+    idpr("Adding Sprites",90);
 
-  res = current_language->module_write_sprites(es, gameModule);
-  irrr();
+    res = current_language->module_write_sprites(es, gameModule);
+    irrr();
 
-  edbg << "Finalized sprites." << flushl;
-  idpr("Adding Sounds",93);
+    edbg << "Finalized sprites." << flushl;
+    idpr("Adding Sounds",93);
 
-  current_language->module_write_sounds(es,gameModule);
+    current_language->module_write_sounds(es,gameModule);
 
-  current_language->module_write_backgrounds(es,gameModule);
+    current_language->module_write_backgrounds(es,gameModule);
 
-  current_language->module_write_fonts(es,gameModule);
+    current_language->module_write_fonts(es,gameModule);
 
-  current_language->module_write_paths(es,gameModule);
+    current_language->module_write_paths(es,gameModule);
 
-  // Tell where the resources start
-  fwrite("\0\0\0\0res0",8,1,gameModule);
-  fwrite(&resourceblock_start,4,1,gameModule);
+    // Drop cached blobs of resources which have since changed or gone
+    rescache::prune();
 
-  // Close the game module; we're done adding resources
-  idpr("Closing game module and running if requested.",99);
-  edbg << "Closing game module and running if requested." << flushl;
-  fclose(gameModule);
+    // Tell where the resources start
+    fwrite("\0\0\0\0res0",8,1,gameModule);
+    fwrite(&resourceblock_start,4,1,gameModule);
+
+    // Close the game module; we're done adding resources
+    idpr("Closing game module and running if requested.",99);
+    edbg << "Closing game module and running if requested." << flushl;
+    if (!fclose(gameModule) and !resname.empty())
+      rescache::note_file(resname, block_key);
+  }
 
   // Run the game if requested
   if (mode == emode_run or mode == emode_debug or mode == emode_design)
@@ -27,10 +27,15 @@
 
 #include <map>
 #include <string>
+#include <cstdio>
+#include <cctype>
+#include <vector>
+#include <algorithm>
 using namespace std;
 
 #include "parser/object_storage.h"
 #include "compile_organization.h"
+#include "compile_common.h"
 
 namespace used_funcs
 {
@@ -42,6 +47,215 @@ namespace used_funcs
 }
 map<string,parsed_script*> scr_lookup;
 
+void ofstream_if_changed::open(const char* fn, ios_base::openmode)
+{
+  close();
+  filename = fn;
+  str("");
+  clear();
+}
+
+void ofstream_if_changed::close()
+{
+  if (filename.empty())
+    return;
+  const string contents = str();
+  string old;
+  bool existed = false;
+  if (FILE *f = fopen(filename.c_str(), "rb")) {
+    existed = true;
+    char buf[16384];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, f)))
+      old.append(buf, n);
+    fclose(f);
+  }
+  if (!existed || old != contents)
+    if (FILE *f = fopen(filename.c_str(), "wb")) {
+      fwrite(contents.data(), 1, contents.length(), f);
+      fclose(f);
+    }
+  filename.clear();
+}
+
+// Splits C++ into tokens good enough to tell declarations from definitions: names and numbers
+// whole, punctuation one character at a time, each literal as a lone quote. Comments and
+// preprocessor lines are dropped.
+static void definitions_tokenize(const string &code, vector<string> &tokens)
+{
+  const size_t n = code.length();
+  bool line_start = true;
+  for (size_t i = 0; i < n; )
+  {
+    const char c = code[i];
+    if (c == '\n') { line_start = true; i++; continue; }
+    if (isspace(c)) { i++; continue; }
+    if (c == '#' and line_start) {
+      while (i < n and code[i] != '\n')
+        i += code[i] == '\\' ? 2 : 1;
+      continue;
+    }
+    line_start = false;
+    if (c == '/' and i + 1 < n and code[i+1] == '/') {
+      while (i < n and code[i] != '\n') i++;
+      continue;
+    }
+    if (c == '/' and i + 1 < n and code[i+1] == '*') {
+      const size_t e = code.find("*/", i + 2);
+      i = e == string::npos ? n : e + 2;
+      continue;
+    }
+    if (c == '"' or c == '\'') {
+      for (i++; i < n and code[i] != c; i++)
+        if (code[i] == '\\') i++;
+      i++, tokens.push_back("\"");
+      continue;
+    }
+    size_t e = i + 1;
+    if (isalnum(c) or c == '_' or c == '$')
+      while (e < n and (isalnum(code[e]) or code[e] == '_' or code[e] == '$' or (isdigit(c) and code[e] == '.')))
+        e++;
+    tokens.push_back(code.substr(i, e - i));
+    i = e;
+  }
+}
+
+static bool has_token(const vector<string> &decl, const char *tk) {
+  return find(decl.begin(), decl.end(), tk) != decl.end();
+}
+
+// Whether the object a declaration names is itself const, as in `const int x' or
+// `const char *const x', rather than only what it points to. Looks no further than the
+// declarator's name, so the parameters of a function pointer don't count.
+static bool top_level_const(const vector<string> &decl)
+{
+  bool is_const = false;
+  for (size_t i = 0; i < decl.size(); i++) {
+    const string &t = decl[i];
+    if (t == "(" or t == "[" or t == "=")
+      break;
+    if (t == "*" or t == "&")
+      is_const = false;
+    else if (t == "const")
+      is_const = true;
+  }
+  return is_const;
+}
+
+// Whether a declaration ending in a semicolon defines a variable or function with external
+// linkage, or static storage each unit would get its own copy of. `assigned' means it has an
+// initializer. Leans toward yes wherever it can't tell.
+static bool declaration_defines(const vector<string> &decl, bool assigned)
+{
+  if (decl.empty())
+    return false;
+  const string &first = decl[0];
+  if (first == "typedef" or first == "using" or first == "static_assert" or first == "friend")
+    return false;
+  if (first == "template") // An explicit specialization is an ordinary function
+    return decl.size() > 2 and decl[1] == "<" and decl[2] == ">";
+  if (has_token(decl, "inline") or has_token(decl, "constexpr"))
+    return false;
+  if (first == "extern")
+    return assigned;
+  if (decl.back() == "{}" and !assigned) // A class or enum defined without declaring anything of its type
+    return false;
+  if ((first == "class" or first == "struct" or first == "union" or first == "enum") and decl.size() == 2)
+    return false;
+  if (top_level_const(decl)) // Namespace scope const is internal
+    return false;
+  if (assigned or has_token(decl, "static"))
+    return true;
+  
+  // Tell a function's prototype from a variable, including one initialized in parentheses or
+  // one pointing to a function.
+  const vector<string>::const_iterator paren = find(decl.begin(), decl.end(), "(");
+  if (paren == decl.end())
+    return true;
+  if (paren + 1 != decl.end() and (paren[1] == "*" or paren[1] == "&"))
+    return true;
+  for (vector<string>::const_iterator it = paren; it != decl.end() and *it != ")"; ++it) {
+    if (*it == "=") // A default argument
+      return false;
+    if (*it == "\"" or isdigit((*it)[0]) or *it == "-" or *it == "{}")
+      return true;
+  }
+  return false;
+}
+
+// Scans the declarations of one scope, through its closing brace. True on finding anything
+// which would be defined once in each unit including it.
+static bool scope_defines(const vector<string> &tk, size_t &i)
+{
+  while (i < tk.size())
+  {
+    if (tk[i] == "}")
+      return ++i, false;
+    
+    vector<string> decl;
+    bool assigned = false;
+    int parens = 0;
+    for (;;)
+    {
+      if (i >= tk.size())
+        return declaration_defines(decl, assigned);
+      const string &t = tk[i];
+      if (t == ";") {
+        i++;
+        if (declaration_defines(decl, assigned))
+          return true;
+        break;
+      }
+      if (t == "{")
+      {
+        i++;
+        if (!decl.empty() and decl[0] == "namespace") {
+          if (decl.size() == 1) // Each unit gets its own anonymous namespace
+            return true;
+          if (scope_defines(tk, i)) return true;
+          break;
+        }
+        if (decl.size() == 2 and decl[0] == "extern" and decl[1] == "\"") { // extern "C" { ... }
+          if (scope_defines(tk, i)) return true;
+          break;
+        }
+        
+        const bool type_body = !has_token(decl, "(") and (has_token(decl, "class") or has_token(decl, "struct")
+                                                       or has_token(decl, "union") or has_token(decl, "enum"));
+        if (!assigned and !type_body and parens == 0) {
+          // A function's body, or a variable initialized in braces
+          if (!(has_token(decl, "inline") or has_token(decl, "constexpr")
+             or (!decl.empty() and decl[0] == "template" and !(decl.size() > 2 and decl[1] == "<" and decl[2] == ">"))))
+            return true;
+        }
+        for (int depth = 1; i < tk.size() and depth; i++)
+          depth += (tk[i] == "{") - (tk[i] == "}");
+        if (!assigned and !type_body and parens == 0)
+          break; // Function bodies end their declaration
+        decl.push_back("{}");
+        continue;
+      }
+      if (t == "(") parens++;
+      else if (t == ")") parens--;
+      else if (t == "=" and parens == 0 and !has_token(decl, "operator"))
+        assigned = true;
+      decl.push_back(t);
+      i++;
+    }
+  }
+  return false;
+}
+
+bool definitions_define_symbols(const string &code)
+{
+  vector<string> tokens;
+  definitions_tokenize(code, tokens);
+  for (size_t i = 0; i < tokens.size(); )
+    if (scope_defines(tokens, i))
+      return true;
+  return false;
+}
+
 //string event_get_function_name(int mid, int id) // Implemented in event_reader/event_parser.cpp
 
 
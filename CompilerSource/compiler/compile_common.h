@@ -29,6 +29,7 @@
 #define _COMPILE_COMMON__H
 
 #include <map>
+#include <sstream>
 #include "compile_organization.h"
 #include "parser/object_storage.h"
 
@@ -41,6 +42,25 @@ extern std::map<string,parsed_script*> scr_lookup;
 
 extern const char* license;
 
+/// An output stream for generated files which holds what is written until it is closed, then
+/// leaves the file alone if it already says the same thing. Make can then tell which parts of
+/// the game actually changed, and rebuild only what depends on them.
+class ofstream_if_changed: public std::ostringstream
+{
+  string filename;
+ public:
+  ofstream_if_changed() {}
+  ofstream_if_changed(const char* fn, std::ios_base::openmode = std::ios_base::out): filename(fn) {}
+  ~ofstream_if_changed() { close(); }
+  void open(const char* fn, std::ios_base::openmode = std::ios_base::out);
+  void close(); ///< Write the file if its contents changed; returns silently if nothing is open.
+};
+
+/// Whether the given Definitions code defines any variable or non-inline function, rather than
+/// only declaring it. Every game source includes the Definitions, so if this is true, the game
+/// code must be compiled as a single unit instead. Errs toward true.
+bool definitions_define_symbols(const string &code);
+
 
 inline string tdefault(string t) {
   return (t != "" ? t : "var");
@@ -17,9 +17,11 @@
 **/
 
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 #include <fstream>
 #include <list>
+#include <vector>
 
 using namespace std;
 
@@ -34,169 +36,220 @@ using namespace std;
 #include "backend/ideprint.h"
 
 #include "compiler/reshandlers/rectpack.h"
+#include "compiler/reshandlers/rescache.h"
+#include "general/parallel.h"
 #include "languages/lang_CPP.h"
 
 inline void writei(int x, FILE *f) {
   fwrite(&x,4,1,f);
 }
-inline void writef(float x, FILE *f) {
-  fwrite(&x,4,1,f);
-}
 
 using namespace rect_packer;
-int lang_CPP::module_write_fonts(EnigmaStruct *es, FILE *gameModule)
-{
-  // Now we're going to add backgrounds
-  edbg << es->fontCount << " Adding Fonts to Game Module: " << flushl;
 
-  //Magic Number
-  fwrite("FNT ",4,1,gameModule);
+namespace {
+  // Each font is built on its own thread into its part of the module.
+  struct font_job {
+    EnigmaStruct *es;
+    vector< vector<unsigned char> > blobs;
+    vector<string> errors;
+    vector<char> cached; // Not vector<bool>, whose elements threads cannot set independently
+  };
 
-  //Indicate how many
-  int font_count = es->fontCount;
-  writei(font_count,gameModule);
+  inline void blob_write(vector<unsigned char> &blob, const void *data, size_t size) {
+    blob.insert(blob.end(), (const unsigned char*) data, (const unsigned char*) data + size);
+  }
+  inline void blob_writei(vector<unsigned char> &blob, int x) {
+    blob_write(blob, &x, 4);
+  }
+  inline void blob_writef(vector<unsigned char> &blob, float x) {
+    blob_write(blob, &x, 4);
+  }
 
-  // For each included font
-  for (int i = 0; i < font_count; i++)
+  inline int blob_readi(const vector<unsigned char> &blob, size_t at) {
+    int x;
+    memcpy(&x, &blob[at], 4);
+    return x;
+  }
+
+  // Whether a cached blob is laid out as build_font writes font.
+  bool font_blob_fits(const vector<unsigned char> &blob, const Font &font) {
+    if (blob.size() < 12 or blob_readi(blob, 0) != font.id) return false;
+    const int w = blob_readi(blob, 4), h = blob_readi(blob, 8);
+    if (w <= 0 or h <= 0) return false;
+    size_t at = 12 + size_t(w) * h;
+    if (at + 4 > blob.size() or memcmp(&blob[at], "done", 4)) return false;
+    at += 4;
+    for (int ii = 0; ii < font.glyphRangeCount; ii++) {
+      const GlyphRange &glyphRange = font.glyphRanges[ii];
+      const unsigned gc = glyphRange.rangeMax - glyphRange.rangeMin + 1;
+      if (at + 8 > blob.size() or blob_readi(blob, at) != glyphRange.rangeMin or unsigned(blob_readi(blob, at + 4)) != gc)
+        return false;
+      at += 8 + size_t(gc) * 36;
+    }
+    return at + 4 == blob.size() and !memcmp(&blob[at], "endf", 4);
+  }
+
+  void build_font(size_t i, void *data)
   {
-    cout << "Iterating included fonts..." << endl;
+    font_job &job = *(font_job*) data;
+    const Font &font = job.es->fonts[i];
+    vector<unsigned char> &blob = job.blobs[i];
+
+    // The font is made of its id and of every glyph's metrics and pixels.
+    rescache::hasher hash;
+    hash.add(font.id);
+    for (int ii = 0; ii < font.glyphRangeCount; ii++) {
+      const GlyphRange &glyphRange = font.glyphRanges[ii];
+      hash.add(glyphRange.rangeMin).add(glyphRange.rangeMax);
+      for (int ig = 0; ig < glyphRange.rangeMax - glyphRange.rangeMin + 1; ig++) {
+        const Glyph &glyph = glyphRange.glyphs[ig];
+        hash.add(&glyph.advance, sizeof glyph.advance).add(&glyph.baseline, sizeof glyph.baseline).add(&glyph.origin, sizeof glyph.origin);
+        hash.add(glyph.width).add(glyph.height);
+        hash.add(glyph.data, size_t(glyph.width) * glyph.height);
+      }
+    }
+    const string key = hash.key("font");
+    if (rescache::fetch(key, blob) and font_blob_fits(blob, font)) {
+      job.cached[i] = true;
+      return;
+    }
+    blob.clear();
+
     // Simple allocations and initializations
-	size_t gc = 0;
-	for (int ii = 0; ii < es->fonts[i].glyphRangeCount; ii++) {
-		GlyphRange &glyphRange = es->fonts[i].glyphRanges[ii];
-		gc += glyphRange.rangeMax - glyphRange.rangeMin + 1 + 1;
-	}
-    pvrect* boxes = new pvrect[gc];
+    size_t gc = 0;
+    for (int ii = 0; ii < font.glyphRangeCount; ii++) {
+      const GlyphRange &glyphRange = font.glyphRanges[ii];
+      gc += glyphRange.rangeMax - glyphRange.rangeMin + 1 + 1;
+    }
+    vector<pvrect> boxes(gc);
     list<unsigned int> box_order;
-    cout << "Allocated some font stuff" << endl;
-
-    /*cout << "Font name `" << es->fonts[i].name << "` uses " << es->fonts[i].fontName << endl;
-    cout << "Basic metric info: " << (es->fonts[i].rangeMax - es->fonts[i].rangeMin + 1)
-         << " glyphs from " << (int)es->fonts[i].rangeMin << " to " << (int)es->fonts[i].rangeMax
-         << ", glyph pointer is at " << es->fonts[i].glyphs << "." << endl;
-    cout << "Dump of concerned memory: " << endl;
-
-    for (size_t ii = 0; ii < sizeof(Font); ii++)
-      printf("%02X%c",((const unsigned char*)(es->fonts+i))[ii],((ii+1)%16)?' ':'\n');
-    cout << endl;
-    for (int ii = 0; ii < gc; ii++)
-    cout << "The dimensions of glyph " << ii << "are " << flush << es->fonts[i].glyphs[ii].width << "x" << es->fonts[i].glyphs[ii].height << "." << endl;
-    cout << "End of list." << endl;*/
-	
-	
 
     // Copy our glyph metrics into it
-	size_t ib = 0;
-	for (int ii = 0; ii < es->fonts[i].glyphRangeCount; ii++) {
-		GlyphRange &glyphRange = es->fonts[i].glyphRanges[ii];
-		for (int ig = 0; ig < glyphRange.rangeMax - glyphRange.rangeMin + 1; ig++) {
-			Glyph &glyph = es->fonts[i].glyphRanges[ii].glyphs[ig];
-			boxes[ib].w = glyph.width,
-			boxes[ib].h = glyph.height;
-			ib++;
-		}
-	}
-    cout << "Copied metrics" << endl;
+    size_t ib = 0;
+    for (int ii = 0; ii < font.glyphRangeCount; ii++) {
+      const GlyphRange &glyphRange = font.glyphRanges[ii];
+      for (int ig = 0; ig < glyphRange.rangeMax - glyphRange.rangeMin + 1; ig++) {
+        const Glyph &glyph = glyphRange.glyphs[ig];
+        boxes[ib].w = glyph.width,
+        boxes[ib].h = glyph.height;
+        ib++;
+      }
+    }
 
     // Sort our boxes from largest to smallest in area.
-	size_t bo = 0;
-	for (int ii = 0; ii < es->fonts[i].glyphRangeCount; ii++) {
-		GlyphRange &glyphRange = es->fonts[i].glyphRanges[ii];
-		for (int ig = 0; ig < glyphRange.rangeMax - glyphRange.rangeMin + 1; ig++) {
-			Glyph &glyph = es->fonts[i].glyphRanges[ii].glyphs[ig];
-			box_order.push_back((glyph.width * glyph.height << 8) + bo); // This reserves only eight bits for the glyph id; unicode will break a little.
-			bo++;
-		}
-	}
+    size_t bo = 0;
+    for (int ii = 0; ii < font.glyphRangeCount; ii++) {
+      const GlyphRange &glyphRange = font.glyphRanges[ii];
+      for (int ig = 0; ig < glyphRange.rangeMax - glyphRange.rangeMin + 1; ig++) {
+        const Glyph &glyph = glyphRange.glyphs[ig];
+        box_order.push_back((glyph.width * glyph.height << 8) + bo); // This reserves only eight bits for the glyph id; unicode will break a little.
+        bo++;
+      }
+    }
     box_order.sort(); // In actuality, unicode will only cause the area sort to be inaccurate, leading to an inefficient pack.
-    cout << "Sorted out some font stuff" << endl;
 
     // Now we actually pack the mothers. We'll iterate our area-sorted list backwards (largest to smallest)
     int w = 64, h = 64;
     rectpnode *rectplane = new rectpnode(0,0,w,h);
     for (list<unsigned int>::reverse_iterator ii = box_order.rbegin(); ii != box_order.rend(); )
     {
-      rectpnode *nn = rninsert(rectplane, *ii & 0xFF, boxes);
+      rectpnode *nn = rninsert(rectplane, *ii & 0xFF, &boxes[0]);
       if (nn)
-        rncopy(nn, boxes, *ii & 0xFF),
+        rncopy(nn, &boxes[0], *ii & 0xFF),
         ii++;
       else
       {
         w > h ? h <<= 1 : w <<= 1,
         rectplane = expand(rectplane, w, h);
-        printf("Expanded to %d by %d\n", w, h);
-        if (!w or !h) return -1;
+        if (!w or !h) {
+          job.errors[i] = "Font `" + string(font.name) + "' could not be packed.";
+          return;
+        }
       }
     }
 
-    cout << "Finished packing font stuff." << endl;
-
-    unsigned char bigtex[w*h];
-    for (int ii = 0; ii < w*h; ii++)
-      bigtex[ii] = 0;
-    struct { float x,y,x2,y2; } glyphtexc[gc];
-
-    cout << "Allocated a big texture. Moving font into it..." << endl;
-	size_t igt = 0;
-	for (int ii = 0; ii < es->fonts[i].glyphRangeCount; ii++) {
-		GlyphRange &glyphRange = es->fonts[i].glyphRanges[ii];
-		for (int ig = 0; ig < glyphRange.rangeMax - glyphRange.rangeMin + 1; ig++) {
-			Glyph &glyph = es->fonts[i].glyphRanges[ii].glyphs[ig];
-			
-			for (int yy = 0; yy < glyph.height; yy++)
-				for (int xx = 0; xx < glyph.width; xx++)
-					bigtex[w*(boxes[igt].y + yy) + boxes[igt].x + xx] = glyph.data[yy * glyph.width + xx];
-
-			glyphtexc[igt].x  = boxes[igt].x / double(w);
-			glyphtexc[igt].y  = boxes[igt].y / double(h);
-			glyphtexc[igt].x2 = (boxes[igt].x + glyph.width) / double(w);
-			glyphtexc[igt].y2 = (boxes[igt].y + glyph.height) / double(h);
-			igt++;
-		}
-	}
-
-    /*cout << "Populated. Debugging..." << endl;
-    FILE* sex = fopen("/home/josh/Desktop/lol.txt","wb");
-    char grades[] = " =COBM";
-    for (int yy = 0; yy < h; yy++)
-    {
-      for (int xx = 0; xx < w; xx++)
-        fputc(grades[bigtex[(yy*w+xx)]*5/255],sex);
-      fputc('\n',sex);
+    // Heap allocated, as big fonts would overflow a worker thread's stack.
+    vector<unsigned char> bigtex(size_t(w) * h, 0);
+    struct texc { float x,y,x2,y2; };
+    vector<texc> glyphtexc(gc);
+
+    size_t igt = 0;
+    for (int ii = 0; ii < font.glyphRangeCount; ii++) {
+      const GlyphRange &glyphRange = font.glyphRanges[ii];
+      for (int ig = 0; ig < glyphRange.rangeMax - glyphRange.rangeMin + 1; ig++) {
+        const Glyph &glyph = glyphRange.glyphs[ig];
+
+        for (int yy = 0; yy < glyph.height; yy++)
+          for (int xx = 0; xx < glyph.width; xx++)
+            bigtex[w*(boxes[igt].y + yy) + boxes[igt].x + xx] = glyph.data[yy * glyph.width + xx];
+
+        glyphtexc[igt].x  = boxes[igt].x / double(w);
+        glyphtexc[igt].y  = boxes[igt].y / double(h);
+        glyphtexc[igt].x2 = (boxes[igt].x + glyph.width) / double(w);
+        glyphtexc[igt].y2 = (boxes[igt].y + glyph.height) / double(h);
+        igt++;
+      }
+    }
+
+    blob_writei(blob, font.id);
+    blob_writei(blob, w), blob_writei(blob, h);
+    blob_write(blob, &bigtex[0], bigtex.size());
+    blob_write(blob, "done", 4);
+
+    igt = 0;
+    for (int ii = 0; ii < font.glyphRangeCount; ii++) {
+      const GlyphRange &glyphRange = font.glyphRanges[ii];
+      blob_writei(blob, glyphRange.rangeMin);
+      unsigned gc = glyphRange.rangeMax - glyphRange.rangeMin + 1;
+      blob_writei(blob, gc);
+      for (unsigned ig = 0; ig < gc; ig++) {
+        const Glyph &glyph = glyphRange.glyphs[ig];
+        blob_writef(blob, glyph.advance);
+        blob_writef(blob, glyph.baseline);
+        blob_writef(blob, glyph.origin);
+        blob_writei(blob, glyph.width);
+        blob_writei(blob, glyph.height);
+
+        blob_writef(blob, glyphtexc[igt].x),
+        blob_writef(blob, glyphtexc[igt].y),
+        blob_writef(blob, glyphtexc[igt].x2),
+        blob_writef(blob, glyphtexc[igt].y2);
+        igt++;
+      }
+    }
+
+    blob_write(blob, "endf", 4);
+    rescache::store(key, blob);
+  }
+}
+
+int lang_CPP::module_write_fonts(EnigmaStruct *es, FILE *gameModule)
+{
+  // Now we're going to add backgrounds
+  edbg << es->fontCount << " Adding Fonts to Game Module: " << flushl;
+
+  //Magic Number
+  fwrite("FNT ",4,1,gameModule);
+
+  //Indicate how many
+  int font_count = es->fontCount;
+  writei(font_count,gameModule);
+
+  // For each included font
+  font_job job;
+  job.es = es;
+  job.blobs.resize(font_count);
+  job.errors.resize(font_count);
+  job.cached.resize(font_count);
+  parallel_for(font_count, build_font, &job);
+  for (int i = 0; i < font_count; i++)
+  {
+    if (!job.errors[i].empty()) {
+      user << job.errors[i] << flushl;
+      return -1;
     }
-    fclose(sex);*/
-
-    writei(es->fonts[i].id,gameModule);
-    writei(w,gameModule), writei(h,gameModule);
-    fwrite(bigtex,1,w*h,gameModule);
-    fwrite("done",1,4,gameModule);
-	
-	igt = 0;
-	for (int ii = 0; ii < es->fonts[i].glyphRangeCount; ii++) {
-		GlyphRange &glyphRange = es->fonts[i].glyphRanges[ii];
-		writei(glyphRange.rangeMin, gameModule);
-		unsigned gc = glyphRange.rangeMax - glyphRange.rangeMin + 1;
-		writei(gc, gameModule);
-		for (unsigned ig = 0; ig < gc; ig++) {
-			Glyph &glyph = glyphRange.glyphs[ig];
-			writef(glyph.advance, gameModule);
-			writef(glyph.baseline,gameModule);
-			writef(glyph.origin, gameModule);
-			writei(glyph.width,  gameModule);
-			writei(glyph.height, gameModule);
-			
-			writef(glyphtexc[igt].x,  gameModule),
-			writef(glyphtexc[igt].y,  gameModule),
-			writef(glyphtexc[igt].x2, gameModule),
-			writef(glyphtexc[igt].y2, gameModule);
-			igt++;
-		}
-	}
-
-
-    fwrite("endf",1,4,gameModule);
-    cout << "Wrote all data for font " << i << endl;
-      delete[] boxes;
+    fwrite(&job.blobs[i][0], 1, job.blobs[i].size(), gameModule);
+    cout << "Wrote all data for font " << i << (job.cached[i] ? " from the resource cache" : "") << endl;
   }
 
   edbg << "Done writing fonts." << flushl;
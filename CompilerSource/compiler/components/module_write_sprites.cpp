@@ -26,8 +26,13 @@
 \********************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <algorithm>
+#include <zlib.h>
+#include <pthread.h>
 
 using namespace std;
 
@@ -41,10 +46,153 @@ using namespace std;
 
 #include "backend/ideprint.h"
 
+#include "compiler/reshandlers/rectpack.h"
+#include "compiler/reshandlers/rescache.h"
+#include "general/estring.h"
+#include "general/parallel.h"
+
 inline void writei(int x, FILE *f) {
   fwrite(&x,4,1,f);
 }
 
+using namespace rect_packer;
+
+// Subimages are packed onto shared atlas pages of at most this size, unless one is bigger on its own.
+static const int atlas_page_size = 2048;
+
+static int next_pow2(int x) {
+  int p = 1;
+  while (p < x) p <<= 1;
+  return p;
+}
+
+static void free_rectpnodes(rectpnode *n) {
+  if (!n) return;
+  free_rectpnodes(n->child[0]);
+  free_rectpnodes(n->child[1]);
+  delete n;
+}
+
+namespace {
+  struct subimage_ref { int sprite, subimage; };
+  // Orders boxes from largest to smallest, which packs tightest; ties keep their original order.
+  struct by_size_desc {
+    const pvrect *boxes;
+    by_size_desc(const pvrect *b): boxes(b) {}
+    bool operator()(int a, int b) const {
+      const int aa = boxes[a].w * boxes[a].h, ab = boxes[b].w * boxes[b].h;
+      if (aa != ab) return aa > ab;
+      if (boxes[a].h != boxes[b].h) return boxes[a].h > boxes[b].h;
+      return a < b;
+    }
+  };
+}
+
+namespace {
+  // What each thread needs to build its atlas page, and where it puts the page's part of the module.
+  struct atlas_job {
+    EnigmaStruct *es;
+    const vector<subimage_ref> &refs;
+    const vector<pvrect> &boxes;
+    const vector<int> &page_width, &page_height;
+    size_t first;
+    vector< vector<unsigned char> > blobs;
+    vector<string> errors;
+    unsigned cached;
+    pthread_mutex_t lock;
+    atlas_job(EnigmaStruct *e, const vector<subimage_ref> &r, const vector<pvrect> &b, const vector<int> &pw, const vector<int> &ph):
+      es(e), refs(r), boxes(b), page_width(pw), page_height(ph), first(0), cached(0) { pthread_mutex_init(&lock, NULL); }
+    ~atlas_job() { pthread_mutex_destroy(&lock); }
+  };
+  
+  void blob_writei(vector<unsigned char> &blob, int x) {
+    const unsigned char *const p = (const unsigned char*) &x;
+    blob.insert(blob.end(), p, p + 4);
+  }
+  int blob_readi(const vector<unsigned char> &blob, size_t at) {
+    int x;
+    memcpy(&x, &blob[at], 4);
+    return x;
+  }
+  
+  // Whether a cached blob is laid out as build_atlas_page writes a pw*ph page.
+  bool atlas_blob_fits(const vector<unsigned char> &blob, int pw, int ph) {
+    return blob.size() >= 20 and blob_readi(blob, 0) == pw and blob_readi(blob, 4) == ph
+       and size_t(unsigned(blob_readi(blob, 8))) == size_t(pw) * ph * 4
+       and size_t(unsigned(blob_readi(blob, 12))) + 20 == blob.size()
+       and blob_readi(blob, blob.size() - 4) == 0;
+  }
+  
+  void build_atlas_page(size_t j, void *data)
+  {
+    atlas_job &job = *(atlas_job*) data;
+    const size_t pg = job.first + j;
+    const int pw = job.page_width[pg], ph = job.page_height[pg];
+    const int box_count = job.boxes.size();
+    vector<unsigned char> &blob = job.blobs[j];
+    
+    // The page is made of its size and of where each of its subimages sits, and what it holds.
+    rescache::hasher hash;
+    hash.add(pw).add(ph);
+    for (int b = 0; b < box_count; b++)
+    {
+      if (job.boxes[b].placed != int(pg)) continue;
+      const Image &img = job.es->sprites[job.refs[b].sprite].subImages[job.refs[b].subimage].image;
+      hash.add(job.boxes[b].x).add(job.boxes[b].y).add(img.width).add(img.height);
+      hash.add(img.data, img.dataSize);
+    }
+    const string key = hash.key("atlas");
+    if (rescache::fetch(key, blob) and atlas_blob_fits(blob, pw, ph)) {
+      pthread_mutex_lock(&job.lock);
+      job.cached++;
+      pthread_mutex_unlock(&job.lock);
+      return;
+    }
+    blob.clear();
+    
+    vector<unsigned char> page(size_t(pw) * ph * 4, 0);
+    vector<unsigned char> pixels;
+    for (int b = 0; b < box_count; b++)
+    {
+      if (job.boxes[b].placed != int(pg)) continue;
+      const Image &img = job.es->sprites[job.refs[b].sprite].subImages[job.refs[b].subimage].image;
+      const int w = img.width, h = img.height;
+      pixels.resize(size_t(w) * h * 4);
+      uLongf unpacked = pixels.size();
+      if (uncompress(&pixels[0], &unpacked, (const Bytef*)img.data, img.dataSize) != Z_OK or unpacked != pixels.size()) {
+        job.errors[j] = "Subimage " + tostring(job.refs[b].subimage) + " of sprite `" + job.es->sprites[job.refs[b].sprite].name + "' could not be unpacked.";
+        return;
+      }
+      // Copy the subimage in with its outermost pixels repeated once around it.
+      for (int y = -1; y <= h; y++)
+      {
+        const int sy = y < 0 ? 0 : y >= h ? h - 1 : y;
+        unsigned char *const row = &page[(size_t(job.boxes[b].y + 1 + y) * pw + job.boxes[b].x + 1) * 4];
+        const unsigned char *const src = &pixels[size_t(sy) * w * 4];
+        for (int c = 0; c < 4; c++) {
+          row[-4 + c] = src[c];
+          row[w*4 + c] = src[(w - 1)*4 + c];
+        }
+        copy(src, src + w*4, row);
+      }
+    }
+    
+    uLongf size = compressBound(page.size());
+    vector<unsigned char> packed(size);
+    if (compress(&packed[0], &size, &page[0], page.size()) != Z_OK) {
+      job.errors[j] = "Atlas page " + tostring(int(pg)) + " could not be compressed.";
+      return;
+    }
+    blob_writei(blob, pw); //width
+    blob_writei(blob, ph); //height
+    blob_writei(blob, page.size()); //size when unpacked
+    blob_writei(blob, size); //size when packed
+    blob.insert(blob.end(), packed.begin(), packed.begin() + size); //page data
+    blob_writei(blob, 0);
+    rescache::store(key, blob);
+  }
+}
+
 #include "languages/lang_CPP.h"
 int lang_CPP::module_write_sprites(EnigmaStruct *es, FILE *gameModule)
 {
@@ -64,10 +212,11 @@ int lang_CPP::module_write_sprites(EnigmaStruct *es, FILE *gameModule)
       sprite_maxid = es->sprites[i].id;
   fwrite(&sprite_maxid,4,1,gameModule);
   
+  // Every subimage of every sprite gets a box, with a pixel of border on each side so that
+  // filtering at its edges does not pick up its neighbors on the page.
+  vector<subimage_ref> refs;
   for (int i = 0; i < sprite_count; i++)
   {
-    writei(es->sprites[i].id,gameModule); //id
-    
     // Track how many subImages we're copying
     int subCount = es->sprites[i].subImageCount;
     
@@ -87,9 +236,82 @@ int lang_CPP::module_write_sprites(EnigmaStruct *es, FILE *gameModule)
       user << "Subimages of sprite `" << es->sprites[i].name << "' have zero size." << flushl;
       return 14;
     }
-    
-    writei(swidth, gameModule); //width
-    writei(sheight,gameModule); //height
+    for (int ii = 0; ii < subCount; ii++) {
+      subimage_ref r = { i, ii };
+      refs.push_back(r);
+    }
+  }
+  
+  const int box_count = refs.size();
+  vector<pvrect> boxes(box_count);
+  vector<int> order(box_count);
+  for (int b = 0; b < box_count; b++) {
+    const Image &img = es->sprites[refs[b].sprite].subImages[refs[b].subimage].image;
+    boxes[b].w = img.width + 2, boxes[b].h = img.height + 2;
+    order[b] = b;
+  }
+  sort(order.begin(), order.end(), by_size_desc(box_count ? &boxes[0] : NULL));
+  
+  // Place each box on the first page it fits, opening a new page when none has room.
+  vector<rectpnode*> pages;
+  vector<int> page_width, page_height;
+  for (int o = 0; o < box_count; o++)
+  {
+    const int b = order[o];
+    rectpnode *nn = NULL;
+    size_t pg;
+    for (pg = 0; pg < pages.size() and !nn; pg++)
+      nn = rninsert(pages[pg], b, &boxes[0]);
+    if (nn) pg--;
+    else {
+      const int pw = max(atlas_page_size, next_pow2(boxes[b].w)), ph = max(atlas_page_size, next_pow2(boxes[b].h));
+      pages.push_back(new rectpnode(0,0,pw,ph));
+      nn = rninsert(pages[pg], b, &boxes[0]);
+    }
+    // The node may be a pixel bigger than the box; only its corner matters.
+    boxes[b].x = nn->x, boxes[b].y = nn->y;
+    boxes[b].placed = pg;
+  }
+  for (size_t pg = 0; pg < pages.size(); pg++)
+    free_rectpnodes(pages[pg]);
+  
+  // Trim each page down to the power of two that holds what landed on it.
+  page_width.assign(pages.size(), 1), page_height.assign(pages.size(), 1);
+  for (int b = 0; b < box_count; b++) {
+    const int pg = boxes[b].placed;
+    page_width[pg]  = max(page_width[pg],  next_pow2(boxes[b].x + boxes[b].w));
+    page_height[pg] = max(page_height[pg], next_pow2(boxes[b].y + boxes[b].h));
+  }
+  
+  edbg << "Packed " << box_count << " subimages onto " << pages.size() << " atlas pages." << flushl;
+  writei(pages.size(),gameModule); //pages
+  
+  // Pages are built a batch at a time, one to a thread, and written in order as each batch finishes.
+  atlas_job job(es, refs, boxes, page_width, page_height);
+  const size_t batch = parallel_thread_count();
+  for (size_t first = 0; first < pages.size(); first += batch)
+  {
+    job.first = first;
+    const size_t count = min(batch, pages.size() - first);
+    job.blobs.assign(count, vector<unsigned char>());
+    job.errors.assign(count, string());
+    job.cached = 0;
+    parallel_for(count, build_atlas_page, &job);
+    for (size_t j = 0; j < count; j++) {
+      if (!job.errors[j].empty()) {
+        user << job.errors[j] << flushl;
+        return 14;
+      }
+      fwrite(&job.blobs[j][0], 1, job.blobs[j].size(), gameModule);
+    }
+    edbg << "Wrote atlas pages " << first << " through " << first + count - 1 << "; " << job.cached << " from the resource cache." << flushl;
+  }
+  
+  for (int i = 0, b = 0; i < sprite_count; i++)
+  {
+    writei(es->sprites[i].id,gameModule); //id
+    writei(es->sprites[i].subImages[0].image.width, gameModule); //width
+    writei(es->sprites[i].subImages[0].image.height,gameModule); //height
     writei(es->sprites[i].originX,gameModule); //xorig
     writei(es->sprites[i].originY,gameModule); //yorig
     writei(es->sprites[i].bbTop,gameModule);    //BBox Top
@@ -98,15 +320,15 @@ int lang_CPP::module_write_sprites(EnigmaStruct *es, FILE *gameModule)
     writei(es->sprites[i].bbRight,gameModule);  //BBox Right
     writei(es->sprites[i].shape,gameModule);  //Mask shape
     
+    const int subCount = es->sprites[i].subImageCount;
     writei(subCount,gameModule); //subimages
     
-    for (int ii = 0;ii < subCount; ii++)
+    // Boxes were made in order of sprite, then subimage.
+    for (int ii = 0; ii < subCount; ii++, b++)
     {
-      //strans = es->sprites[i].subImages[ii].transColor, fwrite(&idttrans,4,1,exe); //Transparent color
-      writei(swidth * sheight * 4,gameModule); //size when unpacked
-      writei(es->sprites[i].subImages[ii].image.dataSize,gameModule); //size when unpacked
-      fwrite(es->sprites[i].subImages[ii].image.data, 1, es->sprites[i].subImages[ii].image.dataSize, gameModule); //sprite data
-      writei(0,gameModule);
+      writei(boxes[b].placed,gameModule); //page
+      writei(boxes[b].x + 1,gameModule); //x on page
+      writei(boxes[b].y + 1,gameModule); //y on page
     }
   }
  
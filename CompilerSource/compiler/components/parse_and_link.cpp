@@ -40,141 +40,244 @@ using namespace std;
 #include "compiler/compile_common.h"
 #include "compiler/event_reader/event_parser.h"
 
-#include <math.h> //log2 to calculate passes.
+#include <vector>
+#include <algorithm>
 
 #include <languages/lang_CPP.h>
 
 #include "compiler/compile_includes.h"
+#include "general/parallel.h"
 
 extern string tostring(int);
 
-int lang_CPP::compile_parseAndLink(EnigmaStruct *es,parsed_script *scripts[])
+// Splits the scripts into strongly connected components of their call graph, using Tarjan's
+// algorithm; components come out with every component a script calls ahead of it.
+struct script_call_graph
 {
-  //First we just parse the scripts to add semicolons and collect variable names
-  for (int i = 0; i < es->scriptCount; i++)
+  vector<vector<int> > calls; // The scripts each script calls directly
+  vector<vector<int> > components;
+  vector<int> component; // The component of each script
+
+  void find_components()
   {
-    int a = syncheck::syntacheck(es->scripts[i].code);
-    if (a != -1) {
-      user << "Syntax error in script `" << es->scripts[i].name << "'\n" << syncheck::syerr << flushl;
-      return E_ERROR_SYNTAX;
-    }
-    // Keep a parsed record of this script
-    scr_lookup[es->scripts[i].name] = scripts[i] = new parsed_script;
-    parser_main(es->scripts[i].code,&scripts[i]->pev);
-    edbg << "Parsed `" << es->scripts[i].name << "': " << scripts[i]->obj.locals.size() << " locals, " << scripts[i]->obj.globals.size() << " globals" << flushl;
-    
-    // If the script accesses variables from outside its scope implicitly
-    if (scripts[i]->obj.locals.size() or scripts[i]->obj.globallocals.size()) {
-      parsed_object temporary_object = *scripts[i]->pev.myObj;
-      scripts[i]->pev_global = new parsed_event(&temporary_object);
-      parser_main(string("with (self) {\n") + es->scripts[i].code + "\n/* */}",scripts[i]->pev_global);
-      scripts[i]->pev_global->myObj = NULL;
-    }
-    fflush(stdout);
+    for (size_t i = 0; i < calls.size(); i++)
+      if (index[i] == -1)
+        visit(i);
   }
-  
-  edbg << "\"Linking\" scripts" << flushl;
-  
-  //Next we traverse the scripts for dependencies.
-  unsigned nec_iters = 0;
-  if (es->scriptCount > 0)
-    nec_iters = lrint(ceilf(log2(es->scriptCount)));
-  edbg << "`Linking' " << es->scriptCount << " scripts in " << nec_iters << " passes...\n";
-  for (unsigned _necit = 0; _necit < nec_iters; _necit++) //We will iterate the list of scripts just enough times to copy everything
-  {
-    for (int _im = 0; _im < es->scriptCount; _im++) //For each script
+
+  script_call_graph(int count): calls(count), component(count, -1), index(count, -1), lowlink(count), next_index(0) {}
+
+  private:
+    vector<int> index, lowlink, stack;
+    int next_index;
+
+    void visit(int v)
     {
-      parsed_script* curscript = scripts[_im]; //At this point, what we have is this:     for each script as curscript
-      for (parsed_object::funcit it = curscript->obj.funcs.begin(); it != curscript->obj.funcs.end(); it++) //For each function called by each script
+      index[v] = lowlink[v] = next_index++;
+      stack.push_back(v);
+      for (size_t e = 0; e < calls[v].size(); e++)
+      {
+        const int w = calls[v][e];
+        if (index[w] == -1)
+          visit(w), lowlink[v] = min(lowlink[v], lowlink[w]);
+        else if (component[w] == -1) // Still on the stack
+          lowlink[v] = min(lowlink[v], index[w]);
+      }
+      if (lowlink[v] == index[v])
       {
-        map<string,parsed_script*>::iterator subscr = scr_lookup.find(it->first); //Check if it's a script
-        if (subscr != scr_lookup.end()) //At this point, what we have is this:     for each script called by curscript
-          curscript->obj.copy_calls_from(subscr->second->obj);
+        components.push_back(vector<int>());
+        int w;
+        do {
+          w = stack.back(), stack.pop_back();
+          component[w] = components.size() - 1;
+          components.back().push_back(w);
+        } while (w != v);
       }
     }
+};
+
+// What a parse job found wrong with the code it was given; pos is -1 if nothing.
+struct parse_failure {
+  int pos, mainEvent, subEvent; // The event in which the error lies, for objects
+  string error;
+  parse_failure(): pos(-1), mainEvent(0), subEvent(0) {}
+};
+
+// Scripts and objects are syntax checked and parsed each on their own thread. A job only
+// touches its own script or object; the results, and the parser's trace, are gathered in
+// order afterward, so the outcome matches parsing them one after the other.
+struct parse_jobs {
+  EnigmaStruct *es;
+  parsed_script **scripts;
+  vector<parsed_object*> objects;
+  vector<parse_failure> failures; // Scripts first, then objects
+};
+
+static void parse_script_job(size_t i, parse_jobs *pj)
+{
+  const char *code = pj->es->scripts[i].code;
+  parse_failure &f = pj->failures[i];
+  if ((f.pos = syncheck::syntacheck(code)) != -1) {
+    f.error = syncheck::syerr;
+    return;
   }
+  parsed_script *scr = pj->scripts[i];
+  parser_main(code,&scr->pev);
   
-  edbg << "Completing script \"Link\"" << flushl;
-  
-  for (int _im = 0; _im < es->scriptCount; _im++) //For each script
+  // If the script accesses variables from outside its scope implicitly
+  if (scr->obj.locals.size() or scr->obj.globallocals.size()) {
+    parsed_object temporary_object = *scr->pev.myObj;
+    scr->pev_global = new parsed_event(&temporary_object);
+    parser_main(string("with (self) {\n") + code + "\n/* */}",scr->pev_global);
+    scr->pev_global->myObj = NULL;
+  }
+}
+
+static void parse_object_job(size_t i, parse_jobs *pj)
+{
+  const GmObject &obj = pj->es->gmObjects[i];
+  parsed_object *pob = pj->objects[i];
+  parse_failure &f = pj->failures[pj->es->scriptCount + i];
+  unsigned ev_count = 0;
+  for (int ii = 0; ii < obj.mainEventCount; ii++)
+  for (int iii = 0; iii < obj.mainEvents[ii].eventCount; iii++) //For every event in every main event, parse the code
   {
-    string curscrname = es->scripts[_im].name;
-    parsed_script* curscript = scripts[_im]; //At this point, what we have is this:     for each script as curscript
-    edbg << "Linking `" << curscrname << "':\n";
-    for (parsed_object::funcit it = curscript->obj.funcs.begin(); it != curscript->obj.funcs.end(); it++) //For each function called by each script
-    {
-      cout << string(it->first) << "::";
-      map<string,parsed_script*>::iterator subscr = scr_lookup.find(it->first); //Check if it's a script
-      if (subscr != scr_lookup.end()) //At this point, what we have is this:     for each script called by curscript
-      {
-        cout << "is_script::";
-        curscript->obj.copy_from(subscr->second->obj,  "script `"+it->first+"'",  "script `"+curscrname + "'");
-      }
+    const int mev_id = obj.mainEvents[ii].id, sev_id = obj.mainEvents[ii].events[iii].id;
+    parsed_event &pev = pob->events[ev_count++]; //Make sure each sub event knows its main event's event ID.
+    pev.mainId = mev_id, pev.id = sev_id;
+    
+    //Copy the code into a string, and its attributes elsewhere
+    string code = obj.mainEvents[ii].events[iii].code;
+    
+    // Check the code
+    if ((f.pos = syncheck::syntacheck(code)) != -1) {
+      f.mainEvent = ii, f.subEvent = iii;
+      f.error = format_error(code,syncheck::syerr,f.pos);
+      return;
     }
-    cout << endl;
+    
+    //Add this to our objects map
+    pev.myObj = pob; //Link to its calling object.
+    parser_main(code,&pev); //Format it to C++
   }
-  edbg << "Done." << flushl;
+}
 
+static void parse_job(size_t i, void *data)
+{
+  parse_jobs *pj = (parse_jobs*) data;
+  if (i < size_t(pj->es->scriptCount))
+    parse_script_job(i, pj);
+  else
+    parse_object_job(i - pj->es->scriptCount, pj);
+}
 
+int lang_CPP::compile_parseAndLink(EnigmaStruct *es,parsed_script *scripts[])
+{
+  //First we just parse the scripts and the objects' events, to add semicolons and collect variable names
+  parse_jobs pj;
+  pj.es = es, pj.scripts = scripts;
+  for (int i = 0; i < es->scriptCount; i++) // Keep a parsed record of each script
+    scr_lookup[es->scripts[i].name] = scripts[i] = new parsed_script;
+  
   edbg << es->gmObjectCount << " Objects:\n";
   for (int i = 0; i < es->gmObjectCount; i++)
   {
     //For every object in Ism's struct, make our own
-    unsigned ev_count = 0;
-    parsed_object* pob = parsed_objects[es->gmObjects[i].id] =
+    pj.objects.push_back(parsed_objects[es->gmObjects[i].id] =
       new parsed_object(
         es->gmObjects[i].name, es->gmObjects[i].id, es->gmObjects[i].spriteId, es->gmObjects[i].maskId,
         es->gmObjects[i].parentId,
         es->gmObjects[i].visible, es->gmObjects[i].solid,
         es->gmObjects[i].depth, es->gmObjects[i].persistent
-      );
-
-    edbg << " " << es->gmObjects[i].name << ": " << es->gmObjects[i].mainEventCount << " events: " << flushl;
-
-    for (int ii = 0; ii < es->gmObjects[i].mainEventCount; ii++)
-    if (es->gmObjects[i].mainEvents[ii].eventCount) //For every MainEvent that contains event code
+      ));
+    edbg << " " << es->gmObjects[i].name << ": " << es->gmObjects[i].mainEventCount << " events" << flushl;
+  }
+  
+  pj.failures.resize(es->scriptCount + es->gmObjectCount);
+  edbg << "Parsing " << es->scriptCount << " scripts and " << es->gmObjectCount << " objects on " << parallel_thread_count() << " threads" << flushl;
+  parallel_for_buffered(pj.failures.size(), parse_job, &pj);
+  
+  // Report the first error, as parsing them in order would have
+  for (int i = 0; i < es->scriptCount; i++)
+  {
+    if (pj.failures[i].pos != -1) {
+      user << "Syntax error in script `" << es->scripts[i].name << "'\n" << pj.failures[i].error << flushl;
+      return E_ERROR_SYNTAX;
+    }
+    edbg << "Parsed `" << es->scripts[i].name << "': " << scripts[i]->obj.locals.size() << " locals, " << scripts[i]->obj.globals.size() << " globals" << flushl;
+  }
+  for (int i = 0; i < es->gmObjectCount; i++)
+  {
+    const parse_failure &f = pj.failures[es->scriptCount + i];
+    if (f.pos != -1) {
+      const MainEvent &mev = es->gmObjects[i].mainEvents[f.mainEvent];
+      user << "Syntax error in object `" << es->gmObjects[i].name << "', " << event_get_human_name(mev.id,mev.events[f.subEvent].id) << " event:"
+           << mev.events[f.subEvent].id << ":\n" << f.error << flushl;
+      return E_ERROR_SYNTAX;
+    }
+  }
+  
+  edbg << "\"Linking\" scripts" << flushl;
+  
+  //Next we traverse the scripts for dependencies. Each script takes on the calls and variables
+  //of every script it can reach; scripts which call each other, directly or not, reach the same
+  //ones, so the call graph is split into strongly connected components, each of which is linked
+  //once all of the components it calls are complete.
+  map<string,int> scr_index;
+  for (int i = 0; i < es->scriptCount; i++)
+    scr_index[es->scripts[i].name] = i;
+  script_call_graph graph(es->scriptCount);
+  for (int i = 0; i < es->scriptCount; i++)
+    for (parsed_object::funcit it = scripts[i]->obj.funcs.begin(); it != scripts[i]->obj.funcs.end(); it++) //For each function called by each script
     {
-      //For each main event in that object, make a copy
-      const int mev_id = es->gmObjects[i].mainEvents[ii].id;
-      edbg << "  Event[" << es->gmObjects[i].mainEvents[ii].id << "]: ";
-
-      edbg << "  Parsing " << es->gmObjects[i].mainEvents[ii].eventCount << " sub-events:" << flushl;
-      for (int iii = 0; iii < es->gmObjects[i].mainEvents[ii].eventCount; iii++)
+      map<string,int>::iterator subscr = scr_index.find(it->first); //Check if it's a script
+      if (subscr != scr_index.end())
+        graph.calls[i].push_back(subscr->second);
+    }
+  graph.find_components();
+  edbg << "`Linking' " << es->scriptCount << " scripts in " << graph.components.size() << " groups...\n";
+  
+  edbg << "Completing script \"Link\"" << flushl;
+  
+  for (size_t c = 0; c < graph.components.size(); c++) //Callees come before their callers
+  {
+    const vector<int> &group = graph.components[c];
+    for (size_t m = 0; m < group.size(); m++) //For each script in the group
+    {
+      const int _im = group[m];
+      string curscrname = es->scripts[_im].name;
+      parsed_script* curscript = scripts[_im];
+      edbg << "Linking `" << curscrname << "':\n";
+      for (size_t e = 0; e < graph.calls[_im].size(); e++) //For each script it calls outside its group, which is complete
       {
-        //For each individual event (like begin_step) in the main event (Step), parse the code
-        const int sev_id = es->gmObjects[i].mainEvents[ii].events[iii].id;
-        parsed_event &pev = pob->events[ev_count++]; //Make sure each sub event knows its main event's event ID.
-        pev.mainId = mev_id, pev.id = sev_id;
-        
-        //Copy the code into a string, and its attributes elsewhere
-        string code = es->gmObjects[i].mainEvents[ii].events[iii].code;
-        
-        //Syntax check the code
-        
-        // Print debug info
-          edbg << "Check `" << es->gmObjects[i].name << "::" << event_get_function_name(es->gmObjects[i].mainEvents[ii].id,es->gmObjects[i].mainEvents[ii].events[iii].id) << "...";
-        
-        // Check the code
-        int sc = syncheck::syntacheck(code);
-        if (sc != -1)
-        {
-          // Error. Report it.
-          user << "Syntax error in object `" << es->gmObjects[i].name << "', " << event_get_human_name(es->gmObjects[i].mainEvents[ii].id,es->gmObjects[i].mainEvents[ii].events[iii].id) << " event:"
-               << es->gmObjects[i].mainEvents[ii].events[iii].id << ":\n" << format_error(code,syncheck::syerr,sc) << flushl;
-          return E_ERROR_SYNTAX;
-        }
-        
-        edbg << " Done. Parse...";
-        
-        //Add this to our objects map
-        pev.myObj = pob; //Link to its calling object.
-        parser_main(code,&pev); //Format it to C++
-        
-        edbg << " Done." << flushl;
+        const int callee = graph.calls[_im][e];
+        if (graph.component[callee] == graph.component[_im])
+          continue;
+        cout << es->scripts[callee].name << "::is_script::";
+        curscript->obj.copy_calls_from(scripts[callee]->obj);
+        curscript->obj.copy_from(scripts[callee]->obj,  "script `"+string(es->scripts[callee].name)+"'",  "script `"+curscrname + "'");
+      }
+      cout << endl;
+    }
+    
+    //The scripts of a group reach each other, so they all share everything the group can reach.
+    if (group.size() > 1)
+    {
+      parsed_object &first = scripts[group[0]]->obj;
+      const string firstname = "script `"+string(es->scripts[group[0]].name)+"'";
+      for (size_t m = 1; m < group.size(); m++) {
+        first.copy_calls_from(scripts[group[m]]->obj);
+        first.copy_from(scripts[group[m]]->obj,  "script `"+string(es->scripts[group[m]].name)+"'",  firstname);
+      }
+      for (size_t m = 1; m < group.size(); m++) {
+        scripts[group[m]]->obj.copy_calls_from(first);
+        scripts[group[m]]->obj.copy_from(first,  firstname,  "script `"+string(es->scripts[group[m]].name)+"'");
       }
     }
   }
-  
+  edbg << "Done." << flushl;
+
+
   //Now we parse the rooms
   edbg << "Creating room creation code scope and parsing" << flushl;
   for (int i = 0; i < es->roomCount; i++)
@@ -212,17 +315,17 @@ int lang_CPP::compile_parseAndLink(EnigmaStruct *es,parsed_script *scripts[])
   for (po_i i = parsed_objects.begin(); i != parsed_objects.end(); i++)
   {
     parsed_object* t = i->second;
+    vector<map<string,parsed_script*>::iterator> called; //The scripts this object calls itself; each already carries what it calls
     for (parsed_object::funcit it = t->funcs.begin(); it != t->funcs.end(); it++) //For each function called by each script
     {
       map<string,parsed_script*>::iterator subscr = scr_lookup.find(it->first); //Check if it's a script
       if (subscr != scr_lookup.end()) //If we've got ourselves a script
-        t->copy_calls_from(subscr->second->obj);
+        called.push_back(subscr);
     }
-    for (parsed_object::funcit it = t->funcs.begin(); it != t->funcs.end(); it++) //For each function called by each script
+    for (size_t c = 0; c < called.size(); c++)
     {
-      map<string,parsed_script*>::iterator subscr = scr_lookup.find(it->first); //Check if it's a script
-      if (subscr != scr_lookup.end()) //If we've got ourselves a script
-        t->copy_from(subscr->second->obj,  "script `"+it->first+"'",  "object `"+i->second->name+"'");
+      t->copy_calls_from(called[c]->second->obj);
+      t->copy_from(called[c]->second->obj,  "script `"+called[c]->first+"'",  "object `"+i->second->name+"'");
     }
   }
   edbg << "\"Link\" complete." << flushl;
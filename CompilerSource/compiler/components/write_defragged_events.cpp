@@ -21,6 +21,7 @@
 #include <fstream>
 #include <string>
 #include <map>
+#include <set>
 
 #include "backend/ideprint.h"
 
@@ -42,7 +43,7 @@ typedef map<string,foundevent>::iterator evfit;
 
 int lang_CPP::compile_writeDefraggedEvents(EnigmaStruct* es)
 {
-  ofstream wto((makedir +"Preprocessor_Environment_Editable/IDE_EDIT_evparent.h").c_str());
+  ofstream_if_changed wto((makedir +"Preprocessor_Environment_Editable/IDE_EDIT_evparent.h").c_str());
   wto << license;
 
 
@@ -50,13 +51,19 @@ int lang_CPP::compile_writeDefraggedEvents(EnigmaStruct* es)
   ** this game. Only events on this list will be exported.
   ***********************************************************/
   used_events.clear();
+  set< pair<int,int> > collision_pairs; // (other object, object) for each collision event
   for (int i = 0; i < es->gmObjectCount; i++)
     for (int ii = 0; ii < es->gmObjects[i].mainEventCount; ii++)
       for (int iii = 0; iii < es->gmObjects[i].mainEvents[ii].eventCount; iii++)
       {
         const int mid = es->gmObjects[i].mainEvents[ii].id, id = es->gmObjects[i].mainEvents[ii].events[iii].id;
         if (event_is_instance(mid,id))
-          used_events[event_stacked_get_root_name(mid)].inc(mid,id);
+        {
+          const string root = event_stacked_get_root_name(mid);
+          used_events[root].inc(mid,id);
+          if (root == "collision")
+            collision_pairs.insert(pair<int,int>(id, es->gmObjects[i].id));
+        }
         else
           used_events[event_get_function_name(mid,id)].inc(mid,id);
       }
@@ -116,6 +123,17 @@ int lang_CPP::compile_writeDefraggedEvents(EnigmaStruct* es)
   wto << license;
   wto << "namespace enigma" << endl << "{" << endl;
 
+  // The objects' own code links and checks their events through these, wherever it is compiled
+  for (evfit it = used_events.begin(); it != used_events.end(); it++)
+    wto  << "  extern event_iter *event_" << it->first << ";" << endl;
+
+  /* Some Super Checks are more complicated than others, requiring a function. Export those functions here. */
+  for (evfit it = used_events.begin(); it != used_events.end(); it++)
+    wto << event_get_super_check_function(it->second.mid, it->second.id);
+
+  // Everything else is SHELLmain.cpp's alone
+  wto << "#ifdef SHELLMAIN_DEFINITIONS" << endl;
+
   // Start by defining storage locations for our event lists to iterate.
   for (evfit it = used_events.begin(); it != used_events.end(); it++)
     wto  << "  event_iter *event_" << it->first << "; // Defined in " << it->second.count << " objects" << endl;
@@ -146,9 +164,15 @@ int lang_CPP::compile_writeDefraggedEvents(EnigmaStruct* es)
 
   wto << "  variant ev_perf(int type, int numb)\n  {\n    return ((enigma::event_parent*)(instance_event_iterator->inst))->myevents_perf(type, numb);\n  }\n";
 
-  /* Some Super Checks are more complicated than others, requiring a function. Export those functions here. */
-  for (evfit it = used_events.begin(); it != used_events.end(); it++)
-    wto << event_get_super_check_function(it->second.mid, it->second.id);
+  /* Every pair of objects with a collision event, so that the collision system can find
+  ** the candidates for all of them at once before the collision events are run. */
+  if (!collision_pairs.empty())
+  {
+    wto << "  static const int collision_event_pairs[][2] = {";
+    for (set< pair<int,int> >::iterator it = collision_pairs.begin(); it != collision_pairs.end(); it++)
+      wto << (it == collision_pairs.begin() ? "" : ", ") << "{" << it->second << "," << it->first << "}";
+    wto << "};" << endl;
+  }
 
   /* Now the event sequence */
   bool using_gui = false;
@@ -169,13 +193,22 @@ int lang_CPP::compile_writeDefraggedEvents(EnigmaStruct* es)
           continue;       // Don't want gui loop to be added
       }
 
+      const bool collision = !collision_pairs.empty() && event_is_instance(mid,id) && it->first == "collision";
       if (seqcode != "")
-        wto << seqcode,
-        wto << "    " << endl,
-        wto << "    enigma::update_globals();" << endl,
+      {
+        if (collision)
+          wto << "    enigma::collision_events_prepare(collision_event_pairs, " << collision_pairs.size() << ");" << endl;
+        wto << seqcode;
+        if (collision)
+          wto << "    enigma::collision_events_finish();" << endl;
+        wto << "    " << endl;
+        wto << "    enigma::update_globals();" << endl;
         wto << "    " << endl;
+      }
     }
     wto << "    after_events:" << endl;
+    if (!collision_pairs.empty()) // The collision events may have been left early
+      wto << "    enigma::collision_events_finish();" << endl;
     if (es->gameSettings.letEscEndGame)
         wto << "    if (keyboard_check_pressed(vk_escape)) game_end();" << endl;
     if (es->gameSettings.letF4SwitchFullscreen)
@@ -198,6 +231,7 @@ int lang_CPP::compile_writeDefraggedEvents(EnigmaStruct* es)
   wto << "  } // event function" << endl;
 
   wto << "  bool gui_used = " << using_gui << ";" << endl;
+  wto << "#endif" << endl;
   // Done, end the namespace
   wto << "} // namespace enigma" << endl;
   wto.close();
@@ -59,11 +59,24 @@ static string esc(string str) {
 
 int lang_CPP::compile_writeGlobals(EnigmaStruct* es, parsed_object* global)
 {
-  ofstream wto;
+  ofstream_if_changed wto;
   wto.open((makedir +"Preprocessor_Environment_Editable/IDE_EDIT_globals.h").c_str(),ios_base::out);
     wto << license;
 
+    // SHELLmain.cpp defines what follows; the game's other sources only need it declared
+    wto << "#ifndef SHELLMAIN_DEFINITIONS" << endl;
     global_script_argument_count=16; //write all 16 arguments
+    if (global_script_argument_count) {
+      wto << "extern variant argument0";
+      for (int i = 1; i < global_script_argument_count; i++)
+        wto << ", argument" << i;
+      wto << ";" << endl;
+    }
+    wto << "namespace enigma_user { extern unsigned int game_id; }" << endl;
+    for (parsed_object::globit i = global->globals.begin(); i != global->globals.end(); i++)
+      wto << "extern " << i->second.type << " " << i->second.prefix << i->first << i->second.suffix << ";" << endl;
+    wto << "#else" << endl << endl;
+
     if (global_script_argument_count) {
       wto << "// Script arguments\n";
       wto << "variant argument0 = 0";
@@ -109,13 +122,14 @@ int lang_CPP::compile_writeGlobals(EnigmaStruct* es, parsed_object* global)
     //This part needs written into a global object_parent class instance elsewhere.
     //for (globit i = global->dots.begin(); i != global->globals.end(); i++)
     //  wto << i->second->type << " " << i->second->prefixes << i->second->name << i->second->suffixes << ";" << endl;
-    wto << endl;
+    wto << "#endif" << endl << endl;
 
     wto << "namespace enigma" << endl << "{" << endl << "  struct ENIGMA_global_structure: object_locals" << endl << "  {" << endl;
     for (deciter i = dot_accessed_locals.begin(); i != dot_accessed_locals.end(); i++) // Dots are vars that are accessed as something.varname.
       wto << "    " << i->second.type << " " << i->second.prefix << i->first << i->second.suffix << ";" << endl;
 
-    wto << "    ENIGMA_global_structure(const int _x, const int _y): object_locals(_x,_y) {}" << endl << "  };" << endl << "  object_basic *ENIGMA_global_instance = new ENIGMA_global_structure(global,global);" << endl << "}";
+    wto << "    ENIGMA_global_structure(const int _x, const int _y): object_locals(_x,_y) {}" << endl << "  };" << endl;
+    wto << "  #ifdef SHELLMAIN_DEFINITIONS" << endl << "  object_basic *ENIGMA_global_instance = new ENIGMA_global_structure(global,global);" << endl << "  #endif" << endl << "}";
     wto << endl;
   wto.close();
   return 0;
@@ -67,12 +67,19 @@ string REFERENCE_POSTFIX(string ref) {
 struct usedtype { int uc; dectrip original; usedtype(): uc(0) {} }; // uc is the use count, then after polling, the dummy number.
 int lang_CPP::compile_writeObjAccess(map<int,parsed_object*> &parsed_objects, parsed_object* global)
 {
-  ofstream wto;
+  ofstream_if_changed wto;
   wto.open((makedir +"Preprocessor_Environment_Editable/IDE_EDIT_objectaccess.h").c_str(),ios_base::out);
     wto << license;
     wto << "// Depending on how many times your game accesses variables via OBJECT.varname, this file may be empty." << endl << endl;
     wto << "namespace enigma" << endl << "{" << endl;
 
+    // Every game source may access variables this way, but only SHELLmain.cpp defines the accessors
+    wto << "  object_locals *glaccess(int x);" << endl;
+    wto << "  var &map_var(std::map<string, var> **vmap, string str);" << endl;
+    for (map<string,dectrip>::iterator dait = dot_accessed_locals.begin(); dait != dot_accessed_locals.end(); dait++)
+      wto << "  " << dait->second.type << " " << dait->second.prefix << REFERENCE_POSTFIX(dait->second.suffix) << " &varaccess_" << dait->first << "(int x);" << endl;
+    wto << endl << "#ifdef SHELLMAIN_DEFINITIONS" << endl;
+
     wto <<
     "  object_locals ldummy;" << endl <<
     "  object_locals *glaccess(int x)" << endl <<
@@ -130,6 +137,7 @@ int lang_CPP::compile_writeObjAccess(map<int,parsed_object*> &parsed_objects, pa
       wto << "    return dummy_" << usedtypes[dait->second.type + " " + dait->second.prefix + dait->second.suffix].uc << ";" << endl;
       wto << "  }" << endl;
     }
+    wto << "#endif" << endl;
     wto << "} // namespace enigma" << endl;
   wto.close();
   return 0;
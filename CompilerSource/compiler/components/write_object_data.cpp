@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <algorithm>
 
 using namespace std;
@@ -30,6 +31,7 @@ using namespace std;
 #include "backend/EnigmaStruct.h" //LateralGM interface structures
 #include "compiler/compile_common.h"
 #include "compiler/event_reader/event_parser.h"
+#include "general/estring.h"
 #include "general/parse_basics_old.h"
 #include "settings.h"
 
@@ -56,6 +58,10 @@ inline string event_forge_group_code(int mainId, int id) {
   return ret;
 }
 
+// How many scripts to write to each source; fewer rebuild less when one changes, but each costs
+// a pass over the engine's headers.
+static const int scripts_per_source = 16;
+
 // modes: 0=run, 1=debug, 2=design, 3=compile
 enum { emode_run, emode_debug, emode_design, emode_compile, emode_rebuild };
 
@@ -64,7 +70,7 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global, i
 {
   //NEXT FILE ----------------------------------------
   //Object declarations: object classes/names and locals.
-  ofstream wto;
+  ofstream_if_changed wto;
   wto.open((makedir +"Preprocessor_Environment_Editable/IDE_EDIT_objectdeclarations.h").c_str(),ios_base::out);
     wto << license;
     wto << "#include \"Universal_System/collisions_object.h\"\n";
@@ -497,7 +503,7 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global, i
 		parsed.push_back(i->first);
 		i++;
       }
-      wto << "\n  objectstruct objs[] = {\n  ";
+      wto << "\n  #ifdef SHELLMAIN_DEFINITIONS\n  objectstruct objs[] = {\n  ";
       int objcunt = 0, obmx = 0;
       for (po_i i = parsed_objects.begin(); i != parsed_objects.end(); i++, objcunt++)
       {
@@ -506,24 +512,45 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global, i
       }
       wto << "  };\n";
       wto << "  int objectcount = " << objcunt << ";\n";
-      wto << "  int obj_idmax = " << obmx+1 << ";\n";
+      wto << "  int obj_idmax = " << obmx+1 << ";\n  #endif\n";
     wto << "}\n";
+
+    // The grouped event bases above call these, so every game source needs them
+    for (po_i i = parsed_objects.begin(); i != parsed_objects.end(); i++)
+    {
+      for (unsigned ii = 0; ii < i->second->events.size; ii++) {
+        const int mid = i->second->events[ii].mainId, id = i->second->events[ii].id;
+        if ((i->second->events[ii].code != "" || event_has_default_code(mid,id)) && event_has_sub_check(mid, id)) {
+          wto << "inline bool enigma::OBJ_" << i->second->name << "::myevent_" << event_get_function_name(mid,id) << "_subcheck()\n{\n  ";
+          wto << event_get_sub_check_condition(mid, id) << endl;
+          wto << "\n}\n";
+        }
+      }
+    }
   wto.close();
 
 
 
-  /* NEXT FILE `******************************************\
-  ** Object functions: events, constructors, other codes.
+  /* NEXT FILES `*****************************************\
+  ** Object functions: events and scripts. Each object, and
+  ** each group of scripts, is a source of its own, so that
+  ** make need only rebuild those whose code changed.
   ********************************************************/
 
     cout << "DBGMSG 1" << endl;
-  wto.open((makedir +"Preprocessor_Environment_Editable/IDE_EDIT_objectfunctionality.h").c_str(),ios_base::out);
-    wto << license;
+  vector<string> game_sources;
+  const string game_code = makedir + "Game_Code/";
 
     cout << "DBGMSG 2" << endl;
     // Export globalized scripts
     for (int i = 0; i < es->scriptCount; i++)
     {
+      if (i % scripts_per_source == 0) {
+        wto.close();
+        game_sources.push_back("scripts" + tostring(i / scripts_per_source) + ".cpp");
+        wto.open((game_code + game_sources.back()).c_str(),ios_base::out);
+        wto << license << "#include \"SHELLmain.h\"\n\n";
+      }
       parsed_script* scr = scr_lookup[es->scripts[i].name];
       const char* comma = "";
       wto << "variant _SCR_" << es->scripts[i].name << "(";
@@ -541,11 +568,16 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global, i
       wto << "\n  return 0;\n}\n\n";
     }
 
+    wto.close();
+
     cout << "DBGMSG 3" << endl;
     // Export everything else
     for (po_i i = parsed_objects.begin(); i != parsed_objects.end(); i++)
     {
       cout << "DBGMSG 4" << endl;
+      game_sources.push_back("object" + tostring(i->second->id) + "_" + i->second->name + ".cpp");
+      wto.open((game_code + game_sources.back()).c_str(),ios_base::out);
+      wto << license << "#include \"SHELLmain.h\"\n\n";
       parent_undefined = parent_undefinitions.find(i->first)->second;
       for (unsigned ii = 0; ii < i->second->events.size; ii++) {
         const int mid = i->second->events[ii].mainId, id = i->second->events[ii].id;
@@ -586,17 +618,6 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global, i
             wto << "#undef event_inherited\n";
           }
         }
-        
-        if  (i->second->events[ii].code != "" || event_has_default_code(mid,id))
-        {
-          // Write event sub check code
-          if (event_has_sub_check(mid, id)) {
-            wto << "inline bool enigma::OBJ_" << i->second->name << "::myevent_" << evname << "_subcheck()\n{\n  ";
-            cout << "DBGMSG 4-3" << endl;
-            wto << event_get_sub_check_condition(mid, id) << endl;
-            wto << "\n}\n";
-          }
-        }
       }
         
       cout << "DBGMSG 5" << endl;
@@ -622,12 +643,43 @@ int lang_CPP::compile_writeObjectData(EnigmaStruct* es, parsed_object* global, i
         }
       }
     cout << "DBGMSG 6" << endl;
+      wto.close();
     }
     cout << "DBGMSG 7" << endl;
 	
 	parent_undefined.clear();
 	parent_undefinitions.clear();
 
+  // Every game source includes the user's Definitions, so if those define anything, each
+  // source would define it again and the link would fail. Then SHELLmain.cpp includes the
+  // game's code instead, and builds it as one unit, as it did before.
+  string definitions;
+  {
+    ifstream ws((makedir + "Preprocessor_Environment_Editable/IDE_EDIT_whitespace.h").c_str(), ios_base::in | ios_base::binary);
+    definitions.assign(istreambuf_iterator<char>(ws), istreambuf_iterator<char>());
+  }
+  const bool single_unit = definitions_define_symbols(definitions);
+  if (single_unit)
+    cout << "Definitions define variables or functions; compiling the game's code as a single unit." << endl;
+
+  // The engine's Makefile builds whichever of these we list
+  wto.open((game_code + "sources.mk").c_str(),ios_base::out);
+    wto << "GAME_SOURCES :=";
+    for (size_t i = 0; !single_unit and i < game_sources.size(); i++)
+      wto << " " << game_sources[i];
+    wto << "\n";
+  wto.close();
+
+
+  /* NEXT FILE `******************************************\
+  ** Object functionality which only SHELLmain.cpp compiles:
+  ** the script table and the universal constructor.
+  ********************************************************/
+
+  wto.open((makedir +"Preprocessor_Environment_Editable/IDE_EDIT_objectfunctionality.h").c_str(),ios_base::out);
+    wto << license;
+    for (size_t i = 0; single_unit and i < game_sources.size(); i++)
+      wto << "#include \"Game_Code/" << game_sources[i] << "\"\n";
     wto << "namespace enigma\n{\n"
     "  callable_script callable_scripts[] = {\n";
     int scr_count = 0;
@@ -0,0 +1,102 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+/* Checks definitions_define_symbols, which decides whether the game's code can be compiled as
+   several units, against Definitions code that does and doesn't define anything. A wrong
+   "no" breaks the link with duplicate symbols; a wrong "yes" only costs the parallel build. */
+
+#include <cstdio>
+#include <string>
+using namespace std;
+
+#include "compiler/compile_common.h"
+
+namespace {
+  struct definitions_case {
+    const char *code;
+    bool defines;
+  };
+
+  const definitions_case cases[] = {
+    // Functions
+    { "int f();", false },
+    { "int f(int a, const char *b);", false },
+    { "int f(int a = 2);", false },
+    { "int f() { return 0; }", true },
+    { "void f(int x) { if (x) { x++; } }", true },
+    { "inline int f() { return 0; }", false },
+    { "static int f() { return 0; }", true },
+    { "extern int f();", false },
+    { "extern \"C\" int f();", false },
+    { "extern \"C\" { int f(); int g(double); }", false },
+    { "extern \"C\" { int f() { return 1; } }", true },
+    { "int (*callback)(int);", true },
+
+    // Variables
+    { "int x;", true },
+    { "int x = 5;", true },
+    { "int x(5);", true },
+    { "int x[4] = { 1, 2, 3, 4 };", true },
+    { "std::string s(\"text\");", true },
+    { "static int x;", true },
+    { "extern int x;", false },
+    { "extern int x = 3;", true },
+    { "const int x = 3;", false },
+    { "const char *name = \"x\";", true },
+    { "int *const p = 0;", false },
+    { "const int *p;", true },
+    { "int (*callback)(const int);", true },
+    { "typedef int number;", false },
+
+    // Types, namespaces and templates
+    { "struct point { int x, y; int length() const { return x + y; } };", false },
+    { "struct point { int x, y; } origin;", true },
+    { "class shape { public: virtual ~shape(); static int count; };", false },
+    { "enum color { red, green, blue };", false },
+    { "struct point;", false },
+    { "namespace geometry { int area(int w, int h); }", false },
+    { "namespace geometry { int scale = 2; }", true },
+    { "namespace geometry { namespace detail { inline int half(int x) { return x / 2; } } }", false },
+    { "namespace { int hidden; }", true },
+    { "template<typename T> T maximum(T a, T b) { return a > b ? a : b; }", false },
+    { "template<typename T> struct box { T held; T get() { return held; } };", false },
+    { "template<> int maximum<int>(int a, int b) { return a; }", true },
+
+    // Comments, strings and the preprocessor
+    { "// int x;\nint f();", false },
+    { "/* int x = 5; */ int f();", false },
+    { "/* int f() { return 0; }\n */\nextern int x;", false },
+    { "#define MAKE(x) int x;\nint f();", false },
+    { "#define LONG_MACRO \\\n  int y = 2;\nint f();", false },
+    { "const char *const greeting = \"{ int x; }\";", false },
+    { "const char brace = '{';", false },
+    { "", false },
+  };
+}
+
+int main()
+{
+  int failures = 0;
+  const size_t count = sizeof(cases) / sizeof(*cases);
+  for (size_t i = 0; i < count; i++)
+    if (definitions_define_symbols(cases[i].code) != cases[i].defines) {
+      printf("FAILED: expected %s for: %s\n", cases[i].defines ? "a definition" : "only declarations", cases[i].code);
+      failures++;
+    }
+  printf("%u of %u Definitions checks passed\n", unsigned(count - failures), unsigned(count));
+  return failures ? 1 : 0;
+}
@@ -39,13 +39,13 @@ namespace rect_packer
         x(xx), y(yy), wid(w), hgt(h), c(-1) { child[0] = c1, child[1]=c2; }
     void rectpnode::rect(int xx, int yy, int w, int h) { x=xx, y=yy, wid=w, hgt=h; }
     
-    void rncopy(rectpnode *h, pvrect *boxes, unsigned char c)
+    void rncopy(rectpnode *h, pvrect *boxes, int c)
     {
       boxes[c].x = h->x,   boxes[c].y = h->y;
       boxes[c].w = h->wid, boxes[c].h = h->hgt;
     }
     
-    rectpnode *rninsert(rectpnode* who, unsigned char c, pvrect* boxes)
+    rectpnode *rninsert(rectpnode* who, int c, pvrect* boxes)
     {
       rectpnode *newNode;
       if (who->child[0]) // Already split
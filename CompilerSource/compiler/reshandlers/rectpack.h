@@ -43,8 +43,8 @@ namespace rect_packer
     void rect(int xx, int yy, int w, int h);
   };
   
-  void rncopy(rectpnode *h, pvrect *boxes, unsigned char c);
-  rectpnode *rninsert(rectpnode* who, unsigned char c, pvrect* boxes);
+  void rncopy(rectpnode *h, pvrect *boxes, int c);
+  rectpnode *rninsert(rectpnode* who, int c, pvrect* boxes);
   rectpnode *expand(rectpnode* who, int w, int h);
 }
 
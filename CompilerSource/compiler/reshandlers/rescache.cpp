@@ -0,0 +1,259 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <algorithm>
+#include <map>
+
+#include "makedir.h"
+#include "rescache.h"
+
+using namespace std;
+
+namespace {
+  // How much the cache may hold across compiles; the blobs this compile used are always kept.
+  const uint64_t cache_budget = uint64_t(256) << 20;
+
+  // Each cached file is this magic, the blob's length, and the hash of the blob, then the blob.
+  const char blob_magic[4] = { 'E', 'R', 'C', '1' };
+  const size_t blob_header_size = sizeof blob_magic + 8 + 16;
+
+  pthread_mutex_t used_lock = PTHREAD_MUTEX_INITIALIZER;
+  map<string, uint64_t> used_keys; // Everything this compile fetched or stored, and its size
+
+  void mark_used(const string &key, uint64_t size) {
+    pthread_mutex_lock(&used_lock);
+    used_keys[key] = size;
+    pthread_mutex_unlock(&used_lock);
+  }
+
+  string cache_file(const string &key) {
+    return makedir + "Resource_Cache/" + key;
+  }
+
+  // Each resource file's key and size are kept beside the blobs, under a hash of its path.
+  string file_note(const string &path) {
+    return cache_file(rescache::hasher().add(path.data(), path.length()).key("file"));
+  }
+
+  // The size of a file, or -1 if it can't be read.
+  long file_size(const string &path) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fclose(f);
+    return size;
+  }
+
+  inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+  inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33; k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ULL;
+    return k ^ (k >> 33);
+  }
+  const uint64_t murmur_c1 = 0x87c37b91114253d5ULL, murmur_c2 = 0x4cf5ad432745937fULL;
+
+  inline void murmur_block(uint64_t &h1, uint64_t &h2, const unsigned char *block) {
+    uint64_t k1, k2;
+    memcpy(&k1, block, 8), memcpy(&k2, block + 8, 8);
+    k1 *= murmur_c1; k1 = rotl64(k1, 31); k1 *= murmur_c2; h1 ^= k1;
+    h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+    k2 *= murmur_c2; k2 = rotl64(k2, 33); k2 *= murmur_c1; h2 ^= k2;
+    h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+  }
+
+  // The two halves of the hash of everything given to h so far.
+  void murmur_finish(const rescache::hasher &h, uint64_t &r1, uint64_t &r2) {
+    uint64_t h1 = h.h1, h2 = h.h2, k1 = 0, k2 = 0;
+    for (size_t i = h.tail_size; i > 8; i--)
+      k2 ^= uint64_t(h.tail[i - 1]) << ((i - 9) * 8);
+    for (size_t i = min<size_t>(h.tail_size, 8); i > 0; i--)
+      k1 ^= uint64_t(h.tail[i - 1]) << ((i - 1) * 8);
+    if (h.tail_size > 8) { k2 *= murmur_c2; k2 = rotl64(k2, 33); k2 *= murmur_c1; h2 ^= k2; }
+    if (h.tail_size > 0) { k1 *= murmur_c1; k1 = rotl64(k1, 31); k1 *= murmur_c2; h1 ^= k1; }
+    h1 ^= h.length, h2 ^= h.length;
+    h1 += h2, h2 += h1;
+    h1 = fmix64(h1), h2 = fmix64(h2);
+    h1 += h2, h2 += h1;
+    r1 = h1, r2 = h2;
+  }
+}
+
+namespace rescache
+{
+  hasher::hasher(): h1(0), h2(0), length(0), tail_size(0) {}
+
+  hasher &hasher::add(const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char*) data, *const end = p + size;
+    length += size;
+    if (tail_size) {
+      const size_t n = min(size, 16 - tail_size);
+      memcpy(tail + tail_size, p, n);
+      p += n, tail_size += n;
+      if (tail_size < 16) return *this;
+      murmur_block(h1, h2, tail);
+      tail_size = 0;
+    }
+    for (; end - p >= 16; p += 16)
+      murmur_block(h1, h2, p);
+    memcpy(tail, p, end - p);
+    tail_size = end - p;
+    return *this;
+  }
+
+  hasher &hasher::add(int x) {
+    return add(&x, sizeof x);
+  }
+
+  string hasher::key(const char *kind) const {
+    uint64_t r1, r2;
+    murmur_finish(*this, r1, r2);
+    char buf[64];
+    sprintf(buf, "-%016llx%016llx-%llx", (unsigned long long) r1, (unsigned long long) r2, (unsigned long long) length);
+    return kind + string(buf);
+  }
+
+  bool fetch(const string &key, vector<unsigned char> &blob)
+  {
+    FILE *f = fopen(cache_file(key).c_str(), "rb");
+    if (!f) return false;
+    unsigned char header[blob_header_size];
+    uint64_t size = 0, sum[2];
+    bool read = fread(header, 1, sizeof header, f) == sizeof header and !memcmp(header, blob_magic, sizeof blob_magic);
+    if (read) {
+      memcpy(&size, header + sizeof blob_magic, 8), memcpy(sum, header + sizeof blob_magic + 8, 16);
+      fseek(f, 0, SEEK_END);
+      read = size > 0 and uint64_t(ftell(f)) == blob_header_size + size;
+      fseek(f, blob_header_size, SEEK_SET);
+    }
+    if (read) {
+      blob.resize(size);
+      read = fread(&blob[0], 1, size, f) == size;
+    }
+    fclose(f);
+
+    // A blob cut short or damaged since it was stored is no blob at all
+    uint64_t r1 = 0, r2 = 0;
+    if (read)
+      murmur_finish(hasher().add(&blob[0], blob.size()), r1, r2);
+    if (!read or r1 != sum[0] or r2 != sum[1]) {
+      blob.clear();
+      return false;
+    }
+    mark_used(key, blob_header_size + size);
+    return true;
+  }
+
+  void store(const string &key, const vector<unsigned char> &blob)
+  {
+    if (blob.empty()) return;
+    unsigned char header[blob_header_size];
+    const uint64_t size = blob.size();
+    uint64_t sum[2];
+    murmur_finish(hasher().add(&blob[0], blob.size()), sum[0], sum[1]);
+    memcpy(header, blob_magic, sizeof blob_magic);
+    memcpy(header + sizeof blob_magic, &size, 8), memcpy(header + sizeof blob_magic + 8, sum, 16);
+
+    // Written aside and renamed into place, so an interrupted compile never leaves half a blob
+    const string fn = cache_file(key), tmp = fn + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f) return;
+    const bool written = fwrite(header, 1, sizeof header, f) == sizeof header and fwrite(&blob[0], 1, blob.size(), f) == blob.size();
+    if (fclose(f) or !written) {
+      remove(tmp.c_str());
+      return;
+    }
+    remove(fn.c_str());
+    if (!rename(tmp.c_str(), fn.c_str()))
+      mark_used(key, blob_header_size + size);
+  }
+
+  bool file_matches(const string &path, const string &key)
+  {
+    FILE *f = fopen(file_note(path).c_str(), "rb");
+    if (!f) return false;
+    char noted[256];
+    unsigned long long noted_size;
+    const bool read = fscanf(f, "%255s %llu", noted, &noted_size) == 2;
+    fclose(f);
+    if (!read or key != noted)
+      return false;
+    const long size = file_size(path);
+    return size >= 0 and (unsigned long long) size == noted_size;
+  }
+
+  void note_file(const string &path, const string &key)
+  {
+    const string fn = file_note(path);
+    remove(fn.c_str());
+    const long size = file_size(path);
+    if (key.empty() or size < 0) return;
+    if (FILE *f = fopen(fn.c_str(), "wb")) {
+      fprintf(f, "%s %lu\n", key.c_str(), size);
+      fclose(f);
+    }
+  }
+
+  void prune()
+  {
+    // The index gives each blob the number of the compile which last used it, and its size.
+    struct entry { unsigned long used; uint64_t size; };
+    map<string, entry> entries;
+    unsigned long compile = 1;
+    const string index = makedir + "Resource_Cache/index.txt";
+    if (FILE *f = fopen(index.c_str(), "rb")) {
+      char line[256], key[256];
+      unsigned long used;
+      unsigned long long size;
+      while (fgets(line, sizeof line, f))
+        if (sscanf(line, "%lu %llu %255s", &used, &size, key) == 3) {
+          entry &e = entries[key];
+          e.used = used, e.size = size;
+          compile = max(compile, used + 1);
+        }
+      fclose(f);
+    }
+    for (map<string, uint64_t>::iterator it = used_keys.begin(); it != used_keys.end(); it++) {
+      entry &e = entries[it->first];
+      e.used = compile, e.size = it->second;
+    }
+    used_keys.clear();
+
+    // Keep the most recently used blobs which fit the budget
+    vector< pair<unsigned long, string> > by_use;
+    for (map<string, entry>::iterator it = entries.begin(); it != entries.end(); it++)
+      by_use.push_back(make_pair(it->second.used, it->first));
+    sort(by_use.rbegin(), by_use.rend());
+    uint64_t total = 0;
+    for (size_t i = 0; i < by_use.size(); i++) {
+      total += entries[by_use[i].second].size;
+      if (by_use[i].first != compile and total > cache_budget) {
+        remove(cache_file(by_use[i].second).c_str());
+        entries.erase(by_use[i].second);
+      }
+    }
+
+    if (FILE *f = fopen(index.c_str(), "wb")) {
+      for (map<string, entry>::iterator it = entries.begin(); it != entries.end(); it++)
+        fprintf(f, "%lu %llu %s\n", it->second.used, (unsigned long long) it->second.size, it->first.c_str());
+      fclose(f);
+    }
+  }
+}
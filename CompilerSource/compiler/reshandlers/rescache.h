@@ -0,0 +1,60 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_RESCACHE_H
+#define ENIGMA_RESCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/* Blobs of the resource block, such as a packed atlas page or a font, which are costly to
+** build, are kept in the make directory under a hash of everything they were built from,
+** so that the next compile can reuse them for any resource which has not changed. The
+** cache is shared by every game built in that directory, and sheds the blobs used least
+** recently once it grows past its budget. */
+namespace rescache
+{
+  // Accumulates the inputs of a blob into the key it is cached under: a 128-bit MurmurHash3
+  // of everything added, and its length.
+  struct hasher {
+    uint64_t h1, h2, length;
+    unsigned char tail[16];
+    size_t tail_size;
+    hasher();
+    hasher &add(const void *data, size_t size);
+    hasher &add(int x);
+    std::string key(const char *kind) const;
+  };
+
+  // Reads the blob cached under key, if there is one and it is whole. Safe to call from
+  // parallel_for jobs. The caller should still check that the blob makes sense.
+  bool fetch(const std::string &key, std::vector<unsigned char> &blob);
+  // Caches a blob under key. Safe to call from parallel_for jobs.
+  void store(const std::string &key, const std::vector<unsigned char> &blob);
+  // Whether the resource file at path is whole, and was last written from inputs with this key.
+  bool file_matches(const std::string &path, const std::string &key);
+  // Records that the resource file at path was just written from inputs with this key. An
+  // empty key forgets the file, as before rewriting it.
+  void note_file(const std::string &path, const std::string &key);
+  // Notes that this compile used the blobs it fetched or stored, then deletes the least
+  // recently used blobs until the cache fits its budget.
+  void prune();
+}
+
+#endif
@@ -0,0 +1,157 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include <pthread.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "parallel.h"
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+unsigned parallel_thread_count()
+{
+  #if defined(_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    const long n = si.dwNumberOfProcessors;
+  #else
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  #endif
+  return n > 1 ? n : 1;
+}
+
+namespace {
+  struct parallel_work {
+    void (*job)(size_t, void*);
+    void *data;
+    size_t count, next;
+    pthread_mutex_t lock;
+  };
+
+  void *parallel_worker(void *arg)
+  {
+    parallel_work *w = (parallel_work*) arg;
+    for (;;) {
+      pthread_mutex_lock(&w->lock);
+      const size_t i = w->next < w->count ? w->next++ : w->count;
+      pthread_mutex_unlock(&w->lock);
+      if (i == w->count)
+        return NULL;
+      w->job(i, w->data);
+    }
+  }
+}
+
+void parallel_for(size_t count, void (*job)(size_t, void*), void *data)
+{
+  parallel_work w;
+  w.job = job, w.data = data;
+  w.count = count, w.next = 0;
+  pthread_mutex_init(&w.lock, NULL);
+
+  // The calling thread works too, so a thread which fails to start only costs us speed
+  std::vector<pthread_t> threads;
+  const size_t extra = parallel_thread_count() - 1;
+  for (size_t i = 0; i < extra && i + 1 < count; i++) {
+    pthread_t t;
+    if (pthread_create(&t, NULL, parallel_worker, &w))
+      break;
+    threads.push_back(t);
+  }
+  parallel_worker(&w);
+  for (size_t i = 0; i < threads.size(); i++)
+    pthread_join(threads[i], NULL);
+
+  pthread_mutex_destroy(&w.lock);
+}
+
+namespace {
+  // What one job wrote to cout and to cerr
+  struct job_output {
+    std::string text[2];
+  };
+
+  pthread_key_t current_job_output;
+  pthread_once_t current_job_output_once = PTHREAD_ONCE_INIT;
+  void make_current_job_output() { pthread_key_create(&current_job_output, NULL); }
+
+  // Stands in for the buffer of cout or cerr while jobs run. It has no put area of its own, so
+  // every write lands here and goes to the output of the job running on the writing thread;
+  // threads running no job write straight through.
+  class job_output_buf: public std::streambuf {
+    std::streambuf *const through;
+    const int stream;
+   public:
+    job_output_buf(std::streambuf *through, int stream): through(through), stream(stream) {}
+    std::streambuf *through_buf() const { return through; }
+   protected:
+    int overflow(int c) {
+      if (c == traits_type::eof())
+        return traits_type::not_eof(c);
+      if (job_output *out = (job_output*) pthread_getspecific(current_job_output))
+        return out->text[stream] += traits_type::to_char_type(c), c;
+      return through->sputc(traits_type::to_char_type(c));
+    }
+    std::streamsize xsputn(const char *s, std::streamsize n) {
+      if (job_output *out = (job_output*) pthread_getspecific(current_job_output))
+        return out->text[stream].append(s, n), n;
+      return through->sputn(s, n);
+    }
+    int sync() {
+      return pthread_getspecific(current_job_output) ? 0 : through->pubsync();
+    }
+  };
+
+  struct buffered_work {
+    void (*job)(size_t, void*);
+    void *data;
+    std::vector<job_output> outputs;
+  };
+
+  void buffered_job(size_t i, void *arg)
+  {
+    buffered_work *w = (buffered_work*) arg;
+    pthread_setspecific(current_job_output, &w->outputs[i]);
+    w->job(i, w->data);
+    pthread_setspecific(current_job_output, NULL);
+  }
+}
+
+void parallel_for_buffered(size_t count, void (*job)(size_t, void*), void *data)
+{
+  pthread_once(&current_job_output_once, make_current_job_output);
+  buffered_work w;
+  w.job = job, w.data = data;
+  w.outputs.resize(count);
+
+  std::cout.flush(), std::cerr.flush();
+  job_output_buf out(std::cout.rdbuf(), 0), err(std::cerr.rdbuf(), 1);
+  std::cout.rdbuf(&out), std::cerr.rdbuf(&err);
+  parallel_for(count, buffered_job, &w);
+  std::cout.rdbuf(out.through_buf()), std::cerr.rdbuf(err.through_buf());
+
+  for (size_t i = 0; i < count; i++) {
+    std::cout << w.outputs[i].text[0] << std::flush;
+    std::cerr << w.outputs[i].text[1];
+  }
+}
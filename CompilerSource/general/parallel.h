@@ -0,0 +1,36 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_GENERAL_PARALLEL_H
+#define ENIGMA_GENERAL_PARALLEL_H
+
+#include <stddef.h>
+
+// The number of threads parallel_for spreads its work over; one per processor.
+unsigned parallel_thread_count();
+
+// Calls job(i, data) once for every i below count, on up to parallel_thread_count() threads,
+// the calling thread among them, and returns once every call has. Calls are handed out in
+// order of i, but may finish in any order; a job must not touch another's state.
+void parallel_for(size_t count, void (*job)(size_t i, void *data), void *data);
+
+// As parallel_for, but what each job writes to cout and cerr is held back, then written out in
+// order of i once every job has finished, so the output reads as if the jobs had run one after
+// another on the calling thread.
+void parallel_for_buffered(size_t count, void (*job)(size_t i, void *data), void *data);
+
+#endif
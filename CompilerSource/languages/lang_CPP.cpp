@@ -86,6 +86,103 @@ const char* heaping_pile_of_dog_shit = "ERROR: Unknown";
 extern jdi::definition *enigma_type__var, *enigma_type__variant, *enigma_type__varargs;
 void parser_init();
 
+#include <zlib.h>
+
+/* The definitions cache holds main_context as it stood after the last successful parse of
+   the engine, along with what that parse depended on: the builds of this library and of JDI,
+   the settings and toolchain defines in full, and the size and CRC of SHELLmain.cpp and every
+   header it included. Files are checked by content rather than time, as the IDE rewrites its
+   editable headers on every call.
+*/
+static const char *const definitions_cache_name = "enigma_definitions.cache";
+
+static string definitions_cache_key(const char* targetYaml)
+{
+  string key = "ENIGMA definitions cache 1; built " __DATE__ " " __TIME__ "\n";
+  key += jdi::context::cache_stamp() + "\n";
+  key += targetYaml? targetYaml : "";
+  key += "\n";
+  const jdi::macro_map &bm = jdi::builtin->get_macros();
+  for (jdi::macro_iter_c it = bm.begin(); it != bm.end(); ++it)
+    key += it->second->toString() + "\n";
+  for (size_t i = 0; i < jdi::builtin->search_dir_count(); ++i)
+    key += jdi::builtin->search_dir(i) + "\n";
+  return key;
+}
+
+static bool read_whole_file(const string &fn, string &out)
+{
+  FILE *f = fopen(fn.c_str(), "rb");
+  if (!f) return false;
+  char buf[16384];
+  size_t n;
+  out.clear();
+  while ((n = fread(buf, 1, sizeof buf, f)))
+    out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+static void cache_put(string &out, unsigned x) { out.append((const char*)&x, sizeof x); }
+static void cache_put(string &out, const string &s) { cache_put(out, s.length()); out += s; }
+static bool cache_get(const string &in, size_t &pos, unsigned &x) {
+  if (in.length() - pos < sizeof x) return false;
+  memcpy(&x, in.data() + pos, sizeof x); pos += sizeof x;
+  return true;
+}
+static bool cache_get(const string &in, size_t &pos, string &s) {
+  unsigned n;
+  if (!cache_get(in, pos, n) or in.length() - pos < n) return false;
+  s.assign(in, pos, n); pos += n;
+  return true;
+}
+
+static unsigned file_crc(const string &contents) {
+  return crc32(crc32(0, Z_NULL, 0), (const Bytef*)contents.data(), contents.length());
+}
+
+static bool load_definitions_cache(jdi::context *ctx, const string &key)
+{
+  string cache, ckey;
+  size_t pos = 0;
+  unsigned filec;
+  if (!read_whole_file(makedir + definitions_cache_name, cache) or !cache_get(cache, pos, ckey) or ckey != key or !cache_get(cache, pos, filec))
+    return false;
+  while (filec--) {
+    string fn, contents;
+    unsigned size, crc;
+    if (!cache_get(cache, pos, fn) or !cache_get(cache, pos, size) or !cache_get(cache, pos, crc))
+      return false;
+    if (!read_whole_file(fn, contents) or contents.length() != size or file_crc(contents) != crc)
+      return false;
+  }
+  return ctx->read_cache(cache.data() + pos, cache.length() - pos);
+}
+
+static void save_definitions_cache(jdi::context *ctx, const string &key, const string &mainfile)
+{
+  string cache;
+  cache_put(cache, key);
+  set<string> files = ctx->included_files;
+  files.insert(mainfile);
+  cache_put(cache, files.size());
+  for (set<string>::iterator it = files.begin(); it != files.end(); ++it) {
+    string contents;
+    if (!read_whole_file(*it, contents))
+      return;
+    cache_put(cache, *it);
+    cache_put(cache, contents.length());
+    cache_put(cache, file_crc(contents));
+  }
+  ctx->write_cache(cache);
+  
+  FILE *of = fopen((makedir + definitions_cache_name).c_str(), "wb");
+  if (!of) return;
+  const bool written = fwrite(cache.data(), 1, cache.length(), of) == cache.length();
+  if (fclose(of) or !written)
+    remove((makedir + definitions_cache_name).c_str());
+}
+
 syntax_error *lang_CPP::definitionsModified(const char* wscode, const char* targetYaml)
 {
   cout << "Parsing settings..." << endl;
@@ -98,19 +195,28 @@ syntax_error *lang_CPP::definitionsModified(const char* wscode, const char* targ
   main_context = new jdi::context();
   
   cout << "Dumping whiteSpace definitions..." << endl;
-  FILE *of = wscode ? fopen((makedir +"Preprocessor_Environment_Editable/IDE_EDIT_whitespace.h").c_str(),"wb") : NULL;
+  // Every game source includes these, so leave the file be unless they changed
+  const string wsname = makedir + "Preprocessor_Environment_Editable/IDE_EDIT_whitespace.h";
+  string wsold;
+  FILE *of = wscode and !(read_whole_file(wsname, wsold) and wsold == wscode) ? fopen(wsname.c_str(),"wb") : NULL;
   if (of) fputs(wscode,of), fclose(of);
   
   cout << "Opening ENIGMA for parse..." << endl;
   
+  const string cache_key = definitions_cache_key(targetYaml);
   llreader f("ENIGMAsystem/SHELL/SHELLmain.cpp");
   int res = 1;
   DECLARE_TIME();
-  if (f.is_open()) {
-    START_TIME();
+  START_TIME();
+  const bool cached = load_definitions_cache(main_context, cache_key);
+  if (cached)
+    res = 0;
+  else if (f.is_open()) {
     res = main_context->parse_C_stream(f, "SHELLmain.cpp");
-    STOP_TIME();
+    if (!res)
+      save_definitions_cache(main_context, cache_key, "ENIGMAsystem/SHELL/SHELLmain.cpp");
   }
+  STOP_TIME();
   
   jdi::definition *d;
   if ((d = main_context->get_global()->look_up("variant"))) {
@@ -147,7 +253,7 @@ syntax_error *lang_CPP::definitionsModified(const char* wscode, const char* targ
     cout << "Continuing anyway." << endl;
     // return &ide_passback_error;
   } else {    
-    cout << "Successfully parsed ENIGMA's engine (" << PRINT_TIME() << "ms)\n"
+    cout << (cached? "Successfully loaded ENIGMA's engine from the definitions cache (" : "Successfully parsed ENIGMA's engine (") << PRINT_TIME() << "ms)\n"
     << "++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++\n";
     //cout << "Namespace std contains " << global_scope.members["std"]->members.size() << " items.\n";
   }
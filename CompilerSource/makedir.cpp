@@ -73,6 +73,8 @@ void setMakeDirectory(string dir) {
 				break;
 		}
 	}
+	CreateDirectory((makedir + "Game_Code").c_str(), NULL);
+	CreateDirectory((makedir + "Resource_Cache").c_str(), NULL);
 #else
 	mkdir((makedir).c_str(),0755);
 	if (mkdir((makedir + "Preprocessor_Environment_Editable").c_str(),0755) == -1)
@@ -81,5 +83,7 @@ void setMakeDirectory(string dir) {
 	} else {
 	  std::cout << "Created make directory: \"" << makedir << "\"" << endl;
 	}
+	mkdir((makedir + "Game_Code").c_str(),0755);
+	mkdir((makedir + "Resource_Cache").c_str(),0755);
 #endif
 }
@@ -32,12 +32,14 @@
 #include <string>
 #include <iostream>
 #include <stdio.h>
+#include <pthread.h>
 using namespace std;
 
 #include "config.h"
 #include "compiler/event_reader/event_parser.h"
 
 extern int global_script_argument_count;
+static pthread_mutex_t argument_count_lock = PTHREAD_MUTEX_INITIALIZER; // Events are collected on several threads at once
 
 struct scope_ignore {
   map<string,int> ignore;
@@ -288,8 +290,10 @@ void collect_variables(language_adapter *lang, string &code, string &synt, parse
         iscr = sscanf(nname.c_str(),"argument%d",&argnum);
         if (iscr == 1)
         { //  not in a script or are but have exceeded arg number
+          pthread_mutex_lock(&argument_count_lock);
           if (global_script_argument_count < argnum + 1)
             global_script_argument_count = argnum + 1;
+          pthread_mutex_unlock(&argument_count_lock);
           continue;
         }
         
@@ -46,15 +46,17 @@ typedef size_t pt; //Use size_t as our pos type; helps on 64bit systems.
 map<string,char> edl_tokens; // Logarithmic lookup, with token.
 typedef map<string,char>::iterator tokiter;
 
-int scope_braceid = 0;
+// Each thread parses in its own scope, which is kept out of the global scope so that threads
+// can look names up there while others parse.
+static thread_local int scope_braceid = 0;
 extern string tostring(int);
 
 #include <Storage/definition.h>
-static jdi::definition_scope *current_scope;
+static thread_local jdi::definition_scope *script_scope, *current_scope;
 
 int dropscope()
 {
-  if (current_scope != main_context->get_global())
+  if (current_scope != script_scope)
   current_scope = current_scope->parent;
   return 0;
 }
@@ -68,7 +70,8 @@ int quickscope()
 int initscope(string name)
 {
   scope_braceid = 0;
-  main_context->get_global()->members[name] = current_scope = new jdi::definition_scope(name,main_context->get_global(),jdi::DEF_NAMESPACE);
+  delete script_scope;
+  script_scope = current_scope = new jdi::definition_scope(name,main_context->get_global(),jdi::DEF_NAMESPACE);
   return 0;
 }
 int quicktype(unsigned flags, string name)
@@ -813,7 +816,7 @@ static inline string string_settings_escape(string n)
   }
   return n;
 }
-void print_to_file(string code,string synt,unsigned int &strc, varray<string> &string_in_code,int indentmin_b4,ofstream &of)
+void print_to_file(string code,string synt,unsigned int &strc, varray<string> &string_in_code,int indentmin_b4,ostream &of)
 {
   //FILE* of = fopen("/media/HP_PAVILION/Documents and Settings/HP_Owner/Desktop/parseout.txt","w+b");
   FILE* of_ = fopen("/home/josh/Desktop/parseout.txt","ab");
@@ -30,7 +30,7 @@
 
 namespace syncheck
 {
-  extern string syerr;
+  extern thread_local string syerr;
   int syntacheck(string code);
   void addscr(string name);
 }
@@ -166,8 +166,9 @@ namespace syncheck
     }
   };
   
-  string syerr;
-  vector<token> lex;
+  // Each thread checks its own code, so keeps its own tokens and error
+  thread_local string syerr;
+  thread_local vector<token> lex;
   
   struct open_parenth_info {
     unsigned ind;
@@ -23,6 +23,7 @@
 #include "Universal_System/collisions_object.h"
 #include "Universal_System/instance_system.h" //iter
 #include "Universal_System/instance.h"
+#include "../General/CSbroadphase.h"
 
 #include "BBOXutil.h"
 #include "BBOXimpl.h"
@@ -79,7 +80,7 @@ enigma::object_collisions* const collide_inst_inst(int object, bool solid_only,
 
     get_border(&left1, &right1, &top1, &bottom1, box.left, box.top, box.right, box.bottom, x, y, xscale1, yscale1, ia1);
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, left1, top1, right1, bottom1); it; ++it)
     {
         enigma::object_collisions* const inst2 = (enigma::object_collisions*)*it;
         if (notme && inst2->id == inst1->id)
@@ -89,12 +90,8 @@ enigma::object_collisions* const collide_inst_inst(int object, bool solid_only,
         if (inst2->sprite_index == -1 && inst2->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box2 = inst2->$bbox_relative();
-        const double x2 = inst2->x, y2 = inst2->y,
-                     xscale2 = inst2->image_xscale, yscale2 = inst2->image_yscale,
-                     ia2 = inst2->image_angle;
         int left2, top2, right2, bottom2;
-        get_border(&left2, &right2, &top2, &bottom2, box2.left, box2.top, box2.right, box2.bottom, x2, y2, xscale2, yscale2, ia2);
+        inst2->$bbox_world(&left2, &right2, &top2, &bottom2);
 
         if (left1 <= right2 && left2 <= right1 && top1 <= bottom2 && top2 <= bottom1)
             return inst2;
@@ -115,36 +112,36 @@ enigma::object_collisions* const collide_inst_rect(int object, bool solid_only,
         y1 = y3;
     }
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, x1, y1, x2, y2); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
             continue;
         if (solid_only && !inst->solid)
             continue;
-         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
-            continue;
-
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
-
-        if (left <= x2 && x1 <= right && top <= y2 && y1 <= bottom)
+        if (collide_rect_single(inst, x1, y1, x2, y2))
             return inst;
     }
     return NULL;
 }
 
+bool collide_rect_single(const enigma::object_collisions* inst, int x1, int y1, int x2, int y2)
+{
+    if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
+        return false;
+
+    int left, top, right, bottom;
+    inst->$bbox_world(&left, &right, &top, &bottom);
+    return left <= x2 && x1 <= right && top <= y2 && y1 <= bottom;
+}
+
 enigma::object_collisions* const collide_inst_line(int object, bool solid_only, bool notme, int x1, int y1, int x2, int y2)
 {
     // Ensure x1 != x2 || y1 != y2.
     if (x1 == x2 && y1 == y2)
         return collide_inst_point(object, solid_only, notme, x1, y1);
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, min(x1,x2), min(y1,y2), max(x1,x2), max(y1,y2)); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
@@ -154,12 +151,8 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        inst->$bbox_world(&left, &right, &top, &bottom);
 
         double minX = max(min(x1,x2),left);
         double maxX = min(max(x1,x2),right);
@@ -202,7 +195,7 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
 
 enigma::object_collisions* const collide_inst_point(int object, bool solid_only, bool notme, int x1, int y1)
 {
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, x1, y1, x1, y1); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
@@ -212,12 +205,8 @@ enigma::object_collisions* const collide_inst_point(int object, bool solid_only,
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        inst->$bbox_world(&left, &right, &top, &bottom);
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom)
             return inst;
@@ -249,7 +238,7 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
     if (fzero(rx) || fzero(ry))
         return 0;
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, int(x1 - rx) - 1, int(y1 - ry) - 1, int(x1 + rx) + 1, int(y1 + ry) + 1); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
@@ -259,12 +248,8 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        inst->$bbox_world(&left, &right, &top, &bottom);
 
         const bool intersects = line_ellipse_intersects(rx, ry, left-x1, top-y1, bottom-y1) ||
                                  line_ellipse_intersects(rx, ry, right-x1, top-y1, bottom-y1) ||
@@ -281,7 +266,7 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
 
 void destroy_inst_point(int object, bool solid_only, int x1, int y1)
 {
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, x1, y1, x1, y1); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (solid_only && !inst->solid)
@@ -289,12 +274,8 @@ void destroy_inst_point(int object, bool solid_only, int x1, int y1)
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        inst->$bbox_world(&left, &right, &top, &bottom);
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom)
             enigma_user::instance_destroy(inst->id);
@@ -19,6 +19,7 @@
 
 enigma::object_collisions* const collide_inst_inst(int object, bool solid_only, bool notme, double x, double y);
 enigma::object_collisions* const collide_inst_rect(int object, bool solid_only, bool notme, int x1, int y1, int x2, int y2);
+bool collide_rect_single(const enigma::object_collisions* inst, int x1, int y1, int x2, int y2);
 enigma::object_collisions* const collide_inst_line(int object, bool solid_only, bool notme, int x1, int y1, int x2, int y2);
 enigma::object_collisions* const collide_inst_point(int object, bool solid_only, bool notme, int x1, int y1);
 enigma::object_collisions* const collide_inst_circle(int object, bool solid_only, bool notme, int x1, int y1, double r);
@@ -1,5 +1,7 @@
 #include "BBOXutil.h"
 #include "BBOXimpl.h"
 #include "../General/CSfuncs.h"
+#include "../General/CSbroadphase.h"
+#include "../General/CSbatch.h"
 #include "Collision_Systems/actions.h"
 
@@ -0,0 +1,145 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "Universal_System/instance_system.h"
+#include "CSbatch.h"
+#include <algorithm>
+
+namespace enigma
+{
+  void bbox_batch::clear()
+  {
+    inst.clear();
+    left.clear(), top.clear(), right.clear(), bottom.clear();
+  }
+
+  void bbox_batch::push_back(object_collisions *i)
+  {
+    const object_collisions::world_bbox_t &box = i->$bbox_world();
+    inst.push_back(i);
+    left.push_back(box.left), top.push_back(box.top);
+    right.push_back(box.right), bottom.push_back(box.bottom);
+  }
+
+  void bbox_batch::gather(int object, bool solid_only)
+  {
+    for (iterator it = fetch_inst_iter_by_int(object); it; ++it)
+    {
+      object_collisions *const i = (object_collisions*)*it;
+      if (i->sprite_index == -1 && i->mask_index == -1) // No sprite/mask, so it can't collide
+        continue;
+      if (solid_only && !i->solid)
+        continue;
+      push_back(i);
+    }
+  }
+
+  namespace
+  {
+    struct left_edge_before
+    {
+      const int *left;
+      left_edge_before(const int *l): left(l) {}
+      bool operator()(unsigned i, unsigned j) const { return left[i] < left[j]; }
+    };
+
+    // A batch's boxes copied out in order of their left edges, with the widest box's width.
+    struct sorted_batch
+    {
+      std::vector<unsigned> index;
+      std::vector<int> left, top, right, bottom;
+      int max_width;
+
+      void sort(const bbox_batch &batch)
+      {
+        const size_t n = batch.size();
+        index.resize(n);
+        for (unsigned i = 0; i < n; i++)
+          index[i] = i;
+        std::sort(index.begin(), index.end(), left_edge_before(&batch.left[0]));
+
+        left.resize(n), top.resize(n), right.resize(n), bottom.resize(n);
+        max_width = 0;
+        for (size_t k = 0; k < n; k++) {
+          const unsigned i = index[k];
+          left[k] = batch.left[i], top[k] = batch.top[i];
+          right[k] = batch.right[i], bottom[k] = batch.bottom[i];
+          max_width = std::max(max_width, right[k] - left[k]);
+        }
+      }
+    };
+  }
+
+  // The second batch is sorted on its left edges. A box of the first batch can then only
+  // meet the run of boxes that begin no further left than its own left edge less the widest
+  // box, and no further right than its own right edge; that run is tested with the same
+  // branch-free loop over separate edge arrays as before, which GCC vectorizes at -O3.
+  // One box much wider than the rest widens every run, back to testing every pair.
+  void bbox_batch_overlaps(const bbox_batch &a, const bbox_batch &b, std::vector<batch_index_pair> &out)
+  {
+    if (!a.size() || !b.size())
+      return;
+
+    static sorted_batch s;
+    static std::vector<unsigned char> hit;
+    s.sort(b);
+    hit.resize(b.size());
+
+    const int *const bl = &s.left[0], *const bt = &s.top[0], *const br = &s.right[0], *const bb = &s.bottom[0];
+    unsigned char *const h = &hit[0];
+
+    for (unsigned i = 0; i < a.size(); i++)
+    {
+      const int al = a.left[i], at = a.top[i], ar = a.right[i], ab = a.bottom[i];
+      const size_t lo = std::lower_bound(s.left.begin(), s.left.end(), al - s.max_width) - s.left.begin();
+      const size_t hi = std::upper_bound(s.left.begin() + lo, s.left.end(), ar) - s.left.begin();
+
+      // No branches and no early exit, so this compiles to packed compares.
+      unsigned char any = 0;
+      for (size_t k = lo; k < hi; k++) {
+        h[k] = (al <= br[k]) & (bl[k] <= ar) & (at <= bb[k]) & (bt[k] <= ab);
+        any |= h[k];
+      }
+      if (!any)
+        continue;
+
+      const size_t first = out.size();
+      for (size_t k = lo; k < hi; k++)
+        if (h[k] && a.inst[i] != b.inst[s.index[k]])
+          out.push_back(batch_index_pair(i, s.index[k]));
+      std::sort(out.begin() + first, out.end());
+    }
+  }
+
+  void bbox_batch_pairs(const bbox_batch &a, const bbox_batch &b, std::vector<collision_pair> &out)
+  {
+    static std::vector<batch_index_pair> found;
+    found.clear();
+    bbox_batch_overlaps(a, b, found);
+    for (size_t i = 0; i < found.size(); i++)
+      out.push_back(collision_pair(a.inst[found[i].first], b.inst[found[i].second]));
+  }
+
+  void collision_bbox_pairs(int object1, int object2, std::vector<collision_pair> &out, bool solid_only)
+  {
+    static bbox_batch a, b;
+    a.clear(), b.clear();
+    a.gather(object1);
+    b.gather(object2, solid_only);
+    bbox_batch_pairs(a, b, out);
+  }
+}
@@ -0,0 +1,62 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Batched bounding box queries - compare every instance of one object against every
+// instance of another in one pass, rather than one collision call per instance.
+////////////////////////////////////
+
+#ifndef _ENIGMA_CS_BATCH__H
+#define _ENIGMA_CS_BATCH__H
+
+#include "Universal_System/collisions_object.h"
+#include <vector>
+#include <utility>
+
+namespace enigma
+{
+  typedef std::pair<object_collisions*, object_collisions*> collision_pair;
+
+  // The bounding boxes of a set of instances, one array per edge, so that one instance
+  // can be compared against all of them with straight-line code the compiler vectorizes.
+  struct bbox_batch
+  {
+    std::vector<object_collisions*> inst;
+    std::vector<int> left, top, right, bottom;
+
+    void clear();
+    size_t size() const { return inst.size(); }
+
+    // Appends the instances of `object' (an object index or all) that have a sprite or mask.
+    void gather(int object, bool solid_only = false);
+    void push_back(object_collisions *inst);
+  };
+
+  // Appends every pair (a, b) with a from the first batch and b from the second whose
+  // bounding boxes overlap, ordered by a and then by b. An instance is never paired with
+  // itself, so a batch may be compared against itself.
+  void bbox_batch_pairs(const bbox_batch &a, const bbox_batch &b, std::vector<collision_pair> &out);
+
+  // As bbox_batch_pairs, but gives the pairs as indices into the two batches.
+  typedef std::pair<unsigned, unsigned> batch_index_pair;
+  void bbox_batch_overlaps(const bbox_batch &a, const bbox_batch &b, std::vector<batch_index_pair> &out);
+
+  // Convenience: all overlapping pairs between the instances of two objects.
+  void collision_bbox_pairs(int object1, int object2, std::vector<collision_pair> &out, bool solid_only = false);
+}
+
+#endif
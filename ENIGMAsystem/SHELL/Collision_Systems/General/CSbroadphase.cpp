@@ -0,0 +1,348 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Collision broadphase - a spatial hash of instance bounding boxes, bucketed by grid cell.
+//
+// Instance positions are plain variables, so the hash cannot be told when they change.
+// Instead, the instance system records every instance which may have changed: each one as
+// it becomes the current instance (whenever instance_event_iterator is set, as by an event
+// loop or a with()), and each one looked up by fetch_instance_by_int, as glaccess does for
+// other.x = 0. On each query, the instances recorded since the last query are resampled,
+// along with any created since. Every instance is resampled at the start of each step and
+// before the collision events, where the engine moves instances itself, and on
+// collision_broadphase_update(). If the instance making a query is not the last one
+// recorded as current, it was changed somewhere that did not record it, and every
+// instance is resampled.
+////////////////////////////////////
+
+#include <vector>
+#include <algorithm>
+
+#include "Universal_System/collisions_object.h"
+#include "Universal_System/instance_system.h"
+#include "Universal_System/callbacks_events.h"
+#include "CSbroadphase.h"
+
+namespace enigma
+{
+  bool broadphase_enabled = false;
+
+  namespace
+  {
+    struct bp_entry
+    {
+      object_collisions *inst; // NULL when this slot is free
+      unsigned id;             // Checked against the instance list before `inst' is touched
+      double x, y, xscale, yscale, angle;
+      int sprite, mask;
+      int left, top, right, bottom; // Bounding box as last sampled
+      int cl, ct, cr, cb;           // Cells covered; cl > cr if not hashed
+      bool oversized;               // Too many cells to hash; tested on every query
+      unsigned seen, stamp;
+    };
+
+    const unsigned bp_bucket_count = 1 << 12; // Power of two
+    const int bp_max_cells = 64;              // Per instance, before it is kept aside
+    const int bp_max_query_cells = 1024;      // Per query, before we fall back to scanning
+
+    int cell_size = 64;
+    std::vector<bp_entry> entries;
+    std::vector<int> free_entries;
+    std::vector<std::vector<int> > buckets;
+    std::vector<int> oversized;
+
+    bool needs_full_update = true;
+    int id_watermark = 0;
+    size_t deactivated_count = 0;
+    touched_instances_reader touches;
+    unsigned generation = 0, query_stamp = 0;
+    std::vector<int> hits;
+
+    inline int cell_of(int v) {
+      return v >= 0 ? v / cell_size : -((-v - 1) / cell_size) - 1;
+    }
+    inline std::vector<int> &bucket_of(int cx, int cy) {
+      return buckets[((unsigned)cx * 73856093u ^ (unsigned)cy * 19349663u) & (bp_bucket_count - 1)];
+    }
+
+    void erase_from(std::vector<int> &list, int index)
+    {
+      for (size_t i = 0; i < list.size(); i++)
+        if (list[i] == index) {
+          list[i] = list.back();
+          list.pop_back();
+          return;
+        }
+    }
+
+    void unhash(int index)
+    {
+      bp_entry &e = entries[index];
+      if (e.oversized)
+        erase_from(oversized, index);
+      else for (int cy = e.ct; cy <= e.cb; cy++)
+        for (int cx = e.cl; cx <= e.cr; cx++)
+          erase_from(bucket_of(cx, cy), index);
+      e.cl = 1, e.cr = 0, e.oversized = false;
+    }
+
+    void rehash(int index)
+    {
+      bp_entry &e = entries[index];
+      const int cl = cell_of(e.left - 1), ct = cell_of(e.top - 1),
+                cr = cell_of(e.right + 1), cb = cell_of(e.bottom + 1);
+      if (cl == e.cl && ct == e.ct && cr == e.cr && cb == e.cb)
+        return;
+      unhash(index);
+      if ((cr - cl + 1) * (cb - ct + 1) > bp_max_cells) {
+        e.oversized = true;
+        oversized.push_back(index);
+        return;
+      }
+      e.cl = cl, e.ct = ct, e.cr = cr, e.cb = cb;
+      for (int cy = ct; cy <= cb; cy++)
+        for (int cx = cl; cx <= cr; cx++)
+          bucket_of(cx, cy).push_back(index);
+    }
+
+    void release(int index)
+    {
+      unhash(index);
+      entries[index].inst = NULL;
+      free_entries.push_back(index);
+    }
+
+    // Brings the entry for a live instance up to date, creating it if needed.
+    void sample(object_collisions *inst)
+    {
+      int index = inst->$broadphase_slot;
+      if (index < 0 || size_t(index) >= entries.size() || entries[index].inst != inst || entries[index].id != inst->id)
+      {
+        if (free_entries.empty()) {
+          index = entries.size();
+          entries.push_back(bp_entry());
+        } else {
+          index = free_entries.back();
+          free_entries.pop_back();
+        }
+        bp_entry &e = entries[index];
+        e.inst = inst, e.id = inst->id;
+        e.sprite = e.mask = -2; // Force a resample
+        e.cl = 1, e.cr = 0, e.oversized = false;
+        e.stamp = query_stamp;
+        inst->$broadphase_slot = index;
+      }
+
+      bp_entry &e = entries[index];
+      e.seen = generation;
+      if (e.x == inst->x && e.y == inst->y && e.xscale == inst->image_xscale && e.yscale == inst->image_yscale
+      &&  e.angle == inst->image_angle && e.sprite == inst->sprite_index && e.mask == inst->mask_index)
+        return;
+
+      e.x = inst->x, e.y = inst->y;
+      e.xscale = inst->image_xscale, e.yscale = inst->image_yscale, e.angle = inst->image_angle;
+      e.sprite = inst->sprite_index, e.mask = inst->mask_index;
+      if (e.sprite == -1 && e.mask == -1) { // No sprite/mask, so it can't collide
+        unhash(index);
+        return;
+      }
+      e.left = inst->$bbox_left(), e.right = inst->$bbox_right();
+      e.top = inst->$bbox_top(), e.bottom = inst->$bbox_bottom();
+      rehash(index);
+    }
+
+    inline bool lower_id(const object_collisions *a, const object_collisions *b) {
+      return a->id < b->id;
+    }
+
+    inline bool is_live(const bp_entry &e) {
+      return e.inst && fetch_instance_by_id(e.id) == e.inst;
+    }
+
+    void catch_up()
+    {
+      if (needs_full_update || !touches.intact() || instance_deactivated_list.size() < deactivated_count) {
+        broadphase_update_all();
+        return;
+      }
+      deactivated_count = instance_deactivated_list.size();
+
+      for (size_t i = touches.next; i < touched_instances.size(); i++)
+        if (object_basic *const inst = fetch_instance_by_id(touched_instances[i]))
+          sample((object_collisions*)inst);
+      touches.finish();
+
+      if (maxid > id_watermark) {
+        for (instance_list_iterator it = instance_list.lower_bound(id_watermark); it != instance_list.end(); ++it)
+          sample((object_collisions*)it->second->inst);
+        id_watermark = maxid;
+      }
+    }
+
+    // The engine is about to move instances itself, without recording them.
+    void invalidate()
+    {
+      needs_full_update = true;
+      clear_touched_instances();
+    }
+
+    void reset()
+    {
+      entries.clear();
+      free_entries.clear();
+      oversized.clear();
+      buckets.clear();
+      if (broadphase_enabled)
+        buckets.resize(bp_bucket_count);
+      invalidate();
+    }
+
+    bool callbacks_registered = false;
+  }
+
+  void broadphase_update_all()
+  {
+    if (!broadphase_enabled)
+      return;
+
+    ++generation;
+    for (instance_list_iterator it = instance_list.begin(); it != instance_list.end(); ++it)
+      sample((object_collisions*)it->second->inst);
+    for (size_t i = 0; i < entries.size(); i++)
+      if (entries[i].inst && entries[i].seen != generation)
+        release(i);
+
+    needs_full_update = false;
+    id_watermark = maxid;
+    deactivated_count = instance_deactivated_list.size();
+
+    touches.finish();
+  }
+
+  bool broadphase_query(int object, int left, int top, int right, int bottom, std::vector<object_collisions*> &out)
+  {
+    if (!broadphase_enabled || object >= 100000 || (object < 0 && object != enigma_user::all))
+      return false;
+
+    const int cl = cell_of(left), ct = cell_of(top), cr = cell_of(right), cb = cell_of(bottom);
+    if (double(cr - cl + 1) * (cb - ct + 1) > bp_max_query_cells)
+      return false;
+
+    catch_up();
+
+    const unsigned stamp = ++query_stamp;
+    hits.clear();
+    for (int cy = ct; cy <= cb; cy++)
+      for (int cx = cl; cx <= cr; cx++)
+      {
+        const std::vector<int> &bucket = bucket_of(cx, cy);
+        for (size_t i = 0; i < bucket.size(); i++)
+        {
+          bp_entry &e = entries[bucket[i]];
+          if (e.stamp == stamp)
+            continue;
+          e.stamp = stamp;
+          if (e.left - 1 <= right && left <= e.right + 1 && e.top - 1 <= bottom && top <= e.bottom + 1)
+            hits.push_back(bucket[i]);
+        }
+      }
+    hits.insert(hits.end(), oversized.begin(), oversized.end());
+
+    // Translate entry indices into instances, dropping the dead and the unrelated.
+    const size_t first = out.size();
+    for (size_t i = 0; i < hits.size(); i++)
+    {
+      const bp_entry &e = entries[hits[i]];
+      if (!is_live(e))
+        continue;
+      if (object != enigma_user::all && e.inst->object_index != object && !enigma_user::object_is_ancestor(e.inst->object_index, object))
+        continue;
+      out.push_back(e.inst);
+    }
+
+    // Buckets are unordered; report hits in a stable order, oldest instance first.
+    std::sort(out.begin() + first, out.end(), lower_id);
+    return true;
+  }
+
+  /*------ Candidate iteration --------------------------------*\
+  \*-----------------------------------------------------------*/
+
+  // Queries may be issued while another is being iterated (eg, from a script called by
+  // a collision function), so each live collision_candidates gets its own list.
+  static std::vector<std::vector<object_collisions*>*> candidate_lists;
+  static size_t candidate_depth = 0;
+
+  static std::vector<object_collisions*> *query_candidates(int object, int left, int top, int right, int bottom)
+  {
+    if (!broadphase_enabled)
+      return NULL;
+    if (candidate_depth == candidate_lists.size())
+      candidate_lists.push_back(new std::vector<object_collisions*>());
+    std::vector<object_collisions*> *list = candidate_lists[candidate_depth];
+    list->clear();
+    if (!broadphase_query(object, left, top, right, bottom, *list))
+      return NULL;
+    ++candidate_depth;
+    return list;
+  }
+
+  collision_candidates::collision_candidates(int object, int left, int top, int right, int bottom):
+    list(query_candidates(object, left, top, right, bottom)), pos(0),
+    it(list ? iterator() : fetch_inst_iter_by_int(object)) {}
+
+  collision_candidates::~collision_candidates() {
+    if (list) --candidate_depth;
+  }
+}
+
+namespace enigma_user
+{
+
+void collision_broadphase_enable(bool enable, int cell_size)
+{
+  if (cell_size < 1)
+    cell_size = 1;
+  if (enable == enigma::broadphase_enabled && cell_size == enigma::cell_size)
+    return;
+
+  if (enable != enigma::broadphase_enabled)
+    enigma::track_touched_instances += enable ? 1 : -1;
+  enigma::broadphase_enabled = enable;
+  enigma::cell_size = cell_size;
+  enigma::reset();
+
+  if (enable && !enigma::callbacks_registered) {
+    enigma::callbacks_registered = true;
+    enigma::register_callback_async_update(enigma::invalidate);
+    enigma::register_callback_before_collision_event(enigma::invalidate);
+    enigma::register_callback_clean_up_roomend(enigma::reset);
+  }
+}
+
+bool collision_broadphase_enabled()
+{
+  return enigma::broadphase_enabled;
+}
+
+void collision_broadphase_update()
+{
+  enigma::broadphase_update_all();
+}
+
+}
@@ -0,0 +1,68 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Collision broadphase - an optional spatial hash over the bounding boxes of all instances,
+// which the collision systems consult before testing instances one by one.
+////////////////////////////////////
+
+#ifndef _ENIGMA_CS_BROADPHASE__H
+#define _ENIGMA_CS_BROADPHASE__H
+
+#include "Universal_System/collisions_object.h"
+#include "Universal_System/instance_system_base.h"
+#include <vector>
+
+namespace enigma
+{
+  extern bool broadphase_enabled;
+
+  // Looks up the instances of `object' whose bounding box may overlap the given region.
+  // Returns false if the broadphase cannot answer this query (it is disabled, `object'
+  // names a single instance, or the region is too large to be worth hashing), in which
+  // case the caller should scan the instances of the object directly.
+  bool broadphase_query(int object, int left, int top, int right, int bottom, std::vector<object_collisions*> &out);
+
+  // Resamples the bounding box of every instance and drops instances no longer in the room.
+  void broadphase_update_all();
+
+  // Iterates the instances of an object which may overlap a region. With the broadphase
+  // disabled, this is every instance of the object, as fetch_inst_iter_by_int gives them.
+  class collision_candidates
+  {
+    std::vector<object_collisions*> *list; // Broadphase hits, or NULL to walk `it'
+    size_t pos;
+    iterator it;
+
+    public:
+    operator bool() const { return list ? pos < list->size() : it.it != NULL; }
+    object_collisions* operator*() { return list ? (*list)[pos] : (object_collisions*)*it; }
+    collision_candidates &operator++() { if (list) ++pos; else ++it; return *this; }
+
+    collision_candidates(int object, int left, int top, int right, int bottom);
+    ~collision_candidates();
+  };
+}
+
+namespace enigma_user
+{
+  void collision_broadphase_enable(bool enable, int cell_size = 64);
+  bool collision_broadphase_enabled();
+  void collision_broadphase_update();
+}
+
+#endif
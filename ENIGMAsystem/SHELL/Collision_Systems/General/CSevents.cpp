@@ -0,0 +1,330 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Collision event candidates - before the collision events of a step, every instance with
+// a collision event is compared against the instances it collides with in one batch, so
+// that each event only tests the instances whose bounding boxes overlap its own.
+//
+// The events themselves move instances (solid collisions put the instance back where it
+// was, and code may move either side), so the batch is only a starting point. Every
+// instance recorded as touched during the events (see touched_instances) is checked
+// against the box it was batched with; those which moved, and any created since, are
+// visited by every event against their object. An instance which has moved itself
+// tests every instance of the object, as it would without any batch, from the one it
+// moved at onward. If the record is lost, later events go back to testing every instance.
+////////////////////////////////////
+
+#include "Universal_System/instance_system.h"
+#include "Universal_System/object.h"
+#include "CSbatch.h"
+#include "Collision_Systems/collision_mandatory.h"
+#include <algorithm>
+
+namespace enigma
+{
+  namespace
+  {
+    const size_t none = size_t(-1);
+
+    struct event_box
+    {
+      bool boxed; // Whether it had a sprite or mask, without which the box means nothing
+      int left, top, right, bottom;
+
+      event_box() {}
+      event_box(object_collisions *inst)
+      {
+        boxed = inst->sprite_index != -1 || inst->mask_index != -1;
+        if (!boxed) return;
+        const object_collisions::world_bbox_t &box = inst->$bbox_world();
+        left = box.left, top = box.top, right = box.right, bottom = box.bottom;
+      }
+      bool operator!=(const event_box &o) const {
+        return boxed != o.boxed || (boxed && (left != o.left || top != o.top || right != o.right || bottom != o.bottom));
+      }
+    };
+
+    struct event_self
+    {
+      unsigned id;
+      object_collisions *inst;
+      event_box box;      // Its bounding box when the candidates were gathered
+      size_t first, last; // Its candidates, in collision_event_target::candidates
+    };
+
+    struct roster_entry
+    {
+      unsigned id; // To tell whether `inst' still exists
+      object_collisions *inst;
+      event_box box;
+      bool moved;
+    };
+
+    bool lower_id(const object_collisions *a, const object_collisions *b) { return a->id < b->id; }
+    bool self_before(const event_self &s, unsigned id) { return s.id < id; }
+    bool roster_before(const std::pair<unsigned, size_t> &r, unsigned id) { return r.first < id; }
+  }
+
+  // The instances with a collision event against one object, and their candidates.
+  struct collision_event_target
+  {
+    int object;
+    std::vector<event_self> selves;    // Ordered by id
+    std::vector<roster_entry> roster;  // Every instance of `object', in iteration order
+    std::vector<std::pair<unsigned, size_t> > roster_ids; // (id, index in roster), by id
+    std::vector<size_t> candidates;    // Indices in roster; each self's run is ascending
+    std::vector<size_t> moved;         // Indices in roster of those since moved; ascending
+
+    void note_touched(object_collisions *inst)
+    {
+      std::vector<std::pair<unsigned, size_t> >::const_iterator r =
+          std::lower_bound(roster_ids.begin(), roster_ids.end(), inst->id, roster_before);
+      if (r == roster_ids.end() || r->first != inst->id)
+        return;
+      roster_entry &e = roster[r->second];
+      if (e.moved || e.inst != inst || !(event_box(inst) != e.box))
+        return;
+      e.moved = true;
+      moved.insert(std::lower_bound(moved.begin(), moved.end(), r->second), r->second);
+    }
+
+    // Instances are created at the end of their objects' lists, so they join the end of the roster.
+    void note_created(object_collisions *inst)
+    {
+      if (inst->object_index != object && !enigma_user::object_is_ancestor(inst->object_index, object))
+        return;
+      roster_entry e = { inst->id, inst, event_box(inst), true };
+      roster_ids.push_back(std::make_pair(inst->id, roster.size()));
+      moved.push_back(roster.size());
+      roster.push_back(e);
+    }
+  };
+
+  namespace
+  {
+    std::vector<collision_event_target> targets;
+    size_t target_count = 0;
+    bool candidates_ready = false, tracking = false;
+
+    touched_instances_reader touches;
+    bool touches_lost; // Moves may have gone unrecorded; the batch is of no further use
+    int id_watermark;
+    size_t deactivated_count;
+
+    std::vector<object_collisions*> selves;
+    bbox_batch self_batch, other_batch;
+    std::vector<size_t> other_index; // Of each instance in other_batch, in the roster
+    std::vector<batch_index_pair> found;
+
+    void prepare_target(collision_event_target &t, const int (*pairs)[2], int count)
+    {
+      selves.clear();
+      for (int i = 0; i < count; i++)
+        for (iterator it = fetch_inst_iter_by_int(pairs[i][0]); it; ++it)
+          selves.push_back((object_collisions*)*it);
+
+      // The same instance may have events against the target from more than one parent.
+      std::sort(selves.begin(), selves.end(), lower_id);
+      selves.erase(std::unique(selves.begin(), selves.end()), selves.end());
+      self_batch.clear();
+      for (size_t i = 0; i < selves.size(); i++)
+        self_batch.push_back(selves[i]);
+
+      t.roster.clear(), t.roster_ids.clear(), t.moved.clear();
+      other_batch.clear(), other_index.clear();
+      for (iterator it = fetch_inst_iter_by_int(t.object); it; ++it)
+      {
+        object_collisions *const inst = (object_collisions*)*it;
+        roster_entry e = { inst->id, inst, event_box(inst), false };
+        if (e.box.boxed)
+          other_batch.push_back(inst), other_index.push_back(t.roster.size());
+        t.roster_ids.push_back(std::make_pair(inst->id, t.roster.size()));
+        t.roster.push_back(e);
+      }
+      std::sort(t.roster_ids.begin(), t.roster_ids.end());
+
+      found.clear();
+      bbox_batch_overlaps(self_batch, other_batch, found);
+
+      t.selves.resize(selves.size());
+      t.candidates.resize(found.size());
+      size_t f = 0;
+      for (size_t i = 0; i < selves.size(); i++)
+      {
+        event_self &s = t.selves[i];
+        s.id = selves[i]->id, s.inst = selves[i];
+        s.box = event_box(selves[i]);
+        s.first = f;
+        for (; f < found.size() && found[f].first == i; f++)
+          t.candidates[f] = other_index[found[f].second];
+        s.last = f;
+      }
+    }
+
+    // Brings every target up to date with the instances touched or created since last time.
+    void catch_up()
+    {
+      if (maxid > id_watermark) {
+        for (instance_list_iterator it = instance_list.lower_bound(id_watermark); it != instance_list.end(); ++it)
+          for (size_t t = 0; t < target_count; t++)
+            targets[t].note_created((object_collisions*)it->second->inst);
+        id_watermark = maxid;
+      }
+
+      if (touches_lost)
+        return;
+      if (!touches.intact() || instance_deactivated_list.size() < deactivated_count) {
+        touches_lost = true;
+        return;
+      }
+      deactivated_count = instance_deactivated_list.size();
+
+      for (size_t i = touches.next; i < touched_instances.size(); i++)
+        if (object_basic *const inst = fetch_instance_by_id(touched_instances[i]))
+          for (size_t t = 0; t < target_count; t++)
+            targets[t].note_touched((object_collisions*)inst);
+      touches.finish();
+    }
+
+    inline bool exists(const roster_entry &e) {
+      return fetch_instance_by_id(e.id) == e.inst;
+    }
+  }
+
+  void collision_events_prepare(const int (*pairs)[2], int count)
+  {
+    target_count = 0;
+    for (int i = 0; i < count; )
+    {
+      int j = i + 1;
+      while (j < count && pairs[j][1] == pairs[i][1])
+        j++;
+      if (target_count == targets.size())
+        targets.push_back(collision_event_target());
+      collision_event_target &t = targets[target_count++];
+      t.object = pairs[i][1];
+      prepare_target(t, pairs + i, j - i);
+      i = j;
+    }
+
+    if (!tracking)
+      ++track_touched_instances, tracking = true;
+    clear_touched_instances();
+    touches.finish();
+    touches_lost = false;
+    id_watermark = maxid;
+    deactivated_count = instance_deactivated_list.size();
+    candidates_ready = true;
+  }
+
+  void collision_events_finish()
+  {
+    candidates_ready = false;
+    if (tracking)
+      --track_touched_instances, tracking = false;
+  }
+
+  bool collision_event_candidates::find_prepared(int object)
+  {
+    if (!candidates_ready)
+      return false;
+    catch_up();
+    if (touches_lost)
+      return false;
+    object_collisions *const me = (object_collisions*)instance_event_iterator->inst;
+    for (size_t i = 0; i < target_count; i++)
+    {
+      collision_event_target &t = targets[i];
+      if (t.object != object)
+        continue;
+      std::vector<event_self>::const_iterator s = std::lower_bound(t.selves.begin(), t.selves.end(), me->id, self_before);
+      if (s == t.selves.end() || s->inst != me)
+        return false;
+
+      // If it has moved since, the candidates gathered for it no longer apply.
+      if (event_box(me) != s->box)
+        return false;
+
+      target = &t, self = s - t.selves.begin();
+      advance(0);
+      return true;
+    }
+    return false;
+  }
+
+  // Finds the first candidate at or after `from' in the roster which still exists.
+  void collision_event_candidates::advance(size_t from)
+  {
+    catch_up();
+    const collision_event_target &t = *target;
+    const event_self &s = t.selves[self];
+    if (!rest && (touches_lost || event_box(s.inst) != s.box))
+      rest = true;
+
+    if (rest) {
+      for (at = from; at < t.roster.size() && !exists(t.roster[at]); at++);
+      if (at == t.roster.size())
+        at = none;
+      return;
+    }
+
+    typedef std::vector<size_t>::const_iterator index_iter;
+    const index_iter cand_end = t.candidates.begin() + s.last;
+    index_iter cand = std::lower_bound(t.candidates.begin() + s.first, cand_end, from);
+    index_iter moved = std::lower_bound(t.moved.begin(), t.moved.end(), from);
+    for (;;)
+    {
+      const size_t c = cand < cand_end ? *cand : none, m = moved != t.moved.end() ? *moved : none;
+      at = std::min(c, m);
+      if (at == none || exists(t.roster[at]))
+        return;
+      if (c == at) ++cand;
+      if (m == at) ++moved;
+    }
+  }
+
+  object_basic *collision_event_candidates::operator*() {
+    return target ? target->roster[at].inst : *it;
+  }
+
+  collision_event_candidates &collision_event_candidates::operator++()
+  {
+    if (target)
+      advance(at + 1);
+    else
+      ++it;
+    return *this;
+  }
+
+  collision_event_candidates::collision_event_candidates(int object):
+    target(NULL), self(0), at(none), rest(false), it(find_prepared(object) ? iterator() : fetch_inst_iter_by_int(object)) {}
+
+  object_basic *collision_event_meeting(cs_scalar x, cs_scalar y, int object)
+  {
+    const object_collisions *const self = (object_collisions*)instance_event_iterator->inst;
+    if (!candidates_ready || x != self->x || y != self->y)
+      return place_meeting_inst(x, y, object);
+    collision_event_candidates it(object);
+    if (!it.target)
+      return place_meeting_inst(x, y, object);
+    for (; it; ++it)
+      if (object_basic *const hit = place_meeting_inst(x, y, (*it)->id))
+        return hit;
+    return NULL;
+  }
+}
@@ -23,8 +23,10 @@
 #include "Universal_System/collisions_object.h"
 #include "Universal_System/instance_system.h" //iter
 #include "Universal_System/instance.h"
+#include "../General/CSbroadphase.h"
 
 #include "PRECimpl.h"
+#include "PRECmask.h"
 #include <cmath>
 
 static inline void get_border(int *leftv, int *rightv, int *topv, int *bottomv, int left, int top, int right, int bottom, double x, double y, double xscale, double yscale, double angle)
@@ -61,14 +63,75 @@ static inline double min(double x, double y) { return x<y? x : y; }
 static inline int max(int x, int y) { return x>y? x : y; }
 static inline double max(double x, double y) { return x>y? x : y; }
 
+// The general tests below sample a mask at (int)(column - x), truncating toward zero. For an
+// unrotated, unscaled instance that puts the mask's left edge at floor(x) for columns left of x
+// and at ceil(x) from there on; likewise for rows. Within each such span the mask sits at a
+// fixed integer offset, so it can be tested 64 pixels at a time.
+struct unit_axis
+{
+    int split, before, after;
+    unit_axis(double pos, double offset): split(int(ceil(pos))), before(int(floor(pos) - offset)), after(int(ceil(pos) - offset)) {}
+    int origin(int coord) const { return coord < split ? before : after; }
+};
+
+static inline bool is_unit_transform(double xscale, double yscale, double ia) {
+    return xscale == 1.0 && yscale == 1.0 && ia == 0.0;
+}
+
+// Cuts [lo, hi] at each split inside it; fills bounds with the start of each span, then hi+1.
+static int unit_spans(int lo, int hi, int split1, int split2, int *bounds)
+{
+    int n = 0;
+    bounds[n++] = lo;
+    if (split1 > split2) { const int t = split1; split1 = split2; split2 = t; }
+    if (split1 > lo && split1 <= hi) bounds[n++] = split1;
+    if (split2 > lo && split2 <= hi && split2 != split1) bounds[n++] = split2;
+    bounds[n] = hi + 1;
+    return n;
+}
+
+static bool packed_collision_single(int intersection_left, int intersection_right, int intersection_top, int intersection_bottom,
+                                double x1, double y1, const enigma::collision_mask* mask1, int xoffset1, int yoffset1)
+{
+    const unit_axis ax(x1, xoffset1), ay(y1, yoffset1);
+    int xs[4], ys[4];
+    const int nx = unit_spans(intersection_left, intersection_right, ax.split, ax.split, xs),
+              ny = unit_spans(intersection_top, intersection_bottom, ay.split, ay.split, ys);
+    for (int j = 0; j < ny; j++)
+        for (int i = 0; i < nx; i++)
+            if (enigma::collision_mask_any(mask1, ax.origin(xs[i]), ay.origin(ys[j]), xs[i], ys[j], xs[i+1] - 1, ys[j+1] - 1))
+                return true;
+    return false;
+}
+
+static bool packed_collision_pair(int intersection_left, int intersection_right, int intersection_top, int intersection_bottom,
+                                double x1, double y1, double x2, double y2,
+                                const enigma::collision_mask* mask1, const enigma::collision_mask* mask2,
+                                int xoffset1, int yoffset1, int xoffset2, int yoffset2)
+{
+    const unit_axis ax1(x1, xoffset1), ay1(y1, yoffset1), ax2(x2, xoffset2), ay2(y2, yoffset2);
+    int xs[4], ys[4];
+    const int nx = unit_spans(intersection_left, intersection_right, ax1.split, ax2.split, xs),
+              ny = unit_spans(intersection_top, intersection_bottom, ay1.split, ay2.split, ys);
+    for (int j = 0; j < ny; j++)
+        for (int i = 0; i < nx; i++)
+            if (enigma::collision_mask_overlap(mask1, ax1.origin(xs[i]), ay1.origin(ys[j]), mask2, ax2.origin(xs[i]), ay2.origin(ys[j]),
+                                               xs[i], ys[j], xs[i+1] - 1, ys[j+1] - 1))
+                return true;
+    return false;
+}
+
 static bool precise_collision_single(int intersection_left, int intersection_right, int intersection_top, int intersection_bottom,
                                 double x1, double y1,
                                 double xscale1, double yscale1,
                                 double ia1,
-                                unsigned char* pixels1,
+                                const enigma::collision_mask* pixels1,
                                 int w1, int h1,
                                 int xoffset1, int yoffset1)
 {
+    if (is_unit_transform(xscale1, yscale1, ia1))
+        return packed_collision_single(intersection_left, intersection_right, intersection_top, intersection_bottom,
+                                       x1, y1, pixels1, xoffset1, yoffset1);
 
     if (xscale1 != 0.0 && yscale1 != 0.0) {
 
@@ -91,7 +154,7 @@ static bool precise_collision_single(int intersection_left, int intersection_rig
                 const int by1 = (rowindex - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1->get(px1, py1);
 
                 if (p1) {
                     return true;
@@ -106,10 +169,13 @@ static bool precise_collision_pair(int intersection_left, int intersection_right
                                 double x1, double y1, double x2, double y2,
                                 double xscale1, double yscale1, double xscale2, double yscale2,
                                 double ia1, double ia2,
-                                unsigned char* pixels1, unsigned char* pixels2,
+                                const enigma::collision_mask* pixels1, const enigma::collision_mask* pixels2,
                                 int w1, int h1, int w2, int h2,
                                 int xoffset1, int yoffset1, int xoffset2, int yoffset2)
 {
+    if (is_unit_transform(xscale1, yscale1, ia1) && is_unit_transform(xscale2, yscale2, ia2))
+        return packed_collision_pair(intersection_left, intersection_right, intersection_top, intersection_bottom,
+                                     x1, y1, x2, y2, pixels1, pixels2, xoffset1, yoffset1, xoffset2, yoffset2);
 
     if (xscale1 != 0.0 && yscale1 != 0.0 && xscale2 != 0.0 && yscale2 != 0.0) {
 
@@ -138,14 +204,14 @@ static bool precise_collision_pair(int intersection_left, int intersection_right
                 const int by1 = (rowindex - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1->get(px1, py1);
 
                 //Test for second image.
                 const int bx2 = (colindex - x2);
                 const int by2 = (rowindex - y2);
                 const int px2 = (int)((bx2*cosa2 + by2*sina2)/xscale2 + xoffset2);
                 const int py2 = (int)((bx2*cosa90_2 + by2*sina90_2)/yscale2 + yoffset2);
-                const bool p2 = px2 >= 0 && py2 >= 0 && px2 < w2 && py2 < h2 && pixels2[py2*w2 + px2] != 0;
+                const bool p2 = px2 >= 0 && py2 >= 0 && px2 < w2 && py2 < h2 && pixels2->get(px2, py2);
 
                 //Final test.
                 if (p1 && p2) {
@@ -162,7 +228,7 @@ static bool precise_collision_line(int intersection_left, int intersection_right
                                 double x1, double y1,
                                 double xscale1, double yscale1,
                                 double ia1,
-                                unsigned char* pixels1,
+                                const enigma::collision_mask* pixels1,
                                 int w1, int h1,
                                 int xoffset1, int yoffset1,
                                 int lx1, int ly1, int lx2, int ly2)
@@ -194,7 +260,7 @@ static bool precise_collision_line(int intersection_left, int intersection_right
                 const int by1 = (gy - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1->get(px1, py1);
 
                 if (p1) {
                     return true;
@@ -217,7 +283,7 @@ static bool precise_collision_line(int intersection_left, int intersection_right
                 const int by1 = (gy - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1->get(px1, py1);
 
                 if (p1) {
                     return true;
@@ -233,7 +299,7 @@ static bool precise_collision_ellipse(int intersection_left, int intersection_ri
                                 double x1, double y1,
                                 double xscale1, double yscale1,
                                 double ia1,
-                                unsigned char* pixels1,
+                                const enigma::collision_mask* pixels1,
                                 int w1, int h1,
                                 int xoffset1, int yoffset1,
                                 int ex, int ey, int rx, int ry)
@@ -265,7 +331,7 @@ static bool precise_collision_ellipse(int intersection_left, int intersection_ri
                 const int by1 = (rowindex - y1);
                 const int px1 = (int)((bx1*cosa1 + by1*sina1)/xscale1 + xoffset1);
                 const int py1 = (int)((bx1*cosa90_1 + by1*sina90_1)/yscale1 + yoffset1);
-                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1[py1*w1 + px1] != 0;
+                const bool p1 = px1 >= 0 && py1 >= 0 && px1 < w1 && py1 < h1 && pixels1->get(px1, py1);
 
                 if (p1) {
                     return true;
@@ -292,7 +358,7 @@ enigma::object_collisions* const collide_inst_inst(int object, bool solid_only,
 
     get_border(&left1, &right1, &top1, &bottom1, box.left, box.top, box.right, box.bottom, x, y, xscale1, yscale1, ia1);
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, left1, top1, right1, bottom1); it; ++it)
     {
         enigma::object_collisions* const inst2 = (enigma::object_collisions*)*it;
         if (notme && inst2->id == inst1->id)
@@ -302,12 +368,11 @@ enigma::object_collisions* const collide_inst_inst(int object, bool solid_only,
         if (inst2->sprite_index == -1 && inst2->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box2 = inst2->$bbox_relative();
         const double x2 = inst2->x, y2 = inst2->y,
                      xscale2 = inst2->image_xscale, yscale2 = inst2->image_yscale,
                      ia2 = inst2->image_angle;
         int left2, top2, right2, bottom2;
-        get_border(&left2, &right2, &top2, &bottom2, box2.left, box2.top, box2.right, box2.bottom, x2, y2, xscale2, yscale2, ia2);
+        inst2->$bbox_world(&left2, &right2, &top2, &bottom2);
 
         if (left1 <= right2 && left2 <= right1 && top1 <= bottom2 && top2 <= bottom1) {
 
@@ -321,8 +386,8 @@ enigma::object_collisions* const collide_inst_inst(int object, bool solid_only,
             const int usi1 = ((int) inst1->image_index) % sprite1->subcount;
             const int usi2 = ((int) inst2->image_index) % sprite2->subcount;
 
-            unsigned char* pixels1 = (unsigned char*) (sprite1->colldata[usi1]);
-            unsigned char* pixels2 = (unsigned char*) (sprite2->colldata[usi2]);
+            const enigma::collision_mask* pixels1 = (const enigma::collision_mask*) (sprite1->colldata[usi1]);
+            const enigma::collision_mask* pixels2 = (const enigma::collision_mask*) (sprite2->colldata[usi2]);
 
             if (pixels1 == 0 && pixels2 == 0) { //bbox vs. bbox.
                 return inst2;
@@ -403,73 +468,74 @@ enigma::object_collisions* const collide_inst_rect(int object, bool solid_only,
     if (y1 > y2)
         y1 ^= (y2 ^= (y1 ^= y2));
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, x1, y1, x2, y2); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
             continue;
         if (solid_only && !inst->solid)
             continue;
-         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
-            continue;
-
-        const bbox_rect_t &box = inst->$bbox_relative();
-        const double x = inst->x, y = inst->y,
-                     xscale = inst->image_xscale, yscale = inst->image_yscale,
-                     ia = inst->image_angle;
-        int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
-
-        if (left <= x2 && x1 <= right && top <= y2 && y1 <= bottom) {
-
-            //Only do precise if prec is true AND the sprite is precise.
-            if (!prec) {
-                return inst;
-            }
-
-            const int collsprite_index = inst->mask_index != -1 ? inst->mask_index : inst->sprite_index;
+        if (collide_rect_single(inst, prec, x1, y1, x2, y2))
+            return inst;
+    }
+    return NULL;
+}
 
-            enigma::sprite* sprite = enigma::spritestructarray[collsprite_index];
+bool collide_rect_single(const enigma::object_collisions* inst, bool prec, int x1, int y1, int x2, int y2)
+{
+    if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
+        return false;
 
-            const int usi = ((int) inst->image_index) % sprite->subcount;
+    const double x = inst->x, y = inst->y,
+                 xscale = inst->image_xscale, yscale = inst->image_yscale,
+                 ia = inst->image_angle;
+    int left, top, right, bottom;
+    inst->$bbox_world(&left, &right, &top, &bottom);
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+    if (!(left <= x2 && x1 <= right && top <= y2 && y1 <= bottom))
+        return false;
 
-            if (pixels == 0) { //bbox.
-                return inst;
-            }
-            else { //precise.
-                //Intersection.
-                const int ins_left = max(left, x1);
-                const int ins_right = min(right, x2);
-                const int ins_top = max(top, y1);
-                const int ins_bottom = min(bottom, y2);
+    //Only do precise if prec is true AND the sprite is precise.
+    if (!prec) {
+        return true;
+    }
 
-                //Check per pixel.
+    const int collsprite_index = inst->mask_index != -1 ? inst->mask_index : inst->sprite_index;
 
-                const int w = sprite->width;
-                const int h = sprite->height;
+    enigma::sprite* sprite = enigma::spritestructarray[collsprite_index];
 
-                const double xoffset = sprite->xoffset;
-                const double yoffset = sprite->yoffset;
+    const int usi = ((int) inst->image_index) % sprite->subcount;
 
-                const bool coll_result = precise_collision_single(
-                    ins_left, ins_right, ins_top, ins_bottom,
-                    x, y,
-                    xscale, yscale,
-                    ia,
-                    pixels,
-                    w, h,
-                    xoffset, yoffset
-                );
+    const enigma::collision_mask* pixels = (const enigma::collision_mask*) (sprite->colldata[usi]);
 
-                if (coll_result) {
-                    return inst;
-                }
-            }
-        }
+    if (pixels == 0) { //bbox.
+        return true;
     }
-    return NULL;
+
+    //precise.
+    //Intersection.
+    const int ins_left = max(left, x1);
+    const int ins_right = min(right, x2);
+    const int ins_top = max(top, y1);
+    const int ins_bottom = min(bottom, y2);
+
+    //Check per pixel.
+
+    const int w = sprite->width;
+    const int h = sprite->height;
+
+    const double xoffset = sprite->xoffset;
+    const double yoffset = sprite->yoffset;
+
+    return precise_collision_single(
+        ins_left, ins_right, ins_top, ins_bottom,
+        x, y,
+        xscale, yscale,
+        ia,
+        pixels,
+        w, h,
+        xoffset, yoffset
+    );
 }
 
 enigma::object_collisions* const collide_inst_line(int object, bool solid_only, bool prec, bool notme, int x1, int y1, int x2, int y2)
@@ -478,7 +544,7 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
     if (x1 == x2 && y1 == y2)
         return collide_inst_point(object, solid_only, prec, notme, x1, y1);
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, min(x1,x2), min(y1,y2), max(x1,x2), max(y1,y2)); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
@@ -488,12 +554,11 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
         if (inst->sprite_index == -1 && inst->mask_index == -1) // No sprite/mask then no collision.
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        inst->$bbox_world(&left, &right, &top, &bottom);
 
         double minX = max(min(x1,x2),left);
         double maxX = min(max(x1,x2),right);
@@ -539,7 +604,7 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
 
                 const int usi = ((int) inst->image_index) % sprite->subcount;
 
-                unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+                const enigma::collision_mask* pixels = (const enigma::collision_mask*) (sprite->colldata[usi]);
 
                 if (pixels == NULL) { // Bounding box.
                     return inst;
@@ -583,7 +648,7 @@ enigma::object_collisions* const collide_inst_line(int object, bool solid_only,
 
 enigma::object_collisions* const collide_inst_point(int object, bool solid_only, bool prec, bool notme, int x1, int y1)
 {
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, x1, y1, x1, y1); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
@@ -593,12 +658,11 @@ enigma::object_collisions* const collide_inst_point(int object, bool solid_only,
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        inst->$bbox_world(&left, &right, &top, &bottom);
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom) {
 
@@ -613,7 +677,7 @@ enigma::object_collisions* const collide_inst_point(int object, bool solid_only,
 
             const int usi = ((int) inst->image_index) % sprite->subcount;
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+            const enigma::collision_mask* pixels = (const enigma::collision_mask*) (sprite->colldata[usi]);
 
             if (pixels == 0) { //bbox.
                 return inst;
@@ -676,7 +740,7 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
     if (rx == 0 || ry == 0)
         return 0;
 
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, int(x1 - rx) - 1, int(y1 - ry) - 1, int(x1 + rx) + 1, int(y1 + ry) + 1); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (notme && inst->id == enigma::instance_event_iterator->inst->id)
@@ -686,12 +750,11 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
         if (inst->sprite_index == -1 && inst->mask_index == -1) // No sprite/mask then no collision.
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        inst->$bbox_world(&left, &right, &top, &bottom);
 
         const bool intersects = line_ellipse_intersects(rx, ry, left-x1, top-y1, bottom-y1) ||
                                  line_ellipse_intersects(rx, ry, right-x1, top-y1, bottom-y1) ||
@@ -711,7 +774,7 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
 
             const int usi = ((int) inst->image_index) % sprite->subcount;
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+            const enigma::collision_mask* pixels = (const enigma::collision_mask*) (sprite->colldata[usi]);
 
             if (pixels == 0) { // Bounding Box.
                 return inst;
@@ -753,7 +816,7 @@ enigma::object_collisions* const collide_inst_ellipse(int object, bool solid_onl
 
 void destroy_inst_point(int object, bool solid_only, int x1, int y1)
 {
-    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(object); it; ++it)
+    for (enigma::collision_candidates it(object, x1, y1, x1, y1); it; ++it)
     {
         enigma::object_collisions* const inst = (enigma::object_collisions*)*it;
         if (solid_only && !inst->solid)
@@ -761,12 +824,11 @@ void destroy_inst_point(int object, bool solid_only, int x1, int y1)
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        inst->$bbox_world(&left, &right, &top, &bottom);
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom) {
 
@@ -776,7 +838,7 @@ void destroy_inst_point(int object, bool solid_only, int x1, int y1)
 
             const int usi = ((int) inst->image_index) % sprite->subcount;
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+            const enigma::collision_mask* pixels = (const enigma::collision_mask*) (sprite->colldata[usi]);
 
             if (pixels == 0) { //bbox.
                 enigma_user::instance_destroy(inst->id);
@@ -822,12 +884,11 @@ void change_inst_point(int obj, bool perf, int x1, int y1)
         if (inst->sprite_index == -1 && inst->mask_index == -1) //no sprite/mask then no collision
             continue;
 
-        const bbox_rect_t &box = inst->$bbox_relative();
         const double x = inst->x, y = inst->y,
                      xscale = inst->image_xscale, yscale = inst->image_yscale,
                      ia = inst->image_angle;
         int left, top, right, bottom;
-        get_border(&left, &right, &top, &bottom, box.left, box.top, box.right, box.bottom, x, y, xscale, yscale, ia);
+        inst->$bbox_world(&left, &right, &top, &bottom);
 
         if (x1 >= left && x1 <= right && y1 >= top && y1 <= bottom) {
 
@@ -837,7 +898,7 @@ void change_inst_point(int obj, bool perf, int x1, int y1)
 
             const int usi = ((int) inst->image_index) % sprite->subcount;
 
-            unsigned char* pixels = (unsigned char*) (sprite->colldata[usi]);
+            const enigma::collision_mask* pixels = (const enigma::collision_mask*) (sprite->colldata[usi]);
 
             if (pixels == 0) { //bbox.
                 enigma::instance_change_inst(obj, perf, inst);
@@ -0,0 +1,79 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "PRECmask.h"
+
+static inline int min(int x, int y) { return x<y? x : y; }
+static inline int max(int x, int y) { return x>y? x : y; }
+
+namespace enigma
+{
+  collision_mask::collision_mask(unsigned w, unsigned h): width(w), height(h), stride((w + 63) >> 6)
+  {
+    const unsigned words = stride*h + 1;
+    bits = new uint64_t[words];
+    for (unsigned i = 0; i < words; i++)
+      bits[i] = 0;
+  }
+
+  collision_mask::~collision_mask() {
+    delete[] bits;
+  }
+
+  // Reads the 64 pixels of row y beginning at column x, lowest column in the lowest bit.
+  // Bits past the end of the row are garbage; callers mask them off.
+  static inline uint64_t read_bits(const collision_mask *m, unsigned x, unsigned y)
+  {
+    const uint64_t *const w = m->bits + y*m->stride + (x >> 6);
+    const unsigned shift = x & 63;
+    return shift ? (w[0] >> shift) | (w[1] << (64 - shift)) : w[0];
+  }
+
+  // A mask with the low n bits set, for 1 <= n <= 64.
+  static inline uint64_t low_bits(int n) {
+    return n >= 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+  }
+
+  bool collision_mask_any(const collision_mask *m, int mx, int my, int left, int top, int right, int bottom)
+  {
+    left = max(left, mx), right = min(right, mx + int(m->width) - 1);
+    top = max(top, my), bottom = min(bottom, my + int(m->height) - 1);
+    if (left > right || top > bottom)
+      return false;
+
+    for (int y = top; y <= bottom; y++)
+      for (int x = left; x <= right; x += 64)
+        if (read_bits(m, x - mx, y - my) & low_bits(right - x + 1))
+          return true;
+    return false;
+  }
+
+  bool collision_mask_overlap(const collision_mask *m1, int mx1, int my1, const collision_mask *m2, int mx2, int my2,
+                              int left, int top, int right, int bottom)
+  {
+    left = max(left, max(mx1, mx2)), right = min(right, min(mx1 + int(m1->width), mx2 + int(m2->width)) - 1);
+    top = max(top, max(my1, my2)), bottom = min(bottom, min(my1 + int(m1->height), my2 + int(m2->height)) - 1);
+    if (left > right || top > bottom)
+      return false;
+
+    for (int y = top; y <= bottom; y++)
+      for (int x = left; x <= right; x += 64)
+        if (read_bits(m1, x - mx1, y - my1) & read_bits(m2, x - mx2, y - my2) & low_bits(right - x + 1))
+          return true;
+    return false;
+  }
+}
@@ -0,0 +1,54 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef _ENIGMA_PRECMASK__H
+#define _ENIGMA_PRECMASK__H
+
+#include <stdint.h>
+
+namespace enigma
+{
+  // A subimage's collision mask, packed one bit per pixel, 64 pixels to a word.
+  // Rows start on word boundaries; one spare word at the end lets any 64 pixels of
+  // any row be read as a pair of words without running off the mask.
+  struct collision_mask
+  {
+    unsigned width, height;
+    unsigned stride; // Words per row
+    uint64_t *bits;
+
+    void set(unsigned x, unsigned y) { bits[y*stride + (x >> 6)] |= uint64_t(1) << (x & 63); }
+    // x and y must lie within the mask.
+    bool get(unsigned x, unsigned y) const { return (bits[y*stride + (x >> 6)] >> (x & 63)) & 1; }
+
+    collision_mask(unsigned w, unsigned h);
+    ~collision_mask();
+  };
+
+  // Both tests take a world-space rectangle, inclusive, and the world position of each
+  // mask's top-left pixel; pixels outside a mask count as empty. They are exact only for
+  // unrotated, unscaled instances.
+
+  // Whether any pixel of the mask is set within the rectangle.
+  bool collision_mask_any(const collision_mask *m, int mx, int my, int left, int top, int right, int bottom);
+
+  // Whether any pixel is set in both masks within the rectangle.
+  bool collision_mask_overlap(const collision_mask *m1, int mx1, int my1, const collision_mask *m2, int mx2, int my2,
+                              int left, int top, int right, int bottom);
+}
+
+#endif
@@ -1,3 +1,5 @@
 #include "PRECimpl.h"
 #include "../General/CSfuncs.h"
+#include "../General/CSbroadphase.h"
+#include "../General/CSbatch.h"
 #include "Collision_Systems/actions.h"
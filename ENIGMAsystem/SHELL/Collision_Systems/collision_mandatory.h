@@ -36,10 +36,57 @@ namespace enigma
   void free_collision_mask(void* mask);
 
   #ifdef _COLLISIONS_OBJECT_H
+  }
+  #include "Universal_System/instance_system_base.h"
+  namespace enigma
+  {
     // This function will be invoked each collision event to obtain a pointer to any
     // instance being collided with. It is expected to return NULL for no collision, or
     // an object_basic* pointing to the first instance found.
     object_basic *place_meeting_inst(cs_scalar x, cs_scalar y, int object);
+
+    // Whether one instance collides with a rectangle, inclusive, by the same test that
+    // collision_rectangle applies to each instance it considers.
+    bool rect_meeting_inst(object_basic *inst, bool prec, int x1, int y1, int x2, int y2);
+
+    // Before the collision events of each step, the generated event loop passes every pair
+    // of objects with a collision event, as {object, other object}, ordered by the other
+    // object. The collision system may use these to find candidates for all of those events
+    // at once. After the collision events, collision_events_finish() is invoked; candidates
+    // found earlier must not be used after that.
+    void collision_events_prepare(const int (*pairs)[2], int count);
+    void collision_events_finish();
+
+    struct collision_event_target; // The candidates prepared against one object
+
+    // Iterates the instances of `object' which the current instance should test in its
+    // collision event with `object', in the order fetch_inst_iter_by_int gives them. Where
+    // nothing was prepared for the current instance, this is every instance of `object'.
+    // Instances which move or are created during the collision events are visited as well,
+    // and if the current instance itself moves, every instance after the one it moved at.
+    class collision_event_candidates
+    {
+      collision_event_target *target; // NULL to visit every instance of the object, by `it'
+      size_t self;                    // The current instance, among target's selves
+      size_t at;                      // The current candidate, in target's roster
+      bool rest;                      // Visit all of the roster after `at'
+      iterator it;
+
+      bool find_prepared(int object);
+      void advance(size_t from);
+      friend object_basic *collision_event_meeting(cs_scalar x, cs_scalar y, int object);
+
+      public:
+      operator bool() const { return target ? at != size_t(-1) : it.it != NULL; }
+      object_basic* operator*();
+      collision_event_candidates &operator++();
+
+      collision_event_candidates(int object);
+    };
+
+    // As place_meeting_inst, but for use in collision events: consults the prepared
+    // candidates, when there are any, rather than every instance of `object'.
+    object_basic *collision_event_meeting(cs_scalar x, cs_scalar y, int object);
   #endif
 }
 
@@ -34,18 +34,22 @@
       show_error("Attempting to draw non-existing background " + toString(back), false);\
       return;\
     }\
-    const enigma::background *const bck2d = enigma::backgroundstructarray[back];
+    const enigma::background *const bck2d = enigma::backgroundstructarray[back];\
+    enigma::background_load(bck2d);
   #define get_backgroundnv(bck2d,back,r)\
     if (back < 0 or size_t(back) >= enigma::background_idmax or !enigma::backgroundstructarray[back]) {\
       show_error("Attempting to draw non-existing background " + toString(back), false);\
       return r;\
     }\
-    const enigma::background *const bck2d = enigma::backgroundstructarray[back];
+    const enigma::background *const bck2d = enigma::backgroundstructarray[back];\
+    enigma::background_load(bck2d);
 #else
   #define get_background(bck2d,back)\
-    const enigma::background *const bck2d = enigma::backgroundstructarray[back];
+    const enigma::background *const bck2d = enigma::backgroundstructarray[back];\
+    enigma::background_load(bck2d);
   #define get_backgroundnv(bck2d,back,r)\
-    const enigma::background *const bck2d = enigma::backgroundstructarray[back];
+    const enigma::background *const bck2d = enigma::backgroundstructarray[back];\
+    enigma::background_load(bck2d);
 #endif
 
 #define __GETR(x) ((x & 0x0000FF))
@@ -42,12 +42,14 @@ using std::string;
     if (id < -1 or size_t(id) > enigma::sprite_idmax or !enigma::spritestructarray[id]) { \
       show_error("Cannot access sprite with id " + toString(id), false); \
       return r; \
-    } const enigma::sprite *const spr = enigma::spritestructarray[id];
+    } const enigma::sprite *const spr = enigma::spritestructarray[id]; \
+    enigma::sprite_load(spr);
   #define get_spritev(spr,id) \
     if (id < -1 or size_t(id) > enigma::sprite_idmax or !enigma::spritestructarray[id]) { \
       show_error("Cannot access sprite with id " + toString(id), false); \
       return; \
-    } const enigma::sprite *const spr = enigma::spritestructarray[id];
+    } const enigma::sprite *const spr = enigma::spritestructarray[id]; \
+    enigma::sprite_load(spr);
   #define get_sprite_null(spr,id,r) \
     if (id < -1 or size_t(id) > enigma::sprite_idmax) { \
       show_error("Cannot access sprite with id " + toString(id), false); \
@@ -55,9 +57,11 @@ using std::string;
     } const enigma::sprite *const spr = enigma::spritestructarray[id];
 #else
   #define get_sprite(spr,id,r) \
-    const enigma::sprite *const spr = enigma::spritestructarray[id];
+    const enigma::sprite *const spr = enigma::spritestructarray[id]; \
+    enigma::sprite_load(spr);
   #define get_spritev(spr,id) \
-    const enigma::sprite *const spr = enigma::spritestructarray[id];
+    const enigma::sprite *const spr = enigma::spritestructarray[id]; \
+    enigma::sprite_load(spr);
   #define get_sprite_null(spr,id,r) \
     const enigma::sprite *const spr = enigma::spritestructarray[id];
 #endif
@@ -70,14 +74,15 @@ void draw_sprite(int spr,int subimg, gs_scalar x, gs_scalar y, int color, gs_sca
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
 
-	const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+	const gs_scalar tx = spr2d->texxarray[usi], ty = spr2d->texyarray[usi],
+			tbx = tx + spr2d->texbordxarray[usi], tby = ty + spr2d->texbordyarray[usi],
 			xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + spr2d->width,
 			yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + spr2d->height;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2, 0,tby,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tx,ty,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tbx,ty,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2, tx,tby,color,alpha);
 	draw_vertex_texture_color(xvert2,yvert2, tbx,tby,color,alpha);
 	draw_primitive_end();
 }
@@ -91,19 +96,20 @@ void draw_sprite_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_scalar xs
 
     const gs_scalar
     w = spr2d->width*xscale, h = spr2d->height*yscale,
-    tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+    tx = spr2d->texxarray[usi], ty = spr2d->texyarray[usi],
+    tbx = tx + spr2d->texbordxarray[usi], tby = ty + spr2d->texbordyarray[usi],
     wsinrot = w*sin(rot), wcosrot = w*cos(rot);
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
 	gs_scalar
 		ulcx = x - xscale * spr2d->xoffset * cos(rot) + yscale * spr2d->yoffset * cos(M_PI/2+rot),
 		ulcy = y + xscale * spr2d->xoffset * sin(rot) - yscale * spr2d->yoffset * sin(M_PI/2+rot);
-	draw_vertex_texture_color(ulcx,ulcy, 0,0, color, alpha);
-	draw_vertex_texture_color(ulcx + wcosrot, ulcy - wsinrot, tbx, 0, color, alpha);
+	draw_vertex_texture_color(ulcx,ulcy, tx,ty, color, alpha);
+	draw_vertex_texture_color(ulcx + wcosrot, ulcy - wsinrot, tbx, ty, color, alpha);
 	const double mpr = 3*M_PI/2 + rot;
     ulcx += h * cos(mpr);
     ulcy -= h * sin(mpr);
-	draw_vertex_texture_color(ulcx,ulcy, 0,tby, color, alpha);
+	draw_vertex_texture_color(ulcx,ulcy, tx,tby, color, alpha);
 	draw_vertex_texture_color(ulcx + wcosrot, ulcy - wsinrot, tbx,tby, color, alpha);
 	draw_primitive_end();
 }
@@ -113,12 +119,13 @@ void draw_sprite_pos(int spr, int subimg, gs_scalar x1, gs_scalar y1, gs_scalar
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
 
-    const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi];
+    const gs_scalar tx = spr2d->texxarray[usi], ty = spr2d->texyarray[usi],
+    tbx = tx + spr2d->texbordxarray[usi], tby = ty + spr2d->texbordyarray[usi];
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(x1,y1,0,0,draw_get_color(),alpha);
-	draw_vertex_texture_color(x2,y1,tbx,0,draw_get_color(),alpha);
-	draw_vertex_texture_color(x1,y2,0,tby,draw_get_color(),alpha);
+	draw_vertex_texture_color(x1,y1,tx,ty,draw_get_color(),alpha);
+	draw_vertex_texture_color(x2,y1,tbx,ty,draw_get_color(),alpha);
+	draw_vertex_texture_color(x1,y2,tx,tby,draw_get_color(),alpha);
 	draw_vertex_texture_color(x2,y2,tbx,tby,draw_get_color(),alpha);
 	draw_primitive_end();
 }
@@ -129,8 +136,8 @@ void draw_sprite_part(int spr, int subimg, gs_scalar left, gs_scalar top, gs_sca
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
 
 	gs_scalar tbw = spr2d->width/(gs_scalar)spr2d->texbordxarray[usi], tbh = spr2d->height/(gs_scalar)spr2d->texbordyarray[usi],
-	  tbx1 = left/tbw, tbx2 = tbx1 + width/tbw,
-	  tby1 = top/tbh, tby2 = tby1 + height/tbh;
+	  tbx1 = spr2d->texxarray[usi] + left/tbw, tbx2 = tbx1 + width/tbw,
+	  tby1 = spr2d->texyarray[usi] + top/tbh, tby2 = tby1 + height/tbh;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
 	draw_vertex_texture_color(x,y,tbx1,tby1,color,alpha);
@@ -148,8 +155,8 @@ void draw_sprite_part_offset(int spr, int subimg, gs_scalar left, gs_scalar top,
 	gs_scalar tbw = spr2d->width/spr2d->texbordxarray[usi], tbh = spr2d->height/spr2d->texbordyarray[usi],
 	  xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + spr2d->width,
 	  yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + spr2d->height,
-	  tbx1 = left/tbw, tbx2 = tbx1 + width/tbw,
-	  tby1 = top/tbh, tby2 = tby1 + height/tbh;
+	  tbx1 = spr2d->texxarray[usi] + left/tbw, tbx2 = tbx1 + width/tbw,
+	  tby1 = spr2d->texyarray[usi] + top/tbh, tby2 = tby1 + height/tbh;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
 	draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
@@ -167,8 +174,8 @@ void draw_sprite_part_ext(int spr, int subimg, gs_scalar left, gs_scalar top, gs
 	gs_scalar tbw = spr2d->width/(gs_scalar)spr2d->texbordxarray[usi], tbh = spr2d->height/(gs_scalar)spr2d->texbordyarray[usi],
 	  xvert1 = x, xvert2 = xvert1 + width*xscale,
 	  yvert1 = y, yvert2 = yvert1 + height*yscale,
-	  tbx1 = left/tbw, tbx2 = tbx1 + width/tbw,
-	  tby1 = top/tbh, tby2 = tby1 + height/tbh;
+	  tbx1 = spr2d->texxarray[usi] + left/tbw, tbx2 = tbx1 + width/tbw,
+	  tby1 = spr2d->texyarray[usi] + top/tbh, tby2 = tby1 + height/tbh;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
 	draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
@@ -186,6 +193,7 @@ void draw_sprite_general(int spr, int subimg, gs_scalar left, gs_scalar top, gs_
 	const gs_scalar
 	  tbx = spr2d->texbordxarray[usi],  tby = spr2d->texbordyarray[usi],
 	  tbw = spr2d->width/tbx, tbh = spr2d->height/tby,
+	  tx = spr2d->texxarray[usi], ty = spr2d->texyarray[usi],
 	  w = width*xscale, h = height*yscale;
 
     rot *= M_PI/180;
@@ -197,14 +205,14 @@ void draw_sprite_general(int spr, int subimg, gs_scalar left, gs_scalar top, gs_
     ulcx = x + xscale * cos(M_PI+rot) + yscale * cos(M_PI/2+rot),
     ulcy = y - yscale * sin(M_PI+rot) - yscale * sin(M_PI/2+rot);
 
-	draw_vertex_texture_color(ulcx, ulcy, left/tbw, top/tbh, c1, alpha);
-	draw_vertex_texture_color((ulcx + wcosrot), (ulcy - wsinrot), (left+width)/tbw, top/tbh, c2, alpha);
+	draw_vertex_texture_color(ulcx, ulcy, tx + left/tbw, ty + top/tbh, c1, alpha);
+	draw_vertex_texture_color((ulcx + wcosrot), (ulcy - wsinrot), tx + (left+width)/tbw, ty + top/tbh, c2, alpha);
 
     ulcx += h * cos(3*M_PI/2 + rot);
     ulcy -= h * sin(3*M_PI/2 + rot);
 
-	draw_vertex_texture_color((ulcx + wcosrot), (ulcy - wsinrot), (left+width)/tbw, (top+height)/tbh, c4, alpha);
-	draw_vertex_texture_color(ulcx, ulcy, left/tbw, (top+height)/tbh, c3, alpha);
+	draw_vertex_texture_color((ulcx + wcosrot), (ulcy - wsinrot), tx + (left+width)/tbw, ty + (top+height)/tbh, c4, alpha);
+	draw_vertex_texture_color(ulcx, ulcy, tx + left/tbw, ty + (top+height)/tbh, c3, alpha);
 
     draw_primitive_end();
 }
@@ -214,14 +222,15 @@ void draw_sprite_stretched(int spr, int subimg, gs_scalar x, gs_scalar y, gs_sca
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
 
-    const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+    const gs_scalar tx = spr2d->texxarray[usi], ty = spr2d->texyarray[usi],
+                tbx = tx + spr2d->texbordxarray[usi], tby = ty + spr2d->texbordyarray[usi],
                 xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + width,
                 yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + height;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2, 0,tby,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tx,ty,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tbx,ty,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2, tx,tby,color,alpha);
 	draw_vertex_texture_color(xvert2,yvert2, tbx,tby,color,alpha);
 	draw_primitive_end();
 }
@@ -231,14 +240,15 @@ void draw_sprite_stretched_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
 
-    const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+    const gs_scalar tx = spr2d->texxarray[usi], ty = spr2d->texyarray[usi],
+                tbx = tx + spr2d->texbordxarray[usi], tby = ty + spr2d->texbordyarray[usi],
                 xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + width,
                 yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + height;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-	draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-	draw_vertex_texture_color(xvert1,yvert2, 0,tby,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert1,tx,ty,color,alpha);
+	draw_vertex_texture_color(xvert2,yvert1,tbx,ty,color,alpha);
+	draw_vertex_texture_color(xvert1,yvert2, tx,tby,color,alpha);
 	draw_vertex_texture_color(xvert2,yvert2, tbx,tby,color,alpha);
 	draw_primitive_end();
 }
@@ -248,14 +258,15 @@ void d3d_draw_sprite(int spr,int subimg, gs_scalar x, gs_scalar y, gs_scalar z)
     get_spritev(spr2d,spr);
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
 
-	const gs_scalar tbx = spr2d->texbordxarray[usi], tby = spr2d->texbordyarray[usi],
+	const gs_scalar tx = spr2d->texxarray[usi], ty = spr2d->texyarray[usi],
+			tbx = tx + spr2d->texbordxarray[usi], tby = ty + spr2d->texbordyarray[usi],
 			xvert1 = x-spr2d->xoffset, xvert2 = xvert1 + spr2d->width,
 			yvert1 = y-spr2d->yoffset, yvert2 = yvert1 + spr2d->height;
 
 	draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-	d3d_vertex_texture(xvert1,yvert1,z,0,0);
-	d3d_vertex_texture(xvert2,yvert1,z,tbx,0);
-	d3d_vertex_texture(xvert1,yvert2,z,0,tby);
+	d3d_vertex_texture(xvert1,yvert1,z,tx,ty);
+	d3d_vertex_texture(xvert2,yvert1,z,tbx,ty);
+	d3d_vertex_texture(xvert1,yvert2,z,tx,tby);
 	d3d_vertex_texture(xvert2,yvert2,z,tbx,tby);
 	draw_primitive_end();
 }
@@ -281,7 +292,8 @@ void draw_sprite_tiled(int spr, int subimg, gs_scalar x, gs_scalar y, int color,
     x = ((spr2d->xoffset+x)<0?0:spr2d->width)-fmod(spr2d->xoffset+x,spr2d->width);
     y = ((spr2d->yoffset+y)<0?0:spr2d->height)-fmod(spr2d->yoffset+y,spr2d->height);
 
-    const gs_scalar tbx  = spr2d->texbordxarray[usi], tby  = spr2d->texbordyarray[usi];
+    const gs_scalar tx = spr2d->texxarray[usi], ty = spr2d->texyarray[usi],
+    tbx = tx + spr2d->texbordxarray[usi], tby = ty + spr2d->texbordyarray[usi];
 
     const int
     hortil = int(ceil((view_enabled ? (gs_scalar)(view_xview[view_current] + view_wview[view_current]) : (gs_scalar)room_width) / ((gs_scalar)spr2d->width))) + 1,
@@ -294,9 +306,9 @@ void draw_sprite_tiled(int spr, int subimg, gs_scalar x, gs_scalar y, int color,
         for (int c=0; c<vertil; ++c)
         {
 			draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-			draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-			draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-			draw_vertex_texture_color(xvert1,yvert2,0,tby,color,alpha);
+			draw_vertex_texture_color(xvert1,yvert1,tx,ty,color,alpha);
+			draw_vertex_texture_color(xvert2,yvert1,tbx,ty,color,alpha);
+			draw_vertex_texture_color(xvert1,yvert2,tx,tby,color,alpha);
 			draw_vertex_texture_color(xvert2,yvert2,tbx,tby,color,alpha);
 			draw_primitive_end();
             yvert1 = yvert2;
@@ -313,7 +325,8 @@ void draw_sprite_tiled_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_sca
     const int usi = subimg >= 0 ? (subimg % spr2d->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr2d->subcount;
 
     const gs_scalar
-    tbx  = spr2d->texbordxarray[usi], tby  = spr2d->texbordyarray[usi],
+    tx = spr2d->texxarray[usi], ty = spr2d->texyarray[usi],
+    tbx = tx + spr2d->texbordxarray[usi], tby = ty + spr2d->texbordyarray[usi],
     width_scaled = spr2d->width*xscale, height_scaled = spr2d->height*yscale;
 
     x = ((spr2d->xoffset*xscale+x)<0?0:width_scaled)-fmod(spr2d->xoffset*xscale+x,width_scaled);
@@ -330,9 +343,9 @@ void draw_sprite_tiled_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_sca
         for (int c=0; c<vertil; ++c)
         {
 			draw_primitive_begin_texture(pr_trianglestrip, spr2d->texturearray[usi]);
-			draw_vertex_texture_color(xvert1,yvert1,0,0,color,alpha);
-			draw_vertex_texture_color(xvert2,yvert1,tbx,0,color,alpha);
-			draw_vertex_texture_color(xvert1,yvert2,0,tby,color,alpha);
+			draw_vertex_texture_color(xvert1,yvert1,tx,ty,color,alpha);
+			draw_vertex_texture_color(xvert2,yvert1,tbx,ty,color,alpha);
+			draw_vertex_texture_color(xvert1,yvert2,tx,tby,color,alpha);
 			draw_vertex_texture_color(xvert2,yvert2,tbx,tby,color,alpha);
 			draw_primitive_end();
             yvert1 = yvert2;
@@ -15,6 +15,15 @@
 *** with this code. If not, see <http://www.gnu.org/licenses/>
 **/
 
+#include <stddef.h>
+
+namespace enigma
+{
+  // Maps a whole file into memory, read-only, for as long as the game runs. Returns NULL if
+  // the file cannot be opened or mapped.
+  const unsigned char *file_map(const char *fname, size_t *size);
+}
+
 namespace enigma_user
 {
 
@@ -0,0 +1,257 @@
+/** Copyright (C) 2008-2011 Josh Ventura
+*** Copyright (C) 2014 Robert B. Colton
+*** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+
+#include "Universal_System/var4.h"
+#include "Universal_System/resource_data.h"
+#include "PFthreads.h"
+#include <vector>
+
+#ifdef DEBUG_MODE
+  #include <string>
+  #include "libEGMstd.h"
+  #include "Widget_Systems/widgets_mandatory.h"
+#endif
+
+namespace enigma
+{
+  // A script run as a thread. The job outlives its run, so the return value can be read after
+  // the pool is done with it, until the thread is joined or freed; it is deleted once the
+  // thread's slot, the pool, and every thread waiting on it have let go of it.
+  struct script_job: pool_job
+  {
+    int scr;
+    variant args[8];
+    variant ret; // Written by whichever thread runs the script; read once the job is done
+    int refs; // Guarded by script_thread_lock
+
+    void run(unsigned) {
+      ret = enigma_user::script_execute(scr,args[0],args[1],args[2],args[3],args[4],args[5],args[6],args[7]);
+    }
+    void release();
+    script_job(): refs(2) {} // One for the slot, one for the pool
+  };
+
+  // Scripts run on the workers may start, join and free threads of their own, so everything
+  // below, and each job's refs, is guarded by this lock. It is never held while waiting, and
+  // never destroyed, as workers may still be running scripts as the game exits.
+  static thread_mutex& script_thread_lock = *new thread_mutex;
+
+  // A thread id is its slot's index in the low bits, and the slot's generation above them;
+  // the generation changes each time the slot is released, so an id kept past thread_join
+  // or thread_free never reaches the thread that next gets the slot.
+  static const int script_thread_index_bits = 16;
+  static const unsigned script_thread_index_mask = (1u << script_thread_index_bits) - 1;
+
+  static std::vector<script_job*> script_threads; // NULL where the slot is free
+  static std::vector<unsigned> script_thread_generations;
+  static std::vector<int> free_script_threads;
+
+  static int script_thread_id(int index) {
+    return int(script_thread_generations[index] << script_thread_index_bits | index);
+  }
+
+  // The job of a thread the game may still use, or NULL if the id is invalid, or was
+  // already joined or freed. Call with script_thread_lock held.
+  static script_job* find_script_thread(int thread)
+  {
+    if (thread < 0)
+      return NULL;
+    const unsigned index = unsigned(thread) & script_thread_index_mask;
+    if (index >= script_threads.size() || script_thread_generations[index] != unsigned(thread) >> script_thread_index_bits)
+      return NULL;
+    return script_threads[index];
+  }
+
+  // Reports a thread id the game passed to `function' which find_script_thread refused.
+  static void bad_script_thread(int thread, const char* function)
+  {
+    #ifdef DEBUG_MODE
+    show_error(std::string(function) + ": no thread with id " + toString(thread), false);
+    #endif
+  }
+
+  // Call with script_thread_lock held.
+  static void unref_script_job(script_job* job)
+  {
+    if (!--job->refs)
+      delete job;
+  }
+
+  // Call with script_thread_lock held.
+  static void release_script_thread(int index)
+  {
+    unref_script_job(script_threads[index]);
+    script_threads[index] = NULL;
+    script_thread_generations[index] = (script_thread_generations[index] + 1) & (~0u >> (script_thread_index_bits + 1));
+    free_script_threads.push_back(index);
+  }
+
+  void script_job::release()
+  {
+    script_thread_lock.lock();
+    unref_script_job(this);
+    script_thread_lock.unlock();
+  }
+
+  // Waits for the first of the jobs to be done, taking on any that no worker has started, so
+  // a script on a worker never waits on a queue that only its own worker would get to.
+  static size_t wait_script_jobs(pool_job* const* jobs, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+      if (thread_pool_run_here(jobs[i]))
+        return i;
+    return thread_pool_wait_any(jobs, count);
+  }
+}
+
+namespace enigma_user
+{
+
+int script_thread(int scr,variant arg0, variant arg1, variant arg2, variant arg3, variant arg4, variant arg5, variant arg6, variant arg7)
+{
+  if (!enigma::thread_pool_size())
+    return -1;
+
+  enigma::script_job* job = new enigma::script_job;
+  job->scr = scr;
+  job->args[0] = arg0, job->args[1] = arg1, job->args[2] = arg2, job->args[3] = arg3;
+  job->args[4] = arg4, job->args[5] = arg5, job->args[6] = arg6, job->args[7] = arg7;
+
+  enigma::script_thread_lock.lock();
+  int index;
+  if (enigma::free_script_threads.empty()) {
+    if (enigma::script_threads.size() > enigma::script_thread_index_mask) {
+      enigma::script_thread_lock.unlock();
+      delete job;
+      return -1;
+    }
+    index = enigma::script_threads.size();
+    enigma::script_threads.push_back(NULL);
+    enigma::script_thread_generations.push_back(0);
+  } else {
+    index = enigma::free_script_threads.back();
+    enigma::free_script_threads.pop_back();
+  }
+  enigma::script_threads[index] = job;
+  const int id = enigma::script_thread_id(index);
+  enigma::thread_pool_submit(job);
+  enigma::script_thread_lock.unlock();
+  return id;
+}
+
+bool thread_get_finished(int thread) {
+  enigma::script_thread_lock.lock();
+  const enigma::script_job* job = enigma::find_script_thread(thread);
+  const bool finished = job && enigma::thread_pool_done(job);
+  enigma::script_thread_lock.unlock();
+  if (!job)
+    enigma::bad_script_thread(thread, "thread_get_finished");
+  return finished;
+}
+
+variant thread_get_return(int thread) {
+  enigma::script_thread_lock.lock();
+  const enigma::script_job* job = enigma::find_script_thread(thread);
+  const variant ret = job && enigma::thread_pool_done(job) ? job->ret : variant(0);
+  enigma::script_thread_lock.unlock();
+  if (!job)
+    enigma::bad_script_thread(thread, "thread_get_return");
+  return ret;
+}
+
+variant thread_join(int thread)
+{
+  enigma::script_thread_lock.lock();
+  enigma::script_job* job = enigma::find_script_thread(thread);
+  if (!job) {
+    enigma::script_thread_lock.unlock();
+    enigma::bad_script_thread(thread, "thread_join");
+    return 0;
+  }
+  job->refs++;
+  enigma::script_thread_lock.unlock();
+
+  enigma::pool_job* wait = job;
+  enigma::wait_script_jobs(&wait, 1);
+
+  enigma::script_thread_lock.lock();
+  const variant ret = job->ret;
+  if (enigma::find_script_thread(thread) == job) // Unless another thread freed it meanwhile
+    enigma::release_script_thread(thread & enigma::script_thread_index_mask);
+  enigma::unref_script_job(job);
+  enigma::script_thread_lock.unlock();
+  return ret;
+}
+
+int thread_wait_any()
+{
+  std::vector<enigma::pool_job*> jobs;
+  std::vector<int> ids;
+  enigma::script_thread_lock.lock();
+  for (size_t i = 0; i < enigma::script_threads.size(); i++)
+  {
+    enigma::script_job* job = enigma::script_threads[i];
+    if (!job)
+      continue;
+    if (enigma::thread_pool_done(job)) {
+      for (size_t j = 0; j < jobs.size(); j++)
+        enigma::unref_script_job(static_cast<enigma::script_job*>(jobs[j]));
+      enigma::script_thread_lock.unlock();
+      return enigma::script_thread_id(i);
+    }
+    job->refs++;
+    jobs.push_back(job);
+    ids.push_back(enigma::script_thread_id(i));
+  }
+  enigma::script_thread_lock.unlock();
+  if (jobs.empty())
+    return -1;
+
+  const size_t done = enigma::wait_script_jobs(&jobs[0], jobs.size());
+
+  enigma::script_thread_lock.lock();
+  for (size_t j = 0; j < jobs.size(); j++)
+    enigma::unref_script_job(static_cast<enigma::script_job*>(jobs[j]));
+  enigma::script_thread_lock.unlock();
+  return ids[done];
+}
+
+bool thread_cancel(int thread) {
+  enigma::script_thread_lock.lock();
+  enigma::script_job* job = enigma::find_script_thread(thread);
+  const bool cancelled = job && enigma::thread_pool_cancel(job);
+  enigma::script_thread_lock.unlock();
+  if (!job)
+    enigma::bad_script_thread(thread, "thread_cancel");
+  return cancelled;
+}
+
+void thread_free(int thread)
+{
+  enigma::script_thread_lock.lock();
+  const bool found = enigma::find_script_thread(thread);
+  if (found)
+    enigma::release_script_thread(thread & enigma::script_thread_index_mask);
+  enigma::script_thread_lock.unlock();
+  if (!found)
+    enigma::bad_script_thread(thread, "thread_free");
+}
+
+}
@@ -18,26 +18,84 @@
 #ifndef ENIGMA_PLATFORM_THREADS_H
 #define ENIGMA_PLATFORM_THREADS_H
 
-#include <deque>
 #include <stdio.h>
 //using namespace std;
 
 #include "Universal_System/var4.h"
 
-struct ethread
+namespace enigma
 {
-  //pthread_t me; //TODO: Do not uncomment or you will break Windows, handle is defined but not in use anyway.
-  bool active;
-  variant ret;
-  ethread(): active(true), ret(0) {};
-};
+  // Work for the worker pool. run() is called on a worker thread, with the index of that
+  // worker; once it returns, finish() is called on the game thread at the start of the next
+  // step, and then release(), which deletes the job unless the job says otherwise.
+  struct pool_job
+  {
+    bool done; // Set by the pool once run() has returned; read it through thread_pool_done
+    virtual void run(unsigned worker) = 0;
+    virtual void finish() {}
+    virtual void release() { delete this; }
+    pool_job(): done(false) {}
+    virtual ~pool_job() {}
+  };
 
-static std::deque<ethread*> threads;
+  // A plain lock, for state which jobs share with the game thread. Each platform's threads
+  // file implements it alongside the pool.
+  class thread_mutex
+  {
+    void* handle;
+    thread_mutex(const thread_mutex&);
+    void operator=(const thread_mutex&);
+  public:
+    thread_mutex();
+    ~thread_mutex();
+    void lock();
+    void unlock();
+  };
+
+  // The number of workers in the pool, starting them if they are not yet running. Worker
+  // indices run from zero to one less than this; it is zero if no thread could be started.
+  unsigned thread_pool_size();
+  // Whether the calling thread is one of the pool's workers.
+  bool thread_pool_on_worker();
+  // Queues a job for the next free worker, or returns false if there are no workers.
+  bool thread_pool_submit(pool_job* job);
+  // Calls finish() on, and deletes, every job whose run() has returned.
+  void thread_pool_finish_jobs();
+
+  // Takes a job off the queue if no worker has started it yet, in which case run() is never
+  // called; it counts as done, and is finished as usual. Returns whether it was in time.
+  bool thread_pool_cancel(pool_job* job);
+  // Whether a job's run() has returned, or it was cancelled.
+  bool thread_pool_done(const pool_job* job);
+  // Runs a job on the calling thread if no worker has started it yet, then counts it done;
+  // returns whether it did. run() is given thread_pool_size() as its worker index, which
+  // no worker has, so this is only for jobs that keep no state per worker.
+  bool thread_pool_run_here(pool_job* job);
+  // Blocks until any of the given jobs is done, and returns its index. Any thread may wait,
+  // so long as the jobs cannot be released meanwhile; the game thread releases them, so it
+  // need not care, but a worker must hold on to them as script threads do.
+  size_t thread_pool_wait_any(pool_job* const* jobs, size_t count);
+}
 
 namespace enigma_user {
+	// Runs a script on the worker pool, returning its thread id, or -1 if there are no workers.
+	// Once a thread is joined or freed, its id is no longer valid, and is not handed out again
+	// for a long while. The functions below return 0, false or -1 for an invalid id. Scripts
+	// running as threads may use them too; one which waits on a thread no worker has started
+	// runs that thread's script itself, so nested threads never wait on a busy pool. Scripts
+	// running as threads must not create or destroy instances.
 	int script_thread(int scr, variant arg0 = 0, variant arg1 = 0, variant arg2 = 0, variant arg3 = 0, variant arg4 = 0, variant arg5 = 0, variant arg6 = 0, variant arg7 = 0);
 	bool thread_get_finished(int thread);
-	variant thread_get_return(int thread);
+	variant thread_get_return(int thread); // 0 until the thread has finished
+	// Waits for the thread to finish, frees it and returns what the script returned.
+	variant thread_join(int thread);
+	// Waits for any thread not yet joined or freed to finish and returns it, or -1 if there are none.
+	int thread_wait_any();
+	// Stops a thread whose script has yet to start, returning whether it was in time; a script
+	// already running is left to finish.
+	bool thread_cancel(int thread);
+	// Lets a thread's id be reused once it finishes, for threads never to be joined.
+	void thread_free(int thread);
 }
 
 #endif //ENIGMA_PLATFORM_THREADS_H
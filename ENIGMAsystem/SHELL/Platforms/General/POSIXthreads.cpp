@@ -16,48 +16,153 @@
 *** with this code. If not, see <http://www.gnu.org/licenses/>
 **/
 
-#include "Universal_System/var4.h"
-#include "Universal_System/resource_data.h"
+#include "Universal_System/callbacks_events.h"
+#include "Universal_System/object_pool.h"
 #include "PFthreads.h"
 #include <pthread.h> // use POSIX threads
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
 
-struct scrtdata {
-  int scr;
-  variant args[8];
-  ethread* mt;
-  scrtdata(int s, variant nargs[8], ethread* mythread): scr(s), mt(mythread) { for (int i = 0; i < 8; i++) args[i] = nargs[i]; }
-};
-
-static void* thread_script_func(void* data) {
-  const scrtdata* const md = (scrtdata*)data;
-  md->mt->ret = enigma_user::script_execute(md->scr,md->args[0],md->args[1],md->args[2],md->args[3],md->args[4],md->args[5],md->args[6],md->args[7]);
-  md->mt->active = false;
-  return NULL;
-}
-
-namespace enigma_user
+namespace enigma
 {
+  thread_mutex::thread_mutex(): handle(new pthread_mutex_t) { pthread_mutex_init((pthread_mutex_t*)handle, NULL); }
+  thread_mutex::~thread_mutex() { pthread_mutex_destroy((pthread_mutex_t*)handle); delete (pthread_mutex_t*)handle; }
+  void thread_mutex::lock() { pthread_mutex_lock((pthread_mutex_t*)handle); }
+  void thread_mutex::unlock() { pthread_mutex_unlock((pthread_mutex_t*)handle); }
 
-int script_thread(int scr,variant arg0, variant arg1, variant arg2, variant arg3, variant arg4, variant arg5, variant arg6, variant arg7)
-{
-  ethread* newthread = new ethread();
-  variant args[] = {arg0,arg1,arg2,arg3,arg4,arg5,arg6,arg7};
-  scrtdata *sd = new scrtdata(scr, args, newthread);
-  pthread_t me;
-  if (pthread_create(&me, NULL, thread_script_func, sd)) {
-    delete sd; delete newthread;
-    return -1;
-  }
-  threads.push_back(newthread);
-  return threads.size() - 1;
-}
+  static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+  static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER, pool_finished = PTHREAD_COND_INITIALIZER;
+  // Guarded by pool_mutex, and never destroyed, as the workers may still be at them as the game exits
+  static std::deque<pool_job*> &pool_queue = *new std::deque<pool_job*>, &pool_done = *new std::deque<pool_job*>;
+  static unsigned pool_workers = 0;
+  static bool pool_started = false;
+  static pthread_key_t pool_worker_key; // Set on each worker
 
-bool thread_get_finished(int thread) {
-  return !threads[thread]->active;
-}
+  static void* pool_worker(void* data)
+  {
+    const unsigned worker = (size_t)data;
+    pthread_setspecific(pool_worker_key, &pool_worker_key);
+    pthread_mutex_lock(&pool_mutex);
+    for (;;)
+    {
+      while (pool_queue.empty())
+        pthread_cond_wait(&pool_wake, &pool_mutex);
+      pool_job* job = pool_queue.front();
+      pool_queue.pop_front();
+      pthread_mutex_unlock(&pool_mutex);
+      job->run(worker);
+      pthread_mutex_lock(&pool_mutex);
+      job->done = true;
+      pool_done.push_back(job);
+      pthread_cond_broadcast(&pool_finished);
+    }
+    return NULL;
+  }
 
-variant thread_get_return(int thread) {
-  return threads[thread]->ret;
-}
+  unsigned thread_pool_size()
+  {
+    if (!pool_started)
+    {
+      pool_started = true;
+      if (pthread_key_create(&pool_worker_key, NULL))
+        return 0;
+      on_worker_thread = thread_pool_on_worker;
+      const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+      const unsigned want = cpus > 2 ? cpus - 1 : 1; // Leave a core to the game thread
+      for (unsigned i = 0; i < want; i++)
+      {
+        pthread_t me;
+        if (pthread_create(&me, NULL, pool_worker, (void*)(size_t)i))
+          break;
+        pthread_detach(me);
+        pool_workers++;
+      }
+      register_callback_async_update(thread_pool_finish_jobs);
+    }
+    return pool_workers;
+  }
 
+  bool thread_pool_on_worker() {
+    return pool_workers && pthread_getspecific(pool_worker_key); // No workers, if the key could not be made
+  }
+
+  bool thread_pool_submit(pool_job* job)
+  {
+    if (!thread_pool_size())
+      return false;
+    pthread_mutex_lock(&pool_mutex);
+    pool_queue.push_back(job);
+    pthread_mutex_unlock(&pool_mutex);
+    pthread_cond_signal(&pool_wake);
+    return true;
+  }
+
+  void thread_pool_finish_jobs()
+  {
+    std::deque<pool_job*> done;
+    pthread_mutex_lock(&pool_mutex);
+    done.swap(pool_done);
+    pthread_mutex_unlock(&pool_mutex);
+    for (std::deque<pool_job*>::iterator it = done.begin(); it != done.end(); ++it) {
+      (*it)->finish();
+      (*it)->release();
+    }
+  }
+
+  bool thread_pool_cancel(pool_job* job)
+  {
+    pthread_mutex_lock(&pool_mutex);
+    std::deque<pool_job*>::iterator it = std::find(pool_queue.begin(), pool_queue.end(), job);
+    const bool queued = it != pool_queue.end();
+    if (queued) {
+      pool_queue.erase(it);
+      job->done = true;
+      pool_done.push_back(job);
+      pthread_cond_broadcast(&pool_finished);
+    }
+    pthread_mutex_unlock(&pool_mutex);
+    return queued;
+  }
+
+  bool thread_pool_run_here(pool_job* job)
+  {
+    pthread_mutex_lock(&pool_mutex);
+    std::deque<pool_job*>::iterator it = std::find(pool_queue.begin(), pool_queue.end(), job);
+    const bool queued = it != pool_queue.end();
+    if (queued)
+      pool_queue.erase(it);
+    pthread_mutex_unlock(&pool_mutex);
+    if (!queued)
+      return false;
+    job->run(pool_workers);
+    pthread_mutex_lock(&pool_mutex);
+    job->done = true;
+    pool_done.push_back(job);
+    pthread_cond_broadcast(&pool_finished);
+    pthread_mutex_unlock(&pool_mutex);
+    return true;
+  }
+
+  bool thread_pool_done(const pool_job* job)
+  {
+    pthread_mutex_lock(&pool_mutex);
+    const bool done = job->done;
+    pthread_mutex_unlock(&pool_mutex);
+    return done;
+  }
+
+  size_t thread_pool_wait_any(pool_job* const* jobs, size_t count)
+  {
+    pthread_mutex_lock(&pool_mutex);
+    for (;;)
+    {
+      for (size_t i = 0; i < count; i++)
+        if (jobs[i]->done) {
+          pthread_mutex_unlock(&pool_mutex);
+          return i;
+        }
+      pthread_cond_wait(&pool_finished, &pool_mutex);
+    }
+  }
 }
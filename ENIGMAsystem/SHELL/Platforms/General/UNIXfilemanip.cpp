@@ -18,7 +18,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #include <string>
 #include "PFfilemanip.h"
@@ -26,6 +28,27 @@ using namespace std;
 
 /* UNIX-ready port of file manipulation */
 
+namespace enigma
+{
+
+const unsigned char *file_map(const char *fname, size_t *size)
+{
+  const int fd = open(fname, O_RDONLY);
+  if (fd == -1)
+    return NULL;
+  struct stat st;
+  void *map = MAP_FAILED;
+  if (fstat(fd, &st) == 0 and st.st_size > 0)
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // The mapping holds its own reference to the file
+  if (map == MAP_FAILED)
+    return NULL;
+  *size = st.st_size;
+  return (const unsigned char*)map;
+}
+
+}
+
 namespace enigma_user
 {
 
@@ -36,6 +36,30 @@
 
 using namespace std;
 
+namespace enigma {
+
+const unsigned char *file_map(const char *fname, size_t *size)
+{
+  HANDLE file = CreateFile(fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+  LARGE_INTEGER len;
+  HANDLE mapping = NULL;
+  if (GetFileSizeEx(file, &len) and len.QuadPart > 0)
+    mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file); // The mapping holds its own reference to the file
+  if (!mapping)
+    return NULL;
+  const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping); // As does the view, to the mapping
+  if (!view)
+    return NULL;
+  *size = len.QuadPart;
+  return (const unsigned char*)view;
+}
+
+}
+
 static std::string iniFilename = "";
 
 namespace enigma_user
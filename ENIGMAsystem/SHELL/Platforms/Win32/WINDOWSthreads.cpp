@@ -16,53 +16,178 @@
 *** with this code. If not, see <http://www.gnu.org/licenses/>
 **/
 
-#include "Universal_System/var4.h"
-#include "Universal_System/resource_data.h"
+#include "Universal_System/callbacks_events.h"
+#include "Universal_System/object_pool.h"
 #include "../General/PFthreads.h"
 
+#include <windows.h>
 #include <process.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
 
-struct scrtdata {
-  int scr;
-  variant args[8];
-  ethread* mt;
-  scrtdata(int s, variant nargs[8], ethread* mythread): scr(s), mt(mythread) { for (int i = 0; i < 8; i++) args[i] = nargs[i]; }
-};
+namespace enigma
+{
+  thread_mutex::thread_mutex(): handle(new CRITICAL_SECTION) { InitializeCriticalSection((CRITICAL_SECTION*)handle); }
+  thread_mutex::~thread_mutex() { DeleteCriticalSection((CRITICAL_SECTION*)handle); delete (CRITICAL_SECTION*)handle; }
+  void thread_mutex::lock() { EnterCriticalSection((CRITICAL_SECTION*)handle); }
+  void thread_mutex::unlock() { LeaveCriticalSection((CRITICAL_SECTION*)handle); }
 
-static void* thread_script_func(void* data) {
-  const scrtdata* const md = (scrtdata*)data;
-  md->mt->ret = enigma_user::script_execute(md->scr,md->args[0],md->args[1],md->args[2],md->args[3],md->args[4],md->args[5],md->args[6],md->args[7]);
-  md->mt->active = false;
-  return NULL;
-}
+  static CRITICAL_SECTION pool_lock;
+  static HANDLE pool_wake; // A semaphore counting the jobs in pool_queue
+  // Guarded by pool_lock, and never destroyed, as the workers may still be at them as the game exits
+  static std::deque<pool_job*> &pool_queue = *new std::deque<pool_job*>, &pool_done = *new std::deque<pool_job*>;
+  static std::vector<HANDLE> &pool_waiting = *new std::vector<HANDLE>; // An event for each thread in thread_pool_wait_any; as above
 
-namespace enigma_user
-{
+  // Marks a job done and wakes everyone waiting on jobs. Call with pool_lock held.
+  static void pool_job_done(pool_job* job)
+  {
+    job->done = true;
+    pool_done.push_back(job);
+    for (size_t i = 0; i < pool_waiting.size(); i++)
+      SetEvent(pool_waiting[i]);
+  }
+  static unsigned pool_workers = 0;
+  static bool pool_started = false;
+  static DWORD pool_worker_slot; // Thread local storage set on each worker
 
-int script_thread(int scr,variant arg0, variant arg1, variant arg2, variant arg3, variant arg4, variant arg5, variant arg6, variant arg7)
-{
-  ethread* newthread = new ethread();
-  variant args[] = {arg0,arg1,arg2,arg3,arg4,arg5,arg6,arg7};
-  scrtdata *sd = new scrtdata(scr, args, newthread);
-  uintptr_t ret = _beginthread((void (*)(void*))thread_script_func, 0, sd);
-  //TODO: May need to check if ret is -1L, and yes it is quite obvious the return value is
-  //an unsigned integer, but Microsoft says to for some reason. See their documentation here.
-  //http://msdn.microsoft.com/en-us/library/kdzttdcb.aspx
-  //NOTE: Same issue is in Universal_Systems/Extensions/Asynchronous/ASYNCdialog.cpp
-  if (ret == NULL) {
-    delete sd; delete newthread;
-    return -1;
+  static unsigned __stdcall pool_worker(void* data)
+  {
+    const unsigned worker = (size_t)data;
+    TlsSetValue(pool_worker_slot, &pool_worker_slot);
+    for (;;)
+    {
+      WaitForSingleObject(pool_wake, INFINITE);
+      EnterCriticalSection(&pool_lock);
+      if (pool_queue.empty()) { // Cancelled after we were woken for it
+        LeaveCriticalSection(&pool_lock);
+        continue;
+      }
+      pool_job* job = pool_queue.front();
+      pool_queue.pop_front();
+      LeaveCriticalSection(&pool_lock);
+      job->run(worker);
+      EnterCriticalSection(&pool_lock);
+      pool_job_done(job);
+      LeaveCriticalSection(&pool_lock);
+    }
+    return 0;
   }
-  threads.push_back(newthread);
-  return threads.size() - 1;
-}
 
-bool thread_get_finished(int thread) {
-  return !threads[thread]->active;
-}
+  unsigned thread_pool_size()
+  {
+    if (!pool_started)
+    {
+      pool_started = true;
+      InitializeCriticalSection(&pool_lock);
+      pool_wake = CreateSemaphore(NULL, 0, MAXLONG, NULL);
+      pool_worker_slot = TlsAlloc();
+      if (!pool_wake || pool_worker_slot == TLS_OUT_OF_INDEXES)
+        return 0;
+      on_worker_thread = thread_pool_on_worker;
+      SYSTEM_INFO info;
+      GetSystemInfo(&info);
+      const unsigned want = info.dwNumberOfProcessors > 2 ? info.dwNumberOfProcessors - 1 : 1; // Leave a core to the game thread
+      for (unsigned i = 0; i < want; i++)
+      {
+        const uintptr_t me = _beginthreadex(NULL, 0, pool_worker, (void*)(size_t)i, 0, NULL);
+        if (!me)
+          break;
+        CloseHandle((HANDLE)me);
+        pool_workers++;
+      }
+      register_callback_async_update(thread_pool_finish_jobs);
+    }
+    return pool_workers;
+  }
 
-variant thread_get_return(int thread) {
-  return threads[thread]->ret;
-}
+  bool thread_pool_on_worker() {
+    return pool_workers && TlsGetValue(pool_worker_slot); // No workers, if the slot could not be had
+  }
 
+  bool thread_pool_submit(pool_job* job)
+  {
+    if (!thread_pool_size())
+      return false;
+    EnterCriticalSection(&pool_lock);
+    pool_queue.push_back(job);
+    LeaveCriticalSection(&pool_lock);
+    ReleaseSemaphore(pool_wake, 1, NULL);
+    return true;
+  }
+
+  void thread_pool_finish_jobs()
+  {
+    std::deque<pool_job*> done;
+    EnterCriticalSection(&pool_lock);
+    done.swap(pool_done);
+    LeaveCriticalSection(&pool_lock);
+    for (std::deque<pool_job*>::iterator it = done.begin(); it != done.end(); ++it) {
+      (*it)->finish();
+      (*it)->release();
+    }
+  }
+
+  bool thread_pool_cancel(pool_job* job)
+  {
+    EnterCriticalSection(&pool_lock);
+    std::deque<pool_job*>::iterator it = std::find(pool_queue.begin(), pool_queue.end(), job);
+    const bool queued = it != pool_queue.end();
+    if (queued) {
+      pool_queue.erase(it);
+      pool_job_done(job);
+      WaitForSingleObject(pool_wake, 0); // Take back its count, unless a worker woke for it already
+    }
+    LeaveCriticalSection(&pool_lock);
+    return queued;
+  }
+
+  bool thread_pool_run_here(pool_job* job)
+  {
+    EnterCriticalSection(&pool_lock);
+    std::deque<pool_job*>::iterator it = std::find(pool_queue.begin(), pool_queue.end(), job);
+    const bool queued = it != pool_queue.end();
+    if (queued) {
+      pool_queue.erase(it);
+      WaitForSingleObject(pool_wake, 0); // As in thread_pool_cancel
+    }
+    LeaveCriticalSection(&pool_lock);
+    if (!queued)
+      return false;
+    job->run(pool_workers);
+    EnterCriticalSection(&pool_lock);
+    pool_job_done(job);
+    LeaveCriticalSection(&pool_lock);
+    return true;
+  }
+
+  bool thread_pool_done(const pool_job* job)
+  {
+    EnterCriticalSection(&pool_lock);
+    const bool done = job->done;
+    LeaveCriticalSection(&pool_lock);
+    return done;
+  }
+
+  size_t thread_pool_wait_any(pool_job* const* jobs, size_t count)
+  {
+    // Each waiter has its own auto-reset event, so a job done since the check still wakes it,
+    // however many threads wait at once.
+    const HANDLE woken = CreateEvent(NULL, FALSE, FALSE, NULL);
+    EnterCriticalSection(&pool_lock);
+    pool_waiting.push_back(woken);
+    for (;;)
+    {
+      for (size_t i = 0; i < count; i++)
+        if (jobs[i]->done) {
+          pool_waiting.erase(std::find(pool_waiting.begin(), pool_waiting.end(), woken));
+          LeaveCriticalSection(&pool_lock);
+          CloseHandle(woken);
+          return i;
+        }
+      LeaveCriticalSection(&pool_lock);
+      WaitForSingleObject(woken, INFINITE);
+      EnterCriticalSection(&pool_lock);
+    }
+  }
 }
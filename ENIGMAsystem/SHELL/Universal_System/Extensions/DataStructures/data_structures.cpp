@@ -28,15 +28,19 @@
 
 #include "Universal_System/var4.h"
 #include <float.h>
+#include <cmath>
 #include <algorithm>
 #include <map>
 #include <deque>
 #include <vector>
 
-#include <sstream>
 #include <string>
+#include <cstring>
 
 #include <floatcomp.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
@@ -53,16 +57,282 @@ template<typename t> bool tequal(t v1, t v2) { return v1 == v2; }
 template<> bool tequal(float v1, float v2)   { return fequal(v1, v2); }
 template<> bool tequal(double v1, double v2) { return fequal(v1, v2); }
 
+// Serialization. ds_*_write streams a container straight from its live storage into one
+// string, and ds_*_read parses that string in a single pass, without substrings.
+// The text format spells every number in uppercase hex: counts and lengths in four digits
+// (FFFF and up as FFFF followed by eight more), types in two, and reals as the sixteen
+// digits of their eight bytes. The binary format, chosen by passing true to a write
+// function, stores counts and lengths as four little-endian bytes, types as one, and reals
+// as their eight raw bytes; those bytes are then spelled in base64 behind an '@', so that
+// the result survives anything that treats it as a C string. Readers accept either,
+// telling them apart by that first character.
+static const char ds_binary_marker = '@';
+static const char ds_base64_digit[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+class ds_writer
+{
+    string out;
+    const bool binary;
+    unsigned group, group_bytes; // Bytes not yet spelled in base64
+
+    void hex(unsigned long long v, int digits)
+    {
+        static const char digit[] = "0123456789ABCDEF";
+        for (int i = digits - 1; i >= 0; i--)
+            out += digit[(v >> (4 * i)) & 15];
+    }
+    void byte(unsigned char c)
+    {
+        group = group << 8 | c;
+        if (++group_bytes < 3)
+            return;
+        for (int i = 3; i >= 0; i--)
+            out += ds_base64_digit[(group >> (6 * i)) & 63];
+        group = group_bytes = 0;
+    }
+    void bytes(unsigned v, int n)
+    {
+        for (int i = 0; i < n; i++)
+            byte((v >> (8 * i)) & 0xFF);
+    }
+
+    public:
+    // Reserves room for `values' values and `counts' counts, besides the text of strings.
+    ds_writer(bool bin, size_t counts, size_t values): binary(bin), group(0), group_bytes(0)
+    {
+        out.reserve(binary ? 4 + (counts * 4 + values * 9) * 4 / 3 : counts * 4 + values * 18);
+        if (binary)
+            out += ds_binary_marker;
+    }
+
+    void count(size_t n)
+    {
+        if (binary)
+            return bytes(n, 4);
+        if (n >= 0xFFFF)
+            hex(0xFFFF, 4), hex(n, 8);
+        else
+            hex(n, 4);
+    }
+    void type(const variant &v)
+    {
+        const unsigned t = (v.type == enigma::vt_real) ? 0x00 : 0x01;
+        if (binary) bytes(t, 1); else hex(t, 2);
+    }
+    void real(double d)
+    {
+        const unsigned char *b = (const unsigned char*)&d;
+        for (unsigned i = 0; i < sizeof d; i++)
+            if (binary) byte(b[i]); else hex(b[i], 2);
+    }
+    void data(const variant &v)
+    {
+        if (v.type == enigma::vt_real)
+            return real(v.rval.d);
+        count(v.sval.length());
+        if (!binary)
+            out += v.sval;
+        else
+            for (size_t i = 0; i < v.sval.length(); i++)
+                byte(v.sval[i]);
+    }
+    void value(const variant &v) { type(v), data(v); }
+
+    string &str()
+    {
+        if (group_bytes) // Pad the last group out to four characters
+        {
+            const unsigned pad = 3 - group_bytes;
+            group <<= 8 * pad;
+            for (int i = 3; i >= 0; i--)
+                out += i < int(pad) ? '=' : ds_base64_digit[(group >> (6 * i)) & 63];
+            group = group_bytes = 0;
+        }
+        return out;
+    }
+};
+
+class ds_reader
+{
+    const char *pos, *const end;
+    const bool binary;
+    bool failed;
+    unsigned group, group_bytes, group_read; // The last four base64 characters, decoded
+
+    unsigned long long hex(int digits)
+    {
+        if (end - pos < digits)
+            return failed = true, pos = end, 0;
+        unsigned long long v = 0;
+        for (int i = 0; i < digits; i++)
+        {
+            const char c = *pos++;
+            v = v << 4 | (c >= 'A' && c <= 'F' ? c - 'A' + 10 : c >= 'a' && c <= 'f' ? c - 'a' + 10 : (c - '0') & 15);
+        }
+        return v;
+    }
+    static unsigned base64(char c)
+    {
+        return c >= 'A' && c <= 'Z' ? c - 'A' : c >= 'a' && c <= 'z' ? c - 'a' + 26
+             : c >= '0' && c <= '9' ? c - '0' + 52 : c == '+' ? 62 : 63;
+    }
+    unsigned char byte()
+    {
+        if (group_read == group_bytes)
+        {
+            if (end - pos < 4 || failed)
+                return failed = true, pos = end, 0;
+            unsigned pad = 0;
+            group = 0;
+            for (int i = 0; i < 4; i++, pos++)
+                group = group << 6 | (*pos == '=' ? (pad++, 0) : base64(*pos));
+            group_bytes = pad < 3 ? 3 - pad : 0, group_read = 0;
+            if (!group_bytes)
+                return failed = true, 0;
+        }
+        return (group >> (16 - 8 * group_read++)) & 0xFF;
+    }
+    unsigned bytes(int n)
+    {
+        unsigned v = 0;
+        for (int i = 0; i < n; i++)
+            v |= unsigned(byte()) << (8 * i);
+        return v;
+    }
+
+    public:
+    ds_reader(const string &s):
+        pos(s.data()), end(s.data() + s.length()), binary(!s.empty() && s[0] == ds_binary_marker),
+        failed(false), group(0), group_bytes(0), group_read(0)
+    {
+        if (binary)
+            ++pos;
+    }
+
+    // False once the input has run out; every read after that yields zero.
+    bool good() const { return !failed; }
+    bool is_binary() const { return binary; }
+
+    unsigned count()
+    {
+        if (binary)
+            return bytes(4);
+        const unsigned n = hex(4);
+        return n == 0xFFFF ? hex(8) : n;
+    }
+    int type() { return binary ? bytes(1) : hex(2); }
+    double real()
+    {
+        double d;
+        unsigned char *b = (unsigned char*)&d;
+        for (unsigned i = 0; i < sizeof d; i++)
+            b[i] = binary ? byte() : hex(2);
+        return d;
+    }
+    void data(int type, variant &v)
+    {
+        if (type == 0)
+        {
+            v = real();
+            return;
+        }
+        const size_t len = count();
+        if (!binary)
+        {
+            if (size_t(end - pos) < len)
+                failed = true;
+            v = string(pos, failed ? 0 : len);
+            pos += failed ? end - pos : len;
+            return;
+        }
+        if (size_t(end - pos) / 4 * 3 + (group_bytes - group_read) < len)
+            failed = true, pos = end;
+        string str(failed ? 0 : len, '\0');
+        for (size_t i = 0; i < str.length(); i++)
+            str[i] = byte();
+        v = str;
+    }
+    void value(variant &v) { data(type(), v); }
+};
+
+// Row kernels for the grid operations: each works along one contiguous run of cells, so
+// that on grids of doubles the compiler can turn them into vector code.
+template<typename t> static inline void row_set(t *p, int n, const t &v) { for (int i = 0; i < n; i++) p[i] = v; }
+template<typename t> static inline void row_add(t *p, int n, const t &v) { for (int i = 0; i < n; i++) p[i] += v; }
+template<typename t> static inline void row_multiply(t *p, int n, const double v) { for (int i = 0; i < n; i++) p[i] *= v; }
+template<typename t, typename s> static inline void row_set(t *p, const s *q, int n) { for (int i = 0; i < n; i++) p[i] = q[i]; }
+template<typename t, typename s> static inline void row_add(t *p, const s *q, int n) { for (int i = 0; i < n; i++) p[i] += q[i]; }
+template<typename t, typename s> static inline void row_multiply(t *p, const s *q, int n) { for (int i = 0; i < n; i++) p[i] *= q[i]; }
+// Sums run strictly in order, even on doubles, so that a real grid sums to exactly what a
+// grid of variants holding the same values does.
+template<typename t> static inline void row_sum(const t *p, int n, t &sum) { for (int i = 0; i < n; i++) sum += p[i]; }
+template<typename t> static inline void row_max(const t *p, int n, t &m) { for (int i = 0; i < n; i++) if (p[i] > m) m = p[i]; }
+template<typename t> static inline void row_min(const t *p, int n, t &m) { for (int i = 0; i < n; i++) if (p[i] < m) m = p[i]; }
+
+// Compilers will not vectorize a floating point min or max by themselves, NaNs being what
+// they are; SSE2's min and max keep the running value when given a NaN, as the loops do.
+static inline void row_max(const double *p, int n, double &m)
+{
+    int i = 0;
+    #ifdef __SSE2__
+    __m128d m0 = _mm_set1_pd(m), m1 = m0;
+    for (; i + 4 <= n; i += 4)
+        m0 = _mm_max_pd(_mm_loadu_pd(p + i), m0), m1 = _mm_max_pd(_mm_loadu_pd(p + i + 2), m1);
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_max_pd(m1, m0));
+    m = lanes[1] > lanes[0] ? lanes[1] : lanes[0];
+    #endif
+    for (; i < n; i++)
+        if (p[i] > m) m = p[i];
+}
+static inline void row_min(const double *p, int n, double &m)
+{
+    int i = 0;
+    #ifdef __SSE2__
+    __m128d m0 = _mm_set1_pd(m), m1 = m0;
+    for (; i + 4 <= n; i += 4)
+        m0 = _mm_min_pd(_mm_loadu_pd(p + i), m0), m1 = _mm_min_pd(_mm_loadu_pd(p + i + 2), m1);
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_min_pd(m1, m0));
+    m = lanes[1] < lanes[0] ? lanes[1] : lanes[0];
+    #endif
+    for (; i < n; i++)
+        if (p[i] < m) m = p[i];
+}
+
+static inline bool in_disk(const double x, const double y, const double rr, const int ii, const int i) {
+    return (x - ii)*(x - ii) + (y - i)*(y - i) <= rr;
+}
+
+// The cells [lo, hi) of row i, between px1 and px2, which lie in the disk. The edges come
+// from the circle's equation, then are settled with the same test the cells used to get
+// one at a time, so that rounding cannot move them.
+static inline bool disk_row(const double x, const double y, const double rr, const int i, const int px1, const int px2, int &lo, int &hi)
+{
+    const double rem = rr - (y - i)*(y - i);
+    if (rem < 0)
+        return false;
+    const double half = sqrt(rem);
+    lo = int(maxv(ceil(x - half), double(px1)));
+    hi = int(minv(floor(x + half), double(px2 - 1)));
+    while (lo > px1 && in_disk(x, y, rr, lo - 1, i)) lo--;
+    while (lo <= hi && !in_disk(x, y, rr, lo, i)) lo++;
+    while (hi < px2 - 1 && in_disk(x, y, rr, hi + 1, i)) hi++;
+    while (hi >= lo && !in_disk(x, y, rr, hi, i)) hi--;
+    return ++hi > lo;
+}
+
 template <typename t>
 class grid
 {
+    template<typename> friend class grid;
     unsigned int xgrid, ygrid;
     t *grid_array;
 
     public:
-    grid() {}
+    grid(): xgrid(0), ygrid(0), grid_array(NULL) {}
     grid(const unsigned int w, const unsigned int h) {
-		ygrid = h; xgrid = w; grid_array = new t[w*h];
+		ygrid = h; xgrid = w; grid_array = new t[w*h]();
 	}
     ~grid() {}
 
@@ -72,17 +342,14 @@ class grid
     }
     void clear(const t val)
     {
-        for (unsigned i = 0; i < ygrid; i++)
-            for (unsigned ii = 0; ii < xgrid; ii++)
-                grid_array[i * xgrid + ii] = val;
+        row_set(grid_array, xgrid*ygrid, val);
     }
     void resize(unsigned w, unsigned h)
     {
-        grid<variant> temp(w, h);
+        grid<t> temp(w, h);
         const unsigned int wm = minv(xgrid, w), hm = minv(ygrid, h);
         for (unsigned i = 0; i < hm; i++)
-            for (unsigned ii = 0; ii < wm; ii++)
-                temp.grid_array[i * w + ii] = grid_array[i * xgrid + ii];
+            row_set(temp.grid_array + i * w, grid_array + i * xgrid, wm);
         delete[] grid_array;
         (*this) = temp;
     }
@@ -92,15 +359,13 @@ class grid
         grid_array = new t[copy_id.ygrid*copy_id.xgrid];
         xgrid = copy_id.xgrid;
         ygrid = copy_id.ygrid;
-        for (unsigned i = 0; i < ygrid; i++)
-            for (unsigned ii = 0; ii < xgrid; ii++)
-                grid_array[i * xgrid + ii] = copy_id.grid_array[i * copy_id.xgrid + ii];
+        row_set(grid_array, copy_id.grid_array, xgrid*ygrid);
     }
-    unsigned int width()
+    unsigned int width() const
     {
         return xgrid;
     }
-    unsigned int height()
+    unsigned int height() const
     {
         return ygrid;
     }
@@ -126,8 +391,7 @@ class grid
        {
            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
            for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   grid_array[i * xgrid + ii] = val;
+               row_set(grid_array + i * xgrid + px1, px2 - px1, val);
        }
     }
     void add_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const t val)
@@ -137,8 +401,7 @@ class grid
        {
            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
            for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   grid_array[i * xgrid + ii] += val;
+               row_add(grid_array + i * xgrid + px1, px2 - px1, val);
        }
     }
     void multiply_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const double val)
@@ -148,8 +411,7 @@ class grid
        {
            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
            for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   grid_array[i * xgrid + ii] *= val;
+               row_multiply(grid_array + i * xgrid + px1, px2 - px1, val);
        }
     }
     void insert_disk(const double x, const double y, const double r, const t val)
@@ -159,10 +421,10 @@ class grid
         if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
         {
             const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+            int lo, hi;
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        grid_array[i * xgrid + ii] = val;
+                if (disk_row(x, y, rr, i, px1, px2, lo, hi))
+                    row_set(grid_array + i * xgrid + lo, hi - lo, val);
         }
     }
     void add_disk(const double x, const double y, const double r, const t val)
@@ -172,10 +434,10 @@ class grid
         if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
         {
             const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+            int lo, hi;
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        grid_array[i * xgrid + ii] += val;
+                if (disk_row(x, y, rr, i, px1, px2, lo, hi))
+                    row_add(grid_array + i * xgrid + lo, hi - lo, val);
         }
     }
     void multiply_disk(const double x, const double y, const double r, const double val)
@@ -185,13 +447,14 @@ class grid
         if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
         {
             const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
+            int lo, hi;
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        grid_array[i * xgrid + ii] *= val;
+                if (disk_row(x, y, rr, i, px1, px2, lo, hi))
+                    row_multiply(grid_array + i * xgrid + lo, hi - lo, val);
         }
     }
-    void insert_grid_region(const grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
+    template<typename s>
+    void insert_grid_region(const grid<s>& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
     {
         if (x < xgrid && y < ygrid)
         {
@@ -200,12 +463,12 @@ class grid
             {
                 const int upx = minv(tx2 - tx1 + 1, minv(int(xgrid - x), xd)), upy = minv(ty2 - ty1 + 1, minv(int(ygrid - y), yd));
                 for (int i = 0; i < upy; i++)
-                    for (int ii = 0; ii < upx; ii++)
-                        grid_array[(y + i)*xgrid + (x + ii)] = source_id.grid_array[(ty1 + i)*source_id.xgrid + (tx1 + ii)];
+                    row_set(grid_array + (y + i)*xgrid + x, source_id.grid_array + (ty1 + i)*source_id.xgrid + tx1, upx);
             }
         }
     }
-    void add_grid_region(const grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
+    template<typename s>
+    void add_grid_region(const grid<s>& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
     {
         if (x < xgrid && y < ygrid)
         {
@@ -214,12 +477,12 @@ class grid
             {
                 const int upx = minv(tx2 - tx1 + 1, minv(int(xgrid - x), xd)), upy = minv(ty2 - ty1 + 1, minv(int(ygrid - y), yd));
                 for (int i = 0; i < upy; i++)
-                    for (int ii = 0; ii < upx; ii++)
-                        grid_array[(y + i)*xgrid + (x + ii)] += source_id.grid_array[(ty1 + i)*source_id.xgrid + (tx1 + ii)];
+                    row_add(grid_array + (y + i)*xgrid + x, source_id.grid_array + (ty1 + i)*source_id.xgrid + tx1, upx);
             }
         }
     }
-    void multiply_grid_region(const grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
+    template<typename s>
+    void multiply_grid_region(const grid<s>& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
     {
         if (x < xgrid && y < ygrid)
         {
@@ -228,12 +491,15 @@ class grid
             {
                 const int upx = minv(tx2 - tx1 + 1, minv(int(xgrid - x), xd)), upy = minv(ty2 - ty1 + 1, minv(int(ygrid - y), yd));
                 for (int i = 0; i < upy; i++)
-                    for (int ii = 0; ii < upx; ii++)
-                        grid_array[(y + i)*xgrid + (x + ii)] *= source_id.grid_array[(ty1 + i)*source_id.xgrid + (tx1 + ii)];
+                    row_multiply(grid_array + (y + i)*xgrid + x, source_id.grid_array + (ty1 + i)*source_id.xgrid + tx1, upx);
             }
         }
     }
 
+    const t &get(unsigned int x, unsigned int y) const
+    {
+        return grid_array[y * xgrid + x];
+    }
     t find(unsigned int x, unsigned int y)
     {
         return (grid_array[y * xgrid + x]);
@@ -244,10 +510,9 @@ class grid
        if (xd > 0 && yd > 0)
        {
            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           variant sum = 0;
+           t sum = 0;
            for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   sum += grid_array[i * xgrid + ii];
+               row_sum(grid_array + i * xgrid + px1, px2 - px1, sum);
            return sum;
        }
        return t();
@@ -255,18 +520,12 @@ class grid
     t find_region_max(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
     {
        const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       t val_check;
        if (xd > 0 && yd > 0)
        {
            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
            t max_check = grid_array[py1 * xgrid + px1];
            for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-               {
-                   val_check = grid_array[i * xgrid + ii];
-                   if (val_check > max_check)
-                       max_check = val_check;
-               }
+               row_max(grid_array + i * xgrid + px1, px2 - px1, max_check);
            return max_check;
        }
        return t();
@@ -274,18 +533,12 @@ class grid
     t find_region_min(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
     {
        const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       t val_check;
        if (xd > 0 && yd > 0)
        {
            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
            t min_check = grid_array[py1 * xgrid + px1];
            for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-               {
-                   val_check = grid_array[i * xgrid + ii];
-                   if (val_check < min_check)
-                       min_check = val_check;
-               }
+               row_min(grid_array + i * xgrid + px1, px2 - px1, min_check);
            return min_check;
        }
        return t();
@@ -298,8 +551,7 @@ class grid
            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
            t sum = 0;
            for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   sum += grid_array[i * xgrid + ii];
+               row_sum(grid_array + i * xgrid + px1, px2 - px1, sum);
            const double region_size = (py2 - py1)*(px2 - px1);
            return sum/region_size;
        }
@@ -313,10 +565,10 @@ class grid
         {
             const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
             t sum = t();
+            int lo, hi;
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        sum += grid_array[i * xgrid + ii];
+                if (disk_row(x, y, rr, i, px1, px2, lo, hi))
+                    row_sum(grid_array + i * xgrid + lo, hi - lo, sum);
             return sum;
         }
         return t();
@@ -328,15 +580,16 @@ class grid
         if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
         {
             const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            t max_check = grid_array[py1 * xgrid + px1];
+            t max_check = t();
+            bool found = false;
+            int lo, hi;
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                    {
-                        const double val_check = grid_array[i * xgrid + ii];
-                        if (val_check > max_check)
-                            max_check = val_check;
-                    }
+                if (disk_row(x, y, rr, i, px1, px2, lo, hi))
+                {
+                    if (!found) // Start from a cell inside the disk
+                        max_check = grid_array[i * xgrid + lo], found = true;
+                    row_max(grid_array + i * xgrid + lo, hi - lo, max_check);
+                }
             return max_check;
         }
         return t();
@@ -348,15 +601,16 @@ class grid
         if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
         {
             const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            t min_check = grid_array[lrint(y) * xgrid + lrint(x)];
+            t min_check = t();
+            bool found = false;
+            int lo, hi;
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                    {
-                        const double val_check = grid_array[i * xgrid + ii];
-                        if (val_check < min_check)
-                            min_check = val_check;
-                    }
+                if (disk_row(x, y, rr, i, px1, px2, lo, hi))
+                {
+                    if (!found) // Start from a cell inside the disk
+                        min_check = grid_array[i * xgrid + lo], found = true;
+                    row_min(grid_array + i * xgrid + lo, hi - lo, min_check);
+                }
             return min_check;
         }
         return t();
@@ -370,13 +624,13 @@ class grid
             const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
             t sum = t();
             double region_size = 0;
+            int lo, hi;
             for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                    {
-                        sum += grid_array[i * xgrid + ii];
-                        ++region_size;
-                    }
+                if (disk_row(x, y, rr, i, px1, px2, lo, hi))
+                {
+                    row_sum(grid_array + i * xgrid + lo, hi - lo, sum);
+                    region_size += hi - lo;
+                }
            return sum/region_size;
         }
         return t();
@@ -473,7 +727,72 @@ class grid
 
 /* ds_grids */
 
-static map<unsigned int, grid<variant> > ds_grids;
+// A grid's cells are variants, unless it was made by ds_grid_create_real: then they are
+// plain doubles, which the region and disk operations get through several at a time.
+// A real grid turns into a variant grid the first time it is given a string.
+struct ds_grid_cells
+{
+    grid<variant> var;
+    grid<double> real;
+    bool numeric;
+
+    ds_grid_cells(): numeric(false) {}
+
+    // Whether the value goes into the doubles, leaving this a real grid.
+    bool stores(const variant &val) const { return numeric && val.type == enigma::vt_real; }
+
+    // The cells as variants, converting a real grid first.
+    grid<variant> &variants()
+    {
+        if (numeric)
+        {
+            grid<variant> cells(real.width(), real.height());
+            for (unsigned y = 0; y < real.height(); y++)
+                for (unsigned x = 0; x < real.width(); x++)
+                    cells.insert(x, y, real.get(x, y));
+            real.destroy();
+            real = grid<double>();
+            var = cells;
+            numeric = false;
+        }
+        return var;
+    }
+
+    unsigned int width() const { return numeric ? real.width() : var.width(); }
+    unsigned int height() const { return numeric ? real.height() : var.height(); }
+    variant get(unsigned int x, unsigned int y) const { return numeric ? variant(real.get(x, y)) : var.get(x, y); }
+    void set(unsigned int x, unsigned int y, const variant &val)
+    {
+        if (stores(val))
+            real.insert(x, y, val.rval.d);
+        else
+            variants().insert(x, y, val);
+    }
+
+    void copy(const ds_grid_cells &source)
+    {
+        if (source.numeric)
+        {
+            var.destroy();
+            var = grid<variant>();
+            real.copy(source.real);
+        }
+        else
+        {
+            real.destroy();
+            real = grid<double>();
+            var.copy(source.var);
+        }
+        numeric = source.numeric;
+    }
+    void destroy()
+    {
+        var.destroy();
+        real.destroy();
+    }
+};
+
+static map<unsigned int, ds_grid_cells> ds_grids;
 static unsigned int ds_grids_maxid = 0;
 
 namespace enigma_user
@@ -482,8 +801,18 @@ namespace enigma_user
 unsigned int ds_grid_create(const unsigned int w, const unsigned int h)
 {
     //Creates a new grid. The function returns an integer as an id that must be used in all other functions to access the particular grid.
-    pair<map<unsigned int, grid<variant> >::iterator, bool> ins = ds_grids.insert(pair<unsigned int, grid<variant> >(ds_grids_maxid++, grid<variant>(w, h)));
-	ins.first->second.clear(0);
+    ds_grid_cells &cells = ds_grids[ds_grids_maxid++];
+    cells.var = grid<variant>(w, h);
+	cells.var.clear(0);
+    return ds_grids_maxid-1;
+}
+
+unsigned int ds_grid_create_real(const unsigned int w, const unsigned int h)
+{
+    //Creates a new grid which stores only reals, until a string is put in it. Region and disk operations are much faster on such a grid.
+    ds_grid_cells &cells = ds_grids[ds_grids_maxid++];
+    cells.real = grid<double>(w, h);
+    cells.numeric = true;
     return ds_grids_maxid-1;
 }
 
@@ -497,7 +826,11 @@ void ds_grid_destroy(const unsigned int id)
 void ds_grid_clear(const unsigned int id, const variant val)
 {
     //Clears the grid with the given id, to the indicated value
-    ds_grids[id].clear(val);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.stores(val))
+        g.real.clear(val.rval.d);
+    else
+        g.variants().clear(val);
 }
 
 void ds_grid_copy(const unsigned int id, const unsigned int source)
@@ -508,7 +841,11 @@ void ds_grid_copy(const unsigned int id, const unsigned int source)
 
 void ds_grid_resize(const unsigned int id, const unsigned int w, const unsigned int h)
 {
-    ds_grids[id].resize(w, h);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.numeric)
+        g.real.resize(w, h);
+    else
+        g.var.resize(w, h);
 }
 
 
@@ -527,169 +864,260 @@ unsigned int ds_grid_height(const unsigned int id)
 void ds_grid_set(const unsigned int id, const unsigned int x, const unsigned int y, const variant val)
 {
     //Sets the indicated cell in the grid with the given id, to the indicated value
-    ds_grids[id].insert(x, y, val);
+    ds_grids[id].set(x, y, val);
 }
 
 void ds_grid_add(const unsigned int id, const unsigned int x, const unsigned int y, const variant val)
 {
     //Add the value to the cell in the region in the grid with the given id. For strings this corresponds to concatenation
-    ds_grids[id].add(x, y, val);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.stores(val))
+        g.real.add(x, y, val.rval.d);
+    else
+        g.variants().add(x, y, val);
 }
 
 void ds_grid_multiply(const unsigned int id, const unsigned int x, const unsigned int y, const double val)
 {
     //Multiplies the value to the cells in the region in the grid with the given id
-    ds_grids[id].multiply(x, y, val);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.numeric)
+        g.real.multiply(x, y, val);
+    else
+        g.var.multiply(x, y, val);
 }
 
 void ds_grid_set_region(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
     //Sets the all cells in the region in the grid with the given id, to the indicated value
-    ds_grids[id].insert_region(x1, y1, x2, y2, val);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.stores(val))
+        g.real.insert_region(x1, y1, x2, y2, val.rval.d);
+    else
+        g.variants().insert_region(x1, y1, x2, y2, val);
 }
 
 void ds_grid_add_region(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
     //Add the value to the cell in the region in the grid with the given id.
-    ds_grids[id].add_region(x1, y1, x2, y2, val);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.stores(val))
+        g.real.add_region(x1, y1, x2, y2, val.rval.d);
+    else
+        g.variants().add_region(x1, y1, x2, y2, val);
 }
 
 void ds_grid_multiply_region(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const double val)
 {
     //Multiplies the value to the cells in the region in the grid with the given id. Is only valid for numbers
-    ds_grids[id].multiply_region(x1, y1, x2, y2, val);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.numeric)
+        g.real.multiply_region(x1, y1, x2, y2, val);
+    else
+        g.var.multiply_region(x1, y1, x2, y2, val);
 }
 
 void ds_grid_set_disk(const unsigned int id, const double x, const double y, const double r, const variant val)
 {
     //Sets all cells in the disk with center (xm,ym) and radius r
-    ds_grids[id].insert_disk(x, y, r, val);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.stores(val))
+        g.real.insert_disk(x, y, r, val.rval.d);
+    else
+        g.variants().insert_disk(x, y, r, val);
 }
 
 void ds_grid_add_disk(const unsigned int id, const double x, const double y, const double r, const variant val)
 {
     //Add the value to all cells in the disk with center (xm,ym) and radius r
-    ds_grids[id].add_disk(x, y, r, val);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.stores(val))
+        g.real.add_disk(x, y, r, val.rval.d);
+    else
+        g.variants().add_disk(x, y, r, val);
 }
 
 void ds_grid_multiply_disk(const unsigned int id, const double x, const double y, const double r, const double val)
 {
     //Multiply the value to all cells in the disk with center (xm,ym) and radius r
-    ds_grids[id].multiply_disk(x, y, r, val);
+    ds_grid_cells &g = ds_grids[id];
+    if (g.numeric)
+        g.real.multiply_disk(x, y, r, val);
+    else
+        g.var.multiply_disk(x, y, r, val);
 }
 
 void ds_grid_set_grid_region(const unsigned int id, const unsigned int source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos)
 {
     //Copies the contents of the cells in the region in grid source to grid id. xpos and ypos indicate the place where the region must be placed in the grid
-    ds_grids[id].insert_grid_region(ds_grids[source], x1, y1, x2, y2, xpos, ypos);
+    ds_grid_cells &g = ds_grids[id], &s = ds_grids[source];
+    if (g.numeric && s.numeric)
+        g.real.insert_grid_region(s.real, x1, y1, x2, y2, xpos, ypos);
+    else if (s.numeric)
+        g.var.insert_grid_region(s.real, x1, y1, x2, y2, xpos, ypos);
+    else
+        g.variants().insert_grid_region(s.var, x1, y1, x2, y2, xpos, ypos);
 }
 
 void ds_grid_add_grid_region(const unsigned int id, const unsigned int source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos)
 {
     //Adds the contents of the cells in the region in grid source to grid id. xpos and ypos indicate the place where the region must be added in the grid
-     ds_grids[id].add_grid_region(ds_grids[source], x1, y1, x2, y2, xpos, ypos);
+    ds_grid_cells &g = ds_grids[id], &s = ds_grids[source];
+    if (g.numeric && s.numeric)
+        g.real.add_grid_region(s.real, x1, y1, x2, y2, xpos, ypos);
+    else if (s.numeric)
+        g.var.add_grid_region(s.real, x1, y1, x2, y2, xpos, ypos);
+    else
+        g.variants().add_grid_region(s.var, x1, y1, x2, y2, xpos, ypos);
 }
 
 void ds_grid_multiply_grid_region(const unsigned int id, const unsigned int source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos)
 {
     //Multiplies the contents of the cells in the region in grid source to grid id. xpos and ypos indicate the place where the region must be multiplied in the grid
-    ds_grids[id].multiply_grid_region(ds_grids[source], x1, y1, x2, y2, xpos, ypos);
+    ds_grid_cells &g = ds_grids[id], &s = ds_grids[source];
+    if (g.numeric && s.numeric)
+        g.real.multiply_grid_region(s.real, x1, y1, x2, y2, xpos, ypos);
+    else if (s.numeric)
+        g.var.multiply_grid_region(s.real, x1, y1, x2, y2, xpos, ypos);
+    else
+        g.variants().multiply_grid_region(s.var, x1, y1, x2, y2, xpos, ypos);
 }
 
 variant ds_grid_get(const unsigned int id, const unsigned int x, const unsigned int y)
 {
     //Returns the value of the indicated cell in the grid with the given id
-    return ((x < ds_grids[id].width() && y < ds_grids[id].height()) ? ds_grids[id].find(x, y) : variant());
+    const ds_grid_cells &g = ds_grids[id];
+    return ((x < g.width() && y < g.height()) ? g.get(x, y) : variant());
 }
 
 variant ds_grid_get_sum(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
 {
     //Returns the sum of the values of the cells in the region in the grid with the given id
-    return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].find_region_sum(x1, y1, x2, y2) : variant());
+    ds_grid_cells &g = ds_grids[id];
+    if (!((x1 < g.width() || x2 < g.width()) && (y1 < g.height() || y2 < g.height())))
+        return variant();
+    return g.numeric ? variant(g.real.find_region_sum(x1, y1, x2, y2)) : g.var.find_region_sum(x1, y1, x2, y2);
 }
 
 variant ds_grid_get_max(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
 {
     //Returns the max of the values of the cells in the region in the grid with the given id
-    return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].find_region_max(x1, y1, x2, y2) : variant());
+    ds_grid_cells &g = ds_grids[id];
+    if (!((x1 < g.width() || x2 < g.width()) && (y1 < g.height() || y2 < g.height())))
+        return variant();
+    return g.numeric ? variant(g.real.find_region_max(x1, y1, x2, y2)) : g.var.find_region_max(x1, y1, x2, y2);
 }
 
 variant ds_grid_get_min(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
 {
     //Returns the min of the values of the cells in the region in the grid with the given id
-    return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].find_region_min(x1, y1, x2, y2) : variant());
+    ds_grid_cells &g = ds_grids[id];
+    if (!((x1 < g.width() || x2 < g.width()) && (y1 < g.height() || y2 < g.height())))
+        return variant();
+    return g.numeric ? variant(g.real.find_region_min(x1, y1, x2, y2)) : g.var.find_region_min(x1, y1, x2, y2);
 }
 
 variant ds_grid_get_mean(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
 {
     //Returns the mean of the values of the cells in the region in the grid with the given id
-    return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].find_region_mean(x1, y1, x2, y2) : variant());
+    ds_grid_cells &g = ds_grids[id];
+    if (!((x1 < g.width() || x2 < g.width()) && (y1 < g.height() || y2 < g.height())))
+        return variant();
+    return g.numeric ? variant(g.real.find_region_mean(x1, y1, x2, y2)) : g.var.find_region_mean(x1, y1, x2, y2);
 }
 
 variant ds_grid_get_disk_sum(const unsigned int id, const double x, const double y, const double r)
 {
     //Returns the sum of the values of the cells in the disk
-    return (ds_grids[id].find_disk_sum(x, y, r));
+    ds_grid_cells &g = ds_grids[id];
+    return g.numeric ? variant(g.real.find_disk_sum(x, y, r)) : g.var.find_disk_sum(x, y, r);
 }
 
 variant ds_grid_get_disk_max(const unsigned int id, const double x, const double y, const double r)
 {
     //Returns the max of the values of the cells in the disk.
-    return (ds_grids[id].find_disk_max(x, y, r));
+    ds_grid_cells &g = ds_grids[id];
+    return g.numeric ? variant(g.real.find_disk_max(x, y, r)) : g.var.find_disk_max(x, y, r);
 }
 
 variant ds_grid_get_disk_min(const unsigned int id, const double x, const double y, const double r)
 {
     //Returns the min of the values of the cells in the disk.
-    return (ds_grids[id].find_disk_min(x, y, r));
+    ds_grid_cells &g = ds_grids[id];
+    return g.numeric ? variant(g.real.find_disk_min(x, y, r)) : g.var.find_disk_min(x, y, r);
 }
 
 variant ds_grid_get_disk_mean(const unsigned int id, const double x, const double y, const double r)
 {
     //Returns the mean of the values of the cells in the disk
-    return (ds_grids[id].find_disk_mean(x, y, r));
+    ds_grid_cells &g = ds_grids[id];
+    return g.numeric ? variant(g.real.find_disk_mean(x, y, r)) : g.var.find_disk_mean(x, y, r);
 }
 
+// A real grid holds no strings, so searches for one there fail without looking.
+
 bool ds_grid_value_exists(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
     //Returns whether the value appears somewhere in the region
-    return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].value_region_exists(x1, y1, x2, y2, val) : false);
+    ds_grid_cells &g = ds_grids[id];
+    if (!((x1 < g.width() || x2 < g.width()) && (y1 < g.height() || y2 < g.height())) || (g.numeric && val.type != enigma::vt_real))
+        return false;
+    return g.numeric ? g.real.value_region_exists(x1, y1, x2, y2, val.rval.d) : g.var.value_region_exists(x1, y1, x2, y2, val);
 }
 
 int ds_grid_value_x(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
     //Returns the x-coordinate of the cell in which the value appears in the region
-    return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].value_region_x(x1, y1, x2, y2, val) : 0);
+    ds_grid_cells &g = ds_grids[id];
+    if (!((x1 < g.width() || x2 < g.width()) && (y1 < g.height() || y2 < g.height())) || (g.numeric && val.type != enigma::vt_real))
+        return 0;
+    return g.numeric ? g.real.value_region_x(x1, y1, x2, y2, val.rval.d) : g.var.value_region_x(x1, y1, x2, y2, val);
 }
 
 int ds_grid_value_y(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
     //Returns the y-coordinate of the cell in which the value appears in the region
-    return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].value_region_y(x1, y1, x2, y2, val) : 0);
+    ds_grid_cells &g = ds_grids[id];
+    if (!((x1 < g.width() || x2 < g.width()) && (y1 < g.height() || y2 < g.height())) || (g.numeric && val.type != enigma::vt_real))
+        return 0;
+    return g.numeric ? g.real.value_region_y(x1, y1, x2, y2, val.rval.d) : g.var.value_region_y(x1, y1, x2, y2, val);
 }
 
 bool ds_grid_value_disk_exists(const unsigned int id, const double x, const double y, const double r, const variant val)
 {
     //Returns whether the value appears somewhere in the disk
-    return (ds_grids[id].value_disk_exists(x, y, r, val));
+    ds_grid_cells &g = ds_grids[id];
+    if (g.numeric && val.type != enigma::vt_real)
+        return false;
+    return g.numeric ? g.real.value_disk_exists(x, y, r, val.rval.d) : g.var.value_disk_exists(x, y, r, val);
 }
 
 bool ds_grid_value_disk_x(const unsigned int id, const double x, const double y, const double r, const variant val)
 {
     //Returns the x-coordinate of the cell in which the value appears in the disk
-    return (ds_grids[id].value_disk_x(x, y, r, val));
+    ds_grid_cells &g = ds_grids[id];
+    if (g.numeric && val.type != enigma::vt_real)
+        return false;
+    return g.numeric ? g.real.value_disk_x(x, y, r, val.rval.d) : g.var.value_disk_x(x, y, r, val);
 }
 
 bool ds_grid_value_disk_y(const unsigned int id, const double x, const double y, const double r, const variant val)
 {
     //Returns the y-coordinate of the cell in which the value appears in the disk
-    return (ds_grids[id].value_disk_y(x, y, r, val));
+    ds_grid_cells &g = ds_grids[id];
+    if (g.numeric && val.type != enigma::vt_real)
+        return false;
+    return g.numeric ? g.real.value_disk_y(x, y, r, val.rval.d) : g.var.value_disk_y(x, y, r, val);
 }
 
 void ds_grid_shuffle(const unsigned int id)
 {
     //Shuffles the values in the grid such that they end up in a random order
-    ds_grids[id].shuffle();
+    ds_grid_cells &g = ds_grids[id];
+    if (g.numeric)
+        g.real.shuffle();
+    else
+        g.var.shuffle();
 }
 
 bool ds_grid_exists(const unsigned int id)
@@ -701,131 +1129,56 @@ bool ds_grid_exists(const unsigned int id)
 unsigned int ds_grid_duplicate(const unsigned int source)
 {
     //creates and returns a new grid containing a copy of the source grid
-    ds_grids.insert(pair<unsigned int, grid<variant> >(ds_grids_maxid++, grid<variant>(0, 0)));
-    ds_grids[ds_grids_maxid-1].copy(ds_grids[source]);
+    ds_grids[ds_grids_maxid++].copy(ds_grids[source]);
     return ds_grids_maxid-1;
 }
 
-std::string ds_grid_write(const unsigned int id)
+std::string ds_grid_write(const unsigned int id, bool binary)
 {
-	std::stringstream ss;
-	ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
-	ss.width(4);
-	ss.fill('0');
-
-	grid<variant> dsGrid = ds_grids[id];
+	const ds_grid_cells &dsGrid = ds_grids[id];
+	const size_t cells = size_t(dsGrid.width()) * dsGrid.height();
+	ds_writer out(binary, 2 + (binary ? 0 : 2 * cells), cells);
 
 	// Write size
-	ss << std::hex << dsGrid.width();
-	ss.width(4); ss << std::hex << dsGrid.height();
-
-	//ds_grids[id].find(x, y)
+	out.count(dsGrid.width());
+	out.count(dsGrid.height());
 
 	for(unsigned y = 0; y < dsGrid.height(); ++y)
 	{
 		for(unsigned x = 0; x < dsGrid.width(); ++x)
 		{
-			// Write coords
-			ss.width(4); ss << x;
-			ss.width(4); ss << y;
-
-			variant vari = dsGrid.find(x, y);
-
-			// Write type
-			ss.width(2);
-			ss << (unsigned int)((vari.type == enigma::vt_real) ? 0x00 : 0x01);
-
-			// Write data
-			if (vari.type == enigma::vt_real)
-			{
-                ss.width(16);
-                char* b = (char*)&vari.rval.d;
-                for (unsigned i = 0; i < sizeof(double); ++i)
-                    ss << b[i];
-
-			}
-			else
-			{
-				ss.width(4); ss << vari.sval.length();
-				ss.width(1);
-				for(size_t j = 0; j < vari.sval.length(); ++j)
-					ss << vari.sval[j];
-			}
+			// Write coords; the binary format leaves them implied
+			if (!binary)
+				out.count(x), out.count(y);
+			out.value(dsGrid.get(x, y));
 		}
 	}
 
-	return ss.str();
+	return out.str();
 }
 
-void ds_grid_read(const unsigned int id, std::string value)
+void ds_grid_read(const unsigned int id, const std::string &value)
 {
-	std::stringstream ss;
-	int i = 8;
-	int width, height;
+	ds_reader in(value);
 
-	// Read count
-	ss << std::hex << value.substr(0, 4);
-	ss >> width;
-	ss.clear();
-	ss << std::hex << value.substr(4, 4);
-	ss >> height;
-	ss.clear();
-
-	for(int y = 0; y < height; ++y)
+	// Read size
+	const unsigned width = in.count(), height = in.count();
+	if (!in.good())
+		return;
+	ds_grid_resize(id, width, height);
+	ds_grid_cells &dsGrid = ds_grids[id];
+
+	variant vari;
+	for(unsigned y = 0; y < height && in.good(); ++y)
 	{
-		for(int x = 0; x < width; ++x)
+		for(unsigned x = 0; x < width && in.good(); ++x)
 		{
-			int xx, yy, type;
-
-			// Read x/y
-			ss << std::hex << value.substr(i, 4);
-			ss >> xx;
-			ss.clear();
-			i += 4;
-			ss << std::hex << value.substr(i, 4);
-			ss >> yy;
-			ss.clear();
-			i += 4;
-
-			// Read type
-			ss << std::hex << value.substr(i, 2);
-			ss >> type;
-			ss.clear();
-			i += 2;
-
-			if (type == 0)
-			{
-				variant vari;
-				vari.type = enigma::vt_real;
-
-                string b;
-				ss << std::hex << value.substr(i, 16);
-				ss >> b;
-                double d = atof(b.c_str());
-
-				ss.clear();
-				i += 16;
-
-				vari.rval.d = d;
-				ds_grids[id].add(xx, yy, vari);
-			}
-			else
-			{
-				variant vari;
-				vari.type = enigma::vt_tstr;
-				int len;
-
-				// Read length
-				ss << std::hex << value.substr(i, 4);
-				ss >> len;
-				ss.clear();
-				i += 4;
-
-				vari.sval = value.substr(i, len);
-				i += len;
-
-				ds_grids[id].add(xx, yy, vari);
-			}
+			unsigned xx = x, yy = y;
+			if (!in.is_binary())
+				xx = in.count(), yy = in.count();
+			in.value(vari);
+			if (in.good())
+				dsGrid.set(xx, yy, vari);
 		}
 	}
 }
@@ -834,53 +1187,301 @@ void ds_grid_read(const unsigned int id, std::string value)
 
 /* ds_maps */
 
-static map<unsigned int, multimap<variant, variant> > ds_maps;
+// A ds_map is an open-addressing hash table over its entries, with a fast path for each
+// kind of key: reals are hashed by value and compared as doubles, strings carry their hash
+// so that most mismatches never reach a string compare. The same key may be added more
+// than once; its values are kept in the order added. Searches by order (find_first,
+// find_next...) and writing go through a list of the entries sorted by key, which is
+// rebuilt only when keys have been added or removed since it was last needed.
+class ds_map_table
+{
+    struct entry
+    {
+        variant key, value;
+        vector<variant> later; // Values added under the same key after `value', oldest first
+        unsigned hash;
+    };
+    struct slot
+    {
+        unsigned index; // Entry index + 1; 0 for an empty slot
+        unsigned hash;
+    };
+
+    vector<entry> entries;
+    vector<slot> slots; // Size is a power of two, at most half full
+    size_t count;       // Values, counting those added under repeated keys
+    mutable vector<unsigned> order;
+    mutable bool order_valid;
+
+    static unsigned hash_key(const variant &key)
+    {
+        if (key.type == enigma::vt_real)
+        {
+            const double d = key.rval.d == 0 ? 0 : key.rval.d; // Fold -0 into 0
+            unsigned long long h;
+            memcpy(&h, &d, sizeof h);
+            h ^= h >> 33, h *= 0xFF51AFD7ED558CCDULL, h ^= h >> 33;
+            return unsigned(h);
+        }
+        unsigned h = 2166136261u;
+        for (size_t i = 0; i < key.sval.length(); i++)
+            h = (h ^ (unsigned char)key.sval[i]) * 16777619u;
+        return h;
+    }
+    static bool same_key(const variant &a, const variant &b)
+    {
+        if (a.type != b.type)
+            return false;
+        if (a.type == enigma::vt_real) // A NaN key can still be found; the sort puts it somewhere
+            return a.rval.d == b.rval.d || (a.rval.d != a.rval.d && b.rval.d != b.rval.d);
+        return a.sval == b.sval;
+    }
+    static bool key_less(const variant &a, const variant &b) {
+        return a.type != b.type ? a.type < b.type : a.type == enigma::vt_real ? a.rval.d < b.rval.d : a.sval < b.sval;
+    }
+    struct order_less
+    {
+        const vector<entry> &e;
+        order_less(const vector<entry> &entries): e(entries) {}
+        bool operator()(unsigned a, unsigned b) const { return key_less(e[a].key, e[b].key); }
+        bool operator()(unsigned a, const variant &key) const { return key_less(e[a].key, key); }
+        bool operator()(const variant &key, unsigned b) const { return key_less(key, e[b].key); }
+    };
+
+    // The slot holding the key, or the empty slot where it would go.
+    size_t probe(const variant &key, unsigned h) const
+    {
+        const size_t mask = slots.size() - 1;
+        size_t s = h & mask;
+        while (slots[s].index && (slots[s].hash != h || !same_key(entries[slots[s].index - 1].key, key)))
+            s = (s + 1) & mask;
+        return s;
+    }
+    void rehash(size_t size)
+    {
+        slots.assign(size, slot());
+        const size_t mask = size - 1;
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            size_t s = entries[i].hash & mask;
+            while (slots[s].index)
+                s = (s + 1) & mask;
+            slots[s].index = i + 1, slots[s].hash = entries[i].hash;
+        }
+    }
+    const vector<unsigned> &sorted() const
+    {
+        if (!order_valid)
+        {
+            order.resize(entries.size());
+            for (size_t i = 0; i < order.size(); i++)
+                order[i] = i;
+            sort(order.begin(), order.end(), order_less(entries));
+            order_valid = true;
+        }
+        return order;
+    }
+
+    // Removes the entry in slot s, along with all its values.
+    void remove_slot(size_t s)
+    {
+        const size_t mask = slots.size() - 1;
+        const unsigned index = slots[s].index - 1;
+        count -= 1 + entries[index].later.size();
+
+        // Shift later members of the probe run back, so no tombstone is needed.
+        for (size_t next = (s + 1) & mask; slots[next].index; next = (next + 1) & mask)
+        {
+            const size_t home = slots[next].hash & mask;
+            if (((next - home) & mask) >= ((next - s) & mask))
+                slots[s] = slots[next], s = next;
+        }
+        slots[s] = slot();
+
+        // Fill the hole in the entries with the last one.
+        const unsigned last = entries.size() - 1;
+        if (index != last)
+        {
+            slots[probe(entries[last].key, entries[last].hash)].index = index + 1;
+            entries[index] = entries[last];
+        }
+        entries.pop_back();
+        order_valid = false;
+    }
+
+    public:
+    ds_map_table(): count(0), order_valid(true) { slots.resize(8); }
+
+    size_t size() const { return count; }
+    bool empty() const { return !count; }
+    void clear()
+    {
+        entries.clear();
+        slots.assign(8, slot());
+        count = 0;
+        order.clear();
+        order_valid = true;
+    }
+
+    const variant *find(const variant &key) const
+    {
+        const slot &s = slots[probe(key, hash_key(key))];
+        return s.index ? &entries[s.index - 1].value : NULL;
+    }
+    variant *find(const variant &key)
+    {
+        const slot &s = slots[probe(key, hash_key(key))];
+        return s.index ? &entries[s.index - 1].value : NULL;
+    }
+
+    void add(const variant &key, const variant &value)
+    {
+        const unsigned h = hash_key(key);
+        size_t s = probe(key, h);
+        count++;
+        if (slots[s].index)
+        {
+            entries[slots[s].index - 1].later.push_back(value);
+            return;
+        }
+
+        // Keys added in increasing order keep the sorted list valid.
+        if (order_valid && (entries.empty() || key_less(entries[order.back()].key, key)))
+            order.push_back(entries.size());
+        else
+            order_valid = false;
+
+        entries.push_back(entry());
+        entry &e = entries.back();
+        e.key = key, e.value = value, e.hash = h;
+        if (entries.size() * 2 > slots.size())
+            rehash(slots.size() * 2);
+        else
+            slots[s].index = entries.size(), slots[s].hash = h;
+    }
+
+    // Removes the oldest value added under the key.
+    void remove(const variant &key)
+    {
+        const size_t s = probe(key, hash_key(key));
+        if (!slots[s].index)
+            return;
+        entry &e = entries[slots[s].index - 1];
+        if (e.later.empty())
+            return remove_slot(s);
+        e.value = e.later.front();
+        e.later.erase(e.later.begin());
+        count--;
+    }
+
+    // Removes every key from `first' up to, but not including, `last'. Both must be present.
+    void remove_range(const variant &first, const variant &last)
+    {
+        if (!find(first) || !find(last))
+            return;
+        const vector<unsigned> &o = sorted();
+        vector<variant> doomed;
+        for (vector<unsigned>::const_iterator it = lower_bound(o.begin(), o.end(), first, order_less(entries));
+             it != o.end() && key_less(entries[*it].key, last); ++it)
+            doomed.push_back(entries[*it].key);
+        for (size_t i = 0; i < doomed.size(); i++)
+            remove_slot(probe(doomed[i], hash_key(doomed[i])));
+    }
+
+    // Keys in order; each returns NULL if there is no such key.
+    const variant *first_key() const { return entries.empty() ? NULL : &entries[sorted().front()].key; }
+    const variant *last_key() const { return entries.empty() ? NULL : &entries[sorted().back()].key; }
+    const variant *next_key(const variant &key) const
+    {
+        const vector<unsigned> &o = sorted();
+        vector<unsigned>::const_iterator it = upper_bound(o.begin(), o.end(), key, order_less(entries));
+        return it == o.end() ? NULL : &entries[*it].key;
+    }
+    const variant *previous_key(const variant &key) const
+    {
+        const vector<unsigned> &o = sorted();
+        vector<unsigned>::const_iterator it = lower_bound(o.begin(), o.end(), key, order_less(entries));
+        return it == o.begin() ? NULL : &entries[*--it].key;
+    }
+
+    // Writes the count, then every key and value, in order of key and then of addition.
+    void write(ds_writer &out) const
+    {
+        out.count(count);
+        const vector<unsigned> &o = sorted();
+        for (size_t i = 0; i < o.size(); i++)
+        {
+            const entry &e = entries[o[i]];
+            out.value(e.key), out.value(e.value);
+            for (size_t j = 0; j < e.later.size(); j++)
+                out.value(e.key), out.value(e.later[j]);
+        }
+    }
+};
+
+// Maps are indexed by id; destroyed maps leave a NULL behind.
+static vector<ds_map_table*> ds_maps;
 static unsigned int ds_maps_maxid = 0;
 
+// Maps spring into existence when an unused id is accessed, as they always have.
+static inline ds_map_table &ds_map_get(const unsigned int id)
+{
+    if (id >= ds_maps.size())
+        ds_maps.resize(id + 1, NULL);
+    if (!ds_maps[id])
+        ds_maps[id] = new ds_map_table();
+    return *ds_maps[id];
+}
+
 namespace enigma_user
 {
 
 unsigned int ds_map_create()
 {
     //Creates a new map. The function returns an integer as an id that must be used in all other functions to access the particular map.
-    ds_maps.insert(pair<unsigned int, multimap<variant, variant> >(ds_maps_maxid++, multimap<variant, variant>()));
+    ds_map_get(ds_maps_maxid++);
     return ds_maps_maxid-1;
 }
 
 void ds_map_destroy(const unsigned int id)
 {
     //Destroys the map
-    ds_maps.erase(ds_maps.find(id));
+    if (id < ds_maps.size())
+    {
+        delete ds_maps[id];
+        ds_maps[id] = NULL;
+    }
 }
 
 void ds_map_clear(const unsigned int id)
 {
     //Clears all values from the map
-    ds_maps[id].clear();
+    ds_map_get(id).clear();
 }
 
 void ds_map_copy(const unsigned int id, const unsigned int source)
 {
     //Copies the source map onto the map
-    ds_maps[id] = ds_maps[source];
+    const ds_map_table &src = ds_map_get(source);
+    ds_map_get(id) = src;
 }
 
 unsigned int ds_map_size(const unsigned int id)
 {
     //Returns the size of the map
-    return ds_maps[id].size();
+    return ds_map_get(id).size();
 }
 
 bool ds_map_empty(const unsigned int id)
 {
     //Returns whether the map contains no values
-    return ds_maps[id].empty();
+    return ds_map_get(id).empty();
 }
 
 void ds_map_add(const unsigned int id, const variant key, const variant val)
 {
    //Adds the value and corresponding key to the map.
-    ds_maps[id].insert(pair<variant, variant>(key, val));
+    ds_map_get(id).add(key, val);
 }
 
 void ds_map_replace(const unsigned int id, const variant key, const variant val)
@@ -894,11 +1495,11 @@ void ds_map_replace(const unsigned int id, const variant key, const variant val)
 	//extension which had to create a special function to replace a value adding it if it does
 	//not exist in the global async_load map.
 	//Replaces the value corresponding with the key with a new value
-	multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-	if (it != ds_maps[id].end())
+	ds_map_table &m = ds_map_get(id);
+	if (m.find(key))
 	{
-		ds_maps[id].erase(it);
-		ds_maps[id].insert(pair<variant, variant>(key, val));
+		m.remove(key);
+		m.add(key, val);
 	}
 }
 
@@ -906,254 +1507,103 @@ void ds_map_replace(const unsigned int id, const variant key, const variant val)
 void ds_map_replaceanyway(const unsigned int id, const variant key, const variant val)
 {
 	//Replaces the value corresponding with the key with a new value, adding it if it was not found in the map.
-	multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-	if (it != ds_maps[id].end())
-	{
-		ds_maps[id].erase(it);
-	}
-	ds_maps[id].insert(pair<variant, variant>(key, val));
+	ds_map_table &m = ds_map_get(id);
+	m.remove(key);
+	m.add(key, val);
 }
 
 void ds_map_delete(const unsigned int id, const variant key)
 {
     //Deletes the key and the corresponding value from the map
-    multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-    if (it != ds_maps[id].end())
-    {
-        ds_maps[id].erase(it);
-    }
+    ds_map_get(id).remove(key);
 }
 
 void ds_map_delete(const unsigned int id, const variant first, const variant last)
 {
     //Deletes the keys and corresponding values in the range between first and last
-    multimap<variant, variant>::iterator itf = ds_maps[id].find(first), itl = ds_maps[id].find(last);
-    if (itf != ds_maps[id].end() && itl != ds_maps[id].end())
-    {
-        ds_maps[id].erase(itf, itl);
-    }
+    ds_map_get(id).remove_range(first, last);
 }
 
 bool ds_map_exists(const unsigned int id, const variant key)
 {
     //returns whether the key exists in the map
-    return (ds_maps[id].find(key) != ds_maps[id].end());
+    return ds_map_get(id).find(key) != NULL;
 }
 
 variant ds_map_find_value(const unsigned int id, const variant key)
 {
     //Returns the value corresponding to the key in the map
-    multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-    return ((it == ds_maps[id].end()) ? variant() : (*it).second);
+    const variant *v = ds_map_get(id).find(key);
+    return v ? *v : variant();
 }
 
 variant ds_map_find_previous(const unsigned int id, const variant key)
 {
     //Returns the largest key in the map smaller than the indicated key
-    multimap<variant, variant>::reverse_iterator rit;
-    variant key_check;
-    for (rit = ds_maps[id].rbegin(); rit != ds_maps[id].rend(); rit++)
-    {
-        if ((key_check = (*rit).first) < key)
-        {
-            return key_check;
-        }
-    }
-    return 0;
+    const variant *k = ds_map_get(id).previous_key(key);
+    return k ? *k : variant(0);
 }
 
 variant ds_map_find_next(const unsigned int id, const variant key)
 {
     //Returns the smallest key in the map larger than the indicated key
-    multimap<variant, variant>::iterator it;
-    variant key_check;
-    for (it = ds_maps[id].begin(); it != ds_maps[id].end(); it++)
-    {
-        if ((key_check = (*it).first) > key)
-        {
-            return key_check;
-        }
-    }
-    return 0;
+    const variant *k = ds_map_get(id).next_key(key);
+    return k ? *k : variant(0);
 }
 
 variant ds_map_find_first(const unsigned int id)
 {
     //Returns the smallest key in the map
-    multimap<variant, variant>::iterator it = ds_maps[id].begin();
-    return (it == ds_maps[id].end()) ? variant() : (*it).first;
+    const variant *k = ds_map_get(id).first_key();
+    return k ? *k : variant();
 }
 
 variant ds_map_find_last(const unsigned int id)
 {
     //Returns the largest key in the map
-    multimap<variant, variant>::reverse_iterator rit = ds_maps[id].rbegin();
-    return ((rit == ds_maps[id].rend()) ? variant() : (*rit).first);
+    const variant *k = ds_map_get(id).last_key();
+    return k ? *k : variant();
 }
 
 bool ds_map_exists(const unsigned int id)
 {
     //returns whether the map exists
-    return (ds_maps.find(id) != ds_maps.end());
+    return id < ds_maps.size() && ds_maps[id];
 }
 
 unsigned int ds_map_duplicate(const unsigned int source)
 {
     //creates and returns a new map containing a copy of the source map
-    ds_maps.insert(pair<unsigned int, multimap<variant, variant> >(++ds_maps_maxid, multimap<variant, variant>()));
-    ds_maps[ds_maps_maxid-1] = ds_maps[source];
+    const ds_map_table &src = ds_map_get(source);
+    ds_map_get(ds_maps_maxid++) = src;
     return ds_maps_maxid-1;
 }
 
-std::string ds_map_write(const unsigned int id)
+std::string ds_map_write(const unsigned int id, bool binary)
 {
-	std::stringstream ss;
-	ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
-	ss.width(4);
-	ss.fill('0');
-
-	std::multimap<variant, variant> dsMap = ds_maps[id];
-
-	// Write size
-	ss << std::hex << dsMap.size();
-
-	std::multimap<variant, variant>::iterator it = dsMap.begin();
-	while (it != dsMap.end())
-	{
-		// Write type
-		ss.width(2);
-		ss << (unsigned int)(((*it).first.type == enigma::vt_real) ? 0x00 : 0x01);
-
-		// Write data
-		if ((*it).first.type == enigma::vt_real)
-		{
-			ss.width(16);
-            char* b = (char*)&(*it).first.rval.d;
-            for (unsigned i = 0; i < sizeof(double); ++i)
-            ss << b[i];
-		}
-		else
-		{
-			ss.width(4); ss << (*it).first.sval.length();
-			ss.width(1);
-			for(size_t j = 0; j < (*it).first.sval.length(); ++j)
-				ss << (*it).first.sval[j];
-		}
-
-		// Write type
-		ss.width(2);
-		ss << (unsigned int)(((*it).second.type == enigma::vt_real) ? 0x00 : 0x01);
-
-		// Write data
-		if ((*it).second.type == enigma::vt_real)
-		{
-			ss.width(16);
-            char* b = (char*)&(*it).second.rval.d;
-            for (unsigned i = 0; i < sizeof(double); ++i)
-            ss << b[i];		}
-		else
-		{
-			ss.width(4); ss << (*it).second.sval.length();
-			ss.width(1);
-			for(size_t j = 0; j < (*it).second.sval.length(); ++j)
-				ss << (*it).second.sval[j];
-		}
-
-		++it;
-	}
-
-	return ss.str();
+	const ds_map_table &dsMap = ds_map_get(id);
+	ds_writer out(binary, 1, 2 * dsMap.size());
+	dsMap.write(out);
+	return out.str();
 }
 
-void ds_map_read(const unsigned int id, std::string value)
+void ds_map_read(const unsigned int id, const std::string &value)
 {
-	std::stringstream ss;
-	int i = 4;
-	int count;
+	ds_reader in(value);
+	ds_map_table &dsMap = ds_map_get(id);
 
 	// Read count
-	ss << std::hex << value.substr(0, 4);
-	ss >> count;
-	ss.clear();
+	const unsigned count = in.count();
 
-	for(int j = 0; j < count; ++j)
+	variant variKey, variValue;
+	for(unsigned j = 0; j < count && in.good(); ++j)
 	{
-		variant variKey, variValue;
-		int type;
-
-		// Read type
-		ss << std::hex << value.substr(i, 2);
-		ss >> type;
-		ss.clear();
-		i += 2;
-
-		if (type == 0)
-		{
-            string b;
-            ss << std::hex << value.substr(i, 16);
-            ss >> b;
-            double d = atof(b.c_str());
-
-            ss.clear();
-            i += 16;
-
-            variKey.rval.d = d;
-			variKey.type = enigma::vt_real;
-		}
-		else
-		{
-			int len;
-
-			// Read length
-			ss << std::hex << value.substr(i, 4);
-			ss >> len;
-			ss.clear();
-			i += 4;
-
-			variKey.type = enigma::vt_tstr;
-			variKey.sval = value.substr(i, len);
-			i += len;
-		}
-
-		// Read type
-		ss << std::hex << value.substr(i, 2);
-		ss >> type;
-		ss.clear();
-		i += 2;
-
-		if (type == 0)
-		{
-            string b;
-            ss << std::hex << value.substr(i, 16);
-            ss >> b;
-            double d = atof(b.c_str());
-
-            ss.clear();
-            i += 16;
-
-            variValue.rval.d = d;
-			variValue.type = enigma::vt_real;
-		}
-		else
-		{
-			int len;
-
-			// Read length
-			ss << std::hex << value.substr(i, 4);
-			ss >> len;
-			ss.clear();
-			i += 4;
-
-			variValue.type = enigma::vt_tstr;
-			variValue.sval = value.substr(i, len);
-			i += len;
-		}
-
-		// Push value
-		ds_maps[id].insert(std::pair<variant, variant>(variKey, variValue));
+		in.value(variKey);
+		in.value(variValue);
+		if (in.good())
+			dsMap.add(variKey, variValue);
 	}
 }
-
 }
 
 /* ds_lists */
@@ -1297,100 +1747,35 @@ unsigned int ds_list_duplicate(const unsigned int source)
     return ds_lists_maxid-1;
 }
 
-std::string ds_list_write(const unsigned int id)
+std::string ds_list_write(const unsigned int id, bool binary)
 {
-	std::stringstream ss;
-	ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
-	ss.width(4);
-	ss.fill('0');
-
-	std::vector<variant> dsList = ds_lists[id];
+	const vector<variant> &ds = ds_lists[id];
+	ds_writer out(binary, 1, ds.size());
 
 	// Write count
-	ss << dsList.size();
-	for(size_t i = 0; i < dsList.size(); ++i)
-	{
-		// Write type
-		ss.width(2);
-		ss << (unsigned int)((dsList[i].type == enigma::vt_real) ? 0x00 : 0x01);
+	out.count(ds.size());
+	for(size_t i = 0; i < ds.size(); ++i)
+		out.value(ds[i]);
 
-		// Write data
-		if (dsList[i].type == enigma::vt_real)
-		{
-			ss.width(16);
-            char* b = (char*)&dsList[i].rval.d;
-            for (unsigned i = 0; i < sizeof(double); ++i)
-                ss << b[i];
-		}
-		else
-		{
-			ss.width(4); ss << dsList[i].sval.length();
-			ss.width(1);
-			for(size_t j = 0; j < dsList[i].sval.length(); ++j)
-				ss << dsList[i].sval[j];
-		}
-	}
-
-	return ss.str();
+	return out.str();
 }
 
-void ds_list_read(const unsigned int id, std::string value)
+void ds_list_read(const unsigned int id, const std::string &value)
 {
-	std::stringstream ss;
-	int i = 4;
-	int count;
+	ds_reader in(value);
+	vector<variant> &ds = ds_lists[id];
 
 	// Read count
-	ss << std::hex << value.substr(0, 4);
-	ss >> count;
-	ss.clear();
+	const unsigned count = in.count();
 
-	for(int j = 0; j < count; ++j)
+	variant vari;
+	for(unsigned j = 0; j < count && in.good(); ++j)
 	{
-		int type;
-
-		// Read type
-		ss << std::hex << value.substr(i, 2);
-		ss >> type;
-		ss.clear();
-		i += 2;
-
-		if (type == 0)
-		{
-			variant vari;
-			vari.type = enigma::vt_real;
-
-            string b;
-            ss << std::hex << value.substr(i, 16);
-            ss >> b;
-            double d = atof(b.c_str());
-
-            ss.clear();
-            i += 16;
-
-            vari.rval.d = d;
-			ds_lists[id].push_back(vari);
-		}
-		else
-		{
-			variant vari;
-			vari.type = enigma::vt_tstr;
-			int len;
-
-			// Read length
-			ss << std::hex << value.substr(i, 4);
-			ss >> len;
-			ss.clear();
-			i += 4;
-
-			vari.sval = value.substr(i, len);
-			i += len;
-
-			ds_lists[id].push_back(vari);
-		}
+		in.value(vari);
+		if (in.good())
+			ds.push_back(vari);
 	}
 }
-
 }
 
 /* ds_prioritys */
@@ -1552,118 +1937,43 @@ unsigned int ds_priority_duplicate(const unsigned int source)
     return ds_prioritys_maxid-1;
 }
 
-std::string ds_priority_write(const unsigned int id)
+std::string ds_priority_write(const unsigned int id, bool binary)
 {
-	std::stringstream ss;
-	ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
-	ss.width(4);
-	ss.fill('0');
-
-	std::multimap<variant, variant> dsPriority = ds_prioritys[id];
+	const multimap<variant, variant> &dsPriority = ds_prioritys[id];
+	ds_writer out(binary, 1, 2 * dsPriority.size());
 
 	// Write size
-	ss << std::hex << dsPriority.size();
+	out.count(dsPriority.size());
 
-	std::multimap<variant, variant>::iterator it = dsPriority.begin();
-	while (it != dsPriority.end())
+	// Each value is written as its type, then its priority, then its data
+	for (multimap<variant, variant>::const_iterator it = dsPriority.begin(); it != dsPriority.end(); ++it)
 	{
-		// Write type
-		ss.width(2);
-		ss << (unsigned int)(((*it).first.type == enigma::vt_real) ? 0x00 : 0x01);
-		ss.width(16);
-        char* b = (char*)&(*it).second.rval.d;
-        for (unsigned i = 0; i < sizeof(double); ++i)
-            ss << b[i];
-
-		// Write data
-		if ((*it).first.type == enigma::vt_real)
-		{
-			ss.width(16);
-            char* b = (char*)&(*it).first.rval.d;
-            for (unsigned i = 0; i < sizeof(double); ++i)
-                ss << b[i];
-		}
-		else
-		{
-			ss.width(4); ss << (*it).first.sval.length();
-			ss.width(1);
-			for(size_t j = 0; j < (*it).first.sval.length(); ++j)
-				ss << (*it).first.sval[j];
-		}
-
-		++it;
+		out.type(it->first);
+		out.real(it->second.rval.d);
+		out.data(it->first);
 	}
 
-	return ss.str();
+	return out.str();
 }
 
-void ds_priority_read(const unsigned int id, std::string value)
+void ds_priority_read(const unsigned int id, const std::string &value)
 {
-	std::stringstream ss;
-	int i = 4;
-	int count;
+	ds_reader in(value);
+	multimap<variant, variant> &dsPriority = ds_prioritys[id];
 
 	// Read count
-	ss << std::hex << value.substr(0, 4);
-	ss >> count;
-	ss.clear();
+	const unsigned count = in.count();
 
-	for(int j = 0; j < count; ++j)
+	variant vari;
+	for(unsigned j = 0; j < count && in.good(); ++j)
 	{
-		variant vari, prio;
-		int type;
-
-		prio.type = enigma::vt_real;
-
-		// Read type
-		ss << std::hex << value.substr(i, 2);
-		ss >> type;
-		ss.clear();
-		i += 2;
-
-    // Read priority
-        string b;
-        ss << std::hex << value.substr(i, 16);
-        ss >> b;
-        double d = atof(b.c_str());
-        ss.clear();
-        i += 16;
-
-        prio = d;
-
-		if (type == 0)
-		{
-            string b;
-            ss << std::hex << value.substr(i, 16);
-            ss >> b;
-            double d = atof(b.c_str());
-
-            ss.clear();
-            i += 16;
-
-            vari.rval.d = d;
-			vari.type = enigma::vt_real;
-		}
-		else
-		{
-			int len;
-
-			// Read length
-			ss << std::hex << value.substr(i, 4);
-			ss >> len;
-			ss.clear();
-			i += 4;
-
-			vari.type = enigma::vt_tstr;
-			vari.sval = value.substr(i, len);
-			i += len;
-		}
-
-		// Push value
-		ds_prioritys[id].insert(std::pair<variant, variant>(vari, prio));
+		const int type = in.type();
+		const variant prio = in.real();
+		in.data(type, vari);
+		if (in.good())
+			dsPriority.insert(std::pair<variant, variant>(vari, prio));
 	}
 }
-
 }
 
 /* ds_queues */
@@ -1755,99 +2065,35 @@ unsigned int ds_queue_duplicate(const unsigned int source)
     return ds_queues_maxid-1;
 }
 
-std::string ds_queue_write(const unsigned int id)
+std::string ds_queue_write(const unsigned int id, bool binary)
 {
-	std::stringstream ss;
-	ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
-	ss.width(4);
-	ss.fill('0');
-
-	std::deque<variant> dsQueue = ds_queues[id];
-
-	// Write size
-	ss << std::hex << dsQueue.size();
+	const deque<variant> &ds = ds_queues[id];
+	ds_writer out(binary, 1, ds.size());
 
-	for(size_t i = 0; i < dsQueue.size(); ++i)
-	{
-		// Write type
-		ss.width(2);
-		ss << (unsigned int)((dsQueue[i].type == enigma::vt_real) ? 0x00 : 0x01);
-
-		// Write data
-		if (dsQueue[i].type == enigma::vt_real)
-		{
-			ss.width(16);
-            char* b = (char*)&dsQueue[i].rval.d;
-            for (unsigned i = 0; i < sizeof(double); ++i)
-                ss << b[i];
-		}
-		else
-		{
-			ss.width(4); ss << dsQueue[i].sval.length();
-			ss.width(1);
-			for(size_t j = 0; j < dsQueue[i].sval.length(); ++j)
-				ss << dsQueue[i].sval[j];
-		}
-	}
+	// Write count
+	out.count(ds.size());
+	for(size_t i = 0; i < ds.size(); ++i)
+		out.value(ds[i]);
 
-	return ss.str();
+	return out.str();
 }
 
-void ds_queue_read(const unsigned int id, std::string value)
+void ds_queue_read(const unsigned int id, const std::string &value)
 {
-	std::stringstream ss;
-	int i = 4;
-	int count;
+	ds_reader in(value);
+	deque<variant> &ds = ds_queues[id];
 
 	// Read count
-	ss << std::hex << value.substr(0, 4);
-	ss >> count;
-	ss.clear();
+	const unsigned count = in.count();
 
-	for(int j = 0; j < count; ++j)
+	variant vari;
+	for(unsigned j = 0; j < count && in.good(); ++j)
 	{
-		variant vari;
-		int type;
-
-		// Read type
-		ss << std::hex << value.substr(i, 2);
-		ss >> type;
-		ss.clear();
-		i += 2;
-
-		if (type == 0)
-		{
-            string b;
-            ss << std::hex << value.substr(i, 16);
-            ss >> b;
-            double d = atof(b.c_str());
-
-            ss.clear();
-            i += 16;
-
-            vari.rval.d = d;
-			vari.type = enigma::vt_real;
-		}
-		else
-		{
-			int len;
-
-			// Read length
-			ss << std::hex << value.substr(i, 4);
-			ss >> len;
-			ss.clear();
-			i += 4;
-
-			vari.type = enigma::vt_tstr;
-			vari.sval = value.substr(i, len);
-			i += len;
-		}
-
-		// Push value
-		ds_queues[id].push_back(vari);
+		in.value(vari);
+		if (in.good())
+			ds.push_back(vari);
 	}
 }
-
 }
 
 /* ds_stacks */
@@ -1932,98 +2178,34 @@ unsigned int ds_stack_duplicate(const unsigned int source)
     return ds_stacks_maxid-1;
 }
 
-std::string ds_stack_write(const unsigned int id)
+std::string ds_stack_write(const unsigned int id, bool binary)
 {
-	std::stringstream ss;
-	ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
-	ss.width(4);
-	ss.fill('0');
+	const deque<variant> &ds = ds_stacks[id];
+	ds_writer out(binary, 1, ds.size());
 
-	std::deque<variant> dsStack = ds_stacks[id];
-
-	// Write size
-	ss << std::hex << dsStack.size();
-
-	for(size_t i = 0; i < dsStack.size(); ++i)
-	{
-		// Write type
-		ss.width(2);
-		ss << (unsigned int)((dsStack[i].type == enigma::vt_real) ? 0x00 : 0x01);
-
-		// Write data
-		if (dsStack[i].type == enigma::vt_real)
-		{
-			ss.width(16);
-            char* b = (char*)&dsStack[i].rval.d;
-            for (unsigned i = 0; i < sizeof(double); ++i)
-                ss << b[i];
-		}
-		else
-		{
-			ss.width(4); ss << dsStack[i].sval.length();
-			ss.width(1);
-			for(size_t j = 0; j < dsStack[i].sval.length(); ++j)
-				ss << dsStack[i].sval[j];
-		}
-	}
+	// Write count
+	out.count(ds.size());
+	for(size_t i = 0; i < ds.size(); ++i)
+		out.value(ds[i]);
 
-	return ss.str();
+	return out.str();
 }
 
-void ds_stack_read(const unsigned int id, std::string value)
+void ds_stack_read(const unsigned int id, const std::string &value)
 {
-	std::stringstream ss;
-	int i = 4;
-	int count;
+	ds_reader in(value);
+	deque<variant> &ds = ds_stacks[id];
 
 	// Read count
-	ss << std::hex << value.substr(0, 4);
-	ss >> count;
-	ss.clear();
+	const unsigned count = in.count();
 
-	for(int j = 0; j < count; ++j)
+	variant vari;
+	for(unsigned j = 0; j < count && in.good(); ++j)
 	{
-		variant vari;
-		int type;
-
-		// Read type
-		ss << std::hex << value.substr(i, 2);
-		ss >> type;
-		ss.clear();
-		i += 2;
-
-		if (type == 0)
-		{
-            string b;
-            ss << std::hex << value.substr(i, 16);
-            ss >> b;
-            double d = atof(b.c_str());
-
-            ss.clear();
-            i += 16;
-
-            vari.rval.d = d;
-			vari.type = enigma::vt_real;
-		}
-		else
-		{
-			int len;
-
-			// Read length
-			ss << std::hex << value.substr(i, 4);
-			ss >> len;
-			ss.clear();
-			i += 4;
-
-			vari.type = enigma::vt_tstr;
-			vari.sval = value.substr(i, len);
-			i += len;
-		}
-
-		// Push value
-		ds_stacks[id].push_back(vari);
+		in.value(vari);
+		if (in.good())
+			ds.push_back(vari);
 	}
 }
-
 }
 
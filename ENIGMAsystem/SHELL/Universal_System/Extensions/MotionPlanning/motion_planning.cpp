@@ -29,24 +29,59 @@
 #include <vector>
 #include <cmath>
 #include <map>
+#include <set>
 using namespace std;
 
 //#include "Graphics_Systems/OpenGL/OpenGLHeaders.h" //For drawing straight lines
 #include "../Paths/pathstruct.h"
+#include "../Paths/path_functions.h"
 #include "libEGMstd.h"
 #include "motion_planning_struct.h"
 #include "motion_planning.h"
 #include "Universal_System/scalar.h"
-
-namespace enigma_user {
-int collision_rectangle(cs_scalar x1, cs_scalar y1, cs_scalar x2, cs_scalar y2, int obj, bool prec /*ignored*/, bool notme);
-}
+#include "Universal_System/collisions_object.h"
+#include "Universal_System/instance_system_base.h"
+#include "Collision_Systems/collision_mandatory.h"
+#include "Platforms/General/PFthreads.h"
 
 namespace enigma {
 	extern size_t grid_idmax;
 	extern unsigned bound_texture;
 }
 
+static unsigned cell_cost(const enigma::grid *gr, unsigned i) { return gr->nodearray[i].cost; }
+static unsigned cell_cost(const enigma::grid_snapshot *gr, unsigned i) { return gr->cost[i]; }
+
+// Replaces a path's points with a walk from the start through the centers of the given cells,
+// ending at the goal if it was reached; start, goal and cells are indices into the grid.
+template<typename G>
+static void set_path_points(unsigned pathid, const G *gr, double speed_modifier, double xstart, double ystart, double xgoal, double ygoal,
+                            unsigned start, unsigned goal, const vector<unsigned> &cells, bool status)
+{
+    enigma::path *path = enigma::pathstructarray[pathid];
+    path->pointarray.clear();
+
+    //push the very first point
+    enigma::path_point point(xstart,ystart,speed_modifier/double(cell_cost(gr,start)));
+    path->pointarray.push_back(point);
+    vector<unsigned>::const_iterator it;
+    for (it=cells.begin(); it != cells.end(); it++)
+    {
+            point = enigma::path_point(gr->left+(*it/gr->vcells+0.5)*gr->cellwidth,gr->top+(*it%gr->vcells+0.5)*gr->cellheight,speed_modifier/double(cell_cost(gr,*it)));
+            path->pointarray.push_back(point);
+    }
+
+    //push the very last point if we can reach the destination
+    if (status == true){
+        point = enigma::path_point(xgoal,ygoal,speed_modifier/double(cell_cost(gr,goal)));
+        path->pointarray.push_back(point);
+    } else if (path->pointarray.size()==1) {
+        point = enigma::path_point(path->pointarray.back().x,path->pointarray.back().y,speed_modifier/double(cell_cost(gr,goal)));
+        path->pointarray.push_back(point);
+    }
+    enigma::path_recalculate(pathid);
+}
+
 namespace enigma_user
 {
 
@@ -64,9 +99,10 @@ void mp_grid_destroy(unsigned id)
 
 unsigned mp_grid_duplicate(unsigned id)
 {
-    enigma::gridstructarray_reallocate();
-    enigma::gridstructarray[enigma::grid_idmax] = new enigma::grid(*enigma::gridstructarray[id]);
-    return enigma::grid_idmax-1;
+    const enigma::grid *grid = enigma::gridstructarray[id];
+    unsigned dup = mp_grid_create(grid->left, grid->top, grid->hcells, grid->vcells, grid->cellwidth, grid->cellheight, grid->speed_modifier);
+    mp_grid_copy(dup, id);
+    return dup;
 }
 
 void mp_grid_copy(unsigned id, unsigned srcid)
@@ -90,29 +126,10 @@ void mp_grid_copy(unsigned id, unsigned srcid)
         grid->nodearray.push_back(node);
     }
 
-    for (unsigned int i = 0; i < grid->hcells; i++){
-        for (unsigned int c = 0; c < grid->vcells; c++){
-        if (i>0){
-            grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i-1)*grid->vcells+c]); //left
-            if (c>0)
-                grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i-1)*grid->vcells+c-1]); //top-left
-            if (c<grid->vcells-1)
-                grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i-1)*grid->vcells+c+1]); //bottom-left
-        }
-        if (c>0)
-            grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[i*grid->vcells+c-1]); //top
-        if (i<grid->hcells-1){
-            grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i+1)*grid->vcells+c]); //right
-            if (c>0)
-                grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i+1)*grid->vcells+c-1]); //top-right
-            if (c<grid->vcells-1)
-                grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[(i+1)*grid->vcells+c+1]); //bottom-bottom
-        }
-        if (c<grid->vcells-1)
-            grid->nodearray[i*grid->vcells+c].neighbor_nodes.push_back(&grid->nodearray[i*grid->vcells+c+1]); //bottom
-
-        }
-    }
+    grid->link_nodes();
+    grid->jump_points = sgrid->jump_points;
+    grid->cluster_size = sgrid->cluster_size;
+    grid->all_changed();
 }
 
 void mp_grid_clear_all(unsigned id, unsigned cost)
@@ -120,6 +137,7 @@ void mp_grid_clear_all(unsigned id, unsigned cost)
     for (vector<enigma::node>::iterator it = enigma::gridstructarray[id]->nodearray.begin(); it!=enigma::gridstructarray[id]->nodearray.end(); ++it)
         (*it).cost = cost;
     enigma::gridstructarray[id]->threshold = cost;
+    enigma::gridstructarray[id]->all_changed();
 }
 
 void mp_grid_add_rectangle(unsigned id,double x1,double y1,double x2,double y2, unsigned cost)
@@ -136,27 +154,64 @@ void mp_grid_add_rectangle(unsigned id,double x1,double y1,double x2,double y2,
             grid->nodearray[i*grid->vcells+c].cost = cost;
         }
     }
+    if (tx1<tx2 && ty1<ty2){grid->cells_changed(tx1,ty1,tx2-1,ty2-1);}
     if (cost>max_cost){max_cost=cost;}
-    if (grid->threshold<max_cost){grid->threshold=max_cost;}
+    if (grid->threshold<max_cost){grid->threshold=max_cost; grid->all_changed();}
     //std::cout << "mp_grid_add_rectangle(grid," << floor(x1/grid->cellwidth)*grid->cellwidth << "," << floor(y1/grid->cellheight)*grid->cellheight << "," << ceil(x2/grid->cellwidth)*grid->cellwidth << "," << ceil(y2/grid->cellheight)*grid->cellheight<< ");" << std::endl;
 }
 
+// Where collision_rectangle would put the edge of a cell: on the pixel its coordinate rounds to.
+static inline int cell_edge(cs_scalar v) { return v + .5; }
+
+// The cells, clamped to the grid, which may meet the pixels from lo to hi along one axis;
+// two spare cells either side cover the rounding of cell_edge.
+static inline void cell_span(int lo, int hi, double origin, unsigned size, unsigned cells, int &first, int &last)
+{
+    first = 0, last = int(cells) - 1;
+    if (!size) return;
+    first = max(first, int(floor((lo - origin)/size)) - 2);
+    last = min(last, int(floor((hi - origin)/size)) + 2);
+}
+
 void mp_grid_add_instances(unsigned id,int obj,bool prec,unsigned cost)
 {
     enigma::grid *grid = enigma::gridstructarray[id];
     unsigned max_cost=0;
     double x=grid->left, y=grid->top;
+    enigma::search_area changed;
+
+    // Visit each instance once, testing only the cells its bounding box spans, each as collision_rectangle would
+    vector<bool> hit(grid->hcells*grid->vcells);
+    for (enigma::iterator it = enigma::fetch_inst_iter_by_int(obj); it; ++it)
+    {
+        enigma::object_collisions *inst = (enigma::object_collisions*)*it;
+        if (inst->sprite_index == -1 && inst->mask_index == -1)
+            continue;
+        int left, right, top, bottom, i1, i2, c1, c2;
+        inst->$bbox_world(&left, &right, &top, &bottom);
+        cell_span(left, right, x, grid->cellwidth, grid->hcells, i1, i2);
+        cell_span(top, bottom, y, grid->cellheight, grid->vcells, c1, c2);
+        for (int i=i1; i<=i2; i++){
+            const int cx1 = cell_edge(x+i*grid->cellwidth), cx2 = cell_edge(x+(i+1)*grid->cellwidth);
+            for (int c=c1; c<=c2; c++){
+                if (!hit[i*grid->vcells+c] && enigma::rect_meeting_inst(inst,prec,cx1,cell_edge(y+c*grid->cellheight),cx2,cell_edge(y+(c+1)*grid->cellheight)))
+                    hit[i*grid->vcells+c] = true;
+            }
+        }
+    }
+
     for (unsigned int i=0; i<grid->hcells; i++){
         for (unsigned int c=0; c<grid->vcells; c++){
             if (grid->nodearray[i*grid->vcells+c].cost>max_cost){max_cost=grid->nodearray[i*grid->vcells+c].cost;}
-            //std::cout<<"collision_rectangle("<<i*grid->cellwidth<<","<<c*grid->cellheight<<","<<(i+1)*grid->cellwidth<<","<<(c+1)*grid->cellheight<<","<<obj<<","<<prec<<","<<false<<")"<<std::endl;
-            if (collision_rectangle(x+i*grid->cellwidth,y+c*grid->cellheight,x+(i+1)*grid->cellwidth,y+(c+1)*grid->cellheight,obj,prec,false)!=-4){
+            if (hit[i*grid->vcells+c]){
+                if (grid->nodearray[i*grid->vcells+c].cost != cost){changed.add(i,c);}
                 grid->nodearray[i*grid->vcells+c].cost = cost;
             }
         }
     }
+    if (changed.left<=changed.right){grid->cells_changed(changed.left,changed.top,changed.right,changed.bottom);}
     if (cost>max_cost){max_cost=cost;}
-    if (grid->threshold<max_cost){grid->threshold=max_cost;}
+    if (grid->threshold<max_cost){grid->threshold=max_cost; grid->all_changed();}
 }
 
 void mp_grid_reset_threshold(unsigned id)
@@ -165,7 +220,7 @@ void mp_grid_reset_threshold(unsigned id)
     unsigned max_cost=0;
     for (vector<enigma::node>::iterator it = grid->nodearray.begin(); it!=grid->nodearray.end(); ++it)
         if ((*it).cost>max_cost){max_cost=(*it).cost;}
-    grid->threshold=max_cost;
+    if (grid->threshold!=max_cost){grid->threshold=max_cost; grid->all_changed();}
 }
 
 void mp_grid_clear_rectangle(unsigned id,double x1,double y1,double x2,double y2, unsigned cost)
@@ -177,8 +232,14 @@ void mp_grid_add_cell(unsigned id,int h,int v, unsigned cost)
 {
     unsigned max_cost=enigma::gridstructarray[id]->nodearray[h*enigma::gridstructarray[id]->vcells+v].cost;
     enigma::gridstructarray[id]->nodearray[h*enigma::gridstructarray[id]->vcells+v].cost = cost;
+    if (cost!=max_cost){enigma::gridstructarray[id]->cells_changed(h,v,h,v);}
     if (cost>max_cost){max_cost=cost;}
-    if (enigma::gridstructarray[id]->threshold<max_cost){enigma::gridstructarray[id]->threshold=max_cost;}
+    if (enigma::gridstructarray[id]->threshold<max_cost){enigma::gridstructarray[id]->threshold=max_cost; enigma::gridstructarray[id]->all_changed();}
+}
+
+void mp_grid_clear_cell(unsigned id,int h,int v, unsigned cost)
+{
+    mp_grid_add_cell(id,h,v,cost);
 }
 
 unsigned mp_grid_get_cell(unsigned id,int h,int v)
@@ -194,6 +255,19 @@ unsigned mp_grid_get_threshold(unsigned id)
 void mp_grid_set_threshold(unsigned id, unsigned value)
 {
     enigma::gridstructarray[id]->threshold = value;
+    enigma::gridstructarray[id]->all_changed();
+}
+
+void mp_grid_set_jump_points(unsigned id, bool enable)
+{
+    enigma::gridstructarray[id]->jump_points = enable;
+    enigma::gridstructarray[id]->all_changed();
+}
+
+void mp_grid_set_hierarchy(unsigned id, unsigned cluster_size)
+{
+    enigma::gridstructarray[id]->cluster_size = cluster_size;
+    enigma::gridstructarray[id]->all_changed();
 }
 
 double mp_grid_get_speed_modifier(unsigned id)
@@ -219,30 +293,85 @@ bool mp_grid_path(unsigned id,unsigned pathid,double xstart,double ystart,double
     //if (xstart==xgoal && ystart==ygoal) return;
 
     bool status = true; //status to check if we can reach the destination
-    multimap<unsigned,enigma::node*> nodelist = enigma::find_path(id, &gr->nodearray[xs*vc+ys], &gr->nodearray[xg*vc+yg], allowdiag, status);
-    enigma::path *path = enigma::pathstructarray[pathid];
-    path->pointarray.clear();
+    vector<enigma::node*> nodelist = enigma::find_path(gr, &gr->nodearray[xs*vc+ys], &gr->nodearray[xg*vc+yg], allowdiag, status);
+    vector<unsigned> cells;
+    cells.reserve(nodelist.size());
+    for (vector<enigma::node*>::iterator it = nodelist.begin(); it != nodelist.end(); it++)
+        cells.push_back((*it)->x*vc+(*it)->y);
+    set_path_points(pathid, gr, gr->speed_modifier, xstart, ystart, xgoal, ygoal, xs*vc+ys, xg*vc+yg, cells, status);
+    return true;
+}
 
-    //push the very first point
-    enigma::path_point point(xstart,ystart,gr->speed_modifier/double(gr->nodearray[xs*vc+ys].cost));
-    path->pointarray.push_back(point);
-    multimap<unsigned,enigma::node*>::reverse_iterator it;
-    for (it=nodelist.rbegin(); it != nodelist.rend(); it++)
+}
+
+namespace enigma
+{
+    // A search run on the worker pool, against a snapshot of the grid as it was requested.
+    struct path_job: pool_job
     {
-            point = enigma::path_point(gr->left+((*it).second->x+0.5)*gr->cellwidth,gr->top+((*it).second->y+0.5)*gr->cellheight,gr->speed_modifier/double((*it).second->cost));
-            path->pointarray.push_back(point);
+        int handle;
+        unsigned pathid;
+        grid_snapshot *snap;
+        grid_mirror *mirror;
+        double speed_modifier, xstart, ystart, xgoal, ygoal;
+        unsigned xs, ys, xg, yg;
+        bool allow_diag, status;
+        vector<unsigned> cells;
+
+        void run(unsigned worker) {
+            status = mirror_find_path(mirror, worker, snap, xs, ys, xg, yg, allow_diag, cells);
+        }
+        void finish();
+    };
+
+    static std::set<int> pending_paths;
+    static int path_handles = 0;
+
+    void path_job::finish()
+    {
+        if (enigma_user::path_exists(pathid))
+            set_path_points(pathid, snap, speed_modifier, xstart, ystart, xgoal, ygoal, xs*snap->vcells+ys, xg*snap->vcells+yg, cells, status);
+        pending_paths.erase(handle);
+        snapshot_release(snap);
+        mirror_release(mirror);
     }
+}
 
-    //push the very last point if we can reach the destination
-    if (status == true){
-        point = enigma::path_point(xgoal,ygoal,gr->speed_modifier/double(gr->nodearray[xg*vc+yg].cost));
-        path->pointarray.push_back(point);
-    } else if (path->pointarray.size()==1) {
-        point = enigma::path_point(path->pointarray.back().x,path->pointarray.back().y,gr->speed_modifier/double(gr->nodearray[xg*vc+yg].cost));
-        path->pointarray.push_back(point);
+namespace enigma_user
+{
+
+int mp_grid_path_async(unsigned id,unsigned pathid,double xstart,double ystart,double xgoal,double ygoal,bool allowdiag)
+{
+    enigma::grid *gr = enigma::gridstructarray[id];
+    int xs = floor((xstart-gr->left)/int(gr->cellwidth)), ys = floor((ystart-gr->top)/int(gr->cellheight)),
+    xg = floor((xgoal-gr->left)/int(gr->cellwidth)), yg = floor((ygoal-gr->top)/int(gr->cellheight));
+    if (xs<0 or xg<0 or xs>int(gr->hcells)-1 or xg>int(gr->hcells)-1) return -1;
+    if (ys<0 or yg<0 or ys>int(gr->vcells)-1 or yg>int(gr->vcells)-1) return -1;
+
+    const int handle = enigma::path_handles++;
+    if (!enigma::thread_pool_size())
+    {   //no workers to be had, so search now and hand back a request that is already done
+        mp_grid_path(id, pathid, xstart, ystart, xgoal, ygoal, allowdiag);
+        return handle;
     }
-    enigma::path_recalculate(pathid);
-    return true;
+
+    enigma::path_job *job = new enigma::path_job;
+    job->handle = handle, job->pathid = pathid;
+    job->snap = enigma::snapshot_take(gr);
+    job->mirror = enigma::mirror_take(gr);
+    job->speed_modifier = gr->speed_modifier;
+    job->xstart = xstart, job->ystart = ystart, job->xgoal = xgoal, job->ygoal = ygoal;
+    job->xs = xs, job->ys = ys, job->xg = xg, job->yg = yg;
+    job->allow_diag = allowdiag;
+    enigma::pending_paths.insert(handle);
+    enigma::thread_pool_submit(job);
+    return handle;
+}
+
+int mp_grid_path_async_status(int handle)
+{
+    if (handle < 0 or handle >= enigma::path_handles) return -1;
+    return !enigma::pending_paths.count(handle);
 }
 
 }
@@ -34,6 +34,12 @@ unsigned mp_grid_get_cell(unsigned id,int h,int v);
 void mp_grid_draw(unsigned id, unsigned mode = 0, unsigned color_mode = 0);
 void mp_grid_draw_neighbours(unsigned int id, unsigned int h, unsigned int v, unsigned int mode = 0);
 bool mp_grid_path(unsigned id,unsigned path,double xstart,double ystart,double xgoal,double ygoal,bool allowdiag);
+// Finds the path on a worker thread, against the grid as it is now, returning a handle to poll
+// with mp_grid_path_async_status, or -1 if either end is off the grid. The path is filled in
+// at the start of a later step, and the status is 0 until then and 1 after; it is -1 for
+// handles never given out.
+int mp_grid_path_async(unsigned id,unsigned path,double xstart,double ystart,double xgoal,double ygoal,bool allowdiag);
+int mp_grid_path_async_status(int handle);
 void mp_grid_clear_all(unsigned id, unsigned cost = 1);
 void mp_grid_clear_cell(unsigned id,int h,int v, unsigned cost = 1);
 void mp_grid_clear_rectangle(unsigned id,double x1,double y1,double x2,double y2, unsigned cost = 1);
@@ -45,5 +51,10 @@ void mp_grid_set_threshold(unsigned id, unsigned threshold = 1);
 void mp_grid_reset_threshold(unsigned id);
 double mp_grid_get_speed_modifier(unsigned id);
 void mp_grid_set_speed_modifier(unsigned id, double value);
+// Pathing aids: jump point search, used while every open cell costs the same, and a
+// hierarchy of clusters of the given side, which trades a few percent of path length for
+// speed on large grids. Both are off by default; a cluster size of 0 turns it off.
+void mp_grid_set_jump_points(unsigned id, bool enable);
+void mp_grid_set_hierarchy(unsigned id, unsigned cluster_size = 16);
 }
 
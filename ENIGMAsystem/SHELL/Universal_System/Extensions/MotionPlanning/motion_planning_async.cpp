@@ -0,0 +1,139 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+
+// The grid side of asynchronous searches. A search requested on the game thread is given
+// the grid's cells as a snapshot; the worker running it searches its own copy of the grid,
+// which it brings up to date with the snapshot first. Copies are kept between searches,
+// so a worker repeats the work of building one, or its search aids, only where cells change.
+
+#include "motion_planning_struct.h"
+#include "Platforms/General/PFthreads.h"
+
+namespace enigma
+{
+  struct grid_mirror
+  {
+    vector<grid*> copies; // Indexed by worker, and each used only by its worker
+    vector<unsigned long> synced; // The serial of the snapshot each copy last matched
+    unsigned refs;
+  };
+
+  static unsigned long snapshot_serial = 0;
+
+  grid_snapshot* snapshot_take(grid* gr)
+  {
+    if (!gr->snapshot)
+    {
+      grid_snapshot *snap = new grid_snapshot;
+      snap->left = gr->left, snap->top = gr->top;
+      snap->hcells = gr->hcells, snap->vcells = gr->vcells;
+      snap->cellwidth = gr->cellwidth, snap->cellheight = gr->cellheight;
+      snap->threshold = gr->threshold;
+      snap->jump_points = gr->jump_points;
+      snap->cluster_size = gr->cluster_size;
+      snap->cost.reserve(gr->nodearray.size());
+      for (vector<node>::const_iterator it = gr->nodearray.begin(); it != gr->nodearray.end(); ++it)
+        snap->cost.push_back(it->cost);
+      snap->serial = ++snapshot_serial;
+      snap->refs = 1; // The grid's own
+      gr->snapshot = snap;
+    }
+    gr->snapshot->refs++;
+    return gr->snapshot;
+  }
+
+  grid_mirror* mirror_take(grid* gr)
+  {
+    if (!gr->mirror)
+    {
+      gr->mirror = new grid_mirror;
+      gr->mirror->copies.resize(thread_pool_size(), NULL);
+      gr->mirror->synced.resize(gr->mirror->copies.size(), 0);
+      gr->mirror->refs = 1;
+    }
+    gr->mirror->refs++;
+    return gr->mirror;
+  }
+
+  void snapshot_release(grid_snapshot* snap)
+  {
+    if (snap && !--snap->refs)
+      delete snap;
+  }
+
+  void mirror_release(grid_mirror* mirror)
+  {
+    if (mirror && !--mirror->refs)
+    {
+      for (size_t i = 0; i < mirror->copies.size(); i++)
+        delete mirror->copies[i];
+      delete mirror;
+    }
+  }
+
+  static grid* mirror_sync(grid_mirror* mirror, unsigned worker, const grid_snapshot* snap)
+  {
+    grid *&gr = mirror->copies[worker];
+    if (gr && mirror->synced[worker] == snap->serial)
+      return gr;
+    mirror->synced[worker] = snap->serial;
+
+    if (!gr || gr->hcells != snap->hcells || gr->vcells != snap->vcells)
+    {
+      delete gr;
+      return gr = new grid(*snap);
+    }
+
+    gr->left = snap->left, gr->top = snap->top;
+    gr->cellwidth = snap->cellwidth, gr->cellheight = snap->cellheight;
+    if (gr->threshold != snap->threshold || gr->jump_points != snap->jump_points || gr->cluster_size != snap->cluster_size)
+    {
+      gr->threshold = snap->threshold;
+      gr->jump_points = snap->jump_points;
+      gr->cluster_size = snap->cluster_size;
+      for (size_t i = 0; i < gr->nodearray.size(); i++)
+        gr->nodearray[i].cost = snap->cost[i];
+      gr->all_changed();
+      return gr;
+    }
+
+    search_area changed;
+    for (size_t i = 0; i < gr->nodearray.size(); i++)
+      if (gr->nodearray[i].cost != snap->cost[i])
+      {
+        gr->nodearray[i].cost = snap->cost[i];
+        changed.add(gr->nodearray[i].x, gr->nodearray[i].y);
+      }
+    if (changed.left <= changed.right)
+      gr->cells_changed(changed.left, changed.top, changed.right, changed.bottom);
+    return gr;
+  }
+
+  bool mirror_find_path(grid_mirror* mirror, unsigned worker, const grid_snapshot* snap, unsigned xs, unsigned ys,
+                        unsigned xg, unsigned yg, bool allow_diag, vector<unsigned> &cells)
+  {
+    grid *gr = mirror_sync(mirror, worker, snap);
+    bool status = true;
+    const vector<node*> path = find_path(gr, gr->at(xs, ys), gr->at(xg, yg), allow_diag, status);
+    cells.clear();
+    cells.reserve(path.size());
+    for (vector<node*>::const_iterator it = path.begin(); it != path.end(); ++it)
+      cells.push_back((*it)->x*gr->vcells + (*it)->y);
+    return status;
+  }
+}
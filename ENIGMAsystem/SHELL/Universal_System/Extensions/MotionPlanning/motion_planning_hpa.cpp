@@ -0,0 +1,330 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+
+// Hierarchical pathfinding: the grid is cut into square clusters, and the cells through
+// which paths can cross from one cluster to the next are linked by the cost of the best
+// path between them within their cluster. Searching that much smaller graph, then filling
+// in each leg, gives paths within a few percent of the best. Changing costs only rebuilds
+// the clusters around the change.
+
+#include "motion_planning_struct.h"
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace enigma
+{
+  static const unsigned unreachable = ~0u;
+
+  // A cell on a cluster's edge through which paths may leave it.
+  struct hpa_entrance
+  {
+    node* cell;
+    node* across[2]; // The cells it leads to in the neighboring clusters; a corner may have two
+    unsigned acrossc;
+  };
+
+  struct hpa_cluster
+  {
+    unsigned left, top, right, bottom; // Inclusive
+    bool dirty;
+    vector<hpa_entrance> entrances;
+    vector<unsigned> costs; // costs[i*n + j] is the cost of the best path from entrance i to j within the cluster
+
+    int find(const node* n) const {
+      for (size_t i = 0; i < entrances.size(); i++)
+        if (entrances[i].cell == n) return i;
+      return -1;
+    }
+    void add_entrance(node* cell, node* across) {
+      const int i = find(cell);
+      if (i >= 0) { entrances[i].across[entrances[i].acrossc++] = across; return; }
+      hpa_entrance e = { cell, { across, NULL }, 1 };
+      entrances.push_back(e);
+    }
+  };
+
+  struct hpa_graph
+  {
+    grid* gr;
+    bool allow_diag;
+    unsigned size, ch, cv; // Cluster side, then clusters across and down
+    bool dirty;
+    vector<hpa_cluster> clusters;
+
+    hpa_cluster &cluster_of(const node* n) { return clusters[(n->x/size)*cv + n->y/size]; }
+    void refresh();
+
+    hpa_graph(grid* g, bool diag);
+  };
+
+  // Dijkstra's algorithm from one cell, confined to a cluster. Run in reverse, it finds
+  // the cost of reaching the source from each cell instead.
+  struct local_search
+  {
+    grid* gr;
+    bool allow_diag;
+    unsigned left, top, w, h;
+    vector<unsigned> dist;
+    vector<unsigned> prev;
+    vector<std::pair<unsigned, unsigned> > heap; // Distance and cell, least on top
+
+    bool inside(const node* n) const { return n->x - left < w && n->y - top < h; }
+    unsigned index(const node* n) const { return (n->x - left)*h + (n->y - top); }
+    node* cell(unsigned i) { return gr->at(left + i/h, top + i%h); }
+    unsigned distance(const node* n) const { return inside(n) ? dist[index(n)] : unreachable; }
+
+    void run(node* source, bool reverse = false, const node* stop = NULL)
+    {
+      dist.assign(w*h, unreachable);
+      prev.assign(w*h, unreachable);
+      heap.clear();
+      dist[index(source)] = 0;
+      heap.push_back(std::make_pair(0u, index(source)));
+      while (!heap.empty())
+      {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<unsigned, unsigned> >());
+        const unsigned d = heap.back().first, i = heap.back().second;
+        heap.pop_back();
+        if (d != dist[i])
+          continue;
+        node* const n = cell(i);
+        if (n == stop)
+          break;
+        for (vector<node*>::iterator it = n->neighbor_nodes.begin(); it != n->neighbor_nodes.end(); ++it)
+        {
+          node* const nb = *it;
+          const bool diagonal = nb->x != n->x && nb->y != n->y;
+          if (!inside(nb) || nb->cost >= gr->threshold || (diagonal && (!allow_diag || cuts_corner(gr, n, nb))))
+            continue;
+          const unsigned nd = d + (reverse ? move_cost(nb, n) : move_cost(n, nb)), j = index(nb);
+          if (nd < dist[j])
+          {
+            dist[j] = nd, prev[j] = i;
+            heap.push_back(std::make_pair(nd, j));
+            std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<unsigned, unsigned> >());
+          }
+        }
+      }
+    }
+
+    // Appends the cells after the source of a forward run, up to and including `to'.
+    void trace(const node* to, vector<node*> &path)
+    {
+      const size_t at = path.size();
+      for (unsigned i = index(to); prev[i] != unreachable; i = prev[i])
+        path.push_back(cell(i));
+      std::reverse(path.begin() + at, path.end());
+    }
+
+    local_search(grid* g, bool diag, const hpa_cluster &c):
+      gr(g), allow_diag(diag), left(c.left), top(c.top), w(c.right - c.left + 1), h(c.bottom - c.top + 1) {}
+  };
+
+  hpa_graph::hpa_graph(grid* g, bool diag): gr(g), allow_diag(diag), size(g->cluster_size),
+    ch((g->hcells + size - 1)/size), cv((g->vcells + size - 1)/size), dirty(true), clusters(ch*cv)
+  {
+    for (unsigned cx = 0; cx < ch; cx++)
+      for (unsigned cy = 0; cy < cv; cy++)
+      {
+        hpa_cluster &c = clusters[cx*cv + cy];
+        c.left = cx*size, c.right = std::min(c.left + size, gr->hcells) - 1;
+        c.top = cy*size, c.bottom = std::min(c.top + size, gr->vcells) - 1;
+        c.dirty = true;
+      }
+  }
+
+  // Adds entrances to `c' along one of its edges. (x,y) walks the edge by (dx,dy), and
+  // (ax,ay) is the offset to the neighboring cluster. Each stretch of the edge open on
+  // both sides gets an entrance in its middle, or one at each end if it is long. Both
+  // clusters sharing an edge pick the same places.
+  static void add_edge_entrances(grid* gr, hpa_cluster &c, unsigned x, unsigned y, int dx, int dy, unsigned len, int ax, int ay)
+  {
+    unsigned run = 0;
+    for (unsigned i = 0; i <= len; i++)
+    {
+      const unsigned cx = x + i*dx, cy = y + i*dy;
+      if (i < len && gr->open(cx, cy) && gr->open(cx + ax, cy + ay)) {
+        run++;
+        continue;
+      }
+      if (!run)
+        continue;
+      const unsigned first = i - run, last = i - 1;
+      if (run < 6) {
+        const unsigned mid = (first + last) / 2;
+        c.add_entrance(gr->at(x + mid*dx, y + mid*dy), gr->at(x + mid*dx + ax, y + mid*dy + ay));
+      } else {
+        c.add_entrance(gr->at(x + first*dx, y + first*dy), gr->at(x + first*dx + ax, y + first*dy + ay));
+        c.add_entrance(gr->at(x + last*dx, y + last*dy), gr->at(x + last*dx + ax, y + last*dy + ay));
+      }
+      run = 0;
+    }
+  }
+
+  void hpa_graph::refresh()
+  {
+    if (!dirty)
+      return;
+    for (vector<hpa_cluster>::iterator c = clusters.begin(); c != clusters.end(); ++c)
+    {
+      if (!c->dirty)
+        continue;
+      const unsigned w = c->right - c->left + 1, h = c->bottom - c->top + 1;
+      c->entrances.clear();
+      if (c->left > 0)            add_edge_entrances(gr, *c, c->left,  c->top,    0, 1, h, -1,  0);
+      if (c->right < gr->hcells-1) add_edge_entrances(gr, *c, c->right, c->top,    0, 1, h,  1,  0);
+      if (c->top > 0)             add_edge_entrances(gr, *c, c->left,  c->top,    1, 0, w,  0, -1);
+      if (c->bottom < gr->vcells-1) add_edge_entrances(gr, *c, c->left,  c->bottom, 1, 0, w,  0,  1);
+
+      const size_t n = c->entrances.size();
+      c->costs.resize(n*n);
+      local_search ls(gr, allow_diag, *c);
+      for (size_t i = 0; i < n; i++)
+      {
+        ls.run(c->entrances[i].cell);
+        for (size_t j = 0; j < n; j++)
+          c->costs[i*n + j] = ls.distance(c->entrances[j].cell);
+      }
+      c->dirty = false;
+    }
+    dirty = false;
+  }
+
+  void hpa_cells_changed(hpa_graph* hpa, unsigned x1, unsigned y1, unsigned x2, unsigned y2)
+  {
+    // A change on a cluster's edge moves its neighbor's entrances, too
+    x1 = x1 ? x1 - 1 : 0, y1 = y1 ? y1 - 1 : 0;
+    x2 = std::min(x2 + 1, hpa->gr->hcells - 1), y2 = std::min(y2 + 1, hpa->gr->vcells - 1);
+    for (unsigned cx = x1/hpa->size; cx <= x2/hpa->size; cx++)
+      for (unsigned cy = y1/hpa->size; cy <= y2/hpa->size; cy++)
+        hpa->clusters[cx*hpa->cv + cy].dirty = true;
+    hpa->dirty = true;
+  }
+
+  void hpa_destroy(hpa_graph* hpa) {
+    delete hpa;
+  }
+
+  static inline void add_cluster(search_area &area, const hpa_cluster &c) {
+    area.add(c.left, c.top);
+    area.add(c.right, c.bottom);
+  }
+
+  bool hpa_path(grid* gr, node* start, node* goal, bool allow_diag, vector<node*> &path, search_area &area)
+  {
+    if (goal->cost >= gr->threshold)
+      return false;
+    hpa_graph* &g = gr->hpa[allow_diag];
+    if (!g)
+      g = new hpa_graph(gr, allow_diag);
+    g->refresh();
+
+    hpa_cluster &sc = g->cluster_of(start), &gc = g->cluster_of(goal);
+    local_search from(gr, allow_diag, sc), to(gr, allow_diag, gc);
+    from.run(start);
+    to.run(goal, true);
+    add_cluster(area, sc);
+    add_cluster(area, gc);
+
+    // A* over the entrances, starting at the start and ending at the goal
+    const unsigned search = begin_search(gr);
+    vector<open_entry> OPEN;
+    vector<std::pair<node*, unsigned> > steps;
+    unsigned opened = 0;
+    start->G = 0;
+    start->H = find_heuristic(start, goal, allow_diag);
+    start->F = start->H;
+    start->came_from = NULL;
+    start->opened = search;
+    OPEN.push_back(open_entry(start->F, opened++, start));
+
+    while (!OPEN.empty())
+    {
+      std::pop_heap(OPEN.begin(), OPEN.end());
+      node* current = OPEN.back().n;
+      const unsigned F = OPEN.back().F;
+      OPEN.pop_back();
+      if (current->closed == search || F != current->F)
+        continue;
+      current->closed = search;
+      if (current == goal)
+        break;
+
+      const hpa_cluster &c = g->cluster_of(current);
+      add_cluster(area, c);
+      const int e = c.find(current);
+      const size_t n = c.entrances.size();
+
+      // Gather the steps out of this cell, then relax them all the same way
+      steps.clear();
+      if (current == start || e >= 0)
+        for (size_t j = 0; j < n; j++)
+          steps.push_back(std::make_pair(c.entrances[j].cell, current == start ? from.distance(c.entrances[j].cell) : c.costs[e*n + j]));
+      if (e >= 0)
+        for (unsigned a = 0; a < c.entrances[e].acrossc; a++)
+          steps.push_back(std::make_pair(c.entrances[e].across[a], move_cost(current, c.entrances[e].across[a])));
+      if (&c == &gc)
+        steps.push_back(std::make_pair(goal, to.distance(current)));
+
+      for (size_t i = 0; i < steps.size(); i++)
+      {
+        node* const nb = steps[i].first;
+        if (steps[i].second == unreachable || nb->closed == search)
+          continue;
+        const unsigned G = current->G + steps[i].second;
+        if (nb->opened == search && G >= nb->G)
+          continue;
+        if (nb->opened != search) {
+          nb->opened = search;
+          nb->H = find_heuristic(nb, goal, allow_diag);
+        }
+        nb->came_from = current;
+        nb->G = G;
+        nb->F = G + nb->H;
+        OPEN.push_back(open_entry(nb->F, opened++, nb));
+        std::push_heap(OPEN.begin(), OPEN.end());
+      }
+    }
+
+    if (goal->closed != search)
+      return false;
+
+    // Fill in each leg: a step across an edge, or a path within one cluster
+    vector<node*> legs;
+    for (node* n = goal; n; n = n->came_from)
+      legs.push_back(n);
+    path.clear();
+    for (size_t i = legs.size() - 1; i > 0; i--)
+    {
+      node *a = legs[i], *b = legs[i - 1];
+      hpa_cluster &ca = g->cluster_of(a);
+      if (&ca != &g->cluster_of(b))
+        path.push_back(b);
+      else if (a == start)
+        from.trace(b, path);
+      else {
+        local_search ls(gr, allow_diag, ca);
+        ls.run(a, false, b);
+        ls.trace(b, path);
+      }
+    }
+    path.pop_back(); // The goal
+    return true;
+  }
+}
@@ -0,0 +1,306 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+
+// Jump point search: A* over uniform-cost grids which, instead of opening every neighbor,
+// runs straight and diagonal lines until something forces a turn, and opens only the
+// cell found there. Diagonal steps never cut a blocked corner, as in find_path.
+
+#include "motion_planning_struct.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdint.h>
+
+namespace enigma
+{
+  // Which cells are open, one bit each, by row and again by column, so runs can be
+  // scanned 64 cells at a time. Each line has at least one spare bit, always clear.
+  struct jps_map
+  {
+    grid* gr;
+    unsigned row_words, col_words;
+    vector<uint64_t> rows, cols, zeros;
+
+    const uint64_t *row(int y) const { return unsigned(y) < gr->vcells ? &rows[y*row_words] : &zeros[0]; }
+    const uint64_t *col(int x) const { return unsigned(x) < gr->hcells ? &cols[x*col_words] : &zeros[0]; }
+
+    void update(unsigned x1, unsigned y1, unsigned x2, unsigned y2)
+    {
+      for (unsigned x = x1; x <= x2; x++)
+        for (unsigned y = y1; y <= y2; y++)
+        {
+          uint64_t &r = rows[y*row_words + x/64], &c = cols[x*col_words + y/64];
+          const uint64_t rb = uint64_t(1) << (x & 63), cb = uint64_t(1) << (y & 63);
+          if (gr->open(x, y)) r |= rb, c |= cb;
+          else r &= ~rb, c &= ~cb;
+        }
+    }
+
+    jps_map(grid* g): gr(g), row_words(g->hcells/64 + 1), col_words(g->vcells/64 + 1),
+      rows(row_words*g->vcells), cols(col_words*g->hcells), zeros(std::max(row_words, col_words))
+    {
+      if (g->hcells && g->vcells)
+        update(0, 0, g->hcells - 1, g->vcells - 1);
+    }
+  };
+
+  void jps_cells_changed(jps_map* jps, unsigned x1, unsigned y1, unsigned x2, unsigned y2) {
+    jps->update(x1, y1, x2, y2);
+  }
+
+  void jps_destroy(jps_map* jps) {
+    delete jps;
+  }
+
+  namespace
+  {
+    inline int lowest_bit(uint64_t x) {
+      #ifdef __GNUC__
+        return __builtin_ctzll(x);
+      #else
+        int i = 0;
+        while (!(x & 1)) x >>= 1, i++;
+        return i;
+      #endif
+    }
+    inline int highest_bit(uint64_t x) {
+      #ifdef __GNUC__
+        return 63 - __builtin_clzll(x);
+      #else
+        int i = 63;
+        while (!(x >> 63)) x <<= 1, i--;
+        return i;
+      #endif
+    }
+
+    // Scans a line of cells from position p in direction dir (1 or -1), given the bits of
+    // the line and of the lines to either side, each n words long. Stops at the first cell
+    // beside an open cell whose predecessor along its line is closed, which is what makes
+    // a neighbor forced, or at the goal, at position goal or -1 if it is not on the line.
+    // Returns that position, with found set; otherwise found is clear and the position is
+    // that of the closed cell which came first, or -1 past the start of the line.
+    int scan(const uint64_t *cur, const uint64_t *s1, const uint64_t *s2, int n, int p, int dir, int goal, bool &found)
+    {
+      if (dir > 0)
+      {
+        for (int w = p >> 6;; w++)
+        {
+          uint64_t stop = (s1[w] & ~((s1[w] << 1) | (w ? s1[w-1] >> 63 : 0)))
+                        | (s2[w] & ~((s2[w] << 1) | (w ? s2[w-1] >> 63 : 0)));
+          uint64_t blocked = ~cur[w];
+          if (w == p >> 6) {
+            const uint64_t from = ~uint64_t(0) << (p & 63);
+            stop &= from, blocked &= from;
+          }
+          if (goal >= p && goal >> 6 == w)
+            stop |= uint64_t(1) << (goal & 63);
+          if (stop | blocked)
+          {
+            const int b = blocked ? lowest_bit(blocked) : 64, s = stop ? lowest_bit(stop) : 64;
+            found = s < b;
+            return w*64 + (found ? s : b);
+          }
+        }
+      }
+      for (int w = p >> 6; w >= 0; w--)
+      {
+        uint64_t stop = (s1[w] & ~((s1[w] >> 1) | (w + 1 < n ? s1[w+1] << 63 : 0)))
+                      | (s2[w] & ~((s2[w] >> 1) | (w + 1 < n ? s2[w+1] << 63 : 0)));
+        uint64_t blocked = ~cur[w];
+        if (w == p >> 6) {
+          const uint64_t to = (p & 63) == 63 ? ~uint64_t(0) : (uint64_t(2) << (p & 63)) - 1;
+          stop &= to, blocked &= to;
+        }
+        if (goal >= 0 && goal <= p && goal >> 6 == w)
+          stop |= uint64_t(1) << (goal & 63);
+        if (stop | blocked)
+        {
+          const int b = blocked ? highest_bit(blocked) : -1, s = stop ? highest_bit(stop) : -1;
+          found = s > b;
+          return w*64 + (found ? s : b);
+        }
+      }
+      found = false;
+      return -1;
+    }
+
+    struct jumper
+    {
+      grid* gr;
+      const jps_map* map;
+      node* goal;
+      bool allow_diag;
+      search_area &area;
+
+      // Cells off the grid read as blocked; negative coordinates wrap to huge ones.
+      bool open(int x, int y) const { return gr->open(x, y); }
+
+      // Runs from (x,y), reached by stepping (dx,dy) with one of them zero, to the next
+      // cell with a forced neighbor, or the goal. Returns NULL on reaching a wall.
+      node* straight(int x, int y, int dx, int dy)
+      {
+        if (!open(x, y))
+          return NULL;
+        bool found;
+        if (dx) {
+          const int end = scan(map->row(y), map->row(y - 1), map->row(y + 1), map->row_words, x, dx, int(goal->y) == y ? int(goal->x) : -1, found);
+          area.add(x, y), area.add(std::max(end, 0), y);
+          return found ? gr->at(end, y) : NULL;
+        }
+        if (allow_diag) {
+          const int end = scan(map->col(x), map->col(x - 1), map->col(x + 1), map->col_words, y, dy, int(goal->x) == x ? int(goal->y) : -1, found);
+          area.add(x, y), area.add(x, std::max(end, 0));
+          return found ? gr->at(x, end) : NULL;
+        }
+        // Without diagonals, a vertical run must also stop wherever a horizontal one would find something
+        for (;; y += dy)
+        {
+          if (!open(x, y))
+            return NULL;
+          area.add(x, y);
+          node* n = gr->at(x, y);
+          if (n == goal || (open(x - 1, y) && !open(x - 1, y - dy)) || (open(x + 1, y) && !open(x + 1, y - dy)))
+            return n;
+          if (straight(x + 1, y, 1, 0) || straight(x - 1, y, -1, 0))
+            return n;
+        }
+      }
+
+      node* jump(int x, int y, int dx, int dy)
+      {
+        if (!dx || !dy)
+          return straight(x, y, dx, dy);
+        for (;; x += dx, y += dy)
+        {
+          if (!open(x, y))
+            return NULL;
+          area.add(x, y);
+          node* n = gr->at(x, y);
+          if (n == goal || straight(x + dx, y, dx, 0) || straight(x, y + dy, 0, dy))
+            return n;
+          if (!open(x + dx, y) || !open(x, y + dy))
+            return NULL;
+        }
+      }
+
+      jumper(grid* g, node* n1, bool diag, search_area &a): gr(g), map(g->jps), goal(n1), allow_diag(diag), area(a) {}
+    };
+
+    inline int sign(int x) { return (x > 0) - (x < 0); }
+  }
+
+  bool jps_path(grid* gr, node* start, node* destination, bool allow_diag, vector<node*> &path, search_area &area)
+  {
+    const unsigned search = begin_search(gr), cost = gr->uniform_cost;
+    if (!gr->jps)
+      gr->jps = new jps_map(gr);
+    jumper j(gr, destination, allow_diag, area);
+    vector<open_entry> OPEN;
+    unsigned opened = 0;
+
+    start->G = 0;
+    start->H = find_heuristic(start, destination, allow_diag) * cost;
+    start->F = start->H;
+    start->came_from = NULL;
+    start->opened = search;
+    area.add(start->x, start->y);
+    OPEN.push_back(open_entry(start->F, opened++, start));
+
+    while (!OPEN.empty())
+    {
+      std::pop_heap(OPEN.begin(), OPEN.end());
+      node* current = OPEN.back().n;
+      const unsigned F = OPEN.back().F;
+      OPEN.pop_back();
+      if (current->closed == search || F != current->F)
+        continue;
+      current->closed = search;
+      if (current == destination)
+        break;
+
+      // The directions worth trying from here, given the direction we arrived from
+      const int x = current->x, y = current->y;
+      int dirs[8][2], dirc = 0;
+      #define try_dir(ddx, ddy) (dirs[dirc][0] = (ddx), dirs[dirc++][1] = (ddy))
+      if (!current->came_from) {
+        for (int ddx = -1; ddx <= 1; ddx++)
+          for (int ddy = -1; ddy <= 1; ddy++)
+            if ((ddx || ddy) && ((!ddx || !ddy) || (allow_diag && j.open(x + ddx, y) && j.open(x, y + ddy))))
+              try_dir(ddx, ddy);
+      } else {
+        const int dx = sign(x - int(current->came_from->x)), dy = sign(y - int(current->came_from->y));
+        if (dx && dy) {
+          const bool v = j.open(x, y + dy), h = j.open(x + dx, y);
+          if (v) try_dir(0, dy);
+          if (h) try_dir(dx, 0);
+          if (v && h) try_dir(dx, dy);
+        } else if (allow_diag) {
+          const int px = dy, py = dx; // Perpendicular to the run, either way
+          const bool next = j.open(x + dx, y + dy), side1 = j.open(x + px, y + py), side2 = j.open(x - px, y - py);
+          if (next) {
+            try_dir(dx, dy);
+            if (side1) try_dir(dx + px, dy + py);
+            if (side2) try_dir(dx - px, dy - py);
+          }
+          if (side1) try_dir(px, py);
+          if (side2) try_dir(-px, -py);
+        } else {
+          try_dir(dx, dy);
+          try_dir(dy, dx);
+          try_dir(-dy, -dx);
+        }
+      }
+      #undef try_dir
+
+      for (int i = 0; i < dirc; i++)
+      {
+        node* const jp = j.jump(x + dirs[i][0], y + dirs[i][1], dirs[i][0], dirs[i][1]);
+        if (!jp || jp->closed == search)
+          continue;
+        const unsigned steps = std::max(abs(int(jp->x) - x), abs(int(jp->y) - y));
+        const unsigned G = current->G + steps * move_cost(current, gr->at(x + dirs[i][0], y + dirs[i][1]));
+        if (jp->opened == search && G >= jp->G)
+          continue;
+        if (jp->opened != search) {
+          jp->opened = search;
+          jp->H = find_heuristic(jp, destination, allow_diag) * cost;
+        }
+        jp->came_from = current;
+        jp->G = G;
+        jp->F = G + jp->H;
+        OPEN.push_back(open_entry(jp->F, opened++, jp));
+        std::push_heap(OPEN.begin(), OPEN.end());
+      }
+    }
+
+    if (destination->closed != search)
+      return false;
+
+    // Fill in the cells along each jump, from the goal back to the start
+    path.clear();
+    for (node* to = destination; to != start; to = to->came_from)
+    {
+      const node* from = to->came_from;
+      const int dx = sign(int(to->x) - int(from->x)), dy = sign(int(to->y) - int(from->y));
+      for (int cx = to->x, cy = to->y; cx != int(from->x) || cy != int(from->y); cx -= dx, cy -= dy)
+        if (to != destination || cx != int(to->x) || cy != int(to->y))
+          path.push_back(gr->at(cx, cy));
+    }
+    std::reverse(path.begin(), path.end());
+    return true;
+  }
+}
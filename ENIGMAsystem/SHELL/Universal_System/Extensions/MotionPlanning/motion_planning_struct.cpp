@@ -34,8 +34,6 @@
 #include <algorithm>
 #include <cstdlib>
 //#include <iostream>
-using std::multimap;
-using std::pair;
 using std::list;
 
 namespace enigma
@@ -46,18 +44,82 @@ namespace enigma
 
 namespace enigma
 {
+    // The most recent paths found on a grid, most recently used first. An entry is dropped
+    // when costs change anywhere near the area its search looked at, so a hit always gives
+    // what searching again would.
+    struct path_cache
+    {
+        struct entry
+        {
+            node *start, *goal;
+            bool allow_diag, status;
+            search_area area;
+            vector<node*> path;
+        };
+        static const size_t capacity = 64;
+        list<entry> entries;
+
+        bool find(node* start, node* goal, bool allow_diag, vector<node*> &path, bool &status)
+        {
+            for (list<entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+                if (it->start == start && it->goal == goal && it->allow_diag == allow_diag)
+                {
+                    entries.splice(entries.begin(), entries, it);
+                    path = it->path, status = it->status;
+                    return true;
+                }
+            return false;
+        }
+        void store(node* start, node* goal, bool allow_diag, const vector<node*> &path, bool status, const search_area &area)
+        {
+            if (entries.size() >= capacity)
+                entries.pop_back();
+            entries.push_front(entry());
+            entry &e = entries.front();
+            e.start = start, e.goal = goal, e.allow_diag = allow_diag;
+            e.status = status, e.area = area, e.path = path;
+        }
+        void invalidate(unsigned x1, unsigned y1, unsigned x2, unsigned y2)
+        {
+            for (list<entry>::iterator it = entries.begin(); it != entries.end(); )
+                if (it->area.touches(x1, y1, x2, y2))
+                    it = entries.erase(it);
+                else ++it;
+        }
+    };
+
     grid::grid(unsigned int idp,int leftp,int topp,unsigned int hcellsp,unsigned int vcellsp,unsigned int cellwidthp,unsigned int cellheightp,unsigned thresholdp,double speed_modifierp):
-        id(idp), left(leftp), top(topp), hcells(hcellsp), vcells(vcellsp), cellwidth(cellwidthp), cellheight(cellheightp), threshold(thresholdp), speed_modifier(speed_modifierp), nodearray()
+        id(idp), left(leftp), top(topp), hcells(hcellsp), vcells(vcellsp), cellwidth(cellwidthp), cellheight(cellheightp), threshold(thresholdp), speed_modifier(speed_modifierp), nodearray(), search(0),
+        jump_points(false), uniform_cost(-1), jps(NULL), cluster_size(0), cache(new path_cache), listed(true), snapshot(NULL), mirror(NULL)
     {
         gridstructarray[id] = this;
-        gridstructarray[id]->nodearray.reserve(hcells*vcells);
+        hpa[0] = hpa[1] = NULL;
+        nodearray.reserve(hcells*vcells);
         for (unsigned int i = 0; i < hcells*vcells; i++)
         {
             node nnode(floor(i / vcells),i % vcells,0,0,0,1);
-            gridstructarray[id]->nodearray.push_back(nnode);
+            nodearray.push_back(nnode);
         }
+        link_nodes();
+
+        if (enigma::grid_idmax < id+1)
+          enigma::grid_idmax = id+1;
+    }
 
-        grid *gr = gridstructarray[id];
+    grid::grid(const grid_snapshot &snap):
+        id(~0u), left(snap.left), top(snap.top), hcells(snap.hcells), vcells(snap.vcells), cellwidth(snap.cellwidth), cellheight(snap.cellheight), threshold(snap.threshold), speed_modifier(1), nodearray(), search(0),
+        jump_points(snap.jump_points), uniform_cost(-1), jps(NULL), cluster_size(snap.cluster_size), cache(new path_cache), listed(false), snapshot(NULL), mirror(NULL)
+    {
+        hpa[0] = hpa[1] = NULL;
+        nodearray.reserve(hcells*vcells);
+        for (unsigned int i = 0; i < hcells*vcells; i++)
+            nodearray.push_back(node(i / vcells,i % vcells,0,0,0,snap.cost[i]));
+        link_nodes();
+    }
+
+    void grid::link_nodes()
+    {
+        grid *gr = this;
 
         for (unsigned int i = 0; i < hcells; i++){
             for (unsigned int c = 0; c < vcells; c++){
@@ -82,11 +144,21 @@ namespace enigma
 
             }
         }
+    }
 
-        if (enigma::grid_idmax < id+1)
-          enigma::grid_idmax = id+1;
+    grid::~grid()
+    {
+        if (listed)
+        {
+            gridstructarray[id] = NULL;
+            snapshot_release(snapshot);
+            mirror_release(mirror);
+        }
+        jps_destroy(jps);
+        hpa_destroy(hpa[0]);
+        hpa_destroy(hpa[1]);
+        delete cache;
     }
-    grid::~grid() { gridstructarray[id] = NULL; }
 
     void gridstructarray_reallocate()
     {
@@ -95,155 +167,182 @@ namespace enigma
         for (size_t i = 0; i < enigma::grid_idmax; i++) gridstructarray[i] = gridold[i]; delete[] gridold;
     }
 
-    //Helper functions
-    static inline unsigned find_heuristic(const node* n0, const node* n1, bool allow_diag) //Distance from n0 to n1
+    void grid::cells_changed(unsigned x1, unsigned y1, unsigned x2, unsigned y2)
     {
-        if (!allow_diag){
-            //std::cout << "Straight " << " H = " << fabs((int)n0->x-(int)n1->x) + fabs((int)n0->y-(int)n1->y) << std::endl;
-            return fabs((int)n0->x-(int)n1->x) + fabs((int)n0->y-(int)n1->y);
-        } else {
-            //std::cout << "Diagn " << " H = " << fmax(fabs((int)n0->x-(int)n1->x) , fabs((int)n0->y-(int)n1->y)) << std::endl;
-            return fmax(fabs((int)n0->x-(int)n1->x) , fabs((int)n0->y-(int)n1->y));
+        snapshot_release(snapshot), snapshot = NULL;
+        cache->invalidate(x1, y1, x2, y2);
+        if (uniform_cost > 0)
+        {   //the grid is still uniform if every open cell changed costs the same as the rest
+            for (unsigned x = x1; x <= x2 && uniform_cost > 0; x++)
+                for (unsigned y = y1; y <= y2; y++)
+                    if (open(x, y) && nodearray[x*vcells + y].cost != unsigned(uniform_cost)) {
+                        uniform_cost = -1;
+                        break;
+                    }
         }
+        else uniform_cost = -1;
+        if (jps)
+            jps_cells_changed(jps, x1, y1, x2, y2);
+        for (int i = 0; i < 2; i++)
+            if (hpa[i])
+                hpa_cells_changed(hpa[i], x1, y1, x2, y2);
     }
 
-    static inline int find_priority(multimap<unsigned,node*> &m, node* value){
-        multimap<unsigned,node*>::iterator it;
-        for (it = m.begin(); it != m.end(); it++)
-            if (it->second == value) return (int)it->first;
-        return -1;
+    void grid::all_changed()
+    {
+        snapshot_release(snapshot), snapshot = NULL;
+        cache->entries.clear();
+        uniform_cost = -1;
+        jps_destroy(jps), jps = NULL;
+        for (int i = 0; i < 2; i++)
+            hpa_destroy(hpa[i]), hpa[i] = NULL;
     }
 
-    static inline bool check_corners(unsigned id, node* n0, node* n1) //There must be a better way to do this
+    //Helper functions
+    unsigned begin_search(grid* gr)
     {
-        //std::cout << "Searching..." << std::endl;
-        for (vector<enigma::node*>::iterator it0 = n0->neighbor_nodes.begin(); it0!=n0->neighbor_nodes.end(); ++it0)
-        {
-            for (vector<enigma::node*>::iterator it1 = n1->neighbor_nodes.begin(); it1!=n1->neighbor_nodes.end(); ++it1)
-            {
-               // std::cout << (*it0) << " == " << (*it1) << " && it0.cost=" << (*it0)->cost << std::endl;
-                if ((*it0)==(*it1) && (*it0)->cost >= gridstructarray[id]->threshold)
-                return true;
-            }
+        if (++gr->search == 0)
+        {   //the counter wrapped, so stamps from long ago could be mistaken for this search
+            for (vector<node>::iterator it = gr->nodearray.begin(); it != gr->nodearray.end(); ++it)
+                it->opened = it->closed = 0;
+            gr->search = 1;
         }
-        return false;
+        return gr->search;
+    }
+
+    unsigned find_heuristic(const node* n0, const node* n1, bool allow_diag) //Distance from n0 to n1
+    {
+        const unsigned dx = abs(int(n0->x) - int(n1->x)), dy = abs(int(n0->y) - int(n1->y));
+        if (!allow_diag)
+            return dx + dy;
+        return dx > dy ? dx : dy;
+    }
+
+    unsigned move_cost(const node* from, const node* to)
+    {
+        if (to->x != from->x && to->y != from->y)
+            return to->cost + unsigned(ceil(to->cost/2.5)); //if it is diagonal increase the move cost
+        return to->cost;
     }
 
-    multimap<unsigned,node*> find_path(unsigned id, node* n0, node* n1, bool allow_diag, bool &status)
+    // The only cells neighboring both ends of a diagonal step are the two orthogonal to it.
+    bool cuts_corner(grid* gr, const node* n0, const node* n1)
     {
-        node* current;
-        for (unsigned int i = 0; i < gridstructarray[id]->hcells*gridstructarray[id]->vcells; i++)
+        return !gr->open(n0->x, n1->y) || !gr->open(n1->x, n0->y);
+    }
+
+    // Whether every open cell costs the same, as jump point search requires.
+    static bool uniform(grid* gr)
+    {
+        if (gr->uniform_cost < 0)
         {
-            gridstructarray[id]->nodearray[i].F=0;
-            gridstructarray[id]->nodearray[i].G=0;
-            gridstructarray[id]->nodearray[i].H=0;
-            gridstructarray[id]->nodearray[i].came_from=NULL;
+            gr->uniform_cost = 0;
+            unsigned cost = 0;
+            vector<node>::const_iterator it;
+            for (it = gr->nodearray.begin(); it != gr->nodearray.end(); ++it)
+                if (it->cost < gr->threshold)
+                {
+                    if (!cost) cost = it->cost;
+                    else if (it->cost != cost) break;
+                }
+            if (it == gr->nodearray.end() && cost)
+                gr->uniform_cost = cost;
         }
+        return gr->uniform_cost > 0;
+    }
 
-        node* start = n0;
-        node* destination = n1;
-        multimap<unsigned,node*> OPEN;
-        list<node*> CLOSED;
-        multimap<unsigned,node*> mm_ret;
+    bool astar_path(grid* gr, node* start, node* destination, bool allow_diag, vector<node*> &path, search_area &area)
+    {
+        const unsigned search = begin_search(gr);
+        vector<open_entry> OPEN;
+        vector<node*> CLOSED;
+        unsigned opened = 0;
 
-        if (start == destination)
-            return mm_ret;
+        start->G = 0;
         start->H = find_heuristic(start,destination,allow_diag);
         start->F = start->H;
-        OPEN.insert(pair<unsigned,node*>(start->F,start));
+        start->came_from = NULL;
+        start->opened = search;
+        area.add(start->x, start->y);
+        OPEN.push_back(open_entry(start->F, opened++, start));
 
-        while (find(CLOSED.begin(), CLOSED.end(), destination) == CLOSED.end() && !OPEN.empty())
-        //loop until destination is in the closed list or the open multimap is empty
+        while (!OPEN.empty())
         {
-            //if (OPEN.empty()){break;}
-            //multimap<unsigned,node*>::iterator tit;
-            /*std::cout << "Begin" << std::endl;
-            for ( tit=OPEN.begin() ; tit != OPEN.end(); tit++ )
-                std::cout << (*tit).first << " => " << (*tit).second << std::endl;*/
-
-            //this is basically ds_priority_delete_min
-            {
-              multimap<unsigned,node*>::iterator it = OPEN.begin(), it_check;
-              it_check = it++;
-              while (it != OPEN.end())
-              {
-                  if ((*it).first < (*it_check).first) {it_check = it;}
-                  it++;
-              }
-              current = (*it_check).second;
-              OPEN.erase(it_check);
-            }
-            //std::cout << OPEN.size() << std::endl;
-            //std::cout << "End" << std::endl;
-            //multimap<unsigned,node*>::iterator tit;
-            /*for ( tit=OPEN.begin() ; tit != OPEN.end(); tit++ )
-                std::cout << (*tit).first << " => " << (*tit).second << std::endl;*/
-            //std::cout << "Ended" << std::endl;
-
-            CLOSED.push_front(current);
+            std::pop_heap(OPEN.begin(), OPEN.end());
+            node* current = OPEN.back().n;
+            const unsigned F = OPEN.back().F;
+            OPEN.pop_back();
+            if (current->closed == search || F != current->F)
+                continue;
+
+            current->closed = search;
+            CLOSED.push_back(current);
+            if (current == destination)
+                break;
+
             for (vector<enigma::node*>::iterator it = current->neighbor_nodes.begin(); it!=current->neighbor_nodes.end(); ++it)
             { //go trough all the neighbors (should be faster then 8 if cycles like in the init)
-                if (!allow_diag && (*it)->x != current->x && (*it)->y != current->y)
+                node* const nb = *it;
+                const bool diagonal = nb->x != current->x && nb->y != current->y;
+                if (diagonal && !allow_diag)
+                    continue;
+                if (nb->closed == search || nb->cost >= gr->threshold)
+                    continue;
+                if (diagonal && cuts_corner(gr, current, nb))
                     continue;
 
-                bool cutting = false;
-                if (allow_diag == true  && (*it)->x != current->x && (*it)->y != current->y)
-                        cutting = check_corners(id, current, (*it));
-
-                if (find(CLOSED.begin(), CLOSED.end(), (*it)) == CLOSED.end() && (*it)->cost<gridstructarray[id]->threshold && cutting == false){
-                    if (find_priority(OPEN,(*it)) == -1){ //if the node isn't on the open list
-                        (*it)->came_from = current;
-                        (*it)->G = current->G + (*it)->cost;
-                        if ((*it)->x != current->x && (*it)->y != current->y)
-                            (*it)->G += ceil((*it)->cost/2.5); //if it is diagonal increase the move cost
-                        (*it)->H = find_heuristic(*it,destination,allow_diag);
-                        (*it)->F = (*it)->G + (*it)->H;
-                        //std::cout << "Node: " << (*it)->x*gridstructarray[id]->vcells+(*it)->y << " F = " << (*it)->F << " H = " << (*it)->H << " G = " << (*it)->G << std::endl;
-                        OPEN.insert(pair<unsigned,node*>((*it)->F,(*it)));
-
-                    }else{ //if the node is already on the open list we just have to see if it is a better path
-                        unsigned temp_G = current->G + (*it)->cost;
-                        if (temp_G < (*it)->G) {
-                            (*it)->came_from = current;
-                            (*it)->G = current->G + (*it)->cost;
-                            if ((*it)->x != current->x && (*it)->y != current->y)
-                                (*it)->G += ceil((*it)->cost/2.5);
-                            (*it)->H = find_heuristic(*it,destination,allow_diag);
-                            (*it)->F = (*it)->G + (*it)->H;
-                        }
-                    }
+                const unsigned G = current->G + move_cost(current, nb);
+                if (nb->opened == search && G >= nb->G)
+                    continue; //already on the open list by a path at least as good
+
+                if (nb->opened != search) {
+                    nb->opened = search;
+                    nb->H = find_heuristic(nb,destination,allow_diag);
+                    area.add(nb->x, nb->y);
                 }
+                nb->came_from = current;
+                nb->G = G;
+                nb->F = G + nb->H;
+                OPEN.push_back(open_entry(nb->F, opened++, nb));
+                std::push_heap(OPEN.begin(), OPEN.end());
             }
         }
-        node *last, *nearest;
-        unsigned i = 0;
-        status = true;
-        if (find(CLOSED.begin(), CLOSED.end(), destination) == CLOSED.end())
-        {   //this is for if the destionation can't be found if
-            status = false;
-            nearest = start;
-
-            list<node*>::iterator it;
-            for (it=CLOSED.begin(); it != CLOSED.end(); it++){
-                (*it)->H = find_heuristic(*it,destination,allow_diag);
+
+        const bool status = destination->closed == search;
+        if (!status)
+        {   //this is for if the destionation can't be found
+            node* nearest = start;
+            for (vector<node*>::reverse_iterator it = CLOSED.rbegin(); it != CLOSED.rend(); ++it)
                 if ((*it)->H < nearest->H)
                     nearest = *it;
-            }
             destination = nearest;
-            if (start == destination)
-                return mm_ret;
         }
 
-        //mm_ret.insert(pair<unsigned,node*>(i,destination));
-        last = destination;
-        while (last->came_from != start){
-            i += 1;
-            mm_ret.insert(pair<unsigned,node*>(i,last->came_from));
-            last = last->came_from;
+        path.clear();
+        if (destination != start)
+        {
+            for (node* last = destination->came_from; last != start; last = last->came_from)
+                path.push_back(last);
+            std::reverse(path.begin(), path.end());
         }
+        return status;
+    }
+
+    vector<node*> find_path(grid* gr, node* n0, node* n1, bool allow_diag, bool &status)
+    {
+        vector<node*> path;
+        status = true;
+        if (n0 == n1 || gr->cache->find(n0, n1, allow_diag, path, status))
+            return path;
+
+        search_area area;
+        status = gr->jump_points && uniform(gr) && jps_path(gr, n0, n1, allow_diag, path, area);
+        if (!status && gr->cluster_size)
+            status = hpa_path(gr, n0, n1, allow_diag, path, area);
+        if (!status)
+            status = astar_path(gr, n0, n1, allow_diag, path, area);
 
-        //delete CLOSED;
-        //delete OPEN;
-        return mm_ret; //return the multimap containing a list of all the nodes that are in the path.
+        gr->cache->store(n0, n1, allow_diag, path, status, area);
+        return path;
     }
 }
@@ -42,9 +42,18 @@ namespace enigma
     unsigned x, y, F, H, G, cost;
     node* came_from;
     vector<node*> neighbor_nodes;
+    // The search in which this node was last opened and closed; F, G, H and came_from
+    // are only meaningful while `opened' matches the grid's current search.
+    unsigned opened, closed;
     node(unsigned X = 0, unsigned Y = 0, unsigned f = 0, unsigned h = 0, unsigned g = 0, unsigned Cost = 0, node* CameFrom = NULL):
-      x(X), y(Y), F(f), H(h), G(g), cost(Cost), came_from(CameFrom) {}
+      x(X), y(Y), F(f), H(h), G(g), cost(Cost), came_from(CameFrom), opened(0), closed(0) {}
   };
+  struct jps_map;
+  struct hpa_graph;
+  struct path_cache;
+  struct grid_snapshot;
+  struct grid_mirror;
+
   struct grid
   {
     unsigned int id;
@@ -53,10 +62,111 @@ namespace enigma
     unsigned threshold;
     double speed_modifier;
     vector<node> nodearray;
+    unsigned search; // Counts searches over the grid, to stamp the nodes each one visits
+    bool jump_points; // Whether to use jump point search while every open cell costs the same
+    int uniform_cost; // The cost of every open cell if they all match, 0 if not, -1 if unknown
+    jps_map *jps; // Which cells are open, packed for jump point search, built on demand
+    unsigned cluster_size; // The side of a hierarchical cluster, in cells, or 0 to search flat
+    hpa_graph *hpa[2]; // The cluster abstraction, without and with diagonals, built on demand
+    path_cache *cache;
+    bool listed; // Whether the grid is in gridstructarray; copies searched by worker threads are not
+    grid_snapshot *snapshot; // The cells as of the last asynchronous search, while they stay unchanged
+    grid_mirror *mirror; // The copies of this grid kept by worker threads, made on demand
+
+    node* at(unsigned x, unsigned y) { return &nodearray[x*vcells + y]; }
+    bool open(unsigned x, unsigned y) const { return x < hcells && y < vcells && nodearray[x*vcells + y].cost < threshold; }
+
+    // Call after changing the cost of the cells in the given rectangle, inclusive.
+    void cells_changed(unsigned x1, unsigned y1, unsigned x2, unsigned y2);
+    // Call after changing the threshold or replacing the nodes.
+    void all_changed();
+    // Links each node in nodearray to its neighbors; call after filling nodearray.
+    void link_nodes();
+
     grid(unsigned int id,int left,int top,unsigned int hcells,unsigned int vcells,unsigned int cellwidth,unsigned int cellheight, unsigned int threshold, double speed_modifier);
+    explicit grid(const grid_snapshot &snap); // An unlisted copy, for a worker thread
     ~grid();
+
+    private:
+    grid(const grid&);
+    void operator=(const grid&);
   };
   extern grid** gridstructarray;
   void gridstructarray_reallocate();
-  multimap<unsigned,node*> find_path(unsigned id, node* n0, node* n1, bool allow_diag, bool &status);
+
+  // Finds a path from n0 to n1, returning the cells strictly between them, in order. If n1
+  // cannot be reached, status is set false and the path leads to the nearest cell that can.
+  vector<node*> find_path(grid* gr, node* n0, node* n1, bool allow_diag, bool &status);
+
+  // The rectangle of cells a search looked at. Changing costs outside it, or further out
+  // than one cell, cannot change the search's result.
+  struct search_area
+  {
+    unsigned left, top, right, bottom;
+    void add(unsigned x, unsigned y) {
+      if (x < left) left = x;
+      if (x > right) right = x;
+      if (y < top) top = y;
+      if (y > bottom) bottom = y;
+    }
+    bool touches(unsigned x1, unsigned y1, unsigned x2, unsigned y2) const {
+      return x1 <= right + 1 && x2 + 1 >= left && y1 <= bottom + 1 && y2 + 1 >= top;
+    }
+    search_area(): left(~0u), top(~0u), right(0), bottom(0) {}
+  };
+
+  // An entry in a search's open set, for use with the std heap functions. A node whose
+  // G improves is pushed again rather than moved; entries whose F no longer matches their
+  // node, or whose node has since been closed, are skipped as they come up. Ties go to
+  // the node opened first.
+  struct open_entry
+  {
+    unsigned F, order;
+    node* n;
+    open_entry(unsigned f, unsigned o, node* nd): F(f), order(o), n(nd) {}
+    bool operator<(const open_entry &other) const { // Reversed, so the heap keeps the least F on top
+      return F != other.F ? F > other.F : order > other.order;
+    }
+  };
+
+  unsigned begin_search(grid* gr); // Returns the stamp for a new search
+  unsigned find_heuristic(const node* n0, const node* n1, bool allow_diag);
+  unsigned move_cost(const node* from, const node* to); // Cost of a step between neighbors
+  bool cuts_corner(grid* gr, const node* n0, const node* n1); // For diagonal steps
+
+  // The searches behind find_path. Each returns whether it reached n1 and, if so, the
+  // cells strictly between n0 and n1. Only astar_path gives a path to an unreachable n1.
+  bool astar_path(grid* gr, node* n0, node* n1, bool allow_diag, vector<node*> &path, search_area &area);
+  bool jps_path(grid* gr, node* n0, node* n1, bool allow_diag, vector<node*> &path, search_area &area);
+  bool hpa_path(grid* gr, node* n0, node* n1, bool allow_diag, vector<node*> &path, search_area &area);
+
+  void jps_cells_changed(jps_map* jps, unsigned x1, unsigned y1, unsigned x2, unsigned y2);
+  void jps_destroy(jps_map* jps);
+  void hpa_cells_changed(hpa_graph* hpa, unsigned x1, unsigned y1, unsigned x2, unsigned y2);
+  void hpa_destroy(hpa_graph* hpa);
+
+  // What an asynchronous search needs of a grid, copied when the search is requested and
+  // shared by the searches requested until the grid next changes.
+  struct grid_snapshot
+  {
+    int left, top;
+    unsigned hcells, vcells, cellwidth, cellheight, threshold;
+    bool jump_points;
+    unsigned cluster_size;
+    vector<unsigned> cost;
+    unsigned long serial; // Distinct for every snapshot taken
+    unsigned refs; // Counted on the game thread only
+  };
+
+  // Each returns the grid's current snapshot or mirror, making it if need be, with a
+  // reference held for the caller. Call these, and release, on the game thread only.
+  grid_snapshot* snapshot_take(grid* gr);
+  grid_mirror* mirror_take(grid* gr);
+  void snapshot_release(grid_snapshot* snap);
+  void mirror_release(grid_mirror* mirror);
+
+  // Searches the given worker's copy of a grid, first bringing it up to date with the
+  // snapshot, as find_path would the grid itself. The path is given as cell indices.
+  bool mirror_find_path(grid_mirror* mirror, unsigned worker, const grid_snapshot* snap, unsigned xs, unsigned ys,
+                        unsigned xg, unsigned yg, bool allow_diag, vector<unsigned> &cells);
 }
@@ -136,7 +136,7 @@ namespace enigma {
     double x_offset;
     double y_offset;
 
-  void draw_particles(std::vector<particle_instance>& pi_list, bool oldtonew, double a_wiggle, int a_subimage_index,
+  void draw_particles(particle_store& pi_list, bool oldtonew, double a_wiggle, int a_subimage_index,
       double a_x_offset, double a_y_offset) {
       using namespace enigma::particle_bridge;
       wiggle = a_wiggle;
@@ -146,13 +146,13 @@ namespace enigma {
 
       glPushAttrib(GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT); // Attrib push 1.
 
-      if (pi_list.size() > 0) {
+      if (pi_list.count() > 0) {
         glBindVertexArray(vao); // Bind vertex array.
         glUseProgram(shader_program); // Bind shader program.
 
         // Transfer data to shaders.
 
-        const unsigned int pi_list_size = pi_list.size();
+        const unsigned int pi_list_size = pi_list.count();
 
         std::vector<GLfloat> points;
         points.reserve(pi_list_size*2);
@@ -171,7 +171,7 @@ namespace enigma {
 
         for (unsigned int i = 0; i < pi_list_size; i++) {
 
-          particle_instance& pi = pi_list[i];
+          const particle_instance pi = pi_list.get(i);
           double x, y;
           int color = pi.color;
           int alpha = pi.alpha;
@@ -179,7 +179,7 @@ namespace enigma {
           double rot;
           double width, height;
           double pi_x_offset, pi_y_offset;
-          double tbx, tby;
+          double tx = 0, ty = 0, tbx, tby;
           if (pi.pt->alive) {
             particle_type* pt = pi.pt;
             x = pi.x;
@@ -213,13 +213,16 @@ namespace enigma {
                 }
               }
               const enigma::sprite *const spr2d = enigma::spritestructarray[sprite_id];
+              enigma::sprite_load(spr2d);
               const int usi = subimg % spr2d->subcount;
               width = spr2d->width;
               height = spr2d->height;
               pi_x_offset = spr2d->xoffset;
               pi_y_offset = spr2d->yoffset;
-              tbx = spr2d->texbordxarray[usi];
-              tby = spr2d->texbordyarray[usi];
+              tx = spr2d->texxarray[usi];
+              ty = spr2d->texyarray[usi];
+              tbx = tx + spr2d->texbordxarray[usi];
+              tby = ty + spr2d->texbordyarray[usi];
               texture_indices.push_back(spr2d->texturearray[usi]);
             }
             else {
@@ -268,16 +271,16 @@ namespace enigma {
           double ulcx = x - xscale * pi_x_offset * cos(rot) + yscale * pi_y_offset * cos(M_PI/2+rot);
           double ulcy = y + xscale * pi_x_offset * sin(rot) - yscale * pi_y_offset * sin(M_PI/2+rot);
 
-          double t1x = 0, t1y = 0;
+          double t1x = tx, t1y = ty;
           double v1x = ulcx, v1y = ulcy;
-          double t2x = tbx, t2y = 0;
+          double t2x = tbx, t2y = ty;
           double v2x = ulcx + wcosrot, v2y = ulcy - wsinrot;
 
           const double mpr = 3*M_PI/2 + rot;
           ulcx += h * cos(mpr);
           ulcy -= h * sin(mpr);
 
-          double t3x = 0, t3y = tby;
+          double t3x = tx, t3y = tby;
           double v3x = ulcx, v3y = ulcy;
           double t4x = tbx, t4y = tby;
           double v4x = ulcx + wcosrot, v4y = ulcy - wsinrot;
@@ -337,7 +340,7 @@ namespace enigma {
           bool curr_blend_add = false;
           int switch_offset = 0;
           int switch_count = 0;
-          for (unsigned int loop_i = 0; loop_i  < pi_list.size(); loop_i ++) {
+          for (unsigned int loop_i = 0; loop_i  < pi_list.count(); loop_i ++) {
             unsigned int i = loop_i;
             if (!oldtonew) {
               i = pi_list_size - 1 - loop_i;
@@ -0,0 +1,203 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+
+#include "PS_particle_instance.h"
+#include <cmath>
+#include <algorithm>
+
+namespace enigma
+{
+  void particle_store::push_back(const particle_instance& pi)
+  {
+    pt.push_back(pi.pt);
+    sprite_subimageindex_initial.push_back(pi.sprite_subimageindex_initial);
+    size.push_back(pi.size);
+    size_wiggle_offset.push_back(pi.size_wiggle_offset);
+    angle.push_back(pi.angle);
+    ang_wiggle_offset.push_back(pi.ang_wiggle_offset);
+    color.push_back(pi.color);
+    alpha.push_back(pi.alpha);
+    life_current.push_back(pi.life_current);
+    life_start.push_back(pi.life_start);
+    x.push_back(pi.x);
+    y.push_back(pi.y);
+    speed.push_back(pi.speed);
+    direction.push_back(pi.direction);
+    speed_wiggle_offset.push_back(pi.speed_wiggle_offset);
+    dir_wiggle_offset.push_back(pi.dir_wiggle_offset);
+    vx.push_back(0);
+    vy.push_back(0);
+    set_motion(count() - 1);
+  }
+
+  particle_instance particle_store::get(size_t i) const
+  {
+    particle_instance pi;
+    pi.pt = pt[i];
+    pi.sprite_subimageindex_initial = sprite_subimageindex_initial[i];
+    pi.size = size[i];
+    pi.size_wiggle_offset = size_wiggle_offset[i];
+    pi.angle = angle[i];
+    pi.ang_wiggle_offset = ang_wiggle_offset[i];
+    pi.color = color[i];
+    pi.alpha = alpha[i];
+    pi.life_current = life_current[i];
+    pi.life_start = life_start[i];
+    pi.x = x[i];
+    pi.y = y[i];
+    pi.speed = speed[i];
+    pi.direction = direction[i];
+    pi.speed_wiggle_offset = speed_wiggle_offset[i];
+    pi.dir_wiggle_offset = dir_wiggle_offset[i];
+    return pi;
+  }
+
+  void particle_store::set_motion(size_t i)
+  {
+    vx[i] = speed[i]*cos(direction[i]*M_PI/180.0);
+    vy[i] = -speed[i]*sin(direction[i]*M_PI/180.0);
+  }
+
+  void particle_store::clear()
+  {
+    pt.clear();
+    sprite_subimageindex_initial.clear();
+    size.clear(), size_wiggle_offset.clear();
+    angle.clear(), ang_wiggle_offset.clear();
+    color.clear(), alpha.clear();
+    life_current.clear(), life_start.clear();
+    x.clear(), y.clear();
+    speed.clear(), direction.clear();
+    speed_wiggle_offset.clear(), dir_wiggle_offset.clear();
+    vx.clear(), vy.clear();
+  }
+
+  // Moves the kept elements of one field, all at or past first, down over the dropped ones.
+  template<typename T> static void compact(std::vector<T>& field, size_t first, const std::vector<size_t>& keep)
+  {
+    for (size_t i = 0; i < keep.size(); i++)
+      field[first + i] = field[keep[i]];
+    field.resize(first + keep.size());
+  }
+
+  void particle_store::remove_dead()
+  {
+    const size_t n = count();
+    size_t first = 0;
+    while (first < n && life_current[first] > 0)
+      first++;
+    if (first == n)
+      return;
+
+    std::vector<size_t> keep;
+    for (size_t i = first + 1; i < n; i++)
+      if (life_current[i] > 0)
+        keep.push_back(i);
+
+    compact(pt, first, keep);
+    compact(sprite_subimageindex_initial, first, keep);
+    compact(size, first, keep), compact(size_wiggle_offset, first, keep);
+    compact(angle, first, keep), compact(ang_wiggle_offset, first, keep);
+    compact(color, first, keep), compact(alpha, first, keep);
+    compact(life_current, first, keep), compact(life_start, first, keep);
+    compact(x, first, keep), compact(y, first, keep);
+    compact(speed, first, keep), compact(direction, first, keep);
+    compact(speed_wiggle_offset, first, keep), compact(dir_wiggle_offset, first, keep);
+    compact(vx, first, keep), compact(vy, first, keep);
+  }
+
+  int particle_grid::column(double x) const
+  {
+    const double f = (x - left)/cell_size;
+    return f > 0 ? (f < columns ? int(f) : columns - 1) : 0; // NaN goes to the first column
+  }
+  int particle_grid::row(double y) const
+  {
+    const double f = (y - top)/cell_size;
+    return f > 0 ? (f < rows ? int(f) : rows - 1) : 0;
+  }
+
+  void particle_grid::build(const particle_store& ps, size_t regions)
+  {
+    particle_count = ps.count();
+    binned = false;
+    if (regions < 2 || particle_count < 64)
+      return;
+
+    double right = ps.x[0], bottom = ps.y[0];
+    left = right, top = bottom;
+    for (size_t i = 1; i < particle_count; i++) {
+      left = std::min(left, ps.x[i]), right = std::max(right, ps.x[i]);
+      top = std::min(top, ps.y[i]), bottom = std::max(bottom, ps.y[i]);
+    }
+    // A handful of particles to a cell, and no more than 128 cells along either side.
+    const double width = right - left, height = bottom - top;
+    const double cells = std::min(particle_count/8.0, 16384.0);
+    cell_size = std::max(std::max(sqrt(width*height/cells), std::max(width, height)/128), 1.0);
+    if (!(cell_size < HUGE_VAL))
+      return; // Particles off at infinity, or not at any number at all
+    columns = int(width/cell_size) + 1;
+    rows = int(height/cell_size) + 1;
+
+    // Counting sort by cell, which keeps each cell's particles in order of index.
+    cell_start.assign(size_t(columns)*rows + 1, 0);
+    cell_of.resize(particle_count);
+    for (size_t i = 0; i < particle_count; i++) {
+      const size_t c = size_t(row(ps.y[i]))*columns + column(ps.x[i]);
+      cell_of[i] = c;
+      cell_start[c + 1]++;
+    }
+    for (size_t c = 1; c < cell_start.size(); c++)
+      cell_start[c] += cell_start[c - 1];
+    cell_particles.resize(particle_count);
+    for (size_t i = 0; i < particle_count; i++)
+      cell_particles[cell_start[cell_of[i]]++] = i;
+    // Filling each cell moved its start up to the next cell's; shift the starts back down.
+    for (size_t c = cell_start.size() - 1; c > 0; c--)
+      cell_start[c] = cell_start[c - 1];
+    cell_start[0] = 0;
+    binned = true;
+  }
+
+  void particle_grid::query(double xmin, double ymin, double xmax, double ymax, std::vector<size_t>& out) const
+  {
+    out.clear();
+    if (!binned) {
+      for (size_t i = 0; i < particle_count; i++)
+        out.push_back(i);
+      return;
+    }
+    if (xmin > xmax || ymin > ymax)
+      return;
+
+    // A bound that is not a number could be anywhere, so it reaches the edge of the grid.
+    const int c0 = column(xmin), c1 = xmax == xmax ? column(xmax) : columns - 1;
+    const int r0 = row(ymin), r1 = ymax == ymax ? row(ymax) : rows - 1;
+    bool mixed = false; // Whether out holds particles from more than one cell
+    for (int r = r0; r <= r1; r++)
+    {
+      // The cells of a row lie side by side, so the row's span is one stretch of particles.
+      const size_t from = cell_start[size_t(r)*columns + c0], to = cell_start[size_t(r)*columns + c1 + 1];
+      if (from == to) continue;
+      mixed = mixed || c1 > c0 || !out.empty();
+      out.insert(out.end(), cell_particles.begin() + from, cell_particles.begin() + to);
+    }
+    if (mixed)
+      std::sort(out.begin(), out.end());
+  }
+}
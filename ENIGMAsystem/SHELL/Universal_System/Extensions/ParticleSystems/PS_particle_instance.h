@@ -29,6 +29,8 @@
 #define ENIGMA_PS_PARTICLEINSTANCE
 
 #include "PS_particle_type.h"
+#include <vector>
+#include <cstddef>
 
 namespace enigma
 {
@@ -49,6 +51,56 @@ namespace enigma
     double speed_wiggle_offset; // [-1;1].
     double dir_wiggle_offset; // [-1;1].
   };
+
+  // The particles of a system, in order of creation, stored a field to an array so the
+  // update can sweep each field it needs without dragging the rest through the cache.
+  struct particle_store
+  {
+    std::vector<particle_type*> pt;
+    std::vector<int> sprite_subimageindex_initial;
+    std::vector<double> size, size_wiggle_offset;
+    std::vector<double> angle, ang_wiggle_offset;
+    std::vector<int> color, alpha;
+    std::vector<int> life_current, life_start;
+    std::vector<double> x, y;
+    std::vector<double> speed, direction;
+    std::vector<double> speed_wiggle_offset, dir_wiggle_offset;
+    std::vector<double> vx, vy; // One step at speed and direction; call set_motion after changing either.
+
+    size_t count() const { return pt.size(); }
+    void push_back(const particle_instance& pi);
+    particle_instance get(size_t i) const;
+    void set_motion(size_t i);
+    void clear();
+    // Drops every particle whose life_current is 0 or less, keeping the rest in order.
+    void remove_dead();
+  };
+
+  // Buckets the particles of a store into a coarse grid of square cells by position, so a
+  // region need only visit the particles in the cells it overlaps. Positions are taken as
+  // they were when the grid was built; a query for particles that may have moved since must
+  // be widened by as far as they may have gone.
+  struct particle_grid
+  {
+    // Bins the particles for the given number of regions to come. With fewer than two the
+    // binning would cost as much as it saves, and every query returns every particle.
+    void build(const particle_store& ps, size_t regions);
+    // Fills out with the indices, in increasing order, of the particles that may lie within
+    // the rectangle; it holds at least all of those that did when the grid was built.
+    void query(double xmin, double ymin, double xmax, double ymax, std::vector<size_t>& out) const;
+    particle_grid(): particle_count(0), binned(false) {}
+
+    private:
+      size_t particle_count;
+      bool binned;
+      double left, top, cell_size;
+      int columns, rows;
+      std::vector<size_t> cell_start; // Where each cell's particles begin in cell_particles, plus the end
+      std::vector<size_t> cell_particles;
+      std::vector<size_t> cell_of; // Scratch for build
+      int column(double x) const;
+      int row(double y) const;
+  };
 }
 
 #endif // ENIGMA_PS_PARTICLEINSTANCE
@@ -63,9 +63,9 @@ namespace enigma_user {
   {
     particle_system* p_s = enigma::get_particlesystem(id);
     if (p_s != NULL) {
-      for (std::vector<enigma::particle_instance>::iterator it = p_s->pi_list.begin(); it != p_s->pi_list.end(); it++)
+      for (size_t i = 0; i < p_s->pi_list.count(); i++)
       {
-        particle_type* pt = it->pt;
+        particle_type* pt = p_s->pi_list.pt[i];
 
         // Death handling.
         pt->particle_count--;
@@ -83,7 +83,7 @@ namespace enigma_user {
   {
     particle_system* p_s = enigma::get_particlesystem(id);
     if (p_s != NULL) {
-      return p_s->pi_list.size();
+      return p_s->pi_list.count();
     }
     return 0;
   }
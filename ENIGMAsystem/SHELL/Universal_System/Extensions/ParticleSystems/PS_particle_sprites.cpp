@@ -959,6 +959,8 @@ namespace enigma
 
     sprite* sprstr = enigma::spritestructarray[sprid];
     sprstr->texturearray.push_back(ps->texture);
+    sprstr->texxarray.push_back(0);
+    sprstr->texyarray.push_back(0);
     sprstr->texbordxarray.push_back(1.0); // Assumes multiple of 2.
     sprstr->texbordyarray.push_back(1.0); // Assumes multiple of 2.
     sprstr->colldata.push_back(get_collision_mask(sprstr,0,ct_bbox));
@@ -51,14 +51,6 @@ using enigma::pt_manager;
 
 namespace enigma
 {
-  struct generation_info
-  {
-    double x;
-    double y;
-    int number;
-    particle_type* pt;
-  };
-  
   double particle_system::get_wiggle_result(double wiggle_offset) {
     return get_wiggle_result(wiggle_offset, wiggle);
   }
@@ -77,7 +69,7 @@ namespace enigma
     oldtonew = true;
     auto_update = true, auto_draw = true;
     depth = 0.0;
-    pi_list = std::vector<particle_instance>();
+    pi_list = particle_store();
     id_to_emitter = std::map<int,particle_emitter*>();
     emitter_max_id = 0;
     id_to_attractor = std::map<int,particle_attractor*>();
@@ -91,208 +83,235 @@ namespace enigma
     hidden = false;
   }
   
-  static inline bool is_dead_from_old_age(particle_instance& pi) {
-    return pi.life_current <= 0;
+  static particle_type* find_particletype(int id)
+  {
+    std::map<int,particle_type*>::iterator it = pt_manager.id_to_particletype.find(id);
+    return it != pt_manager.id_to_particletype.end() ? (*it).second : NULL;
   }
-  
-  void particle_system::update_particlesystem()
+
+  // Types deleted since the particles were last stepped. Generation lists gathered while
+  // stepping may still point to them, in this system or any other stepped at the same time.
+  static std::vector<particle_type*> deleted_types;
+
+  // Finds the particles each changer, attractor, destroyer and deflector need look at.
+  static particle_grid region_grid;
+  static std::vector<size_t> region_particles;
+
+  // Counts a particle of the given type as gone, deleting the type if that was its last
+  // particle and it has been destroyed. Returns whether it was deleted.
+  static bool release_particle(particle_type* pt)
   {
-    // Increase wiggle.
-    wiggle += 1.0/wiggle_frequency;
-    if (wiggle > 1.0) {
-      wiggle -= 1.0;
+    pt->particle_count--;
+    if (pt->particle_count <= 0 && !pt->alive) {
+      // Particle type is no longer used, delete it.
+      int pid = pt->id;
+      deleted_types.push_back(pt);
+      delete pt;
+      enigma::pt_manager.id_to_particletype.erase(pid);
+      return true;
     }
-    // Increase subimage_index.
-    subimage_index++;
+    return false;
+  }
+
+  static void drop_deleted_types(std::vector<generation_info>& generation, const std::vector<particle_type*>& deleted)
+  {
+    for (size_t i = 0; i < generation.size(); )
+      if (std::find(deleted.begin(), deleted.end(), generation[i].pt) != deleted.end())
+        generation.erase(generation.begin() + i);
+      else i++;
+  }
+
+  // Moves particles along their current motion.
+  static inline void drift(particle_store& ps, size_t first, size_t last)
+  {
+    double *const x = &ps.x[0], *const y = &ps.y[0];
+    const double *const vx = &ps.vx[0], *const vy = &ps.vy[0];
+    for (size_t i = first; i < last; i++) {
+      x[i] += vx[i];
+      y[i] += vy[i];
+    }
+  }
 
-    std::vector<generation_info> particles_to_generate;
-    // Handle life and death.
+  size_t particle_system::step_particles(size_t first, size_t last, std::vector<generation_info>& deaths, std::vector<generation_info>& steps)
+  {
+    if (first >= last) return 0;
+    particle_store& ps = pi_list;
+    int *const life = &ps.life_current[0];
+    const int *const life_start = &ps.life_start[0];
+    size_t dead = 0;
+
+    // Particles are taken in runs of one type, as they are created, so that each run looks
+    // its type up once and its loops leave out whatever the type does not use.
+    for (size_t a = first, b; a < last; a = b)
     {
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != pi_list.end(); it++)
-      {
-        // Decrease life.
-        it->life_current--;
-        if (it->life_current <= 0) { // Death.
-          particle_type* pt = it->pt;
+      particle_type* const pt = ps.pt[a];
+      for (b = a + 1; b < last && ps.pt[b] == pt; b++);
 
-          // Generated upon end of life.
-          if (pt->alive && pt->death_on) {
-            std::map<int,particle_type*>::iterator death_pt_it = pt_manager.id_to_particletype.find(pt->death_particle_id);
-            if (death_pt_it != pt_manager.id_to_particletype.end()) {
-              generation_info gen_info;
-              gen_info.x = it->x;
-              gen_info.y = it->y;
-              gen_info.number = pt->death_number;
-              gen_info.pt = (*death_pt_it).second;
-              particles_to_generate.push_back(gen_info);
-            }
-          }
+      // Life and death.
+      size_t run_dead = 0;
+      for (size_t i = a; i < b; i++)
+        run_dead += --life[i] <= 0;
+      dead += run_dead;
+      if (run_dead && pt->alive && pt->death_on) {
+        // Generated upon end of life.
+        if (particle_type* death_pt = find_particletype(pt->death_particle_id))
+          for (size_t i = a; i < b; i++)
+            if (life[i] <= 0)
+              deaths.push_back(generation_info(ps.x[i], ps.y[i], pt->death_number, death_pt));
+      }
 
-          // Death handling.
-          // Only the clean-up is made here.
-          pt->particle_count--;
-          if (pt->particle_count <= 0 && !pt->alive) {
-            // Particle type is no longer used, delete it.
-            int pid = pt->id;
-            delete pt;
-            enigma::pt_manager.id_to_particletype.erase(pid);
-          }
-        }
+      if (!pt->alive) {
+        drift(ps, a, b);
+        continue;
       }
-      pi_list.erase(std::remove_if(pi_list.begin(), pi_list.end(), is_dead_from_old_age), pi_list.end());
-    }
-    // Shape.
-    {
-      std::vector<particle_instance>::iterator end = pi_list.end();
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
+
+      // Shape.
       {
-        particle_type* pt = it->pt;
-        if (pt->alive) {
-          it->size = std::max(it->size + pt->size_incr, 0.0);
-          it->angle = fmod(it->angle + pt->ang_incr, 360.0);
+        double *const size = &ps.size[0];
+        const double size_incr = pt->size_incr;
+        for (size_t i = a; i < b; i++)
+          size[i] = std::max(size[i] + size_incr, 0.0);
+        if (pt->ang_incr != 0) {
+          double *const angle = &ps.angle[0];
+          for (size_t i = a; i < b; i++)
+            angle[i] = fmod(angle[i] + pt->ang_incr, 360.0);
         }
       }
-    }
-    // Color and blending.
-    {
-      std::vector<particle_instance>::iterator end = pi_list.end();
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
-      {
-        particle_type* pt = it->pt;
-        // Color.
-        switch(pt->c_mode) {
-        default:
-        case one_color : {break;}
-        case two_color : {
-          if (pt->alive) {
-            const int r1 = color_get_red(pt->color1),
-                g1 = color_get_green(pt->color1),
-                b1 = color_get_blue(pt->color1);
-            const int r2 = color_get_red(pt->color2),
-                g2 = color_get_green(pt->color2),
-                b2 = color_get_blue(pt->color2);
-            const double part = 1.0 - 1.0*it->life_current/it->life_start;
-            it->color = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
-          }
-          break;
+      // Color and blending.
+      switch (pt->c_mode) {
+      default:
+      case one_color : {break;}
+      case two_color : {
+        const int r1 = color_get_red(pt->color1),
+            g1 = color_get_green(pt->color1),
+            b1 = color_get_blue(pt->color1);
+        const int r2 = color_get_red(pt->color2),
+            g2 = color_get_green(pt->color2),
+            b2 = color_get_blue(pt->color2);
+        for (size_t i = a; i < b; i++) {
+          const double part = 1.0 - 1.0*life[i]/life_start[i];
+          ps.color[i] = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
         }
-        case three_color : {
-          if (pt->alive) {
-            double part = 1.0 - 1.0*it->life_current/it->life_start;
-            int first_color, second_color;
-            if (part <= 0.5) {
-              part = 2.0*part;
-              first_color = pt->color1;
-              second_color = pt->color2;
-            }
-            else {
-              part = 2.0*(part - 0.5);
-              first_color = pt->color2;
-              second_color = pt->color3;
-            }
-            const int r1 = color_get_red(first_color),
-                g1 = color_get_green(first_color),
-                b1 = color_get_blue(first_color);
-            const int r2 = color_get_red(second_color),
-                g2 = color_get_green(second_color),
-                b2 = color_get_blue(second_color);
-            it->color = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
-          }
-          break;
+        break;
+      }
+      case three_color : {
+        const int colors[3] = {pt->color1, pt->color2, pt->color3};
+        for (size_t i = a; i < b; i++) {
+          double part = 1.0 - 1.0*life[i]/life_start[i];
+          const int half = part <= 0.5 ? 0 : 1;
+          part = half ? 2.0*(part - 0.5) : 2.0*part;
+          const int first_color = colors[half], second_color = colors[half + 1];
+          const int r1 = color_get_red(first_color),
+              g1 = color_get_green(first_color),
+              b1 = color_get_blue(first_color);
+          const int r2 = color_get_red(second_color),
+              g2 = color_get_green(second_color),
+              b2 = color_get_blue(second_color);
+          ps.color[i] = make_color_rgb(int((1-part)*r1 + part*r2),int((1-part)*g1 + part*g2),int((1-part)*b1 + part*b2));
         }
-        case mix_color : {break;}
-        case rgb_color : {break;}
-        case hsv_color : {break;}
+        break;
+      }
+      case mix_color : {break;}
+      case rgb_color : {break;}
+      case hsv_color : {break;}
+      }
+      // Alpha.
+      switch (pt->a_mode) {
+      default:
+      case one_alpha : {break;}
+      case two_alpha : {
+        const int alpha1 = pt->alpha1;
+        const int alpha2 = pt->alpha2;
+        for (size_t i = a; i < b; i++) {
+          const double part = 1.0 - 1.0*life[i]/life_start[i];
+          ps.alpha[i] = bounds(int((1-part)*alpha1 + part*alpha2), 0, 255);
         }
-        // Alpha.
-        switch(pt->a_mode) {
-        default:
-        case one_alpha : {break;}
-        case two_alpha : {
-          if (pt->alive) {
-            const int alpha1 = pt->alpha1;
-            const int alpha2 = pt->alpha2;
-            const double part = 1.0 - 1.0*it->life_current/it->life_start;
-            it->alpha = bounds(int((1-part)*alpha1 + part*alpha2), 0, 255);
-          }
-          break;
+        break;
+      }
+      case three_alpha : {
+        const int alphas[3] = {int(pt->alpha1), int(pt->alpha2), int(pt->alpha3)};
+        for (size_t i = a; i < b; i++) {
+          double part = 1.0 - 1.0*life[i]/life_start[i];
+          const int half = part <= 0.5 ? 0 : 1;
+          part = half ? 2.0*(part - 0.5) : 2.0*part;
+          ps.alpha[i] = bounds(int((1-part)*alphas[half] + part*alphas[half + 1]), 0, 255);
         }
-        case three_alpha : {
-          if (pt->alive) {
-            const int alpha1 = pt->alpha1;
-            const int alpha2 = pt->alpha2;
-            const int alpha3 = pt->alpha3;
-            double part = 1.0 - 1.0*it->life_current/it->life_start;
-            int first_alpha, second_alpha;
-            if (part <= 0.5) {
-              part = 2.0*part;
-              first_alpha = alpha1;
-              second_alpha = alpha2;
-            }
-            else {
-              part = 2.0*(part - 0.5);
-              first_alpha = alpha2;
-              second_alpha = alpha3;
-            }
-            it->alpha = bounds(int((1-part)*first_alpha + part*second_alpha), 0, 255);
+        break;
+      }
+      }
+      // Step.
+      if (pt->step_on) {
+        // Generated each step.
+        if (particle_type* step_pt = find_particletype(pt->step_particle_id))
+          for (size_t i = a; i < b; i++)
+            if (life[i] > 0)
+              steps.push_back(generation_info(ps.x[i], ps.y[i], pt->step_number, step_pt));
+      }
+      // Move particles.
+      if (pt->speed_incr != 0 || pt->dir_incr != 0 || pt->grav_amount != 0) {
+        const double grav_x = pt->grav_amount*cos(pt->grav_dir*M_PI/180.0);
+        const double grav_y = pt->grav_amount*sin(pt->grav_dir*M_PI/180.0);
+        for (size_t i = a; i < b; i++) {
+          double speed = ps.speed[i] + pt->speed_incr, direction = ps.direction[i] + pt->dir_incr;
+          if (speed < 0) {
+            speed = -speed;
+            direction += 180.0;
           }
-          break;
+          direction = fmod(direction, 360.0);
+          const double vx = speed*cos(direction*M_PI/180.0) + grav_x;
+          const double vy = -(speed*sin(direction*M_PI/180.0) + grav_y);
+          ps.speed[i] = sqrt(vx*vx + vy*vy);
+          ps.direction[i] = fzero(vx) && fzero(vy) ? direction : -atan2(vy,vx)*180.0/M_PI;
+          ps.vx[i] = vx, ps.vy[i] = vy;
         }
+      }
+      if (pt->speed_wiggle != 0 || pt->dir_wiggle != 0) {
+        for (size_t i = a; i < b; i++) {
+          const double speed = ps.speed[i] + pt->speed_wiggle*get_wiggle_result(ps.speed_wiggle_offset[i]);
+          const double direction = ps.direction[i] + pt->dir_wiggle*get_wiggle_result(ps.dir_wiggle_offset[i]);
+          ps.x[i] += speed*cos(direction*M_PI/180.0);
+          ps.y[i] += -speed*sin(direction*M_PI/180.0);
         }
       }
+      else drift(ps, a, b);
     }
-    // Step.
-    {
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != pi_list.end(); it++)
-      {
-        particle_type* pt = it->pt;
+    return dead;
+  }
 
-        // Generated each step.
-        if (pt->alive && pt->step_on) {
-          std::map<int,particle_type*>::iterator step_pt_it = pt_manager.id_to_particletype.find(pt->step_particle_id);
-          if (step_pt_it != pt_manager.id_to_particletype.end()) {
-            generation_info gen_info;
-            gen_info.x = it->x;
-            gen_info.y = it->y;
-            gen_info.number = pt->step_number;
-            gen_info.pt = (*step_pt_it).second;
-            particles_to_generate.push_back(gen_info);
-          }
-        }
-      }
+  void particle_system::update_particlesystem()
+  {
+    begin_update();
+    std::vector<generation_info> particles_to_generate, step_generated;
+    // Life, shape, color, step and motion, all in one sweep.
+    const size_t dead = step_particles(0, pi_list.count(), particles_to_generate, step_generated);
+    finish_update(dead, particles_to_generate, step_generated);
+  }
+  void particle_system::begin_update()
+  {
+    // Increase wiggle.
+    wiggle += 1.0/wiggle_frequency;
+    if (wiggle > 1.0) {
+      wiggle -= 1.0;
     }
-    // Move particles.
+    // Increase subimage_index.
+    subimage_index++;
+    deleted_types.clear();
+  }
+  void particle_system::finish_update(size_t dead, std::vector<generation_info>& particles_to_generate, const std::vector<generation_info>& step_generated)
+  {
+    if (dead)
     {
-      std::vector<particle_instance>::iterator end = pi_list.end();
-      for (std::vector<particle_instance>::iterator it = pi_list.begin(); it !=end; it++)
-      {
-        particle_type* pt = it->pt;
-        if (pt->alive) {
-          it->speed += pt->speed_incr;
-          it->direction += pt->dir_incr;
-          if (it->speed < 0) {
-            it->speed = -it->speed;
-            it->direction += 180.0;
-          }
-          it->direction = fmod(it->direction, 360.0);
-          const double speed = it->speed, direction = it->direction;
-          const double grav_amount = pt->grav_amount, grav_dir = pt->grav_dir;
-          const double vx = speed*cos(direction*M_PI/180.0) + grav_amount*cos(grav_dir*M_PI/180.0);
-          const double vy = -(speed*sin(direction*M_PI/180.0) + grav_amount*sin(grav_dir*M_PI/180.0));
-          it->speed = sqrt(vx*vx + vy*vy);
-          it->direction = fzero(vx) && fzero(vy) ? direction : -atan2(vy,vx)*180.0/M_PI;
-        }
-        double speed = it->speed, direction = it->direction;
-        if (pt->alive) {
-          speed += pt->speed_wiggle*get_wiggle_result(it->speed_wiggle_offset);
-          direction += pt->dir_wiggle*get_wiggle_result(it->dir_wiggle_offset);
-        }
-        it->x += speed*cos(direction*M_PI/180.0);
-        it->y += -speed*sin(direction*M_PI/180.0);
-      }
+      // Death handling.
+      // Only the clean-up is made here.
+      for (size_t i = 0; i < pi_list.count(); i++)
+        if (pi_list.life_current[i] <= 0)
+          release_particle(pi_list.pt[i]);
+      pi_list.remove_dead();
     }
+    particles_to_generate.insert(particles_to_generate.end(), step_generated.begin(), step_generated.end());
     // Changers.
     {
+      region_grid.build(pi_list, id_to_changer.size());
       std::map<int,particle_changer*>::iterator end1 = id_to_changer.end();
       for (std::map<int,particle_changer*>::iterator ch_it = id_to_changer.begin(); ch_it != end1; ch_it++)
       {
@@ -310,35 +329,29 @@ namespace enigma
         pt1 = (*pt_it1).second;
         pt2 = (*pt_it2).second;
 
-        std::vector<particle_instance>::iterator end2 = pi_list.end();
-        for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != end2; it++)
+        region_grid.query(p_ch->xmin, p_ch->ymin, p_ch->xmax, p_ch->ymax, region_particles);
+        for (size_t k = 0; k < region_particles.size(); k++)
         {
-          if (p_ch->is_inside(it->x, it->y) && it->pt->id == pt1->id && it->life_current > 0) { // Skip particles with life_current <= 0.
-            // Store position of old particle.
-            const double x = it->x, y = it->y;
-            // Destroy the old particle.
-            // Only the clean-up is made here. The actual removal is handle after the loops by remove_if and erase.
-            pt1->particle_count--;
-            if (pt1->particle_count <= 0 && !pt1->alive) {
-              // Particle type is no longer used, delete it.
-              int pid = pt1->id;
-              delete pt1;
-              enigma::pt_manager.id_to_particletype.erase(pid);
-            }
+          const size_t i = region_particles[k];
+          if (p_ch->is_inside(pi_list.x[i], pi_list.y[i]) && pi_list.pt[i]->id == pt1->id && pi_list.life_current[i] > 0) { // Skip particles with life_current <= 0.
             // Internally when handling changers, setting life_current to 0 indicates that the particle has been removed.
-            it->life_current = 0;
+            pi_list.life_current[i] = 0;
             // Create a new particle at its position.
-            generation_info gen_info;
-            gen_info.x = x;
-            gen_info.y = y;
-            gen_info.number = 1;
-            gen_info.pt = pt2;
-            particles_to_generate.push_back(gen_info);
+            particles_to_generate.push_back(generation_info(pi_list.x[i], pi_list.y[i], 1, pt2));
+            // Destroy the old particle.
+            // Only the clean-up is made here. The actual removal is handled after the loops by remove_dead.
+            if (release_particle(pt1)) {
+              break; // That was the last particle of its type.
+            }
           }
         }
       }
       // Erase all particles with life_current <= 0.
-      pi_list.erase(std::remove_if(pi_list.begin(), pi_list.end(), is_dead_from_old_age), pi_list.end());
+      pi_list.remove_dead();
+    }
+    // Types deleted since stepping may have been picked up for generation before they were.
+    if (!deleted_types.empty()) {
+      drop_deleted_types(particles_to_generate, deleted_types);
     }
     // Generate particles.
     for (std::vector<generation_info>::iterator it = particles_to_generate.begin(); it != particles_to_generate.end(); it++)
@@ -369,25 +382,34 @@ namespace enigma
         }
       }
     }
+    // Attractors and destroyers share a grid. How far the attractors may have moved the
+    // particles since it was built widens the regions looked up.
+    region_grid.build(pi_list, id_to_attractor.size() + id_to_destroyer.size());
+    double moved = 0;
     // Attractors.
     {
       std::map<int,particle_attractor*>::iterator end = id_to_attractor.end();
       for (std::map<int,particle_attractor*>::iterator at_it = id_to_attractor.begin(); at_it != end; at_it++)
       {
         particle_attractor* p_a = (*at_it).second;
-        std::vector<particle_instance>::iterator end1 = pi_list.end();
-        for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != end1; it++)
+        const double reach = std::max(1.0, p_a->dist_effect) + moved;
+        region_grid.query(p_a->x - reach, p_a->y - reach, p_a->x + reach, p_a->y + reach, region_particles);
+        if (!p_a->additive) {
+          moved += fabs(p_a->force_strength);
+        }
+        for (size_t k = 0; k < region_particles.size(); k++)
         {
+          const size_t i = region_particles[k];
           // If the particle is not inside the attractor range of influence,
           // or is at the attractor's exact position,
           // skip to next attractor. 
-          const double dx = it->x - p_a->x;
-          const double dy = it->y - p_a->y;
+          const double dx = pi_list.x[i] - p_a->x;
+          const double dy = pi_list.y[i] - p_a->y;
           const double relative_distance = sqrt(dx*dx + dy*dy)/std::max(1.0, p_a->dist_effect);
           if (relative_distance > 1.0 || (fzero(dx) && fzero(dy))) {
             continue;
           }
-          const double direction_radians = atan2(-(p_a->y - it->y), p_a->x - it->x);
+          const double direction_radians = atan2(-(p_a->y - pi_list.y[i]), p_a->x - pi_list.x[i]);
           // Determine force.
           double force_effective_strength;
           switch (p_a->force_kind)  {
@@ -398,15 +420,16 @@ namespace enigma
           }
           // Apply force.
           if (p_a->additive) {
-            const double vx = it->speed*cos(it->direction*M_PI/180.0) + force_effective_strength*cos(direction_radians);
-            const double vy = -it->speed*sin(it->direction*M_PI/180.0) - force_effective_strength*sin(direction_radians);
-            it->speed = sqrt(vx*vx + vy*vy);
-            const double direction = it->direction;
-            it->direction = fzero(vx) && fzero(vy) ? direction : -atan2(vy,vx)*180.0/M_PI;
+            const double vx = pi_list.speed[i]*cos(pi_list.direction[i]*M_PI/180.0) + force_effective_strength*cos(direction_radians);
+            const double vy = -pi_list.speed[i]*sin(pi_list.direction[i]*M_PI/180.0) - force_effective_strength*sin(direction_radians);
+            pi_list.speed[i] = sqrt(vx*vx + vy*vy);
+            const double direction = pi_list.direction[i];
+            pi_list.direction[i] = fzero(vx) && fzero(vy) ? direction : -atan2(vy,vx)*180.0/M_PI;
+            pi_list.vx[i] = vx, pi_list.vy[i] = vy;
           }
           else {
-            it->x += force_effective_strength*cos(direction_radians);
-            it->y += -force_effective_strength*sin(direction_radians);
+            pi_list.x[i] += force_effective_strength*cos(direction_radians);
+            pi_list.y[i] += -force_effective_strength*sin(direction_radians);
           }
         }
       }
@@ -417,48 +440,46 @@ namespace enigma
       for (std::map<int,particle_destroyer*>::iterator ds_it = id_to_destroyer.begin(); ds_it != end1; ds_it++)
       {
         particle_destroyer* p_ds = (*ds_it).second;
-        std::vector<particle_instance>::iterator end2 = pi_list.end();
-        for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != end2; it++)
+        region_grid.query(p_ds->xmin - moved, p_ds->ymin - moved, p_ds->xmax + moved, p_ds->ymax + moved, region_particles);
+        for (size_t k = 0; k < region_particles.size(); k++)
         {
-          if (p_ds->is_inside(it->x, it->y) && it->life_current > 0) { // Skip particles with life_current <= 0.
-            particle_type* pt = it->pt;
-
+          const size_t i = region_particles[k];
+          if (p_ds->is_inside(pi_list.x[i], pi_list.y[i]) && pi_list.life_current[i] > 0) { // Skip particles with life_current <= 0.
             // Death handling.
-            // Only the clean-up is made here. The actual removal is handle after the loops by remove_if and erase.
-            pt->particle_count--;
-            if (pt->particle_count <= 0 && !pt->alive) {
-              // Particle type is no longer used, delete it.
-              int pid = pt->id;
-              delete pt;
-              enigma::pt_manager.id_to_particletype.erase(pid);
-            }
+            // Only the clean-up is made here. The actual removal is handled after the loops by remove_dead.
+            release_particle(pi_list.pt[i]);
             // Internally when handling destroyers, setting life_current to 0 indicates that the particle has been removed.
-            it->life_current = 0;
+            pi_list.life_current[i] = 0;
           }
         }
       }
       // Erase all particles with life_current <= 0.
-      pi_list.erase(std::remove_if(pi_list.begin(), pi_list.end(), is_dead_from_old_age), pi_list.end());
+      pi_list.remove_dead();
     }
     // Deflectors.
     {
+      // Each deflector moves the particles it slows down by at most its friction.
+      region_grid.build(pi_list, id_to_deflector.size());
+      moved = 0;
       std::map<int,particle_deflector*>::iterator end = id_to_deflector.end();
       for (std::map<int,particle_deflector*>::iterator df_it = id_to_deflector.begin(); df_it != end; df_it++)
       {
         particle_deflector* p_df = (*df_it).second;
-        std::vector<particle_instance>::iterator end2 = pi_list.end();
-        for (std::vector<particle_instance>::iterator it = pi_list.begin(); it != end2; it++)
+        region_grid.query(p_df->xmin - moved, p_df->ymin - moved, p_df->xmax + moved, p_df->ymax + moved, region_particles);
+        moved += fabs(p_df->friction);
+        for (size_t k = 0; k < region_particles.size(); k++)
         {
-          if (p_df->is_inside(it->x, it->y)) {
+          const size_t i = region_particles[k];
+          if (p_df->is_inside(pi_list.x[i], pi_list.y[i])) {
             // Direction changing.
-            it->direction = fmod(it->direction + 360.0, 360.0);
+            pi_list.direction[i] = fmod(pi_list.direction[i] + 360.0, 360.0);
             switch (p_df->deflection_kind) {
             case ps_de_horizontal : {
-              it->direction = it->direction <= 180.0 ? 180.0 - it->direction : 540.0 - it->direction;
+              pi_list.direction[i] = pi_list.direction[i] <= 180.0 ? 180.0 - pi_list.direction[i] : 540.0 - pi_list.direction[i];
               break;
             }
             case ps_de_vertical : {
-              it->direction = 360.0 - it->direction;
+              pi_list.direction[i] = 360.0 - pi_list.direction[i];
               break;
             }
             default : {
@@ -466,12 +487,13 @@ namespace enigma
             }
             }
             // Friction handling.
-            const double new_speed = std::max(0.0, it->speed - p_df->friction);
-            const double friction_effect = it->speed - new_speed;
-            it->speed = new_speed;
+            const double new_speed = std::max(0.0, pi_list.speed[i] - p_df->friction);
+            const double friction_effect = pi_list.speed[i] - new_speed;
+            pi_list.speed[i] = new_speed;
+            pi_list.set_motion(i);
             // Move one step.
-            it->x += friction_effect*cos(it->direction*M_PI/180.0);
-            it->y += -friction_effect*sin(it->direction*M_PI/180.0);
+            pi_list.x[i] += friction_effect*cos(pi_list.direction[i]*M_PI/180.0);
+            pi_list.y[i] += -friction_effect*sin(pi_list.direction[i]*M_PI/180.0);
           }
         }
       }
@@ -573,6 +595,10 @@ namespace enigma
       pi.direction = pt->dir_min + (pt->dir_max-pt->dir_min)*1.0*rand()/(RAND_MAX-1);
       pi.speed_wiggle_offset = 1.0*rand()/(RAND_MAX-1);
       pi.dir_wiggle_offset = 1.0*rand()/(RAND_MAX-1);
+      if (pi.speed < 0) { // Keep speed positive, as updating the particle would anyway
+        pi.speed = -pi.speed;
+        pi.direction += 180.0;
+      }
       pi_list.push_back(pi);
     }
   }
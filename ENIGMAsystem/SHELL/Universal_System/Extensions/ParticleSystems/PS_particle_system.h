@@ -48,9 +48,19 @@ namespace enigma
     // Initialization
     void initialize_particle_bridge();
     // Drawing
-    void draw_particles(std::vector<particle_instance>& pi_list, bool oldtonew, double wiggle, int subimage_index,
+    void draw_particles(particle_store& pi_list, bool oldtonew, double wiggle, int subimage_index,
         double x_offset, double y_offset);
   }
+
+  // Particles to be created once the update of the existing ones is done.
+  struct generation_info
+  {
+    double x;
+    double y;
+    int number;
+    particle_type* pt;
+    generation_info(double x, double y, int number, particle_type* pt): x(x), y(y), number(number), pt(pt) {}
+  };
   
   struct particle_system
   {
@@ -66,10 +76,20 @@ namespace enigma
     bool oldtonew;
     double x_offset, y_offset;
     double depth; // Integer stored as double.
-    std::vector<particle_instance> pi_list;
+    particle_store pi_list;
     bool auto_update, auto_draw;
     void initialize();
     void update_particlesystem();
+    // An update in three parts, so that the particles of many systems can be stepped at once.
+    // The first and last parts run on the game thread; step_particles only reads and writes
+    // the particles in its range, so disjoint ranges can be stepped on different threads.
+    void begin_update();
+    // Ages, reshapes, recolors and moves the particles from first up to last, returning how
+    // many died of old age. Those that spawn particles as they die or step add them to the lists.
+    size_t step_particles(size_t first, size_t last, std::vector<generation_info>& deaths, std::vector<generation_info>& steps);
+    // Clears away the dead, spawns the particles the stepped ones asked for, and applies the
+    // changers, emitters, attractors, destroyers and deflectors.
+    void finish_update(size_t dead, std::vector<generation_info>& deaths, const std::vector<generation_info>& steps);
     void draw_particlesystem();
     void create_particles(double x, double y, particle_type* pt, int number, bool use_color=false, int given_color=c_white);
     // Emitters.
@@ -32,17 +32,94 @@
 #include "PS_particle.h"
 #include "Graphics_Systems/graphics_mandatory.h"
 #include "Universal_System/callbacks_events.h"
+#include "Platforms/General/PFthreads.h"
+#include <algorithm>
 
 namespace enigma
 {
+  // A range of one system's particles, stepped as a unit.
+  struct particle_chunk
+  {
+    particle_system* ps;
+    size_t first, last;
+    size_t dead;
+    std::vector<generation_info> deaths, steps;
+    void step() { dead = ps->step_particles(first, last, deaths, steps); }
+  };
+
+  struct particle_chunk_job: pool_job
+  {
+    particle_chunk* chunk;
+    void run(unsigned) { chunk->step(); }
+    particle_chunk_job(particle_chunk* chunk): chunk(chunk) {}
+  };
+
+  // Big enough that handing a chunk to a worker costs little next to stepping it.
+  static const size_t particle_chunk_size = 4096;
+  static std::vector<particle_chunk> particle_chunks; // Kept from step to step for the capacity of the lists
+
+  static void step_particle_chunks(size_t count, size_t total)
+  {
+    if (total < 2*particle_chunk_size || !thread_pool_size()) {
+      for (size_t i = 0; i < count; i++)
+        particle_chunks[i].step();
+      return;
+    }
+
+    // The game thread steps the first chunk itself, then any the workers have yet to start.
+    std::vector<pool_job*> jobs;
+    jobs.reserve(count - 1);
+    for (size_t i = 1; i < count; i++) {
+      jobs.push_back(new particle_chunk_job(&particle_chunks[i]));
+      thread_pool_submit(jobs.back());
+    }
+    particle_chunks[0].step();
+    for (size_t i = jobs.size(); i-- > 0; )
+      if (thread_pool_cancel(jobs[i]))
+        static_cast<particle_chunk_job*>(jobs[i])->chunk->step();
+    for (size_t left = jobs.size(); left > 0; ) {
+      const size_t i = thread_pool_wait_any(&jobs[0], left);
+      jobs[i] = jobs[--left];
+    }
+  }
+
   static void internal_update_particlesystems()
   {
+    // Split the particles of every system to update into chunks.
+    size_t count = 0, total = 0;
     std::map<int,particle_system*>::iterator end = ps_manager.id_to_particlesystem.end();
     for (std::map<int,particle_system*>::iterator it = ps_manager.id_to_particlesystem.begin(); it != end; it++)
     {
-      if ((*it).second->auto_update) {
-        (*it).second->update_particlesystem();
+      particle_system* ps = (*it).second;
+      if (!ps->auto_update) continue;
+      ps->begin_update();
+      const size_t n = ps->pi_list.count();
+      size_t first = 0;
+      do {
+        if (count == particle_chunks.size())
+          particle_chunks.push_back(particle_chunk());
+        particle_chunk& c = particle_chunks[count++];
+        c.ps = ps, c.first = first, c.last = std::min(n, first + particle_chunk_size);
+        c.deaths.clear(), c.steps.clear();
+        first = c.last;
+      } while (first < n);
+      total += n;
+    }
+
+    step_particle_chunks(count, total);
+
+    // Stepping draws no random numbers, and each system's chunks are merged in order, so the
+    // systems finish exactly as they would have stepped alone, however the chunks were shared out.
+    for (size_t i = 0, j; i < count; i = j)
+    {
+      particle_chunk& c = particle_chunks[i];
+      size_t dead = c.dead;
+      for (j = i + 1; j < count && particle_chunks[j].ps == c.ps; j++) {
+        dead += particle_chunks[j].dead;
+        c.deaths.insert(c.deaths.end(), particle_chunks[j].deaths.begin(), particle_chunks[j].deaths.end());
+        c.steps.insert(c.steps.end(), particle_chunks[j].steps.begin(), particle_chunks[j].steps.end());
       }
+      c.ps->finish_update(dead, c.deaths, c.steps);
     }
   }
 
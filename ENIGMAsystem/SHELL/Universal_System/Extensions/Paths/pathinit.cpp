@@ -36,42 +36,42 @@
 
 namespace enigma
 {
-  void exe_loadpaths(FILE *exe)
+  void exe_loadpaths(resource_reader &exe)
   {
     unsigned pathid, pointcount;
     bool smooth, closed;
     int x, y, speed, nullhere, precision;
 
-    if (!fread(&nullhere,4,1,exe)) return;
+    if (!exe.read(&nullhere,4)) return;
     if (nullhere != *(int*)"PTH ")
       return;
 
     // Determine how many paths we have
     int pathcount;
-    if (!fread(&pathcount,4,1,exe)) return;
+    if (!exe.read(&pathcount,4)) return;
 
     // Fetch the highest ID we will be using
     int path_highid, buf;
-    if (!fread(&path_highid,4,1,exe)) return;
+    if (!exe.read(&path_highid,4)) return;
     paths_init();
 
     for (int i = 0; i < pathcount; i++)
     {
-      if (!fread(&pathid, 4,1,exe)) return;
-      if (!fread(&buf, 4,1,exe)) return;
+      if (!exe.read(&pathid,4)) return;
+      if (!exe.read(&buf,4)) return;
       smooth = buf; //to fix int to bool issues
-      if (!fread(&buf, 4,1,exe)) return;
+      if (!exe.read(&buf,4)) return;
       closed = buf;
-      if (!fread(&precision, 4,1,exe)) return;
+      if (!exe.read(&precision,4)) return;
 
-      if (!fread(&pointcount,4,1,exe)) return;
+      if (!exe.read(&pointcount,4)) return;
 
       new path(pathid, smooth, closed, precision, pointcount);
       for (unsigned ii=0;ii<pointcount;ii++)
       {
-        if (!fread(&x, 4,1,exe)) return;
-        if (!fread(&y, 4,1,exe)) return;
-        if (!fread(&speed, 4,1,exe)) return;
+        if (!exe.read(&x,4)) return;
+        if (!exe.read(&y,4)) return;
+        if (!exe.read(&speed,4)) return;
         path_add_point(pathid, x, y, speed/100);
       }
       path_recalculate(pathid);
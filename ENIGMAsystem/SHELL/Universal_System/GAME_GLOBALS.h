@@ -32,6 +32,9 @@ GM Global variables
 #ifndef __GAME_GLOBALS_H
 #define __GAME_GLOBALS_H
 
+// Only SHELLmain.cpp defines these; the game's other sources see them declared at the bottom.
+#ifdef SHELLMAIN_DEFINITIONS
+
 bool argument_relative=false;
 
 namespace enigma_user {
@@ -90,6 +93,28 @@ int cursor_sprite;
 extern int room_first, room_last;
 }
 
+#else
+
+extern bool argument_relative;
+#include <deque>
+extern std::deque<int> instance_id;
+
+namespace enigma_user {
+  extern string caption_score, caption_lives, caption_health;
+  extern double fps, health, score;
+  extern int keyboard_key;
+  extern string keyboard_string;
+  extern bool secure_mode;
+  extern bool show_score, show_lives, show_health;
+  extern int transition_kind, transition_steps;
+  extern bool automatic_redraw;
+  extern int gamemaker_version;
+  extern int cursor_sprite;
+  extern int room_first, room_last;
+}
+
+#endif
+
 /*********************
 End GM global variables
  *********************/
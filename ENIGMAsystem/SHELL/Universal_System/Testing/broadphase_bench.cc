@@ -0,0 +1,112 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Frame time of place_meeting with the collision broadphase, against the linear scan.
+// Each frame, every instance moves in its step event, one in sixteen also shoves another
+// instance aside (as `other.x += 40' would), and then every instance calls place_meeting.
+// Both modes run the same frames from the same start, and must report the same collisions.
+////////////////////////////////////
+
+#include <cmath>
+#include <vector>
+
+#include "Universal_System/callbacks_events.h"
+#include "Collision_Systems/General/CSbroadphase.h"
+#include "Collision_Systems/General/CSfuncs.h"
+#include "harness.h"
+
+namespace
+{
+  const int obj_bullet = 0, spr_bullet = 0;
+  int room_size, frame;
+  unsigned first_id;
+  std::vector<double> start_x, start_y;
+  std::vector<harness::instance*> bullets;
+  long hits;
+
+  void step(harness::instance *self)
+  {
+    const unsigned n = self->id - first_id;
+    self->x += int(n % 7) - 3;
+    self->y += int(n / 7 % 7) - 3;
+    if (self->x < 0) self->x += room_size;
+    if (self->x >= room_size) self->x -= room_size;
+    if (self->y < 0) self->y += room_size;
+    if (self->y >= room_size) self->y -= room_size;
+
+    if (n % 16 == 0) {
+      harness::instance *const other = bullets[(n * 2654435761u + frame) % bullets.size()];
+      enigma::fetch_instance_by_int(other->id); // As glaccess does
+      other->x = fmod(other->x + 40, room_size);
+    }
+  }
+
+  void collide(harness::instance *self) {
+    hits += enigma_user::place_meeting(self->x, self->y, obj_bullet);
+  }
+
+  // Returns the mean time per frame, in milliseconds.
+  double run(int count, int frames, bool broadphase, long *total_hits)
+  {
+    bullets.clear();
+    first_id = enigma::maxid;
+    for (int i = 0; i < count; i++)
+      bullets.push_back(new harness::instance(obj_bullet, start_x[i], start_y[i], spr_bullet));
+    enigma_user::collision_broadphase_enable(broadphase, 32);
+
+    hits = 0;
+    const double start = harness::seconds();
+    for (frame = 0; frame < frames; frame++) {
+      enigma::perform_callbacks_async_update();
+      harness::each(obj_bullet, step);
+      harness::each(obj_bullet, collide);
+    }
+    const double elapsed = harness::seconds() - start;
+
+    *total_hits = hits;
+    harness::clear();
+    enigma::perform_callbacks_clean_up_roomend();
+    return elapsed * 1000 / frames;
+  }
+}
+
+int main()
+{
+  harness::init(1, 1);
+  harness::sprite(spr_bullet, 16, 16);
+
+  const int counts[] = { 1000, 10000, 50000 };
+  printf("%10s %8s %14s %14s %9s\n", "instances", "frames", "linear ms", "broadphase ms", "speedup");
+  for (int c = 0; c < 3; c++)
+  {
+    const int count = counts[c];
+    room_size = int(sqrt(double(count)) * 32);
+    const int frames = std::max(1, int(2e8 / (double(count) * count)));
+    start_x.resize(count), start_y.resize(count);
+    for (int i = 0; i < count; i++)
+      start_x[i] = harness::random(room_size), start_y[i] = harness::random(room_size);
+
+    long linear_hits, hash_hits;
+    const double linear = run(count, frames, false, &linear_hits);
+    const double hashed = run(count, frames, true, &hash_hits);
+    printf("%10d %8d %14.3f %14.3f %8.1fx\n", count, frames, linear, hashed, linear / hashed);
+    HARNESS_CHECK(linear_hits == hash_hits, "%d instances: linear scan found %ld collisions, broadphase %ld",
+                  count, linear_hits, hash_hits);
+  }
+  return harness::failures != 0;
+}
@@ -0,0 +1,153 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Collision events with prepared candidates must fire exactly the events that testing
+// every instance would, in the same order, while the events move, create and destroy
+// instances on both sides. Also checks the batched pair search against a plain n*m test.
+////////////////////////////////////
+
+#include <vector>
+#include <utility>
+
+#include "harness.h"
+#include "Collision_Systems/collision_mandatory.h"
+#include "Collision_Systems/General/CSbatch.h"
+
+namespace
+{
+  const int obj_player = 0, obj_wall = 1, spr_block = 0;
+  const int room_size = 640;
+  const int collision_event_pairs[][2] = { { obj_player, obj_wall } };
+
+  std::vector<std::pair<unsigned, unsigned> > events;
+  unsigned first_id;
+
+  // What the event does depends only on the instances, so both runs behave alike.
+  void collision_event(harness::instance *self, harness::instance *other)
+  {
+    const unsigned s = self->id - first_id, o = other->id - first_id;
+    events.push_back(std::make_pair(s, o));
+    switch ((s * 7 + o) % 6)
+    {
+      case 0: // Put back where it was, as with a solid, then jump well clear of it
+        self->x = self->xprevious, self->y = self->yprevious;
+        self->x = int(self->x + 97) % room_size;
+        break;
+      case 1: // Shove the other into the path of later instances (other.x += 64)
+        enigma::fetch_instance_by_int(other->id); // As glaccess does
+        other->x = int(other->x + 64) % room_size;
+        break;
+      case 2:
+        if (o % 5 == 0) { // with (other) instance_destroy()
+          enigma::fetch_instance_by_int(other->id); // As glaccess does
+          other->unlink();
+        }
+        break;
+      case 3:
+        if (s % 4 == 0) // A new wall, where the next players will run into it
+          new harness::instance(obj_wall, int(self->x + 24) % room_size, self->y, spr_block);
+        break;
+    }
+  }
+
+  // The generated collision event loop, as events.res writes it.
+  void collide(harness::instance *self)
+  {
+    for (enigma::collision_event_candidates it(obj_wall); it; ++it) {
+      enigma::instance_other = *it;
+      if (enigma::place_meeting_inst(self->x, self->y, enigma::instance_other->id))
+        collision_event(self, (harness::instance*)enigma::instance_other);
+    }
+  }
+
+  void spawn(unsigned seed)
+  {
+    first_id = enigma::maxid;
+    for (int i = 0; i < 300; i++) {
+      const double x = (seed + i * 7919u) % room_size, y = (seed + i * 104729u) % 96;
+      harness::instance *const p = new harness::instance(obj_player, x, y, spr_block);
+      p->xprevious = x - 3, p->yprevious = y;
+    }
+    for (int i = 0; i < 300; i++)
+      new harness::instance(obj_wall, (seed * 3 + i * 6271u) % room_size, (seed + i * 3571u) % 96, spr_block);
+  }
+
+  std::vector<std::pair<unsigned, unsigned> > run(unsigned seed, bool prepared)
+  {
+    events.clear();
+    spawn(seed);
+    for (int step = 0; step < 3; step++) {
+      if (prepared)
+        enigma::collision_events_prepare(collision_event_pairs, 1);
+      harness::each(obj_player, collide);
+      enigma::collision_events_finish();
+      enigma::dispose_destroyed_instances();
+    }
+    harness::clear();
+    return events;
+  }
+
+  void check_pairs()
+  {
+    for (unsigned seed = 1; seed <= 20; seed++)
+    {
+      std::vector<harness::instance*> made;
+      for (int i = 0; i < 200; i++)
+        made.push_back(new harness::instance(i % 2, (seed * 131 + i * 7919u) % 400, (seed * 17 + i * 3571u) % 200, spr_block));
+      for (int i = 0; i < 200; i += 9) // Some the same size, some larger, some spriteless
+        made[i]->image_xscale = 1 + i % 4, made[i]->sprite_index = i % 27 ? spr_block : -1;
+
+      std::vector<enigma::collision_pair> swept, plain;
+      enigma::collision_bbox_pairs(obj_player, obj_wall, swept);
+      enigma::collision_bbox_pairs(obj_player, obj_player, swept);
+      for (int a = 0; a < 2; a++)
+        for (size_t i = 0; i < made.size(); i++)
+          for (size_t j = 0; j < made.size(); j++) {
+            enigma::object_collisions *const p = made[i], *const q = made[j];
+            if (p->object_index != obj_player || q->object_index != (a ? obj_player : obj_wall) || p == q
+            ||  p->sprite_index == -1 || q->sprite_index == -1)
+              continue;
+            if (p->$bbox_left() <= q->$bbox_right() && q->$bbox_left() <= p->$bbox_right()
+            &&  p->$bbox_top() <= q->$bbox_bottom() && q->$bbox_top() <= p->$bbox_bottom())
+              plain.push_back(enigma::collision_pair(p, q));
+          }
+      HARNESS_CHECK(swept == plain, "seed %u: the sweep found %u pairs, the plain test %u",
+                    seed, unsigned(swept.size()), unsigned(plain.size()));
+      harness::clear();
+    }
+  }
+}
+
+int main()
+{
+  harness::init(2, 1);
+  harness::sprite(spr_block, 16, 16);
+
+  check_pairs();
+
+  for (unsigned seed = 1; seed <= 20; seed++)
+  {
+    const std::vector<std::pair<unsigned, unsigned> > live = run(seed, false), prepared = run(seed, true);
+    size_t same = 0;
+    while (same < live.size() && same < prepared.size() && live[same] == prepared[same])
+      same++;
+    HARNESS_CHECK(live == prepared, "seed %u: %u events testing every instance, %u with candidates; first difference at %u",
+                  seed, unsigned(live.size()), unsigned(prepared.size()), unsigned(same));
+  }
+  return harness::failures != 0;
+}
@@ -0,0 +1,141 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <time.h>
+
+#include "Universal_System/instance_system.h"
+#include "Universal_System/spritestruct.h"
+#include "Universal_System/instance.h"
+#include "Graphics_Systems/graphics_mandatory.h"
+#include "Widget_Systems/widgets_mandatory.h"
+#include "Collision_Systems/collision_mandatory.h"
+#include "harness.h"
+
+using std::string;
+
+// What a compiled game, and the systems not linked here, would define.
+std::deque<int> instance_id;
+const int variant::default_type = -1;
+void show_error(string msg, const bool fatal) { printf("show_error: %s\n", msg.c_str()); }
+namespace enigma
+{
+  int maxid = 100001, objectcount = 0, object_idmax = 0, obj_idmax = 0;
+  size_t sprite_idmax = 0;
+  objectstruct objs[1];
+  object_basic *ENIGMA_global_instance = NULL;
+  void instance_change_inst(int obj, bool perf, object_graphics* inst) {}
+
+  int graphics_create_texture(unsigned, unsigned, unsigned, unsigned, void*, bool) { return 0; }
+  int graphics_duplicate_texture(int) { return 0; }
+  void graphics_replace_texture_alpha_from_texture(int, int) {}
+  void graphics_delete_texture(int) {}
+  unsigned char* graphics_get_texture_pixeldata(unsigned, unsigned*, unsigned*) { return NULL; }
+  size_t path_idmax = 0;
+}
+namespace enigma_user
+{
+  // Drawing, which the motion planning and path extensions use to draw themselves.
+  int merge_color(int, int, double) { return 0; }
+  void draw_set_color(int) {}
+  void draw_set_color_rgba(unsigned char, unsigned char, unsigned char, float) {}
+  int draw_get_color() { return 0; }
+  void draw_primitive_begin(int) {}
+  void draw_primitive_end() {}
+  void draw_vertex(float, float) {}
+  void draw_vertex_color(float, float, int, float) {}
+  void draw_spline_begin(int) {}
+  void draw_spline_vertex(float, float) {}
+  void draw_bezier_quadratic_spline_end() {}
+  void draw_text(float, float, variant) {}
+}
+
+namespace harness
+{
+  int failures = 0;
+
+  void init(int object_count, int sprite_count)
+  {
+    enigma::objects = new enigma::objectid_base[object_count];
+    enigma::objectcount = enigma::object_idmax = object_count;
+    enigma::sprite_idmax = sprite_count;
+    enigma::sprites_init();
+  }
+
+  void sprite(int id, int w, int h, int xorig, int yorig, const unsigned char *mask)
+  {
+    enigma::sprite_new_empty(id, 1, w, h, xorig, yorig, 0, h - 1, 0, w - 1, false, false);
+    enigma::sprite *const spr = enigma::spritestructarray[id];
+    if (!mask) {
+      spr->colldata.push_back(enigma::get_collision_mask(spr, NULL, enigma::ct_bbox));
+      return;
+    }
+    std::vector<unsigned char> rgba(4 * w * h, 0);
+    for (int i = 0; i < w * h; i++)
+      rgba[4 * i + 3] = mask[i] ? 255 : 0;
+    spr->colldata.push_back(enigma::get_collision_mask(spr, &rgba[0], enigma::ct_precise));
+  }
+
+  instance::instance(int object, double x, double y, int sprite):
+    enigma::object_collisions(enigma::maxid++, object)
+  {
+    this->x = x, this->y = y;
+    sprite_index = sprite, mask_index = -1;
+    image_xscale = image_yscale = 1, image_angle = 0;
+    solid = false;
+    me = enigma::link_instance(this);
+    myobj = enigma::link_obj_instance(this, object);
+    enigma::instancecount++;
+    enigma_user::instance_count++;
+  }
+
+  void instance::unlink()
+  {
+    enigma::instance_iter_queue_for_destroy(me);
+    enigma::unlink_main(me);
+    enigma::unlink_object_id_iter(myobj, object_index);
+  }
+
+  instance::~instance()
+  {
+    enigma::winstance_list_iterator_delete(me);
+    delete myobj;
+  }
+
+  void clear()
+  {
+    while (!enigma::instance_list.empty())
+      enigma::instance_list.begin()->second->inst->unlink();
+    enigma::dispose_destroyed_instances();
+  }
+
+  double seconds()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+  }
+
+  unsigned random(unsigned n)
+  {
+    static unsigned long long state = 88172645463325252ULL;
+    state ^= state << 13, state ^= state >> 7, state ^= state << 17;
+    return unsigned(state % n);
+  }
+}
@@ -0,0 +1,70 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Test harness - just enough of a game for the standalone tests and benchmarks in this
+// directory, which link the engine's sources directly. Objects are bare instances of
+// object_collisions, linked into the instance lists the way compiled objects link themselves.
+////////////////////////////////////
+
+#ifndef _ENIGMA_TESTING_HARNESS__H
+#define _ENIGMA_TESTING_HARNESS__H
+
+#include "Universal_System/collisions_object.h"
+#include "Universal_System/instance_system_base.h"
+#include "Universal_System/instance_system_frontend.h"
+#include <cstdio>
+
+namespace harness
+{
+  // Sets up room for this many objects and sprites; ids start at zero.
+  void init(int object_count, int sprite_count);
+
+  // Adds a sprite with the given size and origin, whose bounding box is all of it. If a mask
+  // is given, one byte per pixel, the sprite gets a precise collision mask built from it.
+  void sprite(int id, int w, int h, int xorig = 0, int yorig = 0, const unsigned char *mask = NULL);
+
+  struct instance: enigma::object_collisions
+  {
+    enigma::pinstance_list_iterator me;
+    enigma::inst_iter *myobj;
+
+    instance(int object, double x, double y, int sprite);
+    void unlink();
+    ~instance();
+  };
+
+  // Runs `step' for each instance of `object', the way a compiled event loop does.
+  template<typename F> void each(int object, F step) {
+    for (enigma::instance_event_iterator = enigma::objects[object].next;
+         enigma::instance_event_iterator != NULL;
+         enigma::instance_event_iterator = enigma::instance_event_iterator->next)
+      step((instance*)enigma::instance_event_iterator->inst);
+  }
+
+  // Destroys every instance and frees it, as at the end of a room.
+  void clear();
+
+  double seconds(); // Monotonic clock
+  unsigned random(unsigned n); // Deterministic; [0, n)
+
+  extern int failures;
+  #define HARNESS_CHECK(cond, ...) \
+    do { if (!(cond)) { ++harness::failures; printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); putchar('\n'); } } while (0)
+}
+
+#endif
@@ -0,0 +1,131 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// mp_grid_add_instances must mark exactly the cells for which collision_rectangle over
+// the cell finds an instance, as it did when it called collision_rectangle per cell.
+// Covers precise and bounding box tests, scaled, mirrored, rotated, masked and spriteless
+// instances, and grids at several origins and cell sizes. Run under each collision system.
+////////////////////////////////////
+
+#include <vector>
+
+#include "harness.h"
+#include "Collision_Systems/General/CSfuncs.h"
+#include "Universal_System/Extensions/MotionPlanning/motion_planning.h"
+
+using enigma_user::mp_grid_create;
+using enigma_user::mp_grid_add_instances;
+using enigma_user::mp_grid_get_cell;
+using enigma_user::mp_grid_destroy;
+
+namespace
+{
+  const int obj_wall = 0, obj_rock = 1;
+  const int spr_block = 0, spr_ring = 1, spr_sliver = 2;
+  const int noone = -4;
+  const unsigned blocked = 7; // Cells start out costing 1
+
+  // What mp_grid_add_instances used to do.
+  void add_per_cell(int left, int top, int hcells, int vcells, int cw, int ch, int obj, bool prec, std::vector<bool> &out)
+  {
+    out.assign(hcells * vcells, false);
+    for (int i = 0; i < hcells; i++)
+      for (int c = 0; c < vcells; c++)
+        out[i * vcells + c] = enigma_user::collision_rectangle(left + i * cw, top + c * ch, left + (i + 1) * cw,
+                                                               top + (c + 1) * ch, obj, prec, false) != noone;
+  }
+
+  void make_sprites()
+  {
+    harness::sprite(spr_block, 16, 16);
+
+    // A ring, hollow in the middle and empty in the corners, so the precise test matters.
+    unsigned char ring[24 * 24];
+    for (int y = 0; y < 24; y++)
+      for (int x = 0; x < 24; x++) {
+        const int dx = 2 * x - 23, dy = 2 * y - 23, rr = dx * dx + dy * dy;
+        ring[y * 24 + x] = rr <= 23 * 23 && rr >= 12 * 12;
+      }
+    harness::sprite(spr_ring, 24, 24, 12, 12, ring);
+
+    // A diagonal line, off center.
+    unsigned char sliver[30 * 6] = { 0 };
+    for (int x = 0; x < 30; x++)
+      sliver[(x / 5) * 30 + x] = 1;
+    harness::sprite(spr_sliver, 30, 6, 3, 5, sliver);
+  }
+
+  void spawn()
+  {
+    for (int i = 0; i < 600; i++)
+    {
+      const int object = i % 3 ? obj_wall : obj_rock;
+      const double x = int(harness::random(900)) - 150 + harness::random(4) * .25;
+      const double y = int(harness::random(700)) - 120 + harness::random(4) * .25;
+      harness::instance *const inst = new harness::instance(object, x, y, spr_block + i % 3);
+      switch (i % 7) {
+        case 1: inst->image_xscale = 2.5, inst->image_yscale = .5; break;
+        case 2: inst->image_xscale = -1.5; break; // Mirrored
+        case 3: inst->image_angle = harness::random(360); break;
+        case 4: inst->image_angle = 45, inst->image_xscale = 1.75, inst->image_yscale = -1; break;
+        case 5: inst->sprite_index = -1; break; // No sprite, no mask: never collides
+        case 6: inst->sprite_index = -1, inst->mask_index = spr_ring; break; // Mask only
+      }
+    }
+  }
+}
+
+int main()
+{
+  harness::init(2, 3);
+  make_sprites();
+  spawn();
+
+  struct { int left, top, cw, ch; } grids[] = {
+    { 0, 0, 16, 16 }, { -37, -11, 16, 16 }, { 13, 5, 7, 13 }, { -200, 40, 32, 8 }, { 3, -150, 1, 1 }, { 0, 0, 0, 10 }
+  };
+  const int objects[] = { obj_wall, obj_rock, enigma_user::all };
+
+  int checked = 0, marked = 0;
+  for (size_t g = 0; g < sizeof grids / sizeof *grids; g++)
+    for (int o = 0; o < 3; o++)
+      for (int prec = 0; prec < 2; prec++)
+      {
+        const int cw = grids[g].cw, ch = grids[g].ch;
+        const int hcells = cw > 1 ? 700 / cw : 90, vcells = ch > 1 ? 500 / ch : 90;
+        const unsigned grid = mp_grid_create(grids[g].left, grids[g].top, hcells, vcells, cw, ch);
+        mp_grid_add_instances(grid, objects[o], prec, blocked);
+
+        std::vector<bool> expected;
+        add_per_cell(grids[g].left, grids[g].top, hcells, vcells, cw, ch, objects[o], prec, expected);
+        int wrong = 0, first = -1;
+        for (int i = 0; i < hcells; i++)
+          for (int c = 0; c < vcells; c++)
+            if ((mp_grid_get_cell(grid, i, c) == blocked) != expected[i * vcells + c]) {
+              if (!wrong++) first = i * vcells + c;
+            } else marked += expected[i * vcells + c];
+        checked += hcells * vcells;
+        HARNESS_CHECK(wrong == 0, "grid at (%d, %d) with %dx%d cells, object %d, prec %d: %d cells differ, first (%d, %d)",
+                      grids[g].left, grids[g].top, cw, ch, objects[o], prec, wrong, first / vcells, first % vcells);
+        mp_grid_destroy(grid);
+      }
+
+  printf("%d cells checked, %d marked\n", checked, marked);
+  harness::clear();
+  return harness::failures != 0;
+}
@@ -0,0 +1,147 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// mp_grid's searches on a fixed grid of walls, blocks and a closed room: jump point search must
+// find a path wherever A* does, and one which costs the same; the cluster hierarchy may
+// give up, but any path it finds must cost no more than its bound over A*'s. Every path
+// must step only between open neighbors, without cutting corners.
+////////////////////////////////////
+
+#include <vector>
+
+#include "harness.h"
+#include "Universal_System/Extensions/MotionPlanning/motion_planning.h"
+#include "Universal_System/Extensions/MotionPlanning/motion_planning_struct.h"
+
+using enigma_user::mp_grid_create;
+using enigma_user::mp_grid_add_cell;
+using enigma_user::mp_grid_add_rectangle;
+using enigma_user::mp_grid_set_hierarchy;
+using enigma_user::mp_grid_destroy;
+
+namespace
+{
+  const int side = 96, cell = 16, cluster = 12;
+  const unsigned blocked = 50000; // Open cells cost 1
+
+  // How much a path through the hierarchy may cost: an eighth more than the best, plus a
+  // cluster's side for the detour to an entrance.
+  unsigned hierarchy_bound(unsigned best) {
+    return best + best / 8 + cluster;
+  }
+
+  // The cost of a path from n0 through the cells between to n1, or 0 if it takes a step
+  // that isn't to an open neighbor, or cuts a corner.
+  unsigned path_cost(enigma::grid *gr, enigma::node *n0, const std::vector<enigma::node*> &between, enigma::node *n1, bool allow_diag)
+  {
+    std::vector<enigma::node*> path(1, n0);
+    path.insert(path.end(), between.begin(), between.end());
+    path.push_back(n1);
+    unsigned cost = 0;
+    for (size_t i = 1; i < path.size(); i++) {
+      const enigma::node *a = path[i - 1], *b = path[i];
+      const int dx = int(b->x) - int(a->x), dy = int(b->y) - int(a->y);
+      if (!gr->open(b->x, b->y) || dx < -1 || dx > 1 || dy < -1 || dy > 1 || (!dx && !dy))
+        return 0;
+      if (dx && dy && (!allow_diag || enigma::cuts_corner(gr, a, b)))
+        return 0;
+      cost += enigma::move_cost(a, b);
+    }
+    return cost;
+  }
+
+  void build_walls(unsigned grid)
+  {
+    // Walls across the grid, each with a gap, so that paths have to wind between them
+    for (int w = 0; w < 7; w++) {
+      const int at = 6 + w * 13, gap = harness::random(side - 6);
+      mp_grid_add_rectangle(grid, at * cell, 0, at * cell + cell - 1, gap * cell - 1, blocked);
+      mp_grid_add_rectangle(grid, at * cell, (gap + 6) * cell, at * cell + cell - 1, side * cell - 1, blocked);
+    }
+    // Scattered blocks and single cells
+    for (int b = 0; b < 40; b++) {
+      const int x = harness::random(side - 4), y = harness::random(side - 4);
+      const int w = 1 + harness::random(4), h = 1 + harness::random(4);
+      mp_grid_add_rectangle(grid, x * cell, y * cell, (x + w) * cell - 1, (y + h) * cell - 1, blocked);
+    }
+    for (int c = 0; c < 300; c++)
+      mp_grid_add_cell(grid, harness::random(side), harness::random(side), blocked);
+
+    // A walled-in room, open inside, which nothing outside can reach
+    for (int i = 0; i < 12; i++) {
+      mp_grid_add_cell(grid, 40 + i, 40, blocked), mp_grid_add_cell(grid, 40 + i, 51, blocked);
+      mp_grid_add_cell(grid, 40, 40 + i, blocked), mp_grid_add_cell(grid, 51, 40 + i, blocked);
+    }
+    enigma_user::mp_grid_clear_rectangle(grid, 41 * cell, 41 * cell, 51 * cell - 1, 51 * cell - 1);
+  }
+}
+
+int main()
+{
+  const unsigned grid = mp_grid_create(0, 0, side, side, cell, cell);
+  build_walls(grid);
+  mp_grid_set_hierarchy(grid, cluster);
+  enigma::grid *const gr = enigma::gridstructarray[grid];
+  gr->uniform_cost = 1; // Every open cell costs the same, as find_path checks before jump point search
+
+  int searched = 0, unreachable = 0, hierarchy_gave_up = 0;
+  unsigned astar_total = 0, hierarchy_total = 0;
+  for (int diag = 0; diag < 2; diag++)
+    for (int trial = 0; trial < 400; trial++)
+    {
+      enigma::node *n0, *n1;
+      do n0 = gr->at(harness::random(side), harness::random(side)); while (!gr->open(n0->x, n0->y));
+      do n1 = gr->at(harness::random(side), harness::random(side)); while (!gr->open(n1->x, n1->y) || n1 == n0);
+      searched++;
+
+      std::vector<enigma::node*> astar, jps, hpa;
+      enigma::search_area area;
+      const bool astar_found = enigma::astar_path(gr, n0, n1, diag, astar, area);
+      const bool jps_found = enigma::jps_path(gr, n0, n1, diag, jps, area);
+      const bool hpa_found = enigma::hpa_path(gr, n0, n1, diag, hpa, area);
+
+      HARNESS_CHECK(jps_found == astar_found, "(%u, %u) to (%u, %u), diag %d: A* %s a path, jump points %s",
+                    n0->x, n0->y, n1->x, n1->y, diag, astar_found ? "found" : "found no", jps_found ? "did" : "did not");
+      HARNESS_CHECK(!hpa_found || astar_found, "(%u, %u) to (%u, %u), diag %d: the hierarchy found a path A* did not",
+                    n0->x, n0->y, n1->x, n1->y, diag);
+      if (!astar_found) {
+        unreachable++;
+        continue;
+      }
+
+      const unsigned best = path_cost(gr, n0, astar, n1, diag);
+      HARNESS_CHECK(best != 0, "(%u, %u) to (%u, %u), diag %d: A*'s path is broken", n0->x, n0->y, n1->x, n1->y, diag);
+      if (jps_found) {
+        const unsigned cost = path_cost(gr, n0, jps, n1, diag);
+        HARNESS_CHECK(cost == best, "(%u, %u) to (%u, %u), diag %d: jump points cost %u, A* %u",
+                      n0->x, n0->y, n1->x, n1->y, diag, cost, best);
+      }
+      if (hpa_found) {
+        const unsigned cost = path_cost(gr, n0, hpa, n1, diag);
+        HARNESS_CHECK(cost != 0 && cost >= best && cost <= hierarchy_bound(best), "(%u, %u) to (%u, %u), diag %d: the hierarchy costs %u, A* %u",
+                      n0->x, n0->y, n1->x, n1->y, diag, cost, best);
+        astar_total += best, hierarchy_total += cost;
+      }
+      else hierarchy_gave_up++;
+    }
+
+  printf("%d searches, %d unreachable; the hierarchy gave up on %d, and its paths cost %.1f%% more than A*'s\n",
+         searched, unreachable, hierarchy_gave_up, astar_total ? 100. * (hierarchy_total - astar_total) / astar_total : 0.);
+  mp_grid_destroy(grid);
+  return harness::failures != 0;
+}
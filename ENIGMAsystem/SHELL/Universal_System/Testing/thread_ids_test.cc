@@ -0,0 +1,114 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Thread ids from script_thread: the thread functions must refuse ids that were never
+// handed out, -1, and ids already joined or freed, even once their slot is reused. Threads
+// which start, join and free threads of their own must not stall the pool, even when
+// there are more of them than workers.
+////////////////////////////////////
+
+#include "Universal_System/var4.h"
+#include "Universal_System/resource_data.h"
+#include "Universal_System/callbacks_events.h"
+#include "Platforms/General/PFthreads.h"
+#include "harness.h"
+#include <unistd.h>
+#include <vector>
+
+using namespace enigma_user;
+
+namespace
+{
+  variant twice(variant x) { return x * 2; }
+
+  // Runs itself on two threads a level down and joins them, and leaves a third to finish
+  // on its own; returns how many scripts were joined, itself included.
+  variant nested(variant depth)
+  {
+    if (depth <= 0)
+      return 1;
+    const int left = script_thread(1, depth - 1), right = script_thread(1, depth - 1);
+    thread_free(script_thread(0, depth));
+    return thread_join(left) + thread_join(right) + 1;
+  }
+}
+
+namespace enigma
+{
+  callable_script callable_scripts[] = { { (variant(*)())twice, 1 }, { (variant(*)())nested, 1 } };
+  int script_idmax = 2;
+}
+
+namespace
+{
+  // Every function given `thread' must treat it as no thread at all.
+  void check_invalid(int thread, const char *what)
+  {
+    HARNESS_CHECK(!thread_get_finished(thread), "thread_get_finished accepted %s", what);
+    HARNESS_CHECK(thread_get_return(thread) == 0, "thread_get_return accepted %s", what);
+    HARNESS_CHECK(!thread_cancel(thread), "thread_cancel accepted %s", what);
+    HARNESS_CHECK(thread_join(thread) == 0, "thread_join accepted %s", what);
+    thread_free(thread);
+  }
+}
+
+int main()
+{
+  const int first = script_thread(0, 21);
+  HARNESS_CHECK(first >= 0, "script_thread found no workers");
+  if (first < 0)
+    return 1;
+  HARNESS_CHECK(thread_join(first) == 42, "thread_join returned the wrong value");
+  enigma::perform_callbacks_async_update();
+
+  check_invalid(-1, "-1, which script_thread returns when there are no workers");
+  check_invalid(first + 1, "an id never handed out");
+  check_invalid(1 << 20, "an id far out of range");
+  check_invalid(first, "an id already joined");
+
+  // The next thread gets the same slot; the old id must not reach it.
+  const int second = script_thread(0, 5);
+  HARNESS_CHECK(second != first, "a joined thread's id was handed out again");
+  check_invalid(first, "an id already joined, once its slot was reused");
+  HARNESS_CHECK(thread_join(second) == 10, "the thread in a reused slot returned the wrong value");
+
+  // Freed while it may still be running: the id is dead at once, and stays dead after the
+  // pool finishes the job and the slot is reused.
+  const int third = script_thread(0, 1);
+  thread_free(third);
+  check_invalid(third, "an id already freed");
+  for (int i = 0; i < 100; i++) // Give the pool time to finish it, as steps would
+    usleep(1000), enigma::perform_callbacks_async_update();
+  const int fourth = script_thread(0, 2);
+  HARNESS_CHECK(thread_join(fourth) == 4, "the thread after a freed one returned the wrong value");
+  enigma::perform_callbacks_async_update();
+  check_invalid(third, "an id freed before its slot was reused");
+
+  // More nested threads than workers, so every worker ends up waiting on threads of its own.
+  const int depth = 5, expected = (2 << depth) - 1;
+  std::vector<int> outer;
+  for (unsigned i = 0; i <= enigma::thread_pool_size(); i++)
+    outer.push_back(script_thread(1, depth));
+  for (size_t i = 0; i < outer.size(); i++) {
+    const int joined = thread_join(outer[i]);
+    HARNESS_CHECK(joined == expected, "nested thread %d joined %d scripts, not %d", int(i), joined, expected);
+  }
+  enigma::perform_callbacks_async_update();
+
+  return harness::failures != 0;
+}
@@ -0,0 +1,109 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+////////////////////////////////////
+// Cost of with() over 100k instances: a single with(all) pass, where the loop itself
+// dominates, and a pass in which every instance runs a with() over a single instance,
+// where registering and unregistering the iterator dominates. Afterward, instances are
+// destroyed in the middle of nested with() loops, which must still visit each survivor once.
+////////////////////////////////////
+
+#include <vector>
+
+#include "Universal_System/instance_system.h"
+#include "Universal_System/with.h"
+#include "harness.h"
+
+using enigma_user::all;
+
+namespace
+{
+  const int obj_crowd = 0, obj_single = 1;
+  const int count = 100000;
+
+  double with_all_pass(double *sum)
+  {
+    double s = 0;
+    with (all)
+      s += ((harness::instance*)enigma::instance_event_iterator->inst)->x;
+    *sum = s;
+    return s;
+  }
+
+  double nested_pass(double *sum)
+  {
+    double s = 0;
+    with (obj_crowd)
+      with (obj_single)
+        s += ((harness::instance*)enigma::instance_event_iterator->inst)->y;
+    *sum = s;
+    return s;
+  }
+
+  // Prints and returns the mean time of a pass, in milliseconds.
+  double time_passes(const char *name, double (*pass)(double*), int passes)
+  {
+    double sum = 0;
+    const double start = harness::seconds();
+    for (int i = 0; i < passes; i++)
+      pass(&sum);
+    const double ms = (harness::seconds() - start) * 1000 / passes;
+    printf("%-34s %9.3f ms  %7.2f ns per instance  (sum %g)\n", name, ms, ms * 1e6 / count, sum);
+    return ms;
+  }
+}
+
+int main()
+{
+  harness::init(2, 1);
+  harness::sprite(0, 16, 16);
+  for (int i = 0; i < count; i++)
+    new harness::instance(obj_crowd, i % 1000, i / 1000, 0);
+  new harness::instance(obj_single, 0, 1, 0);
+
+  time_passes("with(all)", with_all_pass, 50);
+  time_passes("with(crowd) { with(single) }", nested_pass, 20);
+
+  // Destroy every other instance of the crowd from inside a nested with(); the outer loop
+  // must step over the dead without skipping or repeating the living.
+  std::vector<int> visits(count, 0);
+  const unsigned first = enigma::objects[obj_crowd].next->inst->id;
+  with (obj_crowd)
+  {
+    const unsigned me = enigma::instance_event_iterator->inst->id;
+    visits[me - first]++;
+    if ((me - first) % 2 == 0)
+      with (obj_crowd) {
+        const unsigned them = enigma::instance_event_iterator->inst->id;
+        if (them == me + 1 && them - first < unsigned(count))
+          ((harness::instance*)enigma::instance_event_iterator->inst)->unlink();
+        if (them > me + 1)
+          break;
+      }
+  }
+  enigma::dispose_destroyed_instances();
+
+  int wrong = 0;
+  for (int i = 0; i < count; i++)
+    wrong += visits[i] != (i % 2 == 0 ? 1 : 0);
+  HARNESS_CHECK(wrong == 0, "%d instances visited the wrong number of times", wrong);
+  HARNESS_CHECK(enigma::objects[obj_crowd].count == unsigned(count / 2), "%u instances of the crowd left, not %d",
+                unsigned(enigma::objects[obj_crowd].count), count / 2);
+
+  harness::clear();
+  return harness::failures != 0;
+}
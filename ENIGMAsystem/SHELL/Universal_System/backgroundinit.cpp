@@ -31,87 +31,73 @@ using namespace std;
 
 namespace enigma
 {
-  void exe_loadbackgrounds(FILE *exe)
+  void exe_loadbackgrounds(resource_reader &exe)
   {
     int nullhere;
 	  unsigned bkgid, width, height,transparent,smoothEdges,preload,useAsTileset,tileWidth,tileHeight,hOffset,vOffset,hSep,vSep;
 
-    if (!fread(&nullhere,4,1,exe) or nullhere != *(int*)"BKG ")
+    if (!exe.read(&nullhere,4) or nullhere != *(int*)"BKG ")
       return;
 
     // Determine how many backgrounds we have
     int bkgcount;
-    if (!fread(&bkgcount,4,1,exe))
+    if (!exe.read(&bkgcount,4))
       return;
 
 
 	  // Fetch the highest ID we will be using
 	  int bkg_highid;
-	  if (!fread(&bkg_highid,4,1,exe))
+	  if (!exe.read(&bkg_highid,4))
 	    return;
 
 	  for (int i = 0; i < bkgcount; i++)
 	  {
-		  int unpacked;
-		  if (!fread(&bkgid, 4,1,exe)) return;
-		  if (!fread(&width, 4,1,exe)) return;
+		  if (!exe.read(&bkgid,4)) return;
+		  if (!exe.read(&width,4)) return;
 		  printf("width: %d", width);
-		  if (!fread(&height,4,1,exe)) return;
+		  if (!exe.read(&height,4)) return;
 		  printf("height: %d", height);
 
-		  if (!fread(&transparent,4,1,exe)) return;
+		  if (!exe.read(&transparent,4)) return;
 		  printf("transparent: %d", transparent);
-		  if (!fread(&smoothEdges,4,1,exe)) return;
+		  if (!exe.read(&smoothEdges,4)) return;
 		  printf("smoothEdges: %d", smoothEdges);
-		  if (!fread(&preload,4,1,exe)) return;
+		  if (!exe.read(&preload,4)) return;
 		  printf("preload: %d", preload);
-		  if (!fread(&useAsTileset,4,1,exe)) return;
+		  if (!exe.read(&useAsTileset,4)) return;
 		  printf("useAsTileset: %d", useAsTileset);
-		  if (!fread(&tileWidth,4,1,exe)) return;
+		  if (!exe.read(&tileWidth,4)) return;
 		  printf("tileWidth: %d", tileWidth);
-		  if (!fread(&tileHeight,4,1,exe)) return;
+		  if (!exe.read(&tileHeight,4)) return;
 		  printf("tileHeight: %d", tileHeight);
-		  if (!fread(&hOffset,4,1,exe)) return;
+		  if (!exe.read(&hOffset,4)) return;
 		  printf("hOffset: %d", hOffset);
-		  if (!fread(&vOffset,4,1,exe)) return;
+		  if (!exe.read(&vOffset,4)) return;
 		  printf("vOffset: %d", vOffset);
-		  if (!fread(&hSep,4,1,exe)) return;
+		  if (!exe.read(&hSep,4)) return;
 		  printf("hSep: %d", hSep);
-		  if (!fread(&vSep,4,1,exe)) return;
+		  if (!exe.read(&vSep,4)) return;
 		  printf("vSep: %d", vSep);
 
 
 		  //need to add: transparent, smooth, preload, tileset, tileWidth, tileHeight, hOffset, vOffset, hSep, vSep
 
-		  unpacked = width*height*4;
-
 		  unsigned int size;
-		  if (!fread(&size,4,1,exe)){};
+		  if (!exe.read(&size,4)) {
+			  show_error("Failed to load background: Data is truncated before exe end",0);
+			  return;
+		  }
 		  printf("Alloc size: %d", size);
 
-		  unsigned char* cpixels=new unsigned char[size+1];
-		  if (!cpixels)
-		  {
-			  show_error("Failed to load background: Cannot allocate enough memory "+toString(unpacked),0);
-			  break;
-		  }
-		  unsigned int sz2=fread(cpixels,1,size,exe);
-		  if (size!=sz2) {
-			  show_error("Failed to load background: Data is truncated before exe end. Read "+toString(sz2)+" out of expected "+toString(size),0);
+		  // The pixels stay compressed in the resource block until the background is first used.
+		  const unsigned char* cpixels = exe.skip(size);
+		  if (!cpixels) {
+			  show_error("Failed to load background: Data is truncated before exe end. Expected "+toString(size),0);
 			  return;
 		  }
-		  unsigned char* pixels=new unsigned char[unpacked+1];
-		  if (zlib_decompress(cpixels,size,unpacked,pixels) != unpacked)
-		  {
-			  show_error("Background load error: Background does not match expected size",0);
-			  continue;
-		  }
-		  delete[] cpixels;
 
 		  printf("Adding background: %d\n\n", i);
-		  background_new(bkgid, width, height, pixels, false, false, true, false, 32, 32, 0, 0, 1,1);
-
-		  delete[] pixels;
+		  background_new_pending(bkgid, width, height, cpixels, size, false, false, true, false, 32, 32, 0, 0, 1,1);
 	  }
   }
 }
@@ -22,12 +22,13 @@
 using namespace std;
 
 #include "Graphics_Systems/graphics_mandatory.h"
+#include "Widget_Systems/widgets_mandatory.h"
 #include "libEGMstd.h"
 #include "backgroundstruct.h"
 #include "image_formats.h"
+#include "zlib.h"
 
 #ifdef DEBUG_MODE
-  #include "Widget_Systems/widgets_mandatory.h"
   #define get_background(bck2d,back)\
     if (back < 0 or size_t(back) >= enigma::background_idmax or !enigma::backgroundstructarray[back]) {\
       show_error("Attempting to draw non-existing background " + toString(back), false);\
@@ -63,13 +64,13 @@ namespace enigma {
 namespace enigma
 {
   background::background():
-    tileset(false) {}
+    tileset(false), pending(NULL), pending_size(0) {}
   background::background(bool ts):
-    tileset(ts) {}
+    tileset(ts), pending(NULL), pending_size(0) {}
   background::background(int w,int h,int tex,bool trans,bool smth,bool prel):
-    width(w), height(h), texture(tex), transparent(trans), smooth(smth), preload(prel), tileset(false) {}
+    width(w), height(h), texture(tex), transparent(trans), smooth(smth), preload(prel), tileset(false), pending(NULL), pending_size(0) {}
   background::background(bool ts,int w,int h,int tex,bool trans,bool smth,bool prel):
-    width(w), height(h), texture(tex), transparent(trans), smooth(smth), preload(prel), tileset(ts) {}
+    width(w), height(h), texture(tex), transparent(trans), smooth(smth), preload(prel), tileset(ts), pending(NULL), pending_size(0) {}
 
   background_tileset::background_tileset():
     background(true) {}
@@ -89,8 +90,8 @@ namespace enigma
       backgroundstructarray[i] = NULL;
   }
 	
-  //Adds a subimage to an existing sprite from the exe
-  void background_new(int bkgid, unsigned w, unsigned h, unsigned char* chunk, bool transparent, bool smoothEdges, bool preload, bool useAsTileset, int tileWidth, int tileHeight, int hOffset, int vOffset, int hSep, int vSep)
+  // Pads the pixels of a background out to a power of two, and makes a texture of them
+  static int background_create_texture(unsigned w, unsigned h, unsigned char* chunk)
   {
     unsigned int fullwidth = nlpo2dc(w)+1, fullheight = nlpo2dc(h)+1;
     char *imgpxdata = new char[4*fullwidth*fullheight+1], *imgpxptr = imgpxdata;
@@ -111,6 +112,14 @@ namespace enigma
 
     int texture = graphics_create_texture(w, h, fullwidth,fullheight,imgpxdata,false);
     delete[] imgpxdata;
+    return texture;
+  }
+
+  //Adds a subimage to an existing sprite from the exe
+  void background_new(int bkgid, unsigned w, unsigned h, unsigned char* chunk, bool transparent, bool smoothEdges, bool preload, bool useAsTileset, int tileWidth, int tileHeight, int hOffset, int vOffset, int hSep, int vSep)
+  {
+    unsigned int fullwidth = nlpo2dc(w)+1, fullheight = nlpo2dc(h)+1;
+    int texture = background_create_texture(w, h, chunk);
 
     backgroundstructarray[bkgid] = useAsTileset ? new background(w,h,texture,transparent,smoothEdges,preload) : new background_tileset(w,h,texture,transparent,smoothEdges,preload,tileWidth, tileHeight, hOffset, vOffset, hSep, vSep);
     background *bak = backgroundstructarray[bkgid];
@@ -118,6 +127,31 @@ namespace enigma
     bak->texbordy  = (double) h/fullheight;
   }
 
+  void background_new_pending(int bkgid, unsigned w, unsigned h, const unsigned char* data, unsigned size, bool transparent, bool smoothEdges, bool preload, bool useAsTileset, int tileWidth, int tileHeight, int hOffset, int vOffset, int hSep, int vSep)
+  {
+    unsigned int fullwidth = nlpo2dc(w)+1, fullheight = nlpo2dc(h)+1;
+
+    backgroundstructarray[bkgid] = useAsTileset ? new background(w,h,-1,transparent,smoothEdges,preload) : new background_tileset(w,h,-1,transparent,smoothEdges,preload,tileWidth, tileHeight, hOffset, vOffset, hSep, vSep);
+    background *bak = backgroundstructarray[bkgid];
+    bak->texbordx  = (double) w/fullwidth;
+    bak->texbordy  = (double) h/fullheight;
+    bak->pending = data;
+    bak->pending_size = size;
+  }
+
+  void background_load_pending(background *bak)
+  {
+    const int unpacked = bak->width*bak->height*4;
+    unsigned char* pixels = new unsigned char[unpacked+1];
+    if (zlib_decompress(const_cast<unsigned char*>(bak->pending), bak->pending_size, unpacked, pixels) != unpacked) {
+      show_error("Background load error: Background does not match expected size",0);
+      memset(pixels, 0, unpacked);
+    }
+    bak->texture = background_create_texture(bak->width, bak->height, pixels);
+    bak->pending = NULL;
+    delete[] pixels;
+  }
+
   void background_add_to_index(background *bak, string filename, bool transparent, bool smoothEdges, bool preload)
   {
     unsigned int w, h, fullwidth, fullheight;
@@ -135,10 +169,12 @@ namespace enigma
     bak->texbordx = (double) w/fullwidth;
     bak->texbordy = (double) h/fullheight;
     bak->texture = texture;
+    bak->pending = NULL;
   }
 
   void background_add_copy(background *bak, background *bck_copy)
   {
+    background_load(bck_copy);
     bak->width = bck_copy->width;
     bak->height = bck_copy->height;
     bak->transparent = bck_copy->transparent;
@@ -148,6 +184,7 @@ namespace enigma
     bak->texbordx = bck_copy->texbordx;
     bak->texbordy = bck_copy->texbordy;
     bak->texture = graphics_duplicate_texture(bck_copy->texture);
+    bak->pending = NULL;
   }
   
   void backgroundstructarray_reallocate()
@@ -203,7 +240,7 @@ namespace enigma_user
   bool background_replace(int back, string filename, bool transparent, bool smooth, bool preload, bool free_texture)
   {
     get_backgroundnv(bck,back,false);
-    if (free_texture)
+    if (free_texture and !bck->pending)
         enigma::graphics_delete_texture(bck->texture);
 
     enigma::background_add_to_index(bck, filename, transparent, smooth, preload);
@@ -212,6 +249,7 @@ namespace enigma_user
   
   void background_save(int back, string fname) {
 	get_background(bck,back);
+	enigma::background_load(bck);
 	unsigned w, h;
 	unsigned char* rgbdata = enigma::graphics_get_texture_pixeldata(bck->texture, &w, &h);
 	
@@ -224,7 +262,7 @@ namespace enigma_user
 
   void background_delete(int back, bool free_texture) {
     get_background(bck,back);
-    if (free_texture)
+    if (free_texture and !bck->pending)
         enigma::graphics_delete_texture(bck->texture);
 
     delete enigma::backgroundstructarray[back];
@@ -241,7 +279,7 @@ namespace enigma_user
   void background_assign(int back, int copy_background, bool free_texture) {
     get_background(bck,back);
     get_background(bck_copy,copy_background);
-    if (free_texture)
+    if (free_texture and !bck->pending)
       enigma::graphics_delete_texture(bck->texture);
 
     enigma::background_add_copy(bck, bck_copy);
@@ -252,15 +290,23 @@ namespace enigma_user
     return unsigned(back) < enigma::background_idmax && bool(enigma::backgroundstructarray) && bool(enigma::backgroundstructarray[back]);
   }
 
+  void background_prefetch(int back) {
+    get_background(bck,back);
+    enigma::background_load(bck);
+  }
+
   void background_set_alpha_from_background(int back, int copy_background, bool free_texture)
   {
     get_background(bck,back);
     get_background(bck_copy,copy_background);
+    enigma::background_load(bck);
+    enigma::background_load(bck_copy);
     enigma::graphics_replace_texture_alpha_from_texture(bck->texture, bck_copy->texture);
   }
   
   int background_get_texture(int backId) {
     get_backgroundnv(bck2d,backId,-1);
+    enigma::background_load(bck2d);
     return bck2d->texture;
   }
 
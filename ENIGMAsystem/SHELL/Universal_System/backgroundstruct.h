@@ -33,6 +33,8 @@ namespace enigma
     double texbordx, texbordy;
 
     bool tileset;
+    const unsigned char *pending; // Compressed pixels in the resource block, until first use; else NULL
+    unsigned pending_size;
 
     background();
     background(bool);
@@ -57,6 +59,12 @@ namespace enigma
   void background_new(int bkgid, unsigned w, unsigned h, unsigned char* chunk, bool transparent, bool smoothEdges, bool preload, bool useAsTileset, int tileWidth, int tileHeight, int hOffset, int vOffset, int hSep, int vSep);
   void background_add_to_index(background *nb, std::string filename, bool transparent, bool smoothEdges, bool preload);
   void background_add_copy(background *bak, background *bck_copy);
+  // Adds a background from the resource block, whose pixels are decoded the first time it is used.
+  void background_new_pending(int bkgid, unsigned w, unsigned h, const unsigned char* data, unsigned size, bool transparent, bool smoothEdges, bool preload, bool useAsTileset, int tileWidth, int tileHeight, int hOffset, int vOffset, int hSep, int vSep);
+  void background_load_pending(background *bak);
+  inline void background_load(const background *bak) {
+    if (bak->pending) background_load_pending(const_cast<background*>(bak));
+  }
   void backgrounds_init();
   void backgroundstructarray_reallocate();
 }
@@ -72,6 +80,7 @@ void background_delete(int back, bool free_texture = true);
 int background_duplicate(int back);
 void background_assign(int back, int copy_background, bool free_texture = true);
 bool background_exists(int back);
+void background_prefetch(int back); // Decodes a background now, rather than when it is first drawn
 void background_set_alpha_from_background(int back, int copy_background, bool free_texture = true);
 int background_get_texture(int backId);
 int background_get_width(int backId);
@@ -21,6 +21,19 @@ namespace enigma {
   using std::list;
   typedef void (*callback_t )();
 
+  // Async update, at the start of each step.
+
+  list<callback_t> async_update_callbacks;
+  void perform_callbacks_async_update() {
+    list<callback_t>::iterator it_end = async_update_callbacks.end();
+    for (list<callback_t>::iterator it = async_update_callbacks.begin(); it != it_end; it++) {
+      (*it)();
+    }
+  }
+  void register_callback_async_update(callback_t callback) {
+    async_update_callbacks.push_back(callback);
+  }
+
   // Before collision event.
 
   list<callback_t> before_collision_callbacks;
@@ -19,6 +19,10 @@
 #define _ENIGMA_CALLBACKS_EVENTS__H
 
 namespace enigma {
+  // Async update, at the start of each step.
+  void perform_callbacks_async_update();
+  void register_callback_async_update(void (*callback)());
+
   // Before collision event.
   void perform_callbacks_before_collision_event();
   void register_callback_before_collision_event(void (*callback)());
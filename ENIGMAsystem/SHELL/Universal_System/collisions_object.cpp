@@ -27,96 +27,76 @@
 
 namespace enigma
 {
-    int object_collisions::$bbox_left() const
-    {
-        if (fzero(image_angle))
-            return (image_xscale >= 0) ?
-                   ((mask_index >= 0 ? sprite_get_bbox_left_relative(mask_index)*image_xscale : (sprite_index >= 0 ? sprite_get_bbox_left_relative(sprite_index)*image_xscale : 0)) + x + .5) :
-                   ((mask_index >= 0 ? (sprite_get_bbox_right_relative(mask_index) + 1)*image_xscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_right_relative(sprite_index) + 1)*image_xscale - 1: 0)) + x + .5);
-
-        const double arad = image_angle*(M_PI/180.0);
-        const int quad = int(fmod(fmod(image_angle, 360) + 360, 360)/90.0);
-        double w, h;
-        w = ((image_xscale >= 0)^(quad == 1 || quad == 2)) ?
-            (mask_index >= 0 ? sprite_get_bbox_left_relative(mask_index)*image_xscale : (sprite_index >= 0 ? sprite_get_bbox_left_relative(sprite_index)*image_xscale : 0)) :
-            (mask_index >= 0 ? (sprite_get_bbox_right_relative(mask_index) + 1)*image_xscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_right_relative(sprite_index) + 1)*image_xscale - 1: 0));
-        h = ((image_yscale >= 0)^(quad == 2 || quad == 3)) ?
-            (mask_index >= 0 ? sprite_get_bbox_top_relative(mask_index)*image_yscale : (sprite_index >= 0 ? sprite_get_bbox_top_relative(sprite_index)*image_yscale : 0)) :
-            (mask_index >= 0 ? (sprite_get_bbox_bottom_relative(mask_index) + 1)*image_yscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_bottom_relative(sprite_index) + 1)*image_yscale - 1: 0));
+    int object_collisions::$bbox_left()   const { return $bbox_world().left; }
+    int object_collisions::$bbox_right()  const { return $bbox_world().right; }
+    int object_collisions::$bbox_top()    const { return $bbox_world().top; }
+    int object_collisions::$bbox_bottom() const { return $bbox_world().bottom; }
 
-        return cos(arad)*w + sin(arad)*h + x + .5;
-    }
-
-    int object_collisions::$bbox_right() const
+    const bbox_rect_t& object_collisions::$bbox_relative() const
     {
-        if (fzero(image_angle))
-            return (image_xscale >= 0) ?
-                   ((mask_index >= 0 ? (sprite_get_bbox_right_relative(mask_index) + 1)*image_xscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_right_relative(sprite_index) + 1)*image_xscale - 1: 0)) + x + .5) :
-                   ((mask_index >= 0 ? sprite_get_bbox_left_relative(mask_index)*image_xscale : (sprite_index >= 0 ? sprite_get_bbox_left_relative(sprite_index)*image_xscale : 0)) + x + .5);
-
-        const double arad = image_angle*(M_PI/180.0);
-        const int quad = int(fmod(fmod(image_angle, 360) + 360, 360)/90.0);
-        double w, h;
-        w = ((image_xscale >= 0)^(quad == 1 || quad == 2)) ?
-            (mask_index >= 0 ? (sprite_get_bbox_right_relative(mask_index) + 1)*image_xscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_right_relative(sprite_index) + 1)*image_xscale - 1: 0)) :
-            (mask_index >= 0 ? sprite_get_bbox_left_relative(mask_index)*image_xscale : (sprite_index >= 0 ? sprite_get_bbox_left_relative(sprite_index)*image_xscale : 0));
-        h = ((image_yscale >= 0)^(quad == 2 || quad == 3)) ?
-            (mask_index >= 0 ? (sprite_get_bbox_bottom_relative(mask_index) + 1)*image_yscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_bottom_relative(sprite_index) + 1)*image_yscale - 1: 0)) :
-            (mask_index >= 0 ? sprite_get_bbox_top_relative(mask_index)*image_yscale : (sprite_index >= 0 ? sprite_get_bbox_top_relative(sprite_index)*image_yscale : 0));
-
-        return cos(arad)*w + sin(arad)*h + x + .5;
+        return (mask_index >= 0 ? sprite_get_bbox_relative(mask_index) : sprite_get_bbox_relative(sprite_index));
     }
-
-    int object_collisions::$bbox_top() const
+    const bbox_rect_t& object_collisions::$bbox() const
     {
-        if (fzero(image_angle))
-            return (image_yscale >= 0) ?
-                ((mask_index >= 0 ? sprite_get_bbox_top_relative(mask_index)*image_yscale : (sprite_index >= 0 ? sprite_get_bbox_top_relative(sprite_index)*image_yscale : 0)) + y + .5):
-                ((mask_index >= 0 ? (sprite_get_bbox_bottom_relative(mask_index) + 1)*image_yscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_bottom_relative(sprite_index) + 1)*image_yscale - 1: 0)) + y + .5);
-
-        const double arad = image_angle*(M_PI/180.0);
-        const int quad = int(fmod(fmod(image_angle, 360) + 360, 360)/90.0);
-        double w, h;
-        w = ((image_xscale >= 0)^(quad == 2 || quad == 3)) ?
-            (mask_index >= 0 ? (sprite_get_bbox_right_relative(mask_index) + 1)*image_xscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_right_relative(sprite_index) + 1)*image_xscale - 1: 0)) :
-            (mask_index >= 0 ? sprite_get_bbox_left_relative(mask_index)*image_xscale : (sprite_index >= 0 ? sprite_get_bbox_left_relative(sprite_index)*image_xscale : 0));
-        h = ((image_yscale >= 0)^(quad == 1 || quad == 2)) ?
-            (mask_index >= 0 ? sprite_get_bbox_top_relative(mask_index)*image_yscale : (sprite_index >= 0 ? sprite_get_bbox_top_relative(sprite_index)*image_yscale : 0)) :
-            (mask_index >= 0 ? (sprite_get_bbox_bottom_relative(mask_index) + 1)*image_yscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_bottom_relative(sprite_index) + 1)*image_yscale - 1: 0));
-
-        return cos(arad)*h -sin(arad)*w + y + .5;
+         return (mask_index >= 0 ? sprite_get_bbox(mask_index) : sprite_get_bbox(sprite_index));
     }
 
-    int object_collisions::$bbox_bottom() const
+    const object_collisions::world_bbox_t& object_collisions::$bbox_world() const
     {
+        world_bbox_t &c = $bbox_cache;
+        const int spr = mask_index >= 0 ? mask_index : sprite_index;
+        if (spr < 0)
+        {
+            if (c.sprite == -1 && c.x == x && c.y == y)
+                return c;
+            c.sprite = -1, c.x = x, c.y = y;
+            c.left = c.right = x + .5;
+            c.top = c.bottom = y + .5;
+            return c;
+        }
+
+        const bbox_rect_t &rel = sprite_get_bbox_relative(spr);
+        if (c.sprite == spr && c.x == x && c.y == y && c.xscale == image_xscale && c.yscale == image_yscale && c.angle == image_angle
+        &&  c.rel_left == rel.left && c.rel_top == rel.top && c.rel_right == rel.right && c.rel_bottom == rel.bottom)
+            return c;
+
+        c.sprite = spr, c.x = x, c.y = y;
+        c.xscale = image_xscale, c.yscale = image_yscale, c.angle = image_angle;
+        c.rel_left = rel.left, c.rel_top = rel.top, c.rel_right = rel.right, c.rel_bottom = rel.bottom;
+
+        const bool xsp = (image_xscale >= 0), ysp = (image_yscale >= 0);
+        const double lsc = rel.left*image_xscale, rsc = (rel.right+1)*image_xscale-1,
+                     tsc = rel.top*image_yscale, bsc = (rel.bottom+1)*image_yscale-1;
         if (fzero(image_angle))
-            return (image_yscale >= 0) ?
-                ((mask_index >= 0 ? (sprite_get_bbox_bottom_relative(mask_index) + 1)*image_yscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_bottom_relative(sprite_index) + 1)*image_yscale - 1: 0)) + y + .5) :
-                ((mask_index >= 0 ? sprite_get_bbox_top_relative(mask_index)*image_yscale : (sprite_index >= 0 ? sprite_get_bbox_top_relative(sprite_index)*image_yscale : 0)) + y + .5);
-
-        const double arad = image_angle*(M_PI/180.0);
-        const int quad = int(fmod(fmod(image_angle, 360) + 360, 360)/90.0);
-        double w, h;
-        w = ((image_xscale >= 0)^(quad == 2 || quad == 3)) ?
-            (mask_index >= 0 ? sprite_get_bbox_left_relative(mask_index)*image_xscale : (sprite_index >= 0 ? sprite_get_bbox_left_relative(sprite_index)*image_xscale : 0)) :
-            (mask_index >= 0 ? (sprite_get_bbox_right_relative(mask_index) + 1)*image_xscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_right_relative(sprite_index) + 1)*image_xscale - 1: 0));
-        h = ((image_yscale >= 0)^(quad == 1 || quad == 2)) ?
-            (mask_index >= 0 ? (sprite_get_bbox_bottom_relative(mask_index) + 1)*image_yscale - 1 : (sprite_index >= 0 ? (sprite_get_bbox_bottom_relative(sprite_index) + 1)*image_yscale - 1: 0)) :
-            (mask_index >= 0 ? sprite_get_bbox_top_relative(mask_index)*image_yscale : (sprite_index >= 0 ? sprite_get_bbox_top_relative(sprite_index)*image_yscale : 0));
-
-        return cos(arad)*h - sin(arad)*w + y + .5;
+        {
+            c.left   = (xsp ? lsc : rsc) + x + .5;
+            c.right  = (xsp ? rsc : lsc) + x + .5;
+            c.top    = (ysp ? tsc : bsc) + y + .5;
+            c.bottom = (ysp ? bsc : tsc) + y + .5;
+        }
+        else
+        {
+            const double arad = image_angle*(M_PI/180.0);
+            const double sina = sin(arad), cosa = cos(arad);
+            const int quad = int(fmod(fmod(image_angle, 360) + 360, 360)/90.0);
+            const bool q12 = (quad == 1 || quad == 2), q23 = (quad == 2 || quad == 3),
+                       xs12 = xsp^q12, xs23 = xsp^q23, ys12 = ysp^q12, ys23 = ysp^q23;
+
+            c.left   = cosa*(xs12 ? lsc : rsc) + sina*(ys23 ? tsc : bsc) + x + .5;
+            c.right  = cosa*(xs12 ? rsc : lsc) + sina*(ys23 ? bsc : tsc) + x + .5;
+            c.top    = cosa*(ys12 ? tsc : bsc) - sina*(xs23 ? rsc : lsc) + y + .5;
+            c.bottom = cosa*(ys12 ? bsc : tsc) - sina*(xs23 ? lsc : rsc) + y + .5;
+        }
+        return c;
     }
 
-    const bbox_rect_t& object_collisions::$bbox_relative() const
-    {
-        return (mask_index >= 0 ? sprite_get_bbox_relative(mask_index) : sprite_get_bbox_relative(sprite_index));
-    }
-    const bbox_rect_t& object_collisions::$bbox() const
+    void object_collisions::$bbox_world(int *left, int *right, int *top, int *bottom) const
     {
-         return (mask_index >= 0 ? sprite_get_bbox(mask_index) : sprite_get_bbox(sprite_index));
+        const world_bbox_t &c = $bbox_world();
+        *left = c.left, *right = c.right, *top = c.top, *bottom = c.bottom;
     }
 
-    object_collisions::object_collisions(): object_transform() {}
-    object_collisions::object_collisions(unsigned _id,int _objid): object_transform(_id,_objid) {}
+    object_collisions::object_collisions(): object_transform(), $broadphase_slot(-1) { $bbox_cache.sprite = -2; }
+    object_collisions::object_collisions(unsigned _id,int _objid): object_transform(_id,_objid), $broadphase_slot(-1) { $bbox_cache.sprite = -2; }
     object_collisions::~object_collisions() {}
 }
@@ -43,6 +43,22 @@ namespace enigma
     //Bit Mask
       int  mask_index;
       bool solid;
+
+    //Collision broadphase bookkeeping; -1 until the broadphase first sees this instance
+      int $broadphase_slot;
+
+    //World-space bounding box, kept with the fields it was computed from.
+    //It is recomputed only when one of those fields differs from the copy kept here.
+      struct world_bbox_t {
+        cs_scalar x, y;
+        gs_scalar xscale, yscale, angle;
+        int sprite; // Mask, or sprite if there is none; -1 if neither
+        int rel_left, rel_top, rel_right, rel_bottom;
+        int left, top, right, bottom;
+      };
+      mutable world_bbox_t $bbox_cache;
+      const world_bbox_t& $bbox_world() const;
+      void $bbox_world(int *left, int *right, int *top, int *bottom) const;
     
     //Bounding box
       #ifdef JUST_DEFINE_IT_RUN
@@ -32,17 +32,17 @@ using namespace std;
 
 namespace enigma
 {
-  void exe_loadfonts(FILE *exe)
+  void exe_loadfonts(resource_reader &exe)
   {
     int nullhere;
 	  unsigned fontcount, fntid, twid, thgt, gwid, ghgt;
 	  float advance, baseline, origin, gtx, gty, gtx2, gty2;
 
-    if (!fread(&nullhere,4,1,exe)) return;
+    if (!exe.read(&nullhere,4)) return;
     if (nullhere != *(int*)"FNT ")
       return;
 
-    if (!fread(&fontcount,4,1,exe)) return;
+    if (!exe.read(&fontcount,4)) return;
     if ((int)fontcount != rawfontcount) {
       show_error("Resource data does not match up with game metrics. Unable to improvise.",0);
       return;
@@ -53,9 +53,9 @@ namespace enigma
 	for (int rf = 0; rf < rawfontcount; rf++)
 	{
 	  // int unpacked;
-	  if (!fread(&fntid, 4,1,exe)) return;
-	  if (!fread(&twid, 4,1,exe)) return;
-	  if (!fread(&thgt,4,1,exe)) return;
+	  if (!exe.read(&fntid,4)) return;
+	  if (!exe.read(&twid,4)) return;
+	  if (!exe.read(&thgt,4)) return;
 	  const int i = fntid;
 
 	  fontstructarray[i] = new font;
@@ -74,20 +74,19 @@ namespace enigma
 
 	  int* pixels=new int[size+1]; //FYI: This variable was once called "cpixels." When you do compress them, change it back.
 
-	  unsigned int sz2;
-	  for (sz2 = 0; !feof(exe) and sz2 < size; sz2++){
-		pixels[sz2] = 0x00FFFFFF | ((unsigned char)fgetc(exe) << 24);
-		if (pixels[sz2] == 0x00FFFFFF) pixels[sz2] = 0;
-	  }
-
-	  if (size!=sz2) {
-		  show_error("Failed to load font: Data is truncated before exe end. Read "+toString(sz2)+" out of expected "+toString(size),0);
+	  const unsigned char* alpha = exe.skip(size);
+	  if (!alpha) {
+		  show_error("Failed to load font: Data is truncated before exe end. Expected "+toString(size),0);
 		  return;
 	  }
-	  if (!fread(&nullhere,4,1,exe)) return;
+	  for (unsigned sz2 = 0; sz2 < size; sz2++){
+		pixels[sz2] = 0x00FFFFFF | (alpha[sz2] << 24);
+		if (pixels[sz2] == 0x00FFFFFF) pixels[sz2] = 0;
+	  }
+	  if (!exe.read(&nullhere,4)) return;
 	  if (nullhere != *(int*)"done")
 	  {
-		printf("Unexpected end; eof:%s\n",feof(exe)?"true":"false");
+		printf("Unexpected end; eof:%s\n",exe.pos == exe.end?"true":"false");
 		return;
 	  }
 	  //unpacked = width*height*4;
@@ -106,23 +105,23 @@ namespace enigma
 		  //if (fgr == NULL)
 			
 		  unsigned strt, cnt;
-		  if (!fread(&strt,4,1,exe)) return;
-		  if (!fread(&cnt,4,1,exe)) return;
+		  if (!exe.read(&strt,4)) return;
+		  if (!exe.read(&cnt,4)) return;
 		  
 		  fgr->glyphstart = strt;
 		  fgr->glyphcount = cnt;
 		  
 		  for (unsigned gi = 0; gi < fgr->glyphcount; gi++)
 		  {
-			if (!fread(&advance,4,1,exe)) return;
-			if (!fread(&baseline,4,1,exe)) return;
-			if (!fread(&origin,4,1,exe)) return;
-			if (!fread(&gwid,4,1,exe)) return;
-			if (!fread(&ghgt,4,1,exe)) return;
-			if (!fread(&gtx,4,1,exe)) return;
-			if (!fread(&gty,4,1,exe)) return;
-			if (!fread(&gtx2,4,1,exe)) return;
-			if (!fread(&gty2,4,1,exe)) return;
+			if (!exe.read(&advance,4)) return;
+			if (!exe.read(&baseline,4)) return;
+			if (!exe.read(&origin,4)) return;
+			if (!exe.read(&gwid,4)) return;
+			if (!exe.read(&ghgt,4)) return;
+			if (!exe.read(&gtx,4)) return;
+			if (!exe.read(&gty,4)) return;
+			if (!exe.read(&gtx2,4)) return;
+			if (!exe.read(&gty2,4)) return;
 			fontglyph* fg = new fontglyph;
 			fgr->glyphs.push_back(fg);
 			
@@ -153,7 +152,7 @@ namespace enigma
 
 	  delete[] pixels;
 
-      if (!fread(&nullhere,4,1,exe)) return;
+      if (!exe.read(&nullhere,4)) return;
       if (nullhere != *(int*)"endf")
         return;
 	}
@@ -67,6 +67,7 @@ namespace enigma
       // a square space based on the max height of the font.
 
       enigma::sprite *sspr = enigma::spritestructarray[spr];
+      enigma::sprite_unpack(sspr); // Glyphs are read back whole from their textures
       unsigned char* glyphdata[gcount]; // Raw font image data
       std::vector<enigma::rect_packer::pvrect> glyphmetrics(gcount);
       int glyphx[gcount], glyphy[gcount];
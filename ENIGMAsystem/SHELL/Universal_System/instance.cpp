@@ -90,10 +90,10 @@ void instance_activate_object(int obj) {
 void instance_destroy(int id, bool dest_ev)
 {
   enigma::object_basic* who = enigma::fetch_instance_by_id(id);
-  if (who and enigma::cleanups.find(who) == enigma::cleanups.end()) {
+  if (who and !who->$destroyed) {
     if (dest_ev)
         who->myevent_destroy();
-    if (enigma::cleanups.find(who) == enigma::cleanups.end())
+    if (!who->$destroyed)
         who->unlink();
   }
 }
@@ -101,11 +101,11 @@ void instance_destroy(int id, bool dest_ev)
 void instance_destroy()
 {
   enigma::object_basic* const a = enigma::instance_event_iterator->inst;
-  if (enigma::cleanups.find(a) == enigma::cleanups.end()) {
+  if (!a->$destroyed) {
     enigma::instance_event_iterator->inst->myevent_destroy();
-    if (enigma::cleanups.find(a) == enigma::cleanups.end())
+    if (!a->$destroyed)
         enigma::instance_event_iterator->inst->unlink();
-    if (enigma::cleanups.find(a) == enigma::cleanups.end())
+    if (!a->$destroyed)
     printf("FUCK! FUCK! FUCK! FUCK! FUCK! FUCK! FUCK! FUCK! FUCK! FUCK! FUCK! FUCK! FUCK!\nFFFFFFFFFFFFFFFFFFFFFUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUCK!\nFUCK! %p ISN'T ON THE GOD DAMNED MOTHER FUCKING STACK!", (void*)a);
     if (a != (enigma::object_basic*)enigma::instance_event_iterator->inst)
     printf("FUCKING DAMN IT! THE ITERATOR CHANGED FROM POINTING TO %p TO POINTING TO %p\n", (void*)a, (void*)(enigma::object_basic*)enigma::instance_event_iterator->inst);
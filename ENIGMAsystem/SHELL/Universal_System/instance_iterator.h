@@ -55,7 +55,15 @@ namespace enigma {
     
     ~iterator();
     
-    private: void addme();
+    private:
+      // Live iterators which must be told about destroyed instances are kept in an
+      // intrusive list, most recent first, so registering one costs no allocation.
+      iterator *reg_prev, *reg_next;
+      bool registered;
+      void addme();
+      void removeme();
+      friend void update_iterators_for_destroy(const inst_iter*);
+      friend void dispose_destroyed_instances();
   };
   
   void update_iterators_for_destroy(const inst_iter*);
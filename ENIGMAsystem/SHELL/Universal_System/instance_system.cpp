@@ -37,6 +37,11 @@
 
 #include "instance_system.h"
 #include "instance_system_frontend.h"
+#include "object_pool.h"
+
+#ifdef DEBUG_MODE
+  #include "Widget_Systems/widgets_mandatory.h" // show_error
+#endif
 
 using namespace std;
 
@@ -53,17 +58,50 @@ namespace enigma
   event_iter::event_iter(string n): inst_iter(NULL,NULL,this), name(n) {}
   event_iter::event_iter(): inst_iter(NULL,NULL,this) {}
 
+  static chunk_pool &inst_iter_pool() {
+    static chunk_pool pool(sizeof(inst_iter), 1024);
+    return pool;
+  }
+
+  void* inst_iter::operator new(size_t size)
+  {
+    if (size != sizeof(inst_iter)) // Derived iterators come from the heap as usual
+      return ::operator new(size);
+    return inst_iter_pool().alloc();
+  }
+  void inst_iter::operator delete(void* node, size_t size)
+  {
+    if (!node) return;
+    if (size != sizeof(inst_iter))
+      ::operator delete(node);
+    else
+      inst_iter_pool().release(node);
+  }
+
 
   /*------ New iterator system --------------------------------*\
   \*-----------------------------------------------------------*/
 
-    set<iterator*> central_iterator_cache;
-    typedef set<iterator*>::iterator central_iterator_cache_iterator;
+    // Head of the intrusive list of registered iterators. Iterators mostly live on the
+    // stack, so the one being removed is nearly always at the head.
+    static iterator *central_iterator_list = NULL;
 
     object_basic* iterator::operator*() { return it->inst; }
     object_basic* iterator::operator->() { return it->inst; }
 
-    void iterator::addme() { central_iterator_cache.insert(this); }
+    void iterator::addme() {
+      reg_prev = NULL, reg_next = central_iterator_list;
+      if (reg_next) reg_next->reg_prev = this;
+      central_iterator_list = this;
+      registered = true;
+    }
+    void iterator::removeme() {
+      if (!registered) return;
+      if (reg_prev) reg_prev->reg_next = reg_next;
+      else central_iterator_list = reg_next;
+      if (reg_next) reg_next->reg_prev = reg_prev;
+      registered = false;
+    }
 
     iterator::operator bool() { return it; }
     iterator &iterator::operator++()    { it = it->next; return *this; }
@@ -78,23 +116,24 @@ namespace enigma
 
     iterator::iterator(inst_iter*_it, bool tmp): it(_it), temp(tmp) { addme(); }
     iterator::iterator(const iterator&other): it(other.it?new inst_iter(*other.it):NULL), temp(true) { addme(); }
-    iterator::iterator(iterator&other): it(other.it), temp(other.temp) { other.temp = NULL; }
-    iterator::iterator(object_basic*ob): it(new inst_iter(ob,NULL,NULL)), temp(true) { }
-    iterator::iterator(): it(NULL), temp(true) { }
+    iterator::iterator(iterator&other): it(other.it), temp(other.temp), registered(false) { other.temp = NULL; }
+    iterator::iterator(object_basic*ob): it(new inst_iter(ob,NULL,NULL)), temp(true), registered(false) { }
+    iterator::iterator(): it(NULL), temp(true), registered(false) { }
     iterator:: ~iterator() {
-      central_iterator_cache.erase(this);
+      removeme();
       if (temp) delete it;
     }
 
     void update_iterators_for_destroy(const inst_iter* dd)
     {
-      for (central_iterator_cache_iterator it = central_iterator_cache.begin();
-           it != central_iterator_cache.end(); ++it)
+      for (iterator *i = central_iterator_list; i; i = i->reg_next)
       {
-        if ((*it)->it->next == dd)
-          (*it)->it->next = dd->next;
-        else if ((*it)->it->prev == dd)
-          (*it)->it->prev = dd->prev;
+        if (!i->it)
+          continue;
+        if (i->it->next == dd)
+          i->it->next = dd->next;
+        else if (i->it->prev == dd)
+          i->it->prev = dd->prev;
       }
     }
 
@@ -149,8 +188,85 @@ namespace enigma
   map<int,inst_iter*> instance_deactivated_list;
   typedef map<int,inst_iter*>::iterator iliter;
   typedef pair<int,inst_iter*> inode_pair;
-    
-   
+
+  // The map above keeps instances in ID order; lookups by ID go through this table instead.
+  // IDs are handed out in increasing order and never reused, so an ID indexes the table
+  // directly, and a stale ID can only find its own, now empty, slot.
+  // Invariant: for every ID in [id_table_base, id_table_base + id_table.size()), the slot
+  // holds exactly what instance_list holds for that ID. Other IDs are looked up in the map.
+  static vector<inst_iter*> id_table;
+  static int id_table_base = 0;     // ID of id_table[0]
+  static size_t id_table_first = 0; // No live slots before this one
+  static const size_t id_table_slack = 1 << 16; // Empty slots we will tolerate, beyond those needed
+
+  static inline size_t id_table_cap() {
+    return id_table_slack + 4 * instance_list.size();
+  }
+
+  static inline inst_iter *find_instance_node(int id)
+  {
+    const size_t i = size_t(unsigned(id) - unsigned(id_table_base));
+    if (i < id_table.size())
+      return id_table[i];
+    iliter a = instance_list.find(id);
+    return a != instance_list.end() ? a->second : NULL;
+  }
+
+  // Copies the map's entries for IDs [base, base + n) into the table, from slot `at'.
+  static void id_table_fill(int base, size_t n, size_t at)
+  {
+    for (iliter a = instance_list.lower_bound(base); a != instance_list.end() && size_t(unsigned(a->first) - unsigned(base)) < n; ++a)
+      id_table[at + (a->first - base)] = a->second;
+  }
+
+  static void id_table_link(int id, inst_iter *node)
+  {
+    if (id_table.empty()) {
+      id_table_base = id;
+      id_table_first = 0;
+    }
+    else if (id < id_table_base) {
+      // Rare: IDs come in increasing order, but a deactivated instance can return below the base.
+      const size_t grow = size_t(unsigned(id_table_base) - unsigned(id));
+      if (id_table.size() + grow > id_table_cap())
+        return;
+      id_table.insert(id_table.begin(), grow, (inst_iter*)NULL);
+      id_table_base = id;
+      id_table_fill(id + 1, grow - 1, 1);
+      id_table_first = 0;
+    }
+
+    const size_t i = size_t(unsigned(id) - unsigned(id_table_base));
+    if (i >= id_table.size()) {
+      if (i + 1 > id_table_cap())
+        return;
+      const size_t old = id_table.size();
+      id_table.resize(i + 1, NULL);
+      id_table_fill(id_table_base + int(old), i - old, old);
+    }
+    id_table[i] = node;
+    if (i < id_table_first)
+      id_table_first = i;
+  }
+
+  static void id_table_unlink(int id)
+  {
+    const size_t i = size_t(unsigned(id) - unsigned(id_table_base));
+    if (i >= id_table.size())
+      return;
+    id_table[i] = NULL;
+
+    // Drop the run of dead IDs at the front once it is most of the table.
+    while (id_table_first < id_table.size() && !id_table[id_table_first])
+      ++id_table_first;
+    if (id_table_first == id_table.size())
+      id_table.clear();
+    else if (id_table_first > 1024 && id_table_first > id_table.size() / 2) {
+      id_table.erase(id_table.begin(), id_table.begin() + id_table_first);
+      id_table_base += int(id_table_first);
+      id_table_first = 0;
+    }
+  }
 
   // When you say "global.vname", this is the structure that answers
   extern object_basic *ENIGMA_global_instance; // We also need an iterator for only global.
@@ -162,17 +278,81 @@ namespace enigma
   void iterator_level::pop() { il_top = il_top->last; }
   iterator_level *il_top = NULL;
 
-  // This is basically a garbage collection list for when instances are destroyed
-  set<object_basic*> cleanups; // We'll use set, to prevent stupidity
+  // This is basically a garbage collection list for when instances are destroyed.
+  // object_basic::$destroyed keeps anything from being queued twice.
+  vector<object_basic*> cleanups;
+  // The main list nodes of the instances in cleanups, freed along with them.
+  static vector<inst_iter*> cleanup_nodes;
 
   // It's a good idea to centralize an event iterator so error reporting can tell where it is.
   static inst_iter dummy_event_iterator(NULL,NULL,NULL); // For create events and such
-  inst_iter *instance_event_iterator = &dummy_event_iterator; // Not bad for efficiency, either.
+  current_iterator instance_event_iterator = &dummy_event_iterator; // Not bad for efficiency, either.
   object_basic *instance_other = NULL;
 
   temp_event_scope::temp_event_scope(object_basic* ninst): oinst(instance_event_iterator->inst), oiter(instance_event_iterator)
-    { instance_event_iterator = &dummy_event_iterator; instance_event_iterator->inst = ninst; }
-  temp_event_scope::~temp_event_scope() { instance_event_iterator = oiter; instance_event_iterator->inst = oinst; }
+    { instance_event_iterator = &dummy_event_iterator; instance_event_iterator->inst = ninst; touch_current_instance(); }
+  temp_event_scope::~temp_event_scope() { instance_event_iterator = oiter; instance_event_iterator->inst = oinst; touch_current_instance(); }
+
+  // Read by the collision broadphase and the collision events.
+  int track_touched_instances = 0;
+  bool touched_instances_overflowed = false;
+  vector<int> touched_instances;
+  unsigned touched_instances_epoch = 0;
+  int touched_current_instance = -1;
+  static size_t touched_instances_read = 0; // Entries before this may have been read
+
+  static inline int current_instance_id() {
+    object_basic *const current = instance_event_iterator ? instance_event_iterator->inst : NULL;
+    return current ? int(current->id) : -1;
+  }
+
+  void record_touched_instance(object_basic* inst, bool current)
+  {
+    const int id = inst ? int(inst->id) : -1;
+    if (current)
+      touched_current_instance = id;
+    if (id < 0 || touched_instances_overflowed)
+      return;
+    // Repeats are dropped, but only until someone reads the first: it may change again after.
+    if (touched_instances.size() > touched_instances_read && touched_instances.back() == id)
+      return;
+    if (touched_instances.size() > 8 * instance_list.size() + 4096) {
+      touched_instances_overflowed = true;
+      return;
+    }
+    touched_instances.push_back(id);
+  }
+
+  void clear_touched_instances()
+  {
+    touched_instances.clear();
+    touched_instances_overflowed = false;
+    touched_instances_read = 0;
+    ++touched_instances_epoch;
+  }
+
+  bool touched_instances_reader::intact() const {
+    return epoch == touched_instances_epoch && !touched_instances_overflowed
+        && current_instance_id() == touched_current_instance;
+  }
+
+  void touched_instances_reader::finish()
+  {
+    const int current = current_instance_id();
+    if (touched_instances_overflowed || current != touched_current_instance) {
+      clear_touched_instances(); // Every other reader has lost track as well
+      touched_current_instance = current;
+    }
+    epoch = touched_instances_epoch;
+    next = touched_instances.size();
+    if (current >= 0) {
+      if (next && touched_instances[next - 1] == current)
+        --next;
+      else
+        touched_instances.push_back(current);
+    }
+    touched_instances_read = next; // No reader has read past the current instance
+  }
 
   /* **  Methods ** */
   // Retrieve the first instance on the complete list.
@@ -183,7 +363,7 @@ namespace enigma
   }
 
   extern int object_idmax;
-  object_basic* fetch_instance_by_int(int x)
+  static object_basic* find_instance_by_int(int x)
   {
     using namespace enigma_user;
 
@@ -192,8 +372,9 @@ namespace enigma
       case self:
       case local:  return instance_event_iterator ? instance_event_iterator->inst : NULL;
       case other:  return instance_other;
-      case all: {  iterator i = instance_list_first();
-                   return  i ? *i : NULL; }
+      case all: {  // Only the instance is wanted; no iterator need be registered for it
+                   iliter a = instance_list.begin();
+                   return a != instance_list.end() ? a->second->inst : NULL; }
       case global: return ENIGMA_global_instance;
       case noone:
          default:  return NULL;
@@ -202,13 +383,19 @@ namespace enigma
     if (x < 100000)
       return x < object_idmax ? objects[x].next ? objects[x].next->inst : NULL : NULL;
 
-    iliter a = instance_list.find(x);
-    return a != instance_list.end() ? a->second->inst : NULL;
+    inst_iter *a = find_instance_node(x);
+    return a ? a->inst : NULL;
+  }
+  object_basic* fetch_instance_by_int(int x)
+  {
+    object_basic *const inst = find_instance_by_int(x);
+    touch_instance(inst); // Whoever asked may change it, as through glaccess
+    return inst;
   }
   object_basic* fetch_instance_by_id(int x)
   {
-    iliter a = instance_list.find(x);
-    return a != instance_list.end() ? a->second->inst : NULL;
+    inst_iter *a = find_instance_node(x);
+    return a ? a->inst : NULL;
   }
 
   iterator fetch_inst_iter_by_int(int x)
@@ -218,7 +405,7 @@ namespace enigma
     if (x < 0) switch (x) // Keyword-based lookup
     {
       case self:
-      case local:  return instance_event_iterator;
+      case local:  return (inst_iter*)instance_event_iterator;
       case other:  return instance_other ? iterator(instance_other) : iterator();
       case all:    return instance_list_first();
       case global: return &ENIGMA_global_instance_iterator;
@@ -230,26 +417,33 @@ namespace enigma
       return objects[x].next;
 
     // ID-based lookup
-    iliter a = instance_list.find(x);
-    return a != instance_list.end() ? iterator(a->second->inst) : iterator();
+    inst_iter *a = find_instance_node(x);
+    return a ? iterator(a->inst) : iterator();
   }
   iterator fetch_inst_iter_by_id(int x)
   {
     if (x < 100000)
       return iterator();
 
-    iliter a = instance_list.find(x);
-    return a != instance_list.end() ? a->second : NULL;
+    return find_instance_node(x);
   }
 
   // Implementation for frontend
   // (Wrapper struct to lower compile time)
+  static chunk_pool &winstance_list_iterator_pool();
   typedef struct winstance_list_iterator {
     instance_list_iterator w;
-    winstance_list_iterator(instance_list_iterator n): w(n) {}
+    inst_iter *node; // Our node in the instance list, which outlives its entry in the map
+    winstance_list_iterator(instance_list_iterator n): w(n), node(n->second) {}
+    static void* operator new(size_t) { return winstance_list_iterator_pool().alloc(); }
+    static void operator delete(void* p) { if (p) winstance_list_iterator_pool().release(p); }
   } *pinstance_list_iterator;
+  static chunk_pool &winstance_list_iterator_pool() {
+    static chunk_pool pool(sizeof(winstance_list_iterator), 1024);
+    return pool;
+  }
   void winstance_list_iterator_delete(pinstance_list_iterator whop) {
-    delete whop;
+    delete whop; // Its node, if the instance was destroyed, goes in dispose_destroyed_instances
   }
 
   //Link in an instance
@@ -275,6 +469,7 @@ namespace enigma
       ins->next = in->second, // Link this to next instance
       in->second->prev = ins; // Link next to this
     else ins->next = NULL;
+    id_table_link(who->id, ins);
     return new winstance_list_iterator(it.first);
   }
   inst_iter *link_obj_instance(object_basic* who, int oid)
@@ -285,21 +480,40 @@ namespace enigma
 
   void instance_iter_queue_for_destroy(pinstance_list_iterator whop)
   {
-    enigma::cleanups.insert((object_basic*)whop->w->second->inst);
+    object_basic *const inst = whop->w->second->inst;
+    if (!inst->$destroyed) {
+      inst->$destroyed = true;
+      enigma::cleanups.push_back(inst);
+      cleanup_nodes.push_back(whop->node);
+    }
     enigma::instancecount--;
     enigma_user::instance_count--;
   }
+  // A destroyed instance's main list node is kept until now, as a with() or event loop may be
+  // parked on it, and needs its links to step past it. The step calls this only once every
+  // event has returned, so no such loop is left; and nothing else frees instances or their
+  // main list nodes.
   void dispose_destroyed_instances()
   {
-    for (set<object_basic*>::iterator i = cleanups.begin(); i != cleanups.end(); i++)
-      delete (*i);
-    cleanups.clear();
+    for (size_t i = 0; i < cleanups.size(); i++)
+      delete cleanups[i];
+    cleanups.clear(); // Keeps its capacity for the next step
+    for (size_t i = 0; i < cleanup_nodes.size(); i++) {
+      #ifdef DEBUG_MODE
+      for (iterator *it = central_iterator_list; it; it = it->reg_next)
+        if (it->it == cleanup_nodes[i])
+          show_error("An iterator outlived the step on a destroyed instance", true);
+      #endif
+      delete cleanup_nodes[i];
+    }
+    cleanup_nodes.clear();
   }
   void unlink_main(instance_list_iterator who)
   {
     inst_iter *a = who->second;
     if (a->prev) a->prev->next = a->next;
     if (a->next) a->next->prev = a->prev;
+    id_table_unlink(who->first);
     instance_list.erase(who);
     update_iterators_for_destroy(a);
   }
@@ -308,6 +522,7 @@ namespace enigma
     inst_iter *a = whop->w->second;
     if (a->prev) a->prev->next = a->next;
     if (a->next) a->next->prev = a->prev;
+    id_table_unlink(whop->w->first);
     instance_list.erase(whop->w);
     update_iterators_for_destroy(a);
   }
@@ -42,12 +42,13 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 namespace enigma {
   typedef std::map<int,inst_iter*>::iterator instance_list_iterator;
   extern std::map<int,inst_iter*> instance_list;
   extern std::map<int,inst_iter*> instance_deactivated_list;
-  extern std::set<object_basic*> cleanups;
+  extern std::vector<object_basic*> cleanups;
   
   void unlink_main(instance_list_iterator who);
 }
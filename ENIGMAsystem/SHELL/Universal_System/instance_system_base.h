@@ -29,6 +29,8 @@
 #define _INSTANCE_SYSTEM_BASE__H
 
 #include "instance_iterator.h"
+#include <cstddef>
+#include <vector>
 //#include <deque>
 
 namespace enigma
@@ -42,6 +44,10 @@ namespace enigma
     bool dead;              // Whether or not this instance has been destroyed. Should be accessed rarely.
     //std::deque<inst_iter*>::iterator instance_id_index;
     inst_iter(object_basic* i,inst_iter *n,inst_iter *p);
+
+    // Nodes are carved from contiguous blocks, so lists built together sit together in memory.
+    static void* operator new(size_t size);
+    static void operator delete(void* node, size_t size);
   };
 
   class temp_event_scope
@@ -94,8 +100,64 @@ namespace enigma
   extern event_iter *events;
   extern objectid_base *objects;
   extern object_basic *ENIGMA_global_instance;
-  extern inst_iter *instance_event_iterator;
   extern object_basic *instance_other;
+
+  // Ids of instances which may have changed since the list was last cleared: each instance
+  // as it becomes the current instance, and each looked up by fetch_instance_by_int. Nothing is
+  // recorded unless track_touched_instances, a count of the readers who need it, is set.
+  // If the list grows past what a full sweep would cost, recording stops and
+  // touched_instances_overflowed is set.
+  extern int track_touched_instances;
+  extern bool touched_instances_overflowed;
+  extern std::vector<int> touched_instances;
+  extern unsigned touched_instances_epoch; // Counts clear_touched_instances()
+  extern int touched_current_instance; // The last instance touched as current, or -1 for none
+  void record_touched_instance(object_basic* inst, bool current);
+  void clear_touched_instances();
+
+  // One reader's place in touched_instances; several may read it at once.
+  struct touched_instances_reader
+  {
+    size_t next;    // The first entry not yet read
+    unsigned epoch; // touched_instances_epoch as of the last finish()
+
+    touched_instances_reader(): next(0), epoch(~0u) {}
+
+    // False if entries were lost since the last finish(): the list was cleared or overflowed,
+    // or the current instance was changed without being touched. The reader must then
+    // assume that any instance may have changed.
+    bool intact() const;
+    // Marks every entry read, except the current instance, which may yet change before its
+    // event is over.
+    void finish();
+  };
+
+  // The iterator of the instance whose event is running. Setting it records the instance
+  // as touched, so event loops, with() and the draw loops need do nothing more.
+  struct current_iterator
+  {
+    inst_iter *it;
+    current_iterator(inst_iter *i): it(i) {}
+    current_iterator &operator=(inst_iter *i) {
+      it = i;
+      if (track_touched_instances)
+        record_touched_instance(i ? i->inst : NULL, true);
+      return *this;
+    }
+    operator inst_iter*() const { return it; }
+    inst_iter *operator->() const { return it; }
+  };
+  extern current_iterator instance_event_iterator;
+
+  // Call when the current instance changes without instance_event_iterator being set.
+  inline void touch_current_instance() {
+    if (track_touched_instances)
+      record_touched_instance(instance_event_iterator ? instance_event_iterator->inst : NULL, true);
+  }
+  inline void touch_instance(object_basic* inst) {
+    if (track_touched_instances && inst)
+      record_touched_instance(inst, false);
+  }
 /* INSTANTLY ANTIQUATED
   inst_iter*    instance_list_first();
   inst_iter*    fetch_inst_iter_by_id(int id);
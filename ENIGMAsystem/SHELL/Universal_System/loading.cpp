@@ -24,6 +24,7 @@
 #include "spritestruct.h"
 #include "backgroundstruct.h"
 #include "Platforms/platforms_mandatory.h"
+#include "Platforms/General/PFfilemanip.h"
 #include "Audio_Systems/audio_mandatory.h"
 #include "Widget_Systems/widgets_mandatory.h"
 #include "Graphics_Systems/graphics_mandatory.h"
@@ -68,41 +69,40 @@ namespace enigma
     backgrounds_init();
     widget_system_initialize();
 
-    // Open the exe for resource load
+    // Map the exe for resource load. Resources are read straight from the mapping, and the
+    // largest of them are only decoded once they are first used.
     char exename[1025];
     windowsystem_write_exename(exename);
-    FILE* exe = fopen(exename,"rb");
+    size_t exesize;
+    const unsigned char *const exe = file_map(exename, &exesize);
     if (!exe)
       show_error("Resource load fail: exe unopenable",0);
     else do
     {
       int nullhere;
       // Read the magic number so we know we're looking at our own data
-      fseek(exe,-8,SEEK_END);
-      char str_quad[4];
-      if (!fread(str_quad,4,1,exe) or str_quad[0] != 'r' or str_quad[1] != 'e' or str_quad[2] != 's' or str_quad[3] != '0') {
+      if (exesize < 8 or memcmp(exe + exesize - 8, "res0", 4)) {
         printf("No resource data in exe\n");
         break;
       }
 
       // Get where our resources are located in the module
       int pos;
-      if (!fread(&pos,4,1,exe)) break;
+      memcpy(&pos, exe + exesize - 4, 4);
+      if (pos < 0 or size_t(pos) > exesize - 8) break;
 
       // Go to the start of the resource data
-      fseek(exe,pos,SEEK_SET);
-      if (!fread(&nullhere,4,1,exe)) break;
+      resource_reader res(exe + pos, exe + exesize - 8);
+      if (!res.read(&nullhere,4)) break;
       if(nullhere) break;
 
-      enigma::exe_loadsprs(exe);
-      enigma::exe_loadsounds(exe);
-      enigma::exe_loadbackgrounds(exe);
-      enigma::exe_loadfonts(exe);
+      enigma::exe_loadsprs(res);
+      enigma::exe_loadsounds(res);
+      enigma::exe_loadbackgrounds(res);
+      enigma::exe_loadfonts(res);
   //    #ifdef PATH_EXT_SET
-		enigma::exe_loadpaths(exe);
+		enigma::exe_loadpaths(res);
 	//  #endif
-
-      fclose(exe);
     }
     while (false);
 
@@ -22,6 +22,7 @@
 #include "reflexive_types.h"
 
 #include "object.h"
+#include "object_pool.h"
 #include "libEGMstd.h"
 
 
@@ -85,10 +86,13 @@ namespace enigma
     variant object_basic::myevent_roomend()   { return 0; }
     variant object_basic::myevent_destroy()   { return 0; }
 
-    object_basic::object_basic(): id(-4), object_index(-4) {}
-    object_basic::object_basic(int uid, int uoid): id(DEBUG_ID_CHECK(uid, uoid)), object_index(uoid) {}
+    object_basic::object_basic(): id(-4), object_index(-4), $destroyed(false) {}
+    object_basic::object_basic(int uid, int uoid): id(DEBUG_ID_CHECK(uid, uoid)), object_index(uoid), $destroyed(false) {}
     object_basic::~object_basic() {}
 
+    void* object_basic::operator new(size_t size) { return object_pool_alloc(size); }
+    void object_basic::operator delete(void* instance, size_t size) { object_pool_free(instance, size); }
+
     extern objectstruct objs[];
     extern int obj_idmax;
 
@@ -45,6 +45,7 @@ namespace enigma_user {
 }
 
 #include "var4.h"
+#include <cstddef>
 
 namespace enigma
 {
@@ -87,9 +88,15 @@ namespace enigma
       virtual variant myevent_roomend();
       virtual variant myevent_destroy();
 
+      bool $destroyed; // Queued for deletion at the end of the step
+
       object_basic();
       object_basic(int uid, int uoid);
       virtual ~object_basic();
+
+      // Instances are recycled through per-size free lists; see object_pool.h.
+      static void* operator new(size_t size);
+      static void operator delete(void* instance, size_t size);
     };
 
     struct objectstruct
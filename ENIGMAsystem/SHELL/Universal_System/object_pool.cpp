@@ -0,0 +1,114 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include <new>
+#include <vector>
+
+#include "object_pool.h"
+
+#ifdef DEBUG_MODE
+  #include <string>
+  #include "Widget_Systems/widgets_mandatory.h" // show_error
+#endif
+
+namespace enigma
+{
+  size_t pool_allocations = 0, pool_heap_allocations = 0;
+  bool (*on_worker_thread)() = NULL;
+
+  #ifdef DEBUG_MODE
+    static inline void check_game_thread() {
+      if (on_worker_thread && on_worker_thread())
+        show_error("Instances may only be created or destroyed on the game thread, not in a script run by script_thread", true);
+    }
+  #else
+    static inline void check_game_thread() {}
+  #endif
+
+  // Chunks are rounded to this, keeping them aligned for anything an instance may hold.
+  static const size_t chunk_alignment = 16;
+
+  chunk_pool::chunk_pool(size_t size, size_t n):
+    chunk_size((size + chunk_alignment - 1) / chunk_alignment * chunk_alignment),
+    per_block(n), block_used(n), free_chunks(NULL), block(NULL) {}
+
+  void *chunk_pool::alloc()
+  {
+    check_game_thread();
+    ++pool_allocations;
+    if (free_chunks) {
+      void *const chunk = free_chunks;
+      free_chunks = *(void**)chunk;
+      return chunk;
+    }
+    if (block_used == per_block) {
+      block = (char*)::operator new(chunk_size * per_block);
+      block_used = 0;
+      ++pool_heap_allocations;
+    }
+    return block + chunk_size * block_used++;
+  }
+
+  void chunk_pool::release(void *chunk)
+  {
+    check_game_thread();
+    *(void**)chunk = free_chunks;
+    free_chunks = chunk;
+  }
+
+  // Instances run to a few hundred bytes; past this, they are rare enough to leave to the heap.
+  static const size_t max_pooled_object = 4096;
+  static const size_t objects_per_block = 64;
+
+  static chunk_pool *object_pool_for(size_t size)
+  {
+    static std::vector<chunk_pool*> pools;
+    const size_t index = (size + chunk_alignment - 1) / chunk_alignment;
+    if (index >= pools.size())
+      pools.resize(index + 1, NULL);
+    if (!pools[index])
+      pools[index] = new chunk_pool(size, objects_per_block);
+    return pools[index];
+  }
+
+  void *object_pool_alloc(size_t size)
+  {
+    if (size > max_pooled_object)
+      return ::operator new(size);
+    return object_pool_for(size)->alloc();
+  }
+
+  void object_pool_free(void *chunk, size_t size)
+  {
+    if (!chunk)
+      return;
+    if (size > max_pooled_object)
+      ::operator delete(chunk);
+    else
+      object_pool_for(size)->release(chunk);
+  }
+}
+
+namespace enigma_user
+{
+  double instance_pool_allocations() {
+    return enigma::pool_allocations;
+  }
+  double instance_heap_allocations() {
+    return enigma::pool_heap_allocations;
+  }
+}
@@ -0,0 +1,64 @@
+/** Copyright (C) 2026 ENIGMA Development Team
+***
+*** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef _ENIGMA_OBJECT_POOL__H
+#define _ENIGMA_OBJECT_POOL__H
+
+#include <cstddef>
+
+namespace enigma
+{
+  // Counters shared by every pool below. Once a game reaches a steady state, creating and
+  // destroying instances should be served entirely from free lists, leaving
+  // pool_heap_allocations unchanged from frame to frame.
+  extern size_t pool_allocations;      // Chunks handed out
+  extern size_t pool_heap_allocations; // Blocks fetched from the heap to carve chunks from
+
+  // A free list of fixed-size chunks, carved out of contiguous blocks. Freed chunks are
+  // threaded through their first word. Blocks are never returned to the heap, since a room
+  // full of instances is usually followed by another.
+  class chunk_pool
+  {
+    size_t chunk_size, per_block, block_used;
+    void *free_chunks;
+    char *block;
+
+    public:
+    void *alloc();
+    void release(void *chunk);
+    chunk_pool(size_t size, size_t per_block);
+  };
+
+  // The pools take no locks: like the instance lists they back, they belong to the game
+  // thread, and jobs on the worker pool, scripts run as threads included, must not create
+  // or destroy instances. The worker pool, where the platform has one, sets this to tell its
+  // threads apart, and debug builds check it on every allocation.
+  extern bool (*on_worker_thread)();
+
+  // Instances are pooled by size, so each object type (and any others of the same size)
+  // reuses the memory of instances destroyed before it.
+  void *object_pool_alloc(size_t size);
+  void object_pool_free(void *chunk, size_t size);
+}
+
+namespace enigma_user
+{
+  double instance_pool_allocations();
+  double instance_heap_allocations();
+}
+
+#endif
@@ -25,10 +25,34 @@
 **                                                                              **
 \********************************************************************************/
 
+#include <string.h>
+
 namespace enigma {
-  void exe_loadsprs(FILE* exe);
-  void exe_loadsounds(FILE* exe);
-  void exe_loadbackgrounds(FILE* exe);
-  void exe_loadfonts(FILE* exe);
-  void exe_loadpaths(FILE* exe);
+  // Reads the resource block appended to the game. The block stays mapped into memory for as
+  // long as the game runs, so a resource may keep a pointer into it and decode on first use.
+  struct resource_reader
+  {
+    const unsigned char *pos, *end;
+
+    // Copies the next n bytes, or returns false if fewer remain.
+    bool read(void *dest, size_t n) {
+      if (size_t(end - pos) < n) return false;
+      memcpy(dest, pos, n), pos += n;
+      return true;
+    }
+    // Steps over the next n bytes, returning where they begin, or NULL if fewer remain.
+    const unsigned char *skip(size_t n) {
+      if (size_t(end - pos) < n) return NULL;
+      pos += n;
+      return pos - n;
+    }
+
+    resource_reader(const unsigned char *begin, const unsigned char *finish): pos(begin), end(finish) {}
+  };
+
+  void exe_loadsprs(resource_reader &exe);
+  void exe_loadsounds(resource_reader &exe);
+  void exe_loadbackgrounds(resource_reader &exe);
+  void exe_loadfonts(resource_reader &exe);
+  void exe_loadpaths(resource_reader &exe);
 }
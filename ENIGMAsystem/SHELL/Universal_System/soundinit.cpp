@@ -36,36 +36,36 @@ namespace enigma
     
   }
   
-  void exe_loadsounds(FILE *exe)
+  void exe_loadsounds(resource_reader &exe)
   { 
     int nullhere;
     
-    if (!fread(&nullhere,4,1,exe)) return;
+    if (!exe.read(&nullhere,4)) return;
     if (nullhere != *(int*)"SND ")
       return;
     
     // Determine how many sprites we have
     int sndcount;
-    if (!fread(&sndcount,4,1,exe)) return;
+    if (!exe.read(&sndcount,4)) return;
     
     // Fetch the highest ID we will be using
     int snd_highid;
-    if (!fread(&snd_highid,4,1,exe)) return;
+    if (!exe.read(&snd_highid,4)) return;
     
     for (int i = 0; i < sndcount; i++)
     {
       int id;
-      if (!fread(&id,1,4,exe)) return;
+      if (!exe.read(&id,4)) return;
       
       unsigned size;
-      if (!fread(&size,1,4,exe)) return;
+      if (!exe.read(&size,4)) return;
       
-      char* fdata = new char[size];
-      if (!fread(fdata,1,size,exe)) return;
+      // The audio system decodes straight from the resource block.
+      const unsigned char* fdata = exe.skip(size);
+      if (!fdata) return;
       
-      int e = sound_add_from_buffer(id,fdata,size);
+      int e = sound_add_from_buffer(id,const_cast<unsigned char*>(fdata),size);
       if (e) printf("Failed to load sound %d; error %d\n",i,e);
-      delete[] fdata;
     }
   }
 }
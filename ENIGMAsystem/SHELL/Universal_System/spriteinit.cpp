@@ -16,6 +16,8 @@
 **/
 
 #include <string>
+#include <vector>
+#include <cstring>
 #include <stdio.h>
 using namespace std;
 
@@ -29,37 +31,68 @@ using namespace std;
 
 namespace enigma
 {
-  void exe_loadsprs(FILE *exe)
+  void exe_loadsprs(resource_reader &exe)
   {
     int nullhere;
     unsigned sprid, width, height, bbt, bbb, bbl, bbr, shape;
     int xorig, yorig;
     
-    if (!fread(&nullhere,4,1,exe)) return;
+    if (!exe.read(&nullhere,4)) return;
     if (nullhere != *(int*)"SPR ")
       return;
     
     // Determine how many sprites we have
     int sprcount;
-    if (!fread(&sprcount,4,1,exe)) return;
+    if (!exe.read(&sprcount,4)) return;
     
     // Fetch the highest ID we will be using
     int spr_highid;
-    if (!fread(&spr_highid,4,1,exe)) return;
+    if (!exe.read(&spr_highid,4)) return;
     sprites_init();
     
+    // The subimages are packed onto shared atlas pages, which come first. They are left
+    // compressed in the resource block until a sprite on them is first used.
+    int pagecount;
+    if (!exe.read(&pagecount,4)) return;
+    vector<unsigned> pagewidth(pagecount), pageheight(pagecount);
+    for (int i = 0; i < pagecount; i++)
+    {
+      if (!exe.read(&pagewidth[i], 4)) return;
+      if (!exe.read(&pageheight[i],4)) return;
+      unsigned unpacked, size;
+      if (!exe.read(&unpacked,4)) return;
+      if (!exe.read(&size,4)) return;
+      const unsigned char* cpixels = exe.skip(size);
+      if (!cpixels) {
+        show_error("Failed to load sprite: Data is truncated before exe end",0);
+        return;
+      }
+      sprite_add_atlas_page(cpixels, size, unpacked, pagewidth[i], pageheight[i]);
+      
+      if (!exe.read(&nullhere,4)) return;
+      if (nullhere)
+      {
+        show_error("Sprite load error: Null terminator expected",0);
+        return;
+      }
+    }
+    
+    // Precise collision masks are built now, which means decoding the pages they lie on.
+    int decoded = -1;
+    unsigned char* pagepixels = NULL;
+    
     for (int i = 0; i < sprcount; i++)
     {
-      if (!fread(&sprid, 4,1,exe)) return;
-      if (!fread(&width, 4,1,exe)) return;
-      if (!fread(&height,4,1,exe)) return;
-      if (!fread(&xorig, 4,1,exe)) return;
-      if (!fread(&yorig, 4,1,exe)) return;
-      if (!fread(&bbt, 4,1,exe)) return;
-      if (!fread(&bbb, 4,1,exe)) return;
-      if (!fread(&bbl, 4,1,exe)) return;
-      if (!fread(&bbr, 4,1,exe)) return;
-      if (!fread(&shape, 4,1,exe)) return;
+      if (!exe.read(&sprid, 4)) break;
+      if (!exe.read(&width, 4)) break;
+      if (!exe.read(&height,4)) break;
+      if (!exe.read(&xorig, 4)) break;
+      if (!exe.read(&yorig, 4)) break;
+      if (!exe.read(&bbt, 4)) break;
+      if (!exe.read(&bbb, 4)) break;
+      if (!exe.read(&bbl, 4)) break;
+      if (!exe.read(&bbr, 4)) break;
+      if (!exe.read(&shape, 4)) break;
 
       collision_type coll_type;
       switch (shape)
@@ -74,57 +107,42 @@ namespace enigma
       };
       
       int subimages;
-      if (!fread(&subimages,4,1,exe)) return; //co//ut << "Subimages: " << subimages << endl;
+      if (!exe.read(&subimages,4)) break; //co//ut << "Subimages: " << subimages << endl;
       
       sprite_new_empty(sprid, subimages, width, height, xorig, yorig, bbt, bbb, bbl, bbr, 1,0);
+      unsigned char* collision_data = coll_type == ct_precise ? new unsigned char[width*height*4] : 0;
       for (int ii=0;ii<subimages;ii++) 
       {
-        int unpacked;
-        if (!fread(&unpacked,4,1,exe)) return;
-        unsigned int size;
-        if (!fread(&size,4,1,exe)) return; //co//ut << "Alloc size: " << size << endl;
-        unsigned char* cpixels=new unsigned char[size+1];
-        if (!cpixels)
-        {  //FIXME: Uncomment these when tostring is available
-          show_error("Failed to load sprite: Cannot allocate enough memory "+toString(unpacked),0);
-          break;
-        }
-        unsigned int sz2=fread(cpixels,1,size,exe);
-        if (size!=sz2) {
-          show_error("Failed to load sprite: Data is truncated before exe end. Read "+toString(sz2)+" out of expected "+toString(size),0);
-          return;
-        }
-        unsigned char* pixels=new unsigned char[unpacked+1];
-        if (zlib_decompress(cpixels,size,unpacked,pixels) != unpacked)
+        int page;
+        unsigned x, y;
+        if (!exe.read(&page,4)) break;
+        if (!exe.read(&x,4)) break;
+        if (!exe.read(&y,4)) break;
+        if (page < 0 or page >= pagecount or x + width > pagewidth[page] or y + height > pageheight[page])
         {
-          show_error("Sprite load error: Sprite does not match expected size",0);
-          continue;
+          show_error("Sprite load error: Subimage lies outside its atlas page",0);
+          break;
         }
-        delete[] cpixels;
         
-        unsigned char* collision_data = 0;
-        switch (coll_type)
+        // Only precise masks need the pixels, which the collision system copies out.
+        if (collision_data)
         {
-          case ct_precise: collision_data = pixels; break;
-          case ct_circle:
-          case ct_ellipse:
-          case ct_diamond:
-          case ct_bbox: collision_data = 0; break;
-          case ct_polygon: collision_data = 0; break; //FIXME: Support vertex data.
-          default: collision_data = 0; break;
-        };
-        
-        sprite_set_subimage(sprid, ii, width, height, pixels, collision_data, coll_type);
-        
-        delete[] pixels;
-        if (!fread(&nullhere,4,1,exe)) return;
-        
-        if (nullhere)
-        {
-          show_error("Sprite load error: Null terminator expected",0);
-          break;
+          if (page != decoded) {
+            delete[] pagepixels;
+            pagepixels = sprite_decode_atlas_page(page);
+            decoded = page;
+          }
+          for (unsigned row = 0; row < height; row++)
+            memcpy(collision_data + row*width*4, pagepixels + ((y + row)*pagewidth[page] + x)*4, width*4);
         }
+        
+        // Until the sprite is loaded, its subimages name their page by index.
+        sprite_set_subimage(sprid, ii, page, double(x)/pagewidth[page], double(y)/pageheight[page],
+            double(width)/pagewidth[page], double(height)/pageheight[page], collision_data, coll_type);
       }
+      spritestructarray[sprid]->pending = true;
+      delete[] collision_data;
     }
+    delete[] pagepixels;
   }
 }
@@ -18,6 +18,7 @@
 
 #include <string>
 #include <cstring>
+#include <algorithm>
 using namespace std;
 
 #include "Graphics_Systems/graphics_mandatory.h"
@@ -29,6 +30,7 @@ using namespace std;
 #include "libEGMstd.h"
 #include "image_formats.h"
 #include "estring.h"
+#include "zlib.h"
 
 bool get_sprite(enigma::sprite* &spr, int id)
 {
@@ -54,8 +56,8 @@ bool get_sprite_mtx(enigma::sprite* &spr, int id)
 namespace enigma {
   sprite** spritestructarray;
   extern size_t sprite_idmax;
-  sprite::sprite() {}
-  sprite::sprite(int x) {}
+  sprite::sprite(): pending(false) {}
+  sprite::sprite(int x): pending(false) {}
 }
 
 namespace enigma_user
@@ -80,13 +82,17 @@ bool sprite_replace(int ind, string filename, int imgnumb, bool precise, bool tr
     if (!get_sprite_mtx(spr, ind))
         return false;
 
-    if (free_texture)
+    if (free_texture and !spr->pending)
         for (int ii = 0; ii < spr->subcount; ii++)
-            enigma::graphics_delete_texture(spr->texturearray[ii]);
+            if (!enigma::sprite_is_atlas_page(spr->texturearray[ii]))
+                enigma::graphics_delete_texture(spr->texturearray[ii]);
 
     spr->texturearray.clear();
     spr->texbordxarray.clear();
     spr->texbordyarray.clear();
+    spr->texxarray.clear();
+    spr->texyarray.clear();
+    spr->pending = false;
     enigma::sprite_add_to_index(spr, filename, imgnumb, precise, transparent, smooth, x_offset, y_offset);
     return true;
 }
@@ -100,11 +106,20 @@ bool sprite_exists(int spr) {
     return (unsigned(spr) < enigma::sprite_idmax) and bool(enigma::spritestructarray[spr]);
 }
 
+void sprite_prefetch(int ind) {
+    enigma::sprite *spr;
+    if (!get_sprite_mtx(spr, ind))
+        return;
+
+    enigma::sprite_load(spr);
+}
+
 void sprite_save(int ind, unsigned subimg, string fname) {
     enigma::sprite *spr;
     if (!get_sprite_mtx(spr, ind))
         return;
 
+    enigma::sprite_unpack(spr);
 	unsigned w, h;
 	unsigned char* rgbdata = enigma::graphics_get_texture_pixeldata(spr->texturearray[subimg], &w, &h);
 	
@@ -123,9 +138,10 @@ void sprite_delete(int ind, bool free_texture)
     if (!get_sprite_mtx(spr, ind))
         return;
 
-    if (free_texture)
+    if (free_texture and !spr->pending)
         for (int ii = 0; ii < spr->subcount; ii++)
-            enigma::graphics_delete_texture(spr->texturearray[ii]);
+            if (!enigma::sprite_is_atlas_page(spr->texturearray[ii]))
+                enigma::graphics_delete_texture(spr->texturearray[ii]);
 
     delete enigma::spritestructarray[ind];
     enigma::spritestructarray[ind] = NULL;
@@ -152,13 +168,17 @@ void sprite_assign(int ind, int copy_sprite, bool free_texture)
     if (!get_sprite_mtx(spr_copy, copy_sprite))
         return;
 
-    if (free_texture)
+    if (free_texture and !spr->pending)
         for (int ii = 0; ii < spr->subcount; ii++)
-            enigma::graphics_delete_texture(spr->texturearray[ii]);
+            if (!enigma::sprite_is_atlas_page(spr->texturearray[ii]))
+                enigma::graphics_delete_texture(spr->texturearray[ii]);
 
     spr->texturearray.clear();
     spr->texbordxarray.clear();
     spr->texbordyarray.clear();
+    spr->texxarray.clear();
+    spr->texyarray.clear();
+    spr->pending = false;
     enigma::sprite_add_copy(spr, spr_copy);
 }
 
@@ -170,6 +190,8 @@ void sprite_set_alpha_from_sprite(int ind, int copy_sprite, bool free_texture)
     if (!get_sprite_mtx(spr_copy, copy_sprite))
         return;
 
+    enigma::sprite_unpack(spr);
+    enigma::sprite_unpack(spr_copy);
     for (int i = 0; i < spr->subcount; i++)
         enigma::graphics_replace_texture_alpha_from_texture(spr->texturearray[i], spr_copy->texturearray[i % spr_copy->subcount]);
 }
@@ -182,12 +204,17 @@ void sprite_merge(int ind, int copy_sprite)
     if (!get_sprite_mtx(spr_copy, copy_sprite))
         return;
 
+    enigma::sprite_load(spr);
+    enigma::sprite_load(spr_copy);
     int i = 0, j = 0, t_subcount = spr->subcount + spr_copy->subcount;
     while (j < spr_copy->subcount)
     {
-        spr->texturearray.push_back(enigma::graphics_duplicate_texture(spr_copy->texturearray[j]));
+        const int tex = spr_copy->texturearray[j];
+        spr->texturearray.push_back(enigma::sprite_is_atlas_page(tex) ? tex : enigma::graphics_duplicate_texture(tex));
         spr->texbordxarray.push_back(spr_copy->texbordxarray[j]);
         spr->texbordyarray.push_back(spr_copy->texbordyarray[j]);
+        spr->texxarray.push_back(spr_copy->texxarray[j]);
+        spr->texyarray.push_back(spr_copy->texyarray[j]);
         i++; j++;
     }
     spr->subcount = t_subcount;
@@ -327,6 +354,8 @@ namespace enigma
 			ns->texturearray.push_back(texture);
 			ns->texbordxarray.push_back((double) cellwidth/fullcellwidth);
 			ns->texbordyarray.push_back((double) height/fullheight);
+			ns->texxarray.push_back(0);
+			ns->texyarray.push_back(0);
 			
 			collision_type coll_type = precise ? ct_precise : ct_bbox;
 			ns->colldata.push_back(get_collision_mask(ns,(unsigned char*)pixels,coll_type));
@@ -337,6 +366,7 @@ namespace enigma
 
     void sprite_add_copy(sprite *spr, sprite *spr_copy)
     {
+        sprite_load(spr_copy);
         spr->subcount  = spr_copy->subcount;
         spr->width     = spr_copy->width;
         spr->height    = spr_copy->height;
@@ -345,9 +375,13 @@ namespace enigma
 
         for (int i = 0; i < spr->subcount; i++)
         {
-            spr->texturearray.push_back(graphics_duplicate_texture(spr_copy->texturearray[i]));
+            // Subimages on an atlas page can share it; the page is never changed in place.
+            const int tex = spr_copy->texturearray[i];
+            spr->texturearray.push_back(sprite_is_atlas_page(tex) ? tex : graphics_duplicate_texture(tex));
             spr->texbordxarray.push_back(spr_copy->texbordxarray[i]);
             spr->texbordyarray.push_back(spr_copy->texbordyarray[i]);
+            spr->texxarray.push_back(spr_copy->texxarray[i]);
+            spr->texyarray.push_back(spr_copy->texyarray[i]);
         }
     }
 
@@ -378,10 +412,24 @@ namespace enigma
     sprstr->texturearray.push_back(texture);
     sprstr->texbordxarray.push_back((double) w/fullwidth);
     sprstr->texbordyarray.push_back((double) h/fullheight);
+    sprstr->texxarray.push_back(0);
+    sprstr->texyarray.push_back(0);
     sprstr->colldata.push_back(get_collision_mask(sprstr,collision_data,ct));
 
     delete[] imgpxdata;
   }
+
+  void sprite_set_subimage(int sprid, int imgindex, int page, double x, double y, double w, double h, unsigned char* collision_data, collision_type ct)
+  {
+    sprite* sprstr = spritestructarray[sprid];
+
+    sprstr->texturearray.push_back(page);
+    sprstr->texbordxarray.push_back(w);
+    sprstr->texbordyarray.push_back(h);
+    sprstr->texxarray.push_back(x);
+    sprstr->texyarray.push_back(y);
+    sprstr->colldata.push_back(get_collision_mask(sprstr,collision_data,ct));
+  }
   
   //Appends a subimage
   void sprite_add_subimage(int sprid, unsigned int w, unsigned int h, unsigned char* chunk, unsigned char* collision_data, collision_type ct)
@@ -406,16 +454,98 @@ namespace enigma
     unsigned texture = graphics_create_texture(w, h, fullwidth,fullheight,imgpxdata,false);
 
     sprite* sprstr = spritestructarray[sprid];
+    sprite_load(sprstr);
 
     sprstr->texturearray.push_back(texture);
     sprstr->texbordxarray.push_back((double) w/fullwidth);
     sprstr->texbordyarray.push_back((double) h/fullheight);
+    sprstr->texxarray.push_back(0);
+    sprstr->texyarray.push_back(0);
     sprstr->colldata.push_back(get_collision_mask(sprstr,collision_data,ct));
 	
 	sprstr->subcount += 1;
 
     delete[] imgpxdata;
   }
+
+  struct atlas_page
+  {
+    const unsigned char *data; // Compressed, in the resource block
+    unsigned size, unpacked, width, height;
+    int texture; // -1 until the page is decoded
+  };
+  static vector<atlas_page> atlas_page_sources;
+  static vector<int> atlas_pages; // Textures of the decoded pages, sorted
+
+  int sprite_add_atlas_page(const unsigned char *data, unsigned size, unsigned unpacked, unsigned w, unsigned h) {
+    const atlas_page page = { data, size, unpacked, w, h, -1 };
+    atlas_page_sources.push_back(page);
+    return atlas_page_sources.size() - 1;
+  }
+
+  unsigned char *sprite_decode_atlas_page(int page)
+  {
+    const atlas_page &pg = atlas_page_sources[page];
+    unsigned char *pixels = new unsigned char[pg.unpacked+1];
+    if (zlib_decompress(const_cast<unsigned char*>(pg.data), pg.size, pg.unpacked, pixels) != int(pg.unpacked)) {
+      show_error("Sprite load error: Atlas page does not match expected size",0);
+      memset(pixels, 0, pg.unpacked);
+    }
+    return pixels;
+  }
+
+  bool sprite_is_atlas_page(int texture) {
+    return binary_search(atlas_pages.begin(), atlas_pages.end(), texture);
+  }
+
+  void sprite_load_pending(sprite *spr)
+  {
+    for (size_t i = 0; i < spr->texturearray.size(); i++)
+    {
+      atlas_page &pg = atlas_page_sources[spr->texturearray[i]];
+      if (pg.texture == -1) {
+        unsigned char *pixels = sprite_decode_atlas_page(spr->texturearray[i]);
+        pg.texture = graphics_create_texture(pg.width, pg.height, pg.width, pg.height, pixels, false);
+        atlas_pages.insert(lower_bound(atlas_pages.begin(), atlas_pages.end(), pg.texture), pg.texture);
+        delete[] pixels;
+      }
+      spr->texturearray[i] = pg.texture;
+    }
+    spr->pending = false;
+  }
+
+  void sprite_unpack(sprite *spr)
+  {
+    sprite_load(spr);
+    const unsigned w = spr->width, h = spr->height;
+    const unsigned fullwidth = nlpo2dc(w)+1, fullheight = nlpo2dc(h)+1;
+    int fetched = -1;
+    unsigned char *page = NULL;
+    unsigned pw = 0, ph = 0;
+    for (int i = 0; i < spr->subcount; i++)
+    {
+      if (!sprite_is_atlas_page(spr->texturearray[i]))
+        continue;
+      if (spr->texturearray[i] != fetched) {
+        delete[] page;
+        fetched = spr->texturearray[i];
+        page = graphics_get_texture_pixeldata(fetched, &pw, &ph);
+      }
+
+      const unsigned px = unsigned(spr->texxarray[i]*pw + .5), py = unsigned(spr->texyarray[i]*ph + .5);
+      unsigned char *pixels = new unsigned char[4*fullwidth*fullheight]();
+      for (unsigned row = 0; row < h; row++)
+        memcpy(pixels + 4*row*fullwidth, page + 4*((py + row)*pw + px), 4*w);
+
+      spr->texturearray[i] = graphics_create_texture(w, h, fullwidth, fullheight, pixels, false);
+      spr->texbordxarray[i] = (double) w/fullwidth;
+      spr->texbordyarray[i] = (double) h/fullheight;
+      spr->texxarray[i] = 0;
+      spr->texyarray[i] = 0;
+      delete[] pixels;
+    }
+    delete[] page;
+  }
 }
 
 namespace enigma_user
@@ -565,6 +695,8 @@ int sprite_get_texture(int sprite,int subimage)
         return 0;
 
     const int usi = subimage >= 0 ? (subimage % spr->subcount) : int(((enigma::object_graphics*)enigma::instance_event_iterator->inst)->image_index) % spr->subcount;
+    // The caller may use the texture as a whole, or repeat it.
+    enigma::sprite_unpack(spr);
     return spr->texturearray[usi];
 }
 
@@ -35,14 +35,17 @@ namespace enigma
   {
     int width,height,subcount,xoffset,yoffset,id;
 	
-	vector<int> texturearray; //Each subimage has a texture
+	vector<int> texturearray; //Each subimage has a texture, which may be an atlas page shared with other subimages
 	vector<double> texbordxarray;
 	vector<double> texbordyarray;
+	vector<double> texxarray; //Where each subimage begins in its texture, as a fraction of the texture
+	vector<double> texyarray;
 	vector<void*> colldata; // Each subimage has collision data
 
     //void*  *pixeldata;
     bbox_rect_t bbox, bbox_relative;
     bool where,smooth;
+    bool pending; // Loaded from the resource block, but its atlas pages are not yet decoded; texturearray holds page indices
 
     sprite();
     sprite(int);
@@ -64,9 +67,27 @@ namespace enigma
 
   //Sets the subimage
   void sprite_set_subimage(int sprid, int imgindex, unsigned int w,unsigned int h,unsigned char*chunk, unsigned char*collision_data, collision_type ct);
+  //Sets the subimage to a rectangle of an atlas page, given as fractions of the page
+  void sprite_set_subimage(int sprid, int imgindex, int page, double x, double y, double w, double h, unsigned char*collision_data, collision_type ct);
   //Appends a subimage
   void sprite_add_subimage(int sprid, unsigned int w, unsigned int h, unsigned char*chunk, unsigned char*collision_data, collision_type ct);
   void spritestructarray_reallocate();
+
+  // Atlas pages hold the subimages of many sprites, packed together at compile time. Sprites
+  // only borrow them, so a page is never freed or changed through any one sprite.
+  // Pages stay compressed in the resource block until a sprite on them is first used, when
+  // the page is decoded and becomes a texture; its index is returned when it is added.
+  int sprite_add_atlas_page(const unsigned char *data, unsigned size, unsigned unpacked, unsigned w, unsigned h);
+  unsigned char *sprite_decode_atlas_page(int page); // Pixels of a page; free them with delete[]
+  bool sprite_is_atlas_page(int texture);
+  // Gives a pending sprite its textures, decoding the pages it lies on as needed.
+  void sprite_load_pending(sprite *spr);
+  inline void sprite_load(const sprite *spr) {
+    if (spr->pending) sprite_load_pending(const_cast<sprite*>(spr));
+  }
+  // Moves each subimage that lies on an atlas page onto a texture of its own, for the
+  // functions that work on, or hand out, the whole texture of a subimage.
+  void sprite_unpack(sprite *spr);
 }
 
 namespace enigma_user
@@ -106,6 +127,7 @@ int sprite_add(std::string filename, int imgnumb, bool transparent, bool smooth,
 bool sprite_replace(int ind, std::string fname, int imgnumb, bool precise, bool transparent, bool smooth, bool preload, int x_offset, int y_offset, bool free_texture = true); //GM8+ compatible
 bool sprite_replace(int ind, std::string fname, int imgnumb, bool transparent, bool smooth, int x_offset, int y_offset, bool free_texture = true);   //GM7+ compatible
 bool sprite_exists(int spr);
+void sprite_prefetch(int ind); // Decodes a sprite now, rather than when it is first drawn
 void sprite_save(int ind, unsigned subimg, std::string fname);
 void sprite_save_strip(int ind, std::string fname);
 void sprite_delete(int ind, bool free_texture = true);
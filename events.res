@@ -82,6 +82,12 @@ destroy: 1			# This event is performed as a dtor: immediately as the instance is
 
 # Here marks the start of events that are actually executed in place
 
+asyncupdate: 100000
+	Name: Async update
+	Mode: None
+	Default: ;
+	Instead: enigma::perform_callbacks_async_update();
+
 beginstep: 3
 	Group: Step
 	Name: Begin Step
@@ -410,8 +416,8 @@ collision: 4
 	Type: Object
 	Mode: Stacked
 	Super Check: instance_number(%1)
-	Sub Check: (instance_other = enigma::place_meeting_inst(x,y,%1)) # Parenthesize assignment used as truth
-	prefix: for (enigma::iterator it = enigma::fetch_inst_iter_by_int(%1); it; ++it) {int $$$internal$$$ = %1; instance_other = *it; if (enigma::place_meeting_inst(x,y,instance_other->id)) {if(enigma::glaccess(int(other))->solid && enigma::place_meeting_inst(x,y,instance_other->id)) x = xprevious, y = yprevious;
+	Sub Check: (instance_other = enigma::collision_event_meeting(x,y,%1)) # Parenthesize assignment used as truth
+	prefix: for (enigma::collision_event_candidates it(%1); it; ++it) {int $$$internal$$$ = %1; instance_other = *it; if (enigma::place_meeting_inst(x,y,instance_other->id)) {if(enigma::glaccess(int(other))->solid && enigma::place_meeting_inst(x,y,instance_other->id)) x = xprevious, y = yprevious;
 	suffix: if (enigma::glaccess(int(other))->solid) {x += hspeed; y += vspeed; if (enigma::place_meeting_inst(x, y, $$$internal$$$)) {x = xprevious; y = yprevious;}}}}
 # Check for detriment from collision events above
 